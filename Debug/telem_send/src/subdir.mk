@@ -5,18 +5,45 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../telem_send/src/TelemEncoding.c \
+../telem_send/src/decode_8b10b.c \
+../telem_send/src/frame_archive.c \
+../telem_send/src/gf256.c \
+../telem_send/src/hs_frame.c \
+../telem_send/src/layout_codec.c \
+../telem_send/src/rs_decoder.c \
+../telem_send/src/rs_encoder.c \
 ../telem_send/src/telem_processor.c \
-../telem_send/src/telem_thread.c 
+../telem_send/src/telem_scheduler.c \
+../telem_send/src/telem_thread.c \
+../telem_send/src/wod_store.c 
 
 C_DEPS += \
 ./telem_send/src/TelemEncoding.d \
+./telem_send/src/decode_8b10b.d \
+./telem_send/src/frame_archive.d \
+./telem_send/src/gf256.d \
+./telem_send/src/hs_frame.d \
+./telem_send/src/layout_codec.d \
+./telem_send/src/rs_decoder.d \
+./telem_send/src/rs_encoder.d \
 ./telem_send/src/telem_processor.d \
-./telem_send/src/telem_thread.d 
+./telem_send/src/telem_scheduler.d \
+./telem_send/src/telem_thread.d \
+./telem_send/src/wod_store.d 
 
 OBJS += \
 ./telem_send/src/TelemEncoding.o \
+./telem_send/src/decode_8b10b.o \
+./telem_send/src/frame_archive.o \
+./telem_send/src/gf256.o \
+./telem_send/src/hs_frame.o \
+./telem_send/src/layout_codec.o \
+./telem_send/src/rs_decoder.o \
+./telem_send/src/rs_encoder.o \
 ./telem_send/src/telem_processor.o \
-./telem_send/src/telem_thread.o 
+./telem_send/src/telem_scheduler.o \
+./telem_send/src/telem_thread.o \
+./telem_send/src/wod_store.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -31,7 +58,7 @@ telem_send/src/%.o: ../telem_send/src/%.c telem_send/src/subdir.mk
 clean: clean-telem_send-2f-src
 
 clean-telem_send-2f-src:
-	-$(RM) ./telem_send/src/TelemEncoding.d ./telem_send/src/TelemEncoding.o ./telem_send/src/telem_processor.d ./telem_send/src/telem_processor.o ./telem_send/src/telem_thread.d ./telem_send/src/telem_thread.o
+	-$(RM) ./telem_send/src/TelemEncoding.d ./telem_send/src/TelemEncoding.o ./telem_send/src/decode_8b10b.d ./telem_send/src/decode_8b10b.o ./telem_send/src/frame_archive.d ./telem_send/src/frame_archive.o ./telem_send/src/gf256.d ./telem_send/src/gf256.o ./telem_send/src/hs_frame.d ./telem_send/src/hs_frame.o ./telem_send/src/layout_codec.d ./telem_send/src/layout_codec.o ./telem_send/src/rs_decoder.d ./telem_send/src/rs_decoder.o ./telem_send/src/rs_encoder.d ./telem_send/src/rs_encoder.o ./telem_send/src/telem_processor.d ./telem_send/src/telem_processor.o ./telem_send/src/telem_scheduler.d ./telem_send/src/telem_scheduler.o ./telem_send/src/telem_thread.d ./telem_send/src/telem_thread.o ./telem_send/src/wod_store.d ./telem_send/src/wod_store.o
 
 .PHONY: clean-telem_send-2f-src
 
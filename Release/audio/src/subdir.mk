@@ -4,19 +4,49 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../audio/src/alsa_audio.c \
+../audio/src/audio_backend.c \
+../audio/src/audio_perf.c \
 ../audio/src/audio_processor.c \
 ../audio/src/audio_tools.c \
-../audio/src/jack_audio.c 
+../audio/src/ber_sim.c \
+../audio/src/duv_demodulator.c \
+../audio/src/file_audio.c \
+../audio/src/fsk_modulator.c \
+../audio/src/golden_output.c \
+../audio/src/jack_audio.c \
+../audio/src/latency_histogram.c \
+../audio/src/loop_latency.c 
 
 C_DEPS += \
+./audio/src/alsa_audio.d \
+./audio/src/audio_backend.d \
+./audio/src/audio_perf.d \
 ./audio/src/audio_processor.d \
 ./audio/src/audio_tools.d \
-./audio/src/jack_audio.d 
+./audio/src/ber_sim.d \
+./audio/src/duv_demodulator.d \
+./audio/src/file_audio.d \
+./audio/src/fsk_modulator.d \
+./audio/src/golden_output.d \
+./audio/src/jack_audio.d \
+./audio/src/latency_histogram.d \
+./audio/src/loop_latency.d 
 
 OBJS += \
+./audio/src/alsa_audio.o \
+./audio/src/audio_backend.o \
+./audio/src/audio_perf.o \
 ./audio/src/audio_processor.o \
 ./audio/src/audio_tools.o \
-./audio/src/jack_audio.o 
+./audio/src/ber_sim.o \
+./audio/src/duv_demodulator.o \
+./audio/src/file_audio.o \
+./audio/src/fsk_modulator.o \
+./audio/src/golden_output.o \
+./audio/src/jack_audio.o \
+./audio/src/latency_histogram.o \
+./audio/src/loop_latency.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -31,7 +61,7 @@ audio/src/%.o: ../audio/src/%.c audio/src/subdir.mk
 clean: clean-audio-2f-src
 
 clean-audio-2f-src:
-	-$(RM) ./audio/src/audio_processor.d ./audio/src/audio_processor.o ./audio/src/audio_tools.d ./audio/src/audio_tools.o ./audio/src/jack_audio.d ./audio/src/jack_audio.o
+	-$(RM) ./audio/src/alsa_audio.d ./audio/src/alsa_audio.o ./audio/src/audio_backend.d ./audio/src/audio_backend.o ./audio/src/audio_perf.d ./audio/src/audio_perf.o ./audio/src/audio_processor.d ./audio/src/audio_processor.o ./audio/src/audio_tools.d ./audio/src/audio_tools.o ./audio/src/ber_sim.d ./audio/src/ber_sim.o ./audio/src/duv_demodulator.d ./audio/src/duv_demodulator.o ./audio/src/file_audio.d ./audio/src/file_audio.o ./audio/src/fsk_modulator.d ./audio/src/fsk_modulator.o ./audio/src/golden_output.d ./audio/src/golden_output.o ./audio/src/jack_audio.d ./audio/src/jack_audio.o ./audio/src/latency_histogram.d ./audio/src/latency_histogram.o ./audio/src/loop_latency.d ./audio/src/loop_latency.o
 
 .PHONY: clean-audio-2f-src
 
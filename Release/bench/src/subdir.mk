@@ -0,0 +1,34 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../bench/src/microbench.c \
+../bench/src/telem_bench.c 
+
+C_DEPS += \
+./bench/src/microbench.d \
+./bench/src/telem_bench.d 
+
+BENCH_OBJS += \
+./bench/src/microbench.o \
+./bench/src/telem_bench.o 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+bench/src/%.o: ../bench/src/%.c bench/src/subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: GCC C Compiler'
+	gcc -DRASPBERRY_PI -I../inc -I../dsp/inc -I../audio/inc -I../telem_send/inc -I../telem_capture/inc -I../bench/inc -O3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
+clean: clean-bench-2f-src
+
+clean-bench-2f-src:
+	-$(RM) ./bench/src/microbench.d ./bench/src/microbench.o ./bench/src/telem_bench.d ./bench/src/telem_bench.o
+
+.PHONY: clean-bench-2f-src
+
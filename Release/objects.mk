@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lm -lpthread -lbcm2835 -ljack
+LIBS := -lm -lpthread -lbcm2835 -ljack -lasound
 
@@ -10,10 +10,12 @@ S_UPPER_SRCS :=
 C_DEPS := 
 EXECUTABLES := 
 OBJS := 
+BENCH_OBJS := 
 
 # Every subdirectory with source files must be described here
 SUBDIRS := \
 audio/src \
+bench/src \
 dsp/src \
 src \
 telem_capture/src \
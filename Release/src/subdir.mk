@@ -8,21 +8,30 @@ C_SRCS += \
 ../src/config.c \
 ../src/gpio_interface.c \
 ../src/main.c \
-../src/serial.c 
+../src/realtime.c \
+../src/rt_log.c \
+../src/serial.c \
+../src/test_random.c 
 
 C_DEPS += \
 ./src/cmd_console.d \
 ./src/config.d \
 ./src/gpio_interface.d \
 ./src/main.d \
-./src/serial.d 
+./src/realtime.d \
+./src/rt_log.d \
+./src/serial.d \
+./src/test_random.d 
 
 OBJS += \
 ./src/cmd_console.o \
 ./src/config.o \
 ./src/gpio_interface.o \
 ./src/main.o \
-./src/serial.o 
+./src/realtime.o \
+./src/rt_log.o \
+./src/serial.o \
+./src/test_random.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -37,7 +46,7 @@ src/%.o: ../src/%.c src/subdir.mk
 clean: clean-src
 
 clean-src:
-	-$(RM) ./src/cmd_console.d ./src/cmd_console.o ./src/config.d ./src/config.o ./src/gpio_interface.d ./src/gpio_interface.o ./src/main.d ./src/main.o ./src/serial.d ./src/serial.o
+	-$(RM) ./src/cmd_console.d ./src/cmd_console.o ./src/config.d ./src/config.o ./src/gpio_interface.d ./src/gpio_interface.o ./src/main.d ./src/main.o ./src/realtime.d ./src/realtime.o ./src/rt_log.d ./src/rt_log.o ./src/serial.d ./src/serial.o ./src/test_random.d ./src/test_random.o
 
 .PHONY: clean-src
 
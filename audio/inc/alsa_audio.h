@@ -0,0 +1,39 @@
+/*
+ * alsa_audio.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef ALSA_AUDIO_H_
+#define ALSA_AUDIO_H_
+
+#include "audio_backend.h"
+
+/* Defaults if the values are not in telem_radio.config */
+#define ALSA_DEFAULT_DEVICE "hw:1,0"
+#define ALSA_DEFAULT_PERIODS 3
+#define ALSA_DEFAULT_RT_PRIORITY 80
+
+/*
+ * The ALSA backend talks directly to the sound card with mmap access and calls the
+ * process callback from its own SCHED_FIFO thread once per hardware period.  Use
+ * alsa_device=null in telem_radio.config to test it without a sound card.
+ */
+extern audio_backend_t alsa_audio_backend;
+
+#endif /* ALSA_AUDIO_H_ */
@@ -0,0 +1,74 @@
+/*
+ * audio_backend.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * An audio backend moves periods of samples between a source/sink and the
+ * audio_loop().  JACK is the normal backend on the radio.  The file and null
+ * backends let us run the pipeline without a sound card.
+ *
+ */
+
+#ifndef AUDIO_BACKEND_H_
+#define AUDIO_BACKEND_H_
+
+#include "audio_processor.h"
+
+/* The default backend if none is given on the command line */
+#define DEFAULT_AUDIO_BACKEND "jack"
+
+/* The process callback.  This is audio_loop() in normal operation */
+typedef jack_default_audio_sample_t * (*audio_process_callback_t)(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes);
+
+typedef struct {
+	char *name;
+	/* Connect to the device or file and check the sample rate.  The callback is called once per period */
+	int (*open)(audio_process_callback_t process);
+	/* Start calling the process callback */
+	int (*start)(void);
+	/* Stop processing and release the device or file */
+	int (*stop)(void);
+	/* Block until the backend has no more audio to process.  NULL for backends that run until stopped */
+	int (*wait)(void);
+	int (*get_buffer_size)(void);
+	int (*get_sample_rate)(void);
+	int (*get_xruns)(void);
+} audio_backend_t;
+
+/*
+ * Select a backend by name.  This must be called before audio_backend_start().
+ * Returns EXIT_FAILURE if there is no backend with that name.
+ */
+int audio_backend_select(char *name);
+audio_backend_t *audio_backend_get();
+
+/* Open and start the selected backend with audio_loop() as the process callback */
+int audio_backend_start();
+int audio_backend_stop();
+
+/* Returns true if the selected backend runs until stopped, false if it finishes by itself */
+int audio_backend_is_continuous();
+int audio_backend_wait();
+
+/* The number of xruns reported by the selected backend since it started */
+int get_xruns_since_start();
+
+/* Print the names of the available backends */
+void audio_backend_print_list();
+
+#endif /* AUDIO_BACKEND_H_ */
@@ -0,0 +1,76 @@
+/*
+ * audio_perf.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef AUDIO_PERF_H_
+#define AUDIO_PERF_H_
+
+#include <stdint.h>
+#include <time.h>
+
+#include "latency_histogram.h"
+
+/* The phases of the audio loop that are timed */
+typedef enum {
+	PERF_DECIMATE_FILTER,
+	PERF_DECIMATE,
+	PERF_HPF,
+	PERF_MODULATE,
+	PERF_INTERPOLATE,
+	PERF_INTERPOLATE_FILTER,
+	PERF_HIGH_SPEED_MODULATE,
+	PERF_TOTAL,
+	PERF_NUM_STAGES
+} audio_perf_stage_t;
+
+/*
+ * Read the monotonic raw clock in nanoseconds.  This is not slewed by NTP and is read
+ * through the vDSO, so it is cheap enough to call several times per period.
+ */
+static inline uint64_t audio_perf_now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Called from the audio thread.  Record the time since start_ns against the stage and
+ * return the current time so that calls can be chained from one stage to the next.
+ * The results are held until audio_perf_end_period() publishes them.
+ */
+uint64_t audio_perf_stage(audio_perf_stage_t stage, uint64_t start_ns);
+void audio_perf_end_period();
+
+/*
+ * Called from any other thread.  Take a consistent copy of the stats for all stages
+ * without blocking the audio thread.
+ */
+void audio_perf_get_stats(latency_histogram_t stats[PERF_NUM_STAGES]);
+char *audio_perf_stage_name(audio_perf_stage_t stage);
+
+/* Ask the audio thread to clear the stats at the start of the next period */
+void audio_perf_reset();
+
+/* Print mean, p99 and max for each stage that has run */
+void audio_perf_print();
+
+int test_audio_perf();
+
+#endif /* AUDIO_PERF_H_ */
@@ -22,7 +22,12 @@
 #ifndef AUDIO_PROCESSOR_H_
 #define AUDIO_PROCESSOR_H_
 
+#include <stdint.h>
 #include <jack/jack.h>
+#include <iir_filter.h>
+
+#include "fsk_modulator.h"
+#include "telem_processor.h"
 
 /* the number of frames in each audio sample period.  This must match the period in ALSA */
 #define PERIOD_SIZE 512
@@ -30,43 +35,156 @@
 /* The reduction from 48000 samples per sec for the audio loop */
 #define DUV_DECIMATION_RATE 4
 
+#define DECIMATE_FILTER_LEN 480
+#define BIT_FILTER_LEN 180 // 60 is one bit.  Filter across 3 bits seems to be a good trade off
+
+/*
+ * The modes the audio processor can run in.  Each has its own pipeline.  The combined mode sends
+ * DUV with high speed telemetry on top, using a second high speed pipeline for the burst.
+ */
+#define AUDIO_MODE_DUV 0
+#define AUDIO_MODE_HIGH_SPEED 1
+#define AUDIO_MODE_COMBINED 2
+#define AUDIO_NUM_MODES 3
+#define AUDIO_PIPELINE_BURST 3 // the high speed half of the combined mode
+#define AUDIO_NUM_PIPELINES 4
+
+/*
+ * Everything the audio loop needs for one mode: the filter coefficients designed for its rates,
+ * the filter history and the modulator state.  One is built for each mode at startup, so
+ * changing mode only changes which pipeline the audio loop uses.
+ */
+typedef struct audio_pipeline {
+	char *name;
+	int mode;
+	int bit_rate;
+	int decimation_rate;
+	double samples_per_bit; // For example 12000/200 = 60.  It does not have to be a whole number
+
+	double decimate_filter_coeffs[DECIMATE_FILTER_LEN];
+	double decimate_filter_xv[DECIMATE_FILTER_LEN];
+	double interpolate_filter_coeffs[DECIMATE_FILTER_LEN];
+	double interpolate_filter_xv[DECIMATE_FILTER_LEN];
+	TIIRStorage iir_hpf_store; // storage for the IIR High Pass filter
+	double bit_filter_coeffs[BIT_FILTER_LEN];
+	double bit_filter_xv[BIT_FILTER_LEN];
+
+	/*
+	 * Telemetry modulator.  The symbol clock phase moves on by bit_phase_step each sample and a
+	 * bit ends when it reaches bit_phase_wrap.  These are whole numbers so the clock never drifts.
+	 */
+	uint32_t bit_phase;
+	uint32_t bit_phase_step; // bit rate * decimation rate
+	uint32_t bit_phase_wrap; // sample rate
+	int current_bit; // the value of the current bit we are sending
+	int starting_bit_modulator;
+	int zero_bits_in_a_row;
+	int one_bits_in_a_row;
+	int test_bits_sent;
+
+	/* High speed AFSK or GFSK.  The modulation is FSK_NRZ if the bits are sent as levels */
+	fsk_modulator_t fsk;
+
+	telem_stream_t *stream; // the telemetry this pipeline sends
+	uint32_t period_start_bit; // bits_sent of the stream at the start of this period
+	uint32_t frames_archived; // frames_started of the stream when the last frame was archived
+	int switch_ready; // the frame is finished and the modulator is holding until the mode changes
+	struct audio_pipeline *burst; // high speed telemetry mixed with this pipeline in the combined mode, or NULL
+} audio_pipeline_t;
+
+/*
+ * Settings that the console can change while the audio is running.  The audio thread uses
+ * a snapshot of these that can only change between periods.
+ */
+typedef struct {
+	int hpf;
+	int lpf_bits;
+	int send_telem;
+	int send_high_speed_telem;
+	int send_duv_with_high_speed; // keep sending DUV underneath the high speed telemetry
+	int send_test_telem;
+	int send_test_tone;
+	int measure_test_tone;
+	double test_tone_freq;
+} audio_params_t;
+
 /* Access to variables needed by other files */
 int get_decimation_rate();
 double get_loop_time_microsec();
 double get_max_loop_time_microsec();
 double get_min_loop_time_microsec();
-int get_samples_per_bit();
+double get_samples_per_bit();
 double get_test_tone_freq();
 int get_hpf();
 int get_lpf_bits();
 int get_send_telem();
 int get_send_high_speed_telem();
+int get_send_duv_with_high_speed();
 int get_send_test_telem();
 int get_send_test_tone();
 int get_measure_test_tone();
 
-void set_samples_per_bit(int val);
 void set_test_tone_freq(double val);
 void set_hpf(int val);
 void set_lpf_bits(int val);
 void set_send_telem(int val);
 void set_send_high_speed_telem(int val);
+void set_send_duv_with_high_speed(int val);
 void set_send_test_telem(int val);
 void set_send_test_tone(int val);
 void set_measure_test_tone(int val);
 
+/*
+ * The set functions change the console copy of the settings.  Call this afterwards to pass all
+ * of the changes to the audio thread in one step.  A change between DUV and high speed
+ * telemetry takes effect at the end of the frame that is being sent.
+ */
+void audio_processor_publish_params();
+
+/* A version of the audio loop specialized for one combination of settings */
+typedef jack_default_audio_sample_t * (*audio_loop_variant_t)(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes);
+
 /* The audio loop.  This is called from jackd or alsa hardware interface routines */
 jack_default_audio_sample_t * audio_loop(jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, jack_nframes_t nframes);
 
-/* Create the filters and initialize ready to process audio.  Call this before jack is started */
-int init_audio_processor(int bit_rate, int decimation_rate);
+/*
+ * The JACK backend sets the frame time of the first sample of each period before the audio loop
+ * is called.  With the other backends it counts the samples processed
+ */
+void audio_processor_set_frame_time(jack_nframes_t frame_time);
+
+/* Create the pipelines and initialize ready to process audio.  Call this before jack is started */
+int init_audio_processor();
+
+/* Write to the audio loop buffers so they are resident before the audio starts */
+void audio_processor_touch_buffers();
 
-/* Reset the modulator ready to send new telemetry */
-int init_bit_modulator(int bit_rate, int decimation_rate);
+/* Print the current mode and how long the last mode switch took */
+void audio_processor_print_mode_status();
 
 /*
  * Test functions
  */
 int test_modulate_bit();
+int test_audio_params();
+int test_audio_pipeline();
+int test_symbol_clock();
+int test_combined_pipeline();
+
+/*
+ * Benchmark functions
+ */
+int bench_audio_loop_variants(int periods);
+
+/* For telem_bench.  The high pass filter the DUV loop uses and the bit modulator for the current pipeline */
+extern TIIRCoeff Elliptic8Pole300HzHighPassIIRCoeff;
+double modulate_bit();
+
+/*
+ * Change straight to the pipeline for mode and put it and the telemetry back to the start, so
+ * that runs of the audio loop can be timed or compared.  Not for use while the audio is running
+ */
+void audio_processor_start_mode(int mode);
 
 #endif /* AUDIO_PROCESSOR_H_ */
@@ -0,0 +1,85 @@
+/*
+ * ber_sim.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Monte Carlo simulation of the DUV bit and frame error rates.  Frames of random data are sent
+ * through audio_loop() once, with the current settings.  The audio is then passed through a model
+ * of the radio, a single pole high pass filter and white noise, and decoded by the DUV demodulator
+ * many times at each Eb/N0.
+ *
+ * The audio loop has one set of state so the audio is generated in one thread.  The channel and
+ * demodulator have their own state, so the passes run in a thread for each core.  Each pass has its
+ * own random number generator, seeded from the SNR and the pass number, so the results are the
+ * same for any number of threads.
+ *
+ */
+
+#ifndef BER_SIM_H_
+#define BER_SIM_H_
+
+#include <stdint.h>
+
+#include "telem_processor.h"
+
+#define BER_SIM_DEFAULT_FRAMES 200 // frames at each Eb/N0
+#define BER_SIM_TX_FRAMES 16 // different frames generated by the audio loop.  Each pass sends all of them
+#define BER_SIM_MIN_EBN0_DB 0
+#define BER_SIM_MAX_EBN0_DB 20
+#define BER_SIM_HPF_FREQ 7.0 // Hz.  The ramp_amount in the config compensates for roughly this
+#define BER_SIM_SEED 0x7e1e3ad10ULL
+
+/* The audio sent by the audio loop and the frames that are in it */
+typedef struct {
+	int frames; // counted frames.  One more is sent first
+	long samples;
+	long samples_per_frame;
+	float *audio;
+	unsigned char (*bytes)[DUV_DATA_LENGTH]; // for each frame sent, including the first
+	uint16_t (*words)[DUV_PACKET_LENGTH]; // as sent, without the sync words
+	double signal_power; // mean square of the audio
+	long first_sync_sample; // where the sync word before the first frame is found with no noise
+} ber_sim_tx_t;
+
+/* The results for one Eb/N0 */
+typedef struct {
+	double ebn0_db;
+	long frames;
+	long bits;
+	long bit_errors; // in the frames that were received
+	long frames_missed; // the sync word was not found
+	long frames_failed; // received but the RS decoder could not correct it
+	long frames_corrected; // received with errors that the RS decoder corrected
+	long symbols_corrected; // bytes corrected by the RS decoder
+} ber_sim_point_t;
+
+/* Run the audio loop to generate frames of random data.  Free the audio with ber_sim_free_tx() */
+int ber_sim_transmit(ber_sim_tx_t *tx, int frames, uint64_t seed);
+void ber_sim_free_tx(ber_sim_tx_t *tx);
+
+/*
+ * Send the audio through the channel and demodulate it.  A negative ebn0_db means there is no
+ * noise.  A hpf_freq of zero means there is no high pass filter.  The totals are added to point
+ */
+void ber_sim_pass(ber_sim_tx_t *tx, double ebn0_db, double hpf_freq, uint64_t seed, ber_sim_point_t *point);
+
+/* Measure the bit and frame error rates over the range of Eb/N0 and print them */
+int ber_sim_run(int frames);
+
+int test_ber_sim();
+
+#endif /* BER_SIM_H_ */
@@ -0,0 +1,117 @@
+/*
+ * duv_demodulator.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * An offline receiver for the DUV telemetry, so that the audio the audio loop sends can be
+ * decoded again.  It is not used on the air, it is used to test the modulator and to measure
+ * the bit and frame error rates in a simulation.
+ *
+ * The audio is decimated to the DUV rate and low pass filtered by integrating over one bit, which
+ * is the matched filter for the bits.  The bit timing is recovered from the zero crossings of the
+ * filter output.  It jumps to each crossing until they are a whole number of bits apart and then
+ * follows the bits with a Gardner timing error detector.  The 8b10b code has no DC, so the bits
+ * are sliced at zero.  Once a sync word is seen the next 96 10b words are a frame.  They are
+ * decoded back to bytes and the RS parities are checked.
+ *
+ */
+
+#ifndef DUV_DEMODULATOR_H_
+#define DUV_DEMODULATOR_H_
+
+#include <stdint.h>
+
+#include "telem_processor.h"
+
+#define DUV_DEMOD_MAX_SAMPLES_PER_BIT 256
+#define DUV_DEMOD_TIMING_GAIN 0.05 // fraction of the timing error corrected at each change of bit
+#define DUV_DEMOD_AMPLITUDE_GAIN 0.01
+#define DUV_DEMOD_ACQUIRE_CROSSINGS 4 // zero crossings in a row at the expected time to find the timing
+#define DUV_DEMOD_ACQUIRE_TOLERANCE 0.1 // of a bit
+#define DUV_DEMOD_SYNC_WORD 0x0fa // K.28.5 with RD=-1.  The inverse is sent with RD=+1
+#define DUV_DEMOD_SYNC_ERRORS 2 // bit errors allowed in a sync word that is straight after a frame
+#define DUV_DEMOD_INVALID_WORD -1
+
+/* A frame that followed a sync word */
+typedef struct {
+	uint16_t words[DUV_PACKET_LENGTH]; // as received, without the sync word
+	unsigned char bytes[DUV_PACKET_LENGTH]; // the data and then the parities
+	int invalid_words; // words that are not 8b10b code words.  Their bytes are zero
+	int disparity_errors; // code words sent with the wrong running disparity
+	int rs_ok; // true if the RS decoder found a codeword, after any corrections
+	int rs_corrected; // bytes the RS decoder corrected, which are fixed in bytes
+	long sample; // the input sample where the sync word before the frame ended
+} duv_frame_t;
+
+typedef void (*duv_frame_callback_t)(duv_frame_t *frame, void *arg);
+
+typedef struct {
+	int decimation_rate;
+	int samples_per_bit; // at the decimated rate
+
+	/* Integrate and dump decimation */
+	int decimate_count;
+	double decimate_sum;
+
+	/* Matched filter.  A running sum over one bit */
+	double filter_xv[DUV_DEMOD_MAX_SAMPLES_PER_BIT];
+	int filter_pos;
+	double filter_sum;
+	double last_filter_value;
+
+	/* Timing recovery.  A bit is sampled when the phase reaches one */
+	double bit_phase;
+	double bit_phase_step;
+	int timing_locked; // false until the bit timing is found
+	int good_crossings; // zero crossings in a row at the expected time
+	double mid_value; // filter output half way between the last two bits
+	double amplitude; // average filter output at the bits
+	int last_bit;
+
+	/* Frame sync */
+	uint32_t shift_reg; // the last bits received, most recent in bit zero
+	int in_frame;
+	int bits_in_frame;
+	int bits_after_frame;
+	duv_frame_t frame;
+
+	long samples;
+	long bits;
+	long frames;
+	long frames_rs_ok;
+	long rs_corrected; // bytes corrected in all the frames
+
+	duv_frame_callback_t frame_callback;
+	void *frame_callback_arg;
+} duv_demodulator_t;
+
+/*
+ * Setup a demodulator.  The callback is called with each frame that is received.  The 8b10b
+ * table is shared, so decode_8b10b_init() must be called first
+ */
+int duv_demodulator_init(duv_demodulator_t *d, int sample_rate, int decimation_rate, int bit_rate,
+		duv_frame_callback_t callback, void *arg);
+
+/* Demodulate a block of audio at the sample rate */
+void duv_demodulator_process(duv_demodulator_t *d, float *in, int nframes);
+
+/* The byte for a 10b word, or DUV_DEMOD_INVALID_WORD if it is not a code word */
+int duv_demodulator_decode_word(duv_demodulator_t *d, uint16_t word);
+
+int test_duv_demodulator();
+
+#endif /* DUV_DEMODULATOR_H_ */
@@ -0,0 +1,49 @@
+/*
+ * file_audio.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#ifndef FILE_AUDIO_H_
+#define FILE_AUDIO_H_
+
+#include "audio_backend.h"
+
+/* Number of periods the null backend runs for if no value is given.  About 10 seconds of audio */
+#define NULL_AUDIO_DEFAULT_PERIODS 1000
+
+/*
+ * The file backend reads a WAV or raw file and writes the output to a WAV file.  Raw
+ * files are signed 16 bit little endian mono at the configured sample rate.
+ * The null backend feeds silence and throws the output away.  Both run as fast as
+ * they can and report the realtime factor when they finish.
+ */
+extern audio_backend_t file_audio_backend;
+extern audio_backend_t null_audio_backend;
+
+/*
+ * Set the files used by the file backend.  Either can be NULL, in which case silence is read or the
+ * output is discarded.  periods limits the number of periods processed, 0 means run to the end of
+ * the input file, or NULL_AUDIO_DEFAULT_PERIODS if there is no input.
+ */
+void file_audio_configure(char *input_file, char *output_file, int periods);
+
+/* The realtime factor achieved by the last run.  Audio seconds processed per second of wall clock time */
+double file_audio_get_realtime_factor();
+
+#endif /* FILE_AUDIO_H_ */
@@ -0,0 +1,108 @@
+/*
+ * fsk_modulator.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Continuous phase FSK for the high speed telemetry.  A numerically controlled oscillator
+ * generates a tone whose frequency moves between the space and mark frequencies.  For AFSK
+ * the frequency changes at the bit edge.  For GFSK the bits are shaped by a Gaussian pulse
+ * so the frequency moves smoothly.  The phase of the tone never jumps, so there are no clicks
+ * at the bit edges.
+ *
+ * The pulse is calculated once when the modulator is initialized and stored in a table of
+ * FSK_PULSE_STEPS_PER_BIT steps for each bit it spans, so the table does not depend on the
+ * sample rate or the bit rate.  The weight at each sample is interpolated linearly between the
+ * two nearest steps.  A whole period of audio is generated in one call.
+ *
+ */
+
+#ifndef FSK_MODULATOR_H_
+#define FSK_MODULATOR_H_
+
+#include <stdint.h>
+
+/* Values for high_speed_modulation in the config file */
+#define FSK_MODULATION_NRZ "nrz"   /* baseband levels from the bit filter, no FSK */
+#define FSK_MODULATION_AFSK "afsk"
+#define FSK_MODULATION_GFSK "gfsk"
+
+#define FSK_NRZ 0
+#define FSK_AFSK 1
+#define FSK_GFSK 2
+
+/* Bell 202 tones */
+#define FSK_DEFAULT_MARK_FREQ 1200
+#define FSK_DEFAULT_SPACE_FREQ 2200
+#define FSK_DEFAULT_GFSK_BT 0.5
+
+#define FSK_SIN_TABLE_BITS 12
+#define FSK_SIN_TABLE_SIZE (1 << FSK_SIN_TABLE_BITS)
+#define FSK_PULSE_SPAN_BITS 4       /* the Gaussian pulse is truncated to this many bits */
+#define FSK_PULSE_STEPS_PER_BIT 64  /* the pulse table has this many steps across a bit */
+
+/* Called by the modulator at the start of each bit.  Return the value of the bit */
+typedef int (*fsk_next_bit_t)(void *arg);
+
+typedef struct {
+	int modulation;
+	int bit_rate;
+	double mark_freq;
+	double space_freq;
+	double amplitude;
+	int span; /* bits the pulse lasts for.  1 for AFSK */
+
+	/* Symbol clock, as in the audio processor */
+	uint32_t bit_phase;
+	uint32_t bit_phase_step;
+	uint32_t bit_phase_wrap;
+	int starting;
+	double symbols[FSK_PULSE_SPAN_BITS]; /* +1 for a one, -1 for a zero.  symbols[0] is the current bit */
+
+	/* Oscillator */
+	uint32_t nco_phase;
+	double center_step; /* phase step at the center frequency */
+	double deviation_step; /* phase step from the center to the mark frequency */
+	double last_freq; /* frequency of the last sample, for testing */
+
+	/* pulse[j][s] is the weight of the bit j bits back at step s through the current bit */
+	double pulse[FSK_PULSE_SPAN_BITS][FSK_PULSE_STEPS_PER_BIT + 1];
+	float sin_table[FSK_SIN_TABLE_SIZE];
+
+	fsk_next_bit_t next_bit;
+	void *next_bit_arg;
+} fsk_modulator_t;
+
+/* Return FSK_NRZ, FSK_AFSK or FSK_GFSK for a config file value, or -1 if it is not known */
+int fsk_modulation_type(char *name);
+
+/*
+ * Build the pulse and sine tables.  This calculates, so call it at startup and not from the
+ * audio thread.
+ */
+int fsk_modulator_init(fsk_modulator_t *m, int modulation, int bit_rate, int sample_rate, double mark_freq,
+		double space_freq, double bt, double amplitude, fsk_next_bit_t next_bit, void *next_bit_arg);
+
+/* Start again with the next bit.  This only resets the state so it can be called from the audio thread */
+void fsk_modulator_start(fsk_modulator_t *m);
+
+/* Generate nframes samples of FSK */
+void fsk_modulator_block(fsk_modulator_t *m, float *out, int nframes);
+
+int test_fsk_modulator();
+int bench_fsk_modulator(int periods);
+
+#endif /* FSK_MODULATOR_H_ */
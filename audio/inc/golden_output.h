@@ -0,0 +1,90 @@
+/*
+ * golden_output.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Regression test for the audio that is sent.  The audio loop is run for a number of periods
+ * in each mode with the test packet and a fixed tone and noise input, and the output is compared
+ * with a reference file that was saved from a build that is known to be good.  A change to the
+ * DSP must not change the waveform by more than the tolerance.
+ *
+ * The settings that shape the audio are fixed here rather than taken from the config file, so
+ * the references do not change when the config does.  The references are 32 bit float mono WAV
+ * files, so they can be looked at in any audio editor.
+ *
+ * A sample matches if it is within the absolute tolerance or within the number of units in the
+ * last place of the float.  For each case the first sample that does not match is reported, with
+ * the SNR of the output against the reference.
+ *
+ */
+
+#ifndef GOLDEN_OUTPUT_H_
+#define GOLDEN_OUTPUT_H_
+
+#include <stddef.h>
+
+#define GOLDEN_DIR_NAME "golden" // next to the Debug or Release directory that telem_radio is built in
+#define GOLDEN_DEFAULT_ABS_TOLERANCE 1E-6
+#define GOLDEN_DEFAULT_ULP_TOLERANCE 4
+
+/* The fixed settings the references are made with */
+#define GOLDEN_SAMPLE_RATE 48000
+#define GOLDEN_ONE_VALUE 0.5
+#define GOLDEN_ZERO_VALUE -0.5
+#define GOLDEN_RAMP_AMOUNT 0.1
+#define GOLDEN_DUV_BIT_RATE 200
+#define GOLDEN_HIGH_SPEED_BIT_RATE 1200
+#define GOLDEN_BURST_LEVEL 0.5
+#define GOLDEN_TONE_FREQ 1000.0 // transponder audio on the input, and the test tone
+#define GOLDEN_TONE_LEVEL 0.3
+#define GOLDEN_NOISE_LEVEL 0.05
+
+/* The comparison of one case with its reference */
+typedef struct {
+	long samples;
+	long mismatches; // samples outside both tolerances
+	long first_mismatch; // sample number, or -1
+	float expected; // at the first mismatch
+	float actual;
+	double max_abs_error;
+	long max_ulp_error;
+	double snr_db; // signal to error power.  Infinite if they are the same
+} golden_result_t;
+
+/* Compare two blocks of audio.  Used for each case, and public so it can be tested */
+void golden_output_compare(float *expected, float *actual, long samples, double abs_tolerance, long ulp_tolerance,
+		golden_result_t *result);
+
+/* The distance between two floats in units in the last place */
+long golden_output_ulps(float a, float b);
+
+/*
+ * Run every case and compare it with its reference in dir.  With update true the references are
+ * written instead.  Prints a line for each case if print is true
+ */
+int golden_output_run(char *dir, int update, int print);
+
+/*
+ * The directory of the reference files.  This is golden_dir from the config file if it is set,
+ * otherwise the golden directory in the parent of the directory that holds the executable, so it
+ * does not depend on where telem_radio is run from
+ */
+void golden_output_dir(char *dir, size_t len);
+
+int test_golden_output();
+
+#endif /* GOLDEN_OUTPUT_H_ */
@@ -8,10 +8,9 @@
 #ifndef JACK_AUDIO_H_
 #define JACK_AUDIO_H_
 
-/* Setup and start the jack audio thread */
-int start_jack_audio_processor (void);
-int stop_jack_audio_processor (void);
+#include "audio_backend.h"
 
-int get_xruns_since_start();
+/* The jack audio backend.  Select it with audio_backend_select("jack") */
+extern audio_backend_t jack_audio_backend;
 
 #endif /* JACK_AUDIO_H_ */
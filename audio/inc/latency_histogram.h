@@ -0,0 +1,58 @@
+/*
+ * latency_histogram.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * A log-linear histogram of times in nanoseconds.  Below LATENCY_SUB_BUCKETS ns each bucket
+ * is 1ns wide.  Above that each power of two is split into LATENCY_SUB_BUCKETS equal buckets,
+ * so any percentile is accurate to 1/LATENCY_SUB_BUCKETS.  The histogram is a fixed size and
+ * recording a value does not allocate, so it is safe to call from the audio thread.
+ *
+ */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS 200 /* The last bucket holds everything above 134ms */
+
+typedef struct {
+	uint32_t count;
+	uint64_t total_ns;
+	uint32_t max_ns;
+	uint32_t buckets[LATENCY_HISTOGRAM_BUCKETS];
+} latency_histogram_t;
+
+void latency_histogram_clear(latency_histogram_t *hist);
+void latency_histogram_record(latency_histogram_t *hist, uint64_t ns);
+
+/* Add the counts in src to dest, so histograms for short periods can be combined into a window */
+void latency_histogram_add(latency_histogram_t *dest, latency_histogram_t *src);
+
+/* Return the time in ns that percentile (0-100) of the values were at or below */
+double latency_histogram_percentile(latency_histogram_t *hist, double percentile);
+double latency_histogram_mean(latency_histogram_t *hist);
+
+int latency_histogram_bucket(uint64_t ns);
+uint64_t latency_histogram_bucket_upper_ns(int bucket);
+
+int test_latency_histogram();
+
+#endif /* LATENCY_HISTOGRAM_H_ */
@@ -0,0 +1,59 @@
+/*
+ * loop_latency.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Histogram of the time the audio loop takes to process each period, kept since start
+ * and in one second slots so that it can be reported over a recent window.
+ *
+ */
+
+#ifndef LOOP_LATENCY_H_
+#define LOOP_LATENCY_H_
+
+#include <stdint.h>
+
+#include "latency_histogram.h"
+
+/* The longest window that can be reported */
+#define LOOP_LATENCY_MAX_WINDOW_SEC 600
+
+/* Default windows if they are not in the config file */
+#define LOOP_LATENCY_DEFAULT_SHORT_WINDOW_SEC 10
+#define LOOP_LATENCY_DEFAULT_LONG_WINDOW_SEC 60
+
+/* Clear the histograms.  Call this before the audio backend is started */
+void loop_latency_init();
+
+/* Called from the audio thread once per period with the time it took to process */
+void loop_latency_record(uint64_t ns);
+
+/*
+ * Called from any other thread.  Combine the slots for the last window_sec seconds into
+ * hist.  A window of 0 gives the histogram since start.  This never blocks the audio thread.
+ */
+void loop_latency_get(int window_sec, latency_histogram_t *hist);
+
+/* The time available to process one period before we cause an xrun */
+double loop_latency_deadline_ns();
+
+/* Print percentiles and the fraction of the deadline used for each window and since start */
+void loop_latency_print();
+
+int test_loop_latency();
+
+#endif /* LOOP_LATENCY_H_ */
@@ -0,0 +1,440 @@
+/*
+ * alsa_audio.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Direct ALSA backend.  This avoids the extra context switch per period that
+ * the JACK server adds.  The capture and playback PCMs are linked so they
+ * start together and both use mmap access, so samples are read from and
+ * written to the DMA buffer in place with snd_pcm_mmap_begin()/commit().
+ *
+ * The audio thread runs at SCHED_FIFO.  It waits for one period of capture
+ * audio, calls the process callback and writes the result to the playback
+ * buffer.  The playback buffer is filled with silence before we start, so
+ * the latency is the length of the playback buffer.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+/* Libraries */
+#include <alsa/asoundlib.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "rt_log.h"
+#include "audio_processor.h"
+#include "audio_backend.h"
+#include "alsa_audio.h"
+
+/* Forward function declarations */
+int alsa_audio_open(audio_process_callback_t process);
+int alsa_audio_start(void);
+int alsa_audio_stop(void);
+int alsa_audio_get_buffer_size(void);
+int alsa_audio_get_sample_rate(void);
+int alsa_audio_get_xruns(void);
+int alsa_audio_set_params(snd_pcm_t *pcm, char *name);
+int alsa_audio_read_period(jack_default_audio_sample_t *in);
+int alsa_audio_write_period(jack_default_audio_sample_t *out);
+int alsa_audio_write_silence(snd_pcm_uframes_t frames);
+int alsa_audio_recover(snd_pcm_t *pcm, int err);
+void *alsa_audio_process(void *arg);
+
+audio_backend_t alsa_audio_backend = {
+		.name = "alsa",
+		.open = alsa_audio_open,
+		.start = alsa_audio_start,
+		.stop = alsa_audio_stop,
+		.wait = NULL,
+		.get_buffer_size = alsa_audio_get_buffer_size,
+		.get_sample_rate = alsa_audio_get_sample_rate,
+		.get_xruns = alsa_audio_get_xruns
+};
+
+#define ALSA_MAX_CHANNELS 8
+#define ALSA_WRITE_TIMEOUT_MS 100 // many periods, the card has stopped if there is still no space
+
+snd_pcm_t *capture_pcm = NULL;
+snd_pcm_t *playback_pcm = NULL;
+snd_pcm_format_t alsa_format[2]; /* Indexed by the snd_pcm_stream_t */
+unsigned int alsa_channels[2];
+snd_pcm_uframes_t alsa_buffer_size[2]; /* As the device rounded it, indexed by the snd_pcm_stream_t */
+int alsa_linked = false;
+unsigned int alsa_rate = 0;
+snd_pcm_uframes_t alsa_period_size = 0;
+audio_process_callback_t alsa_process_callback;
+pthread_t alsa_pthread;
+int alsa_thread_started = false;
+int alsa_running = false; // set by the control thread and read by the audio thread
+static int xruns = 0;
+
+int alsa_audio_get_buffer_size(void) { return alsa_period_size; }
+int alsa_audio_get_sample_rate(void) { return alsa_rate; }
+int alsa_audio_get_xruns(void) { return xruns; }
+
+/*
+ * Open the capture and playback devices with the same hardware parameters and link
+ * them so that they start together.
+ */
+int alsa_audio_open(audio_process_callback_t process) {
+	int err;
+	alsa_process_callback = process;
+
+	if ((err = snd_pcm_open(&capture_pcm, g_alsa_device, SND_PCM_STREAM_CAPTURE, 0)) < 0) {
+		error_print("Could not open ALSA capture device %s: %s\n", g_alsa_device, snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+	if ((err = snd_pcm_open(&playback_pcm, g_alsa_device, SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+		error_print("Could not open ALSA playback device %s: %s\n", g_alsa_device, snd_strerror(err));
+		snd_pcm_close(capture_pcm);
+		capture_pcm = NULL;
+		return EXIT_FAILURE;
+	}
+	if (alsa_audio_set_params(capture_pcm, "capture") != EXIT_SUCCESS
+			|| alsa_audio_set_params(playback_pcm, "playback") != EXIT_SUCCESS) {
+		alsa_audio_stop();
+		return EXIT_FAILURE;
+	}
+	alsa_linked = true;
+	if ((err = snd_pcm_link(capture_pcm, playback_pcm)) < 0) {
+		/* Not fatal, but the two streams may start a few frames apart */
+		error_print("Could not link the ALSA capture and playback streams: %s\n", snd_strerror(err));
+		alsa_linked = false;
+	}
+	verbose_print("ALSA device %s: %d Hz, period %d frames, buffer %d frames, %s\n", g_alsa_device, alsa_rate,
+			(int)alsa_period_size, (int)alsa_buffer_size[SND_PCM_STREAM_PLAYBACK],
+			alsa_format[SND_PCM_STREAM_CAPTURE] == SND_PCM_FORMAT_FLOAT_LE ? "float" : "16 bit");
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Request mmap interleaved access at the configured rate and period size.  We try float
+ * samples first and fall back to 16 bit, which is what most USB sound cards support.  We
+ * take whatever number of channels the card needs and only use the first.
+ */
+int alsa_audio_set_params(snd_pcm_t *pcm, char *name) {
+	int err;
+	snd_pcm_hw_params_t *hw_params;
+	snd_pcm_sw_params_t *sw_params;
+	int stream = (pcm == capture_pcm) ? SND_PCM_STREAM_CAPTURE : SND_PCM_STREAM_PLAYBACK;
+
+	snd_pcm_hw_params_malloc(&hw_params);
+	snd_pcm_hw_params_any(pcm, hw_params);
+	if ((err = snd_pcm_hw_params_set_access(pcm, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+		error_print("ALSA %s device does not support mmap access: %s\n", name, snd_strerror(err));
+		snd_pcm_hw_params_free(hw_params);
+		return EXIT_FAILURE;
+	}
+	alsa_format[stream] = SND_PCM_FORMAT_FLOAT_LE;
+	if (snd_pcm_hw_params_set_format(pcm, hw_params, alsa_format[stream]) < 0) {
+		alsa_format[stream] = SND_PCM_FORMAT_S16_LE;
+		if ((err = snd_pcm_hw_params_set_format(pcm, hw_params, alsa_format[stream])) < 0) {
+			error_print("ALSA %s device does not support float or 16 bit samples: %s\n", name, snd_strerror(err));
+			snd_pcm_hw_params_free(hw_params);
+			return EXIT_FAILURE;
+		}
+	}
+	unsigned int channels = 1;
+	snd_pcm_hw_params_set_channels_near(pcm, hw_params, &channels);
+	if (channels > ALSA_MAX_CHANNELS) {
+		error_print("ALSA %s device needs %d channels\n", name, channels);
+		snd_pcm_hw_params_free(hw_params);
+		return EXIT_FAILURE;
+	}
+	alsa_channels[stream] = channels;
+
+	/* Do not let the plugin layer resample, the filters are designed for g_sample_rate */
+	snd_pcm_hw_params_set_rate_resample(pcm, hw_params, 0);
+	alsa_rate = g_sample_rate;
+	if ((err = snd_pcm_hw_params_set_rate_near(pcm, hw_params, &alsa_rate, 0)) < 0 || alsa_rate != g_sample_rate) {
+		error_print("ALSA %s device does not support %d Hz, nearest is %d\n", name, g_sample_rate, alsa_rate);
+		snd_pcm_hw_params_free(hw_params);
+		return EXIT_FAILURE;
+	}
+	/* The audio thread buffers hold exactly one period of PERIOD_SIZE samples */
+	alsa_period_size = PERIOD_SIZE;
+	if ((err = snd_pcm_hw_params_set_period_size_near(pcm, hw_params, &alsa_period_size, 0)) < 0
+			|| alsa_period_size != PERIOD_SIZE) {
+		error_print("ALSA %s device does not support a period of %d frames, nearest is %d\n", name, PERIOD_SIZE,
+				(int)alsa_period_size);
+		snd_pcm_hw_params_free(hw_params);
+		return EXIT_FAILURE;
+	}
+	/* The buffer can be rounded, so the prefill uses the size we get.  It needs a period to spare */
+	snd_pcm_uframes_t buffer_size = alsa_period_size * g_alsa_periods;
+	if ((err = snd_pcm_hw_params_set_buffer_size_near(pcm, hw_params, &buffer_size)) < 0
+			|| buffer_size < 2 * alsa_period_size) {
+		error_print("ALSA %s device does not support a buffer of %d periods, nearest is %d frames\n", name,
+				g_alsa_periods, (int)buffer_size);
+		snd_pcm_hw_params_free(hw_params);
+		return EXIT_FAILURE;
+	}
+	alsa_buffer_size[stream] = buffer_size;
+	err = snd_pcm_hw_params(pcm, hw_params);
+	snd_pcm_hw_params_free(hw_params);
+	if (err < 0) {
+		error_print("Could not set ALSA %s parameters: %s\n", name, snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+
+	/* Wake us once per period.  We start the streams ourselves in alsa_audio_start() */
+	snd_pcm_sw_params_malloc(&sw_params);
+	snd_pcm_sw_params_current(pcm, sw_params);
+	snd_pcm_sw_params_set_avail_min(pcm, sw_params, alsa_period_size);
+	snd_pcm_sw_params_set_start_threshold(pcm, sw_params, buffer_size * 2);
+	err = snd_pcm_sw_params(pcm, sw_params);
+	snd_pcm_sw_params_free(sw_params);
+	if (err < 0) {
+		error_print("Could not set ALSA %s software parameters: %s\n", name, snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Return a pointer to the sample for this channel and frame in an mmap area
+ */
+static inline void *alsa_sample_addr(const snd_pcm_channel_area_t *area, snd_pcm_uframes_t frame) {
+	return (char *)area->addr + (area->first + frame * area->step) / 8;
+}
+
+/*
+ * Copy one period from the first capture channel.  The mmap area can wrap at the end of
+ * the DMA buffer, so it may take two passes.  Returns 0 or a negative ALSA error.
+ */
+int alsa_audio_read_period(jack_default_audio_sample_t *in) {
+	snd_pcm_uframes_t done = 0;
+	while (done < alsa_period_size) {
+		const snd_pcm_channel_area_t *areas;
+		snd_pcm_uframes_t offset;
+		snd_pcm_uframes_t frames = alsa_period_size - done;
+		int err = snd_pcm_mmap_begin(capture_pcm, &areas, &offset, &frames);
+		if (err < 0)
+			return err;
+		if (alsa_format[SND_PCM_STREAM_CAPTURE] == SND_PCM_FORMAT_FLOAT_LE) {
+			for (snd_pcm_uframes_t i=0; i < frames; i++)
+				in[done + i] = *(float *)alsa_sample_addr(&areas[0], offset + i);
+		} else {
+			for (snd_pcm_uframes_t i=0; i < frames; i++)
+				in[done + i] = *(int16_t *)alsa_sample_addr(&areas[0], offset + i) / 32768.0f;
+		}
+		snd_pcm_sframes_t committed = snd_pcm_mmap_commit(capture_pcm, offset, frames);
+		if (committed < 0)
+			return committed;
+		done += committed;
+	}
+	return 0;
+}
+
+/*
+ * Write one period to every playback channel.  Returns 0 or a negative ALSA error.
+ */
+int alsa_audio_write_period(jack_default_audio_sample_t *out) {
+	snd_pcm_uframes_t done = 0;
+	unsigned int channels = alsa_channels[SND_PCM_STREAM_PLAYBACK];
+	while (done < alsa_period_size) {
+		const snd_pcm_channel_area_t *areas;
+		snd_pcm_uframes_t offset;
+		snd_pcm_uframes_t frames = alsa_period_size - done;
+		int err = snd_pcm_mmap_begin(playback_pcm, &areas, &offset, &frames);
+		if (err < 0)
+			return err;
+		if (frames == 0) {
+			/* The buffer is full.  Wait for the card to play some, rather than spin at SCHED_FIFO */
+			snd_pcm_sframes_t avail = snd_pcm_avail_update(playback_pcm);
+			if (avail < 0)
+				return avail;
+			if (avail == 0) {
+				err = snd_pcm_wait(playback_pcm, ALSA_WRITE_TIMEOUT_MS);
+				if (err < 0)
+					return err;
+				if (err == 0)
+					return -EPIPE; // no space after a timeout, so restart the streams as for an xrun
+			}
+			continue;
+		}
+		for (unsigned int c=0; c < channels; c++) {
+			if (alsa_format[SND_PCM_STREAM_PLAYBACK] == SND_PCM_FORMAT_FLOAT_LE) {
+				for (snd_pcm_uframes_t i=0; i < frames; i++)
+					*(float *)alsa_sample_addr(&areas[c], offset + i) = out[done + i];
+			} else {
+				for (snd_pcm_uframes_t i=0; i < frames; i++) {
+					float value = out[done + i];
+					if (value > 32767.0f/32768.0f) value = 32767.0f/32768.0f;
+					if (value < -1.0f) value = -1.0f;
+					*(int16_t *)alsa_sample_addr(&areas[c], offset + i) = (int16_t)(value * 32768.0f);
+				}
+			}
+		}
+		snd_pcm_sframes_t committed = snd_pcm_mmap_commit(playback_pcm, offset, frames);
+		if (committed < 0)
+			return committed;
+		done += committed;
+	}
+	return 0;
+}
+
+/*
+ * Fill the playback buffer with silence before the streams are started.  Only whole periods are
+ * written, so a buffer that is not a multiple of the period is never overfilled
+ */
+int alsa_audio_write_silence(snd_pcm_uframes_t frames) {
+	jack_default_audio_sample_t silence[PERIOD_SIZE];
+	memset(silence, 0, sizeof(silence));
+	for (snd_pcm_uframes_t i=0; i + alsa_period_size <= frames; i += alsa_period_size) {
+		int err = alsa_audio_write_period(silence);
+		if (err < 0)
+			return err;
+	}
+	return 0;
+}
+
+/*
+ * Count the xrun and restart both streams with a fresh buffer of silence
+ */
+int alsa_audio_recover(snd_pcm_t *pcm, int err) {
+	if (err == -EPIPE || err == -ESTRPIPE) {
+		xruns++;
+		snd_pcm_drop(capture_pcm);
+		snd_pcm_drop(playback_pcm);
+		snd_pcm_prepare(capture_pcm);
+		snd_pcm_prepare(playback_pcm);
+		if ((err = alsa_audio_write_silence(alsa_buffer_size[SND_PCM_STREAM_PLAYBACK])) < 0)
+			return err;
+		if (!alsa_linked)
+			snd_pcm_start(playback_pcm);
+		return snd_pcm_start(capture_pcm);
+	}
+	return snd_pcm_recover(pcm, err, 0);
+}
+
+/*
+ * The realtime audio thread.  This is the equivalent of process_audio() in the jack backend.
+ */
+void *alsa_audio_process(void *arg) {
+	static jack_default_audio_sample_t in[PERIOD_SIZE];
+	static jack_default_audio_sample_t out[PERIOD_SIZE];
+
+	while (__atomic_load_n(&alsa_running, __ATOMIC_RELAXED)) {
+		int err = snd_pcm_wait(capture_pcm, 1000);
+		if (err < 0) {
+			if (alsa_audio_recover(capture_pcm, err) < 0)
+				break;
+			continue;
+		}
+		snd_pcm_sframes_t avail = snd_pcm_avail_update(capture_pcm);
+		if (avail < 0) {
+			if (alsa_audio_recover(capture_pcm, avail) < 0)
+				break;
+			continue;
+		}
+		if (avail < (snd_pcm_sframes_t)alsa_period_size)
+			continue;
+
+		if ((err = alsa_audio_read_period(in)) < 0) {
+			if (alsa_audio_recover(capture_pcm, err) < 0)
+				break;
+			continue;
+		}
+
+		alsa_process_callback(in, out, alsa_period_size);
+
+		if ((err = alsa_audio_write_period(out)) < 0) {
+			if (alsa_audio_recover(playback_pcm, err) < 0)
+				break;
+		}
+	}
+	if (__atomic_load_n(&alsa_running, __ATOMIC_RELAXED))
+		rt_error_print("ALSA audio thread stopped after an unrecoverable error\n");
+	return NULL;
+}
+
+/*
+ * Fill the playback buffer, start the streams and then start the audio thread at
+ * SCHED_FIFO.  If we do not have permission for realtime scheduling then we warn
+ * and run at normal priority.
+ */
+int alsa_audio_start(void) {
+	int err;
+	if ((err = snd_pcm_prepare(playback_pcm)) < 0 || (err = snd_pcm_prepare(capture_pcm)) < 0) {
+		error_print("Could not prepare the ALSA device: %s\n", snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+	if ((err = alsa_audio_write_silence(alsa_buffer_size[SND_PCM_STREAM_PLAYBACK])) < 0) {
+		error_print("Could not write to the ALSA playback buffer: %s\n", snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+
+	pthread_attr_t attr;
+	struct sched_param param;
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+	param.sched_priority = g_alsa_rt_priority;
+	pthread_attr_setschedparam(&attr, &param);
+
+	__atomic_store_n(&alsa_running, true, __ATOMIC_RELAXED);
+	if (!alsa_linked)
+		snd_pcm_start(playback_pcm);
+	if ((err = snd_pcm_start(capture_pcm)) < 0) {
+		error_print("Could not start the ALSA device: %s\n", snd_strerror(err));
+		__atomic_store_n(&alsa_running, false, __ATOMIC_RELAXED);
+		return EXIT_FAILURE;
+	}
+	int rc = pthread_create(&alsa_pthread, &attr, alsa_audio_process, NULL);
+	if (rc == EPERM) {
+		error_print("No permission for SCHED_FIFO, running the ALSA audio thread at normal priority\n");
+		rc = pthread_create(&alsa_pthread, NULL, alsa_audio_process, NULL);
+	}
+	pthread_attr_destroy(&attr);
+	if (rc != EXIT_SUCCESS) {
+		error_print("Could not start the ALSA audio thread\n");
+		__atomic_store_n(&alsa_running, false, __ATOMIC_RELAXED);
+		return EXIT_FAILURE;
+	}
+	alsa_thread_started = true;
+	return EXIT_SUCCESS;
+}
+
+int alsa_audio_stop(void) {
+	__atomic_store_n(&alsa_running, false, __ATOMIC_RELAXED);
+	if (alsa_thread_started) {
+		pthread_join(alsa_pthread, NULL);
+		alsa_thread_started = false;
+	}
+	if (capture_pcm != NULL) {
+		snd_pcm_drop(capture_pcm);
+		snd_pcm_close(capture_pcm);
+		capture_pcm = NULL;
+	}
+	if (playback_pcm != NULL) {
+		snd_pcm_drop(playback_pcm);
+		snd_pcm_close(playback_pcm);
+		playback_pcm = NULL;
+	}
+	debug_print("ALSA device closed\n");
+	return EXIT_SUCCESS;
+}
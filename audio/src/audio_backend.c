@@ -0,0 +1,103 @@
+/*
+ * audio_backend.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Keeps the list of audio backends and forwards calls to the one selected
+ * at startup.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_processor.h"
+#include "audio_backend.h"
+#include "jack_audio.h"
+#include "file_audio.h"
+#include "alsa_audio.h"
+
+audio_backend_t *audio_backends[] = {
+		&jack_audio_backend,
+		&alsa_audio_backend,
+		&file_audio_backend,
+		&null_audio_backend,
+		NULL
+};
+
+audio_backend_t *selected_backend = &jack_audio_backend;
+
+int audio_backend_select(char *name) {
+	for (int i=0; audio_backends[i] != NULL; i++) {
+		if (strcmp(audio_backends[i]->name, name) == 0) {
+			selected_backend = audio_backends[i];
+			return EXIT_SUCCESS;
+		}
+	}
+	error_print("No audio backend called: %s\n", name);
+	return EXIT_FAILURE;
+}
+
+audio_backend_t *audio_backend_get() { return selected_backend; }
+
+int audio_backend_start() {
+	verbose_print("Starting %s audio backend\n", selected_backend->name);
+	int rc = selected_backend->open(audio_loop);
+	if (rc != EXIT_SUCCESS)
+		return rc;
+	if (selected_backend->get_sample_rate() != g_sample_rate) {
+		error_print("Backend sample rate %d does not match the configured rate %d\n",
+				selected_backend->get_sample_rate(), g_sample_rate);
+		selected_backend->stop();
+		return EXIT_FAILURE;
+	}
+	if (selected_backend->get_buffer_size() != PERIOD_SIZE) {
+		error_print("Backend period of %d frames does not match PERIOD_SIZE %d\n",
+				selected_backend->get_buffer_size(), PERIOD_SIZE);
+		selected_backend->stop();
+		return EXIT_FAILURE;
+	}
+	return selected_backend->start();
+}
+
+int audio_backend_stop() {
+	return selected_backend->stop();
+}
+
+int audio_backend_is_continuous() {
+	return selected_backend->wait == NULL;
+}
+
+int audio_backend_wait() {
+	if (selected_backend->wait == NULL)
+		return EXIT_SUCCESS;
+	return selected_backend->wait();
+}
+
+int get_xruns_since_start() {
+	return selected_backend->get_xruns();
+}
+
+void audio_backend_print_list() {
+	for (int i=0; audio_backends[i] != NULL; i++)
+		printf("%s%s", i ? "|" : "", audio_backends[i]->name);
+}
@@ -0,0 +1,177 @@
+/*
+ * audio_perf.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Per stage timing of the audio loop.  The audio thread is the only writer.  It
+ * collects the time for each stage during a period and publishes them all at the
+ * end of the period under a sequence lock.  Readers copy the stats and retry if
+ * the sequence number changed while they were copying, so the audio thread never
+ * waits for the console.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_perf.h"
+
+/* Forward function declarations */
+void audio_perf_record(audio_perf_stage_t stage, uint64_t ns);
+
+char *audio_perf_stage_names[PERF_NUM_STAGES] = {
+		"decimate filter",
+		"decimate",
+		"high pass filter",
+		"modulate bits",
+		"interpolate",
+		"interpolate filter",
+		"high speed modulate",
+		"total"
+};
+
+/* Written only by the audio thread */
+uint64_t period_ns[PERF_NUM_STAGES]; /* time spent in each stage so far this period */
+int period_ran[PERF_NUM_STAGES];     /* true if the stage ran this period */
+
+/* Published stats, protected by the sequence number.  Odd means an update is in progress */
+latency_histogram_t perf_stats[PERF_NUM_STAGES];
+uint32_t perf_seq = 0;
+int perf_reset_requested = false;
+
+char *audio_perf_stage_name(audio_perf_stage_t stage) { return audio_perf_stage_names[stage]; }
+
+uint64_t audio_perf_stage(audio_perf_stage_t stage, uint64_t start_ns) {
+	uint64_t now = audio_perf_now();
+	audio_perf_record(stage, now - start_ns);
+	return now;
+}
+
+void audio_perf_record(audio_perf_stage_t stage, uint64_t ns) {
+	period_ns[stage] += ns;
+	period_ran[stage] = true;
+}
+
+/*
+ * Called by the audio thread at the end of each period.  Publish the stage times for this
+ * period.  This is the only place the published stats are written.
+ */
+void audio_perf_end_period() {
+	uint32_t seq = __atomic_load_n(&perf_seq, __ATOMIC_RELAXED);
+	__atomic_store_n(&perf_seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if (__atomic_exchange_n(&perf_reset_requested, false, __ATOMIC_ACQUIRE))
+		memset(perf_stats, 0, sizeof(perf_stats));
+	for (int s=0; s < PERF_NUM_STAGES; s++) {
+		if (!period_ran[s])
+			continue;
+		latency_histogram_record(&perf_stats[s], period_ns[s]);
+		period_ns[s] = 0;
+		period_ran[s] = false;
+	}
+
+	__atomic_store_n(&perf_seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Copy the stats.  If the audio thread published while we were copying then try again.
+ */
+void audio_perf_get_stats(latency_histogram_t stats[PERF_NUM_STAGES]) {
+	uint32_t seq1, seq2;
+	do {
+		seq1 = __atomic_load_n(&perf_seq, __ATOMIC_ACQUIRE);
+		if (seq1 & 1) {
+			sched_yield();
+			continue;
+		}
+		memcpy(stats, perf_stats, sizeof(perf_stats));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(&perf_seq, __ATOMIC_RELAXED);
+		if (seq1 == seq2)
+			break;
+	} while (true);
+}
+
+void audio_perf_reset() {
+	__atomic_store_n(&perf_reset_requested, true, __ATOMIC_RELEASE);
+}
+
+void audio_perf_print() {
+	latency_histogram_t stats[PERF_NUM_STAGES];
+	audio_perf_get_stats(stats);
+	printf("Audio loop stage times in microseconds over %d periods:\n", stats[PERF_TOTAL].count);
+	printf(" %-20s %10s %10s %10s\n", "stage", "mean", "p99", "max");
+	for (int s=0; s < PERF_NUM_STAGES; s++) {
+		if (stats[s].count == 0)
+			continue;
+		printf(" %-20s %10.1f %10.1f %10.1f\n", audio_perf_stage_names[s],
+				latency_histogram_mean(&stats[s]) / 1000.0,
+				latency_histogram_percentile(&stats[s], 99) / 1000.0,
+				stats[s].max_ns / 1000.0);
+	}
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_audio_perf() {
+	printf("TESTING audio_perf .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+
+	/* 99 periods of 10us and one of 1ms */
+	audio_perf_reset();
+	audio_perf_end_period();
+	for (int i=0; i < 100; i++) {
+		audio_perf_record(PERF_TOTAL, i == 50 ? 1000000 : 10000);
+		audio_perf_end_period();
+	}
+	latency_histogram_t stats[PERF_NUM_STAGES];
+	audio_perf_get_stats(stats);
+	double mean = latency_histogram_mean(&stats[PERF_TOTAL]);
+	double p50 = latency_histogram_percentile(&stats[PERF_TOTAL], 50);
+	double p99 = latency_histogram_percentile(&stats[PERF_TOTAL], 99);
+	verbose_print(" count %d mean %.0f p50 %.0f p99 %.0f max %d\n", stats[PERF_TOTAL].count, mean, p50, p99,
+			stats[PERF_TOTAL].max_ns);
+	if (stats[PERF_TOTAL].count != 100 || mean != 19900 || stats[PERF_TOTAL].max_ns != 1000000)
+		fail = EXIT_FAILURE;
+	if (p50 < 10000 || p50 > 10000 * 1.125 || p99 < 10000 || p99 > 10000 * 1.125)
+		fail = EXIT_FAILURE;
+	if (latency_histogram_percentile(&stats[PERF_TOTAL], 100) != 1000000)
+		fail = EXIT_FAILURE;
+	if (stats[PERF_HPF].count != 0)
+		fail = EXIT_FAILURE;
+
+	audio_perf_reset();
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -32,7 +32,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
-#include <iir_filter.h>
 #include <stdint.h>
 #include <math.h>
 #include <time.h>
@@ -43,26 +42,38 @@
 /* telem_radio includes */
 #include "config.h"
 #include "debug.h"
+#include "rt_log.h"
+#include "realtime.h"
 #include "audio_processor.h"
 #include "audio_tools.h"
 #include "cheby_iir_filter.h"
 #include "fir_filter.h"
 #include "oscillator.h"
 #include "dc_filter.h"
+#include "audio_perf.h"
+#include "loop_latency.h"
 
 #include "../../telem_send/inc/telem_processor.h"
 #include "../../telem_send/inc/telem_thread.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/frame_archive.h"
 
 /* Forward function declarations */
-double modulate_bit();
 jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
 		jack_default_audio_sample_t *out, jack_nframes_t nframes);
-int init_filters(int bit_rate, int decimation_rate);
+int init_pipeline(audio_pipeline_t *p, int mode, char *name, int bit_rate, int decimation_rate);
+int audio_pipeline_next_bit(void *arg);
+void audio_pipeline_start(audio_pipeline_t *p);
+void audio_processor_update_params();
+void audio_processor_update_pipeline();
+void audio_processor_reset_state();
+audio_pipeline_t *audio_processor_target_pipeline();
+void audio_processor_start_period(audio_pipeline_t *p);
+void audio_processor_archive_frame(audio_pipeline_t *p);
 
 /* Test tone parameters */
 #define OSC_TABLE_SIZE 9600
 double osc_phase = 0;
-double test_tone_freq = 5000.0f;
 double osc_sin_table[OSC_TABLE_SIZE];
 
 /* Tone measurement parameters */
@@ -71,54 +82,68 @@ int measurement_loops = 0;
 int measurements = 0;
 double peak_value = 0.0f;
 
-// audio filter variables
-#define DECIMATE_FILTER_LEN 480
-
-double decimate_filter_coeffs[DECIMATE_FILTER_LEN];
-double decimate_filter_xv[DECIMATE_FILTER_LEN];
-
-double interpolate_filter_coeffs[DECIMATE_FILTER_LEN];
-double interpolate_filter_xv[DECIMATE_FILTER_LEN];
-
-#define BIT_FILTER_LEN 180 // 60 is one bit.  Filter across 3 bits seems to be a good trade off
-double bit_filter_coeffs[BIT_FILTER_LEN];
-double bit_filter_xv[BIT_FILTER_LEN];
-
 double filtered_audio_buffer[PERIOD_SIZE]; // the audio samples after they are filtered by the decimation filter
 double decimated_audio_buffer[PERIOD_SIZE/4]; // the audio samples after decimation and decimation filter
 double hpf_decimated_audio_buffer[PERIOD_SIZE/4]; // the decimated audio samples after high pass filtering
 double interpolated_audio_buffer[PERIOD_SIZE]; // the audio samples after interpolation back to 48000 but before interpolation filter
+float burst_audio_buffer[PERIOD_SIZE]; // the high speed telemetry that is mixed with DUV in the combined mode
 
 TIIRCoeff Elliptic8Pole300HzHighPassIIRCoeff;
 TIIRCoeff Elliptic4Pole300HzHighPassIIRCoeff;
-TIIRStorage iir_hpf_store; // storage for the IIR High Pass filter
-
-/* Audio processor variables */
-int decimation_rate;
-
-/* Telemetry modulator settings */
-int samples_per_bit = 0; // this is calculated in the code.  For example it is 12000/200 = 60
-int samples_sent_for_current_bit = 0; // how many samples have we sent for the current bit
-int current_bit = 0; // the value of the current bit we are sending
-int starting_bit_modulator = true;
-
-/* User settings changeable from cmd console */
-int hpf = true; // filter the transponder audio
-int send_telem = true;
-int send_high_speed_telem = false;
-int send_test_telem = false; // send a 10101 test telem sequence
-int send_test_tone = false; // output a steady tone for measurement of a sound card
-int measure_test_tone = false; // display the peak ampltude of a received tone to measure the sound card
-int lpf_bits = true;  // filter the telem bits
+
+/*
+ * A pipeline for each mode, built when the audio processor is initialized, plus the burst pipeline
+ * that the combined mode mixes in.  The audio thread only uses the one that pipeline points to, so
+ * the others can not be disturbed by a change of mode.
+ */
+audio_pipeline_t pipelines[AUDIO_NUM_PIPELINES];
+audio_pipeline_t *pipeline = &pipelines[AUDIO_MODE_DUV];
+
+/*
+ * Mode switches.  The audio thread waits for the end of the frame that is being sent and then
+ * changes pipeline at the start of the next period.  Until then the modulator holds the last bit.
+ * In the combined mode both frames must end.  The burst is silent once its frame has ended.
+ */
+int pipeline_switch_pending = false; // the console asked for another mode
+uint64_t pipeline_switch_requested_ns = 0;
+uint64_t pipeline_switch_ns = 0; // when the last switch happened, so the period it was in can be timed
+int pipeline_switches = 0;
+uint64_t last_switch_wait_ns = 0; // from the request to the switch
+uint64_t last_switch_cost_ns = 0; // time to switch, inside the audio loop
+uint64_t last_switch_loop_ns = 0; // time for the whole period the switch was in
+
+/*
+ * User settings changeable from cmd console.  The console changes console_params and then
+ * publishes a copy.  There are three buffers.  The audio thread owns the front one and the
+ * console owns the back one.  Publishing swaps the back buffer with the middle one and marks it
+ * fresh.  At the start of each period the audio thread swaps a fresh middle buffer with the front
+ * one.  Each swap is one atomic exchange, so the audio thread never sees half of a change.
+ */
+#define PARAMS_FRESH 4 // set in params_middle when it holds a buffer the audio thread has not seen
+audio_params_t console_params = {
+		.hpf = true, // filter the transponder audio
+		.lpf_bits = true, // filter the telem bits
+		.send_telem = true,
+		.send_high_speed_telem = false,
+		.send_duv_with_high_speed = false,
+		.send_test_telem = false, // send a 10101 test telem sequence
+		.send_test_tone = false, // output a steady tone for measurement of a sound card
+		.measure_test_tone = false, // display the peak ampltude of a received tone to measure the sound card
+		.test_tone_freq = 5000.0f
+};
+audio_params_t params_buffer[3];
+int params_front = 0;  // only used by the audio thread
+int params_back = 1;   // only used by the console
+int params_middle = 2; // swapped by both
+audio_params_t *params = &params_buffer[0]; // the settings the audio thread is using this period
 
 /* Setup the test bit pattern.  Send this many bits in a row. */
 int TEST_BIT_NUMBER = 5;
-int test_bits_sent = 0;
 
-int zero_bits_in_a_row = 0;
-int one_bits_in_a_row = 0;
 int clipping_reported = 0;
 
+jack_nframes_t audio_frame_time = 0; // the frame time of the first sample of this period
+
 /* Audio loop timing variables */
 struct timespec ts_start, ts_end;
 double loop_time_microsec = 0.0;
@@ -132,47 +157,129 @@ double get_loop_time_microsec() { return loop_time_microsec; }
 double get_max_loop_time_microsec() { return max_loop_time_microsec; }
 double get_min_loop_time_microsec() { return min_loop_time_microsec; }
 
-int get_decimation_rate() { return decimation_rate; }
-int get_samples_per_bit() { return samples_per_bit; }
-double get_test_tone_freq() { return test_tone_freq; }
-int get_hpf() { return hpf; }
-int get_lpf_bits() { return lpf_bits; }
-int get_send_telem() { return send_telem; }
-int get_send_high_speed_telem() { return send_high_speed_telem; }
-int get_send_test_telem() { return send_test_telem; }
-int get_send_test_tone() { return send_test_tone; }
-int get_measure_test_tone() { return measure_test_tone; }
-
-void set_samples_per_bit(int val) { samples_per_bit = val; }
-void set_test_tone_freq(double val) { test_tone_freq = val; }
-void set_hpf(int val) { hpf = val; }
-void set_lpf_bits(int val) { lpf_bits = val; }
-void set_send_telem(int val) { send_telem = val; }
-void set_send_high_speed_telem(int val) { send_high_speed_telem = val; }
-void set_send_test_telem(int val) { send_test_telem = val; }
-void set_send_test_tone(int val) { send_test_tone = val; }
-void set_measure_test_tone(int val) { measure_test_tone = val; }
+int get_decimation_rate() { return __atomic_load_n(&pipeline, __ATOMIC_ACQUIRE)->decimation_rate; }
+double get_samples_per_bit() { return __atomic_load_n(&pipeline, __ATOMIC_ACQUIRE)->samples_per_bit; }
+double get_test_tone_freq() { return console_params.test_tone_freq; }
+int get_hpf() { return console_params.hpf; }
+int get_lpf_bits() { return console_params.lpf_bits; }
+int get_send_telem() { return console_params.send_telem; }
+int get_send_high_speed_telem() { return console_params.send_high_speed_telem; }
+int get_send_duv_with_high_speed() { return console_params.send_duv_with_high_speed; }
+int get_send_test_telem() { return console_params.send_test_telem; }
+int get_send_test_tone() { return console_params.send_test_tone; }
+int get_measure_test_tone() { return console_params.measure_test_tone; }
+
+void set_test_tone_freq(double val) { console_params.test_tone_freq = val; }
+void set_hpf(int val) { console_params.hpf = val; }
+void set_lpf_bits(int val) { console_params.lpf_bits = val; }
+void set_send_telem(int val) { console_params.send_telem = val; }
+void set_send_high_speed_telem(int val) { console_params.send_high_speed_telem = val; }
+void set_send_duv_with_high_speed(int val) { console_params.send_duv_with_high_speed = val; }
+void set_send_test_telem(int val) { console_params.send_test_telem = val; }
+void set_send_test_tone(int val) { console_params.send_test_tone = val; }
+void set_measure_test_tone(int val) { console_params.measure_test_tone = val; }
 
 /*
- * This initializes the audio processor and should be called when it is first started
+ * Called from the console after it has changed the settings.  All of the changes since the
+ * last call are picked up together by the audio thread at the start of its next period.
  */
-int init_audio_processor(int bit_rate, int dec_rate) {
+void audio_processor_publish_params() {
+	params_buffer[params_back] = console_params;
+	params_back = __atomic_exchange_n(&params_middle, params_back | PARAMS_FRESH, __ATOMIC_ACQ_REL) & ~PARAMS_FRESH;
+}
+
+/*
+ * Called by the audio thread at the start of each period.  If the console has published new
+ * settings then swap them in.
+ */
+void audio_processor_update_params() {
+	if (!(__atomic_load_n(&params_middle, __ATOMIC_RELAXED) & PARAMS_FRESH))
+		return;
+	params_front = __atomic_exchange_n(&params_middle, params_front, __ATOMIC_ACQ_REL) & ~PARAMS_FRESH;
+	params = &params_buffer[params_front];
+}
+
+/* The pipeline for the mode the settings ask for */
+audio_pipeline_t *audio_processor_target_pipeline() {
+	if (!params->send_high_speed_telem)
+		return &pipelines[AUDIO_MODE_DUV];
+	return &pipelines[params->send_duv_with_high_speed ? AUDIO_MODE_COMBINED : AUDIO_MODE_HIGH_SPEED];
+}
+
+/*
+ * Called by the audio thread at the start of each period, after the params are updated.  If the
+ * settings ask for another mode then switch pipeline once the current frame has been sent.  If
+ * no telemetry is being sent there is no frame to wait for.
+ */
+void audio_processor_update_pipeline() {
+	audio_pipeline_t *target = audio_processor_target_pipeline();
+	if (target == pipeline) {
+		pipeline_switch_pending = false; // the console changed its mind before the frame ended
+		pipeline->switch_ready = false;
+		if (pipeline->burst != NULL)
+			pipeline->burst->switch_ready = false;
+		return;
+	}
+	uint64_t now = audio_perf_now();
+	if (!pipeline_switch_pending) {
+		pipeline_switch_pending = true;
+		pipeline_switch_requested_ns = now;
+	}
+	int ready = pipeline->switch_ready && (pipeline->burst == NULL || pipeline->burst->switch_ready);
+	if (!ready && params->send_telem && !params->send_test_telem)
+		return;
+
+	audio_pipeline_start(target);
+	__atomic_store_n(&pipeline, target, __ATOMIC_RELEASE);
+	pipeline_switch_pending = false;
+	pipeline_switch_ns = audio_perf_now();
+	__atomic_store_n(&last_switch_cost_ns, pipeline_switch_ns - now, __ATOMIC_RELAXED);
+	__atomic_store_n(&last_switch_wait_ns, pipeline_switch_ns - pipeline_switch_requested_ns, __ATOMIC_RELAXED);
+	__atomic_store_n(&pipeline_switches, pipeline_switches + 1, __ATOMIC_RELAXED);
+	rt_verbose_print("Switched to %s after %.1f ms\n", target->name, last_switch_wait_ns / 1000000.0);
+}
+
+/*
+ * This initializes the audio processor and should be called when it is first started.  It builds
+ * the pipeline for each mode and starts in the mode given by the settings.
+ */
+int init_audio_processor() {
 	// Init
 	int rc;
-	decimation_rate = dec_rate;
 
-	rc = init_bit_modulator(bit_rate, decimation_rate);
+	/* now we know the sample rate then setup things that are dependent on that */
+	rc = init_pipeline(&pipelines[AUDIO_MODE_DUV], AUDIO_MODE_DUV, "DUV", g_duv_bit_rate, DUV_DECIMATION_RATE);
 	if (rc != 0) {
-		error_print("Error initializing bit modulator\n");
+		error_print("Error initializing the DUV pipeline\n");
+		return rc;
+	}
+	rc = init_pipeline(&pipelines[AUDIO_MODE_HIGH_SPEED], AUDIO_MODE_HIGH_SPEED, "High Speed", g_high_speed_bit_rate, 1);
+	if (rc != 0) {
+		error_print("Error initializing the high speed pipeline\n");
 		return rc;
 	}
 
-	/* now we know the sample rate then setup things that are dependent on that */
-	rc = init_filters(bit_rate, decimation_rate);
+	/* The combined mode is a DUV pipeline with a high speed pipeline that sends the burst stream */
+	rc = init_pipeline(&pipelines[AUDIO_MODE_COMBINED], AUDIO_MODE_COMBINED, "DUV with High Speed", g_duv_bit_rate,
+			DUV_DECIMATION_RATE);
+	if (rc == 0)
+		rc = init_pipeline(&pipelines[AUDIO_PIPELINE_BURST], AUDIO_MODE_HIGH_SPEED, "High Speed burst",
+				g_high_speed_bit_rate, 1);
 	if (rc != 0) {
-		error_print("Error initializing filters\n");
+		error_print("Error initializing the combined pipeline\n");
 		return rc;
 	}
+	pipelines[AUDIO_MODE_COMBINED].burst = &pipelines[AUDIO_PIPELINE_BURST];
+	pipelines[AUDIO_PIPELINE_BURST].stream = telem_processor_stream(TELEM_STREAM_BURST);
+
+	/* The audio is not running yet, so apply the settings now */
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	pipeline = audio_processor_target_pipeline();
+	audio_pipeline_start(pipeline);
+	pipeline_switch_pending = false;
+
+	loop_latency_init();
 
 	/* Initialize a sine table in the oscillator */
 	rc = gen_cos_table(osc_sin_table, OSC_TABLE_SIZE);
@@ -183,26 +290,71 @@ int init_audio_processor(int bit_rate, int dec_rate) {
 }
 
 /*
- * This is called at startup to populate the coefficients for digital filters
+ * Write to every buffer used by the audio loop so that the pages are resident before it runs.
+ * This is called by realtime_init() after the memory is locked.
  */
-int init_filters(int bit_rate, int decimation_rate) {
-	verbose_print("Generating filters ..\n");
+void audio_processor_touch_buffers() {
+	memset(filtered_audio_buffer, 0, sizeof(filtered_audio_buffer));
+	memset(decimated_audio_buffer, 0, sizeof(decimated_audio_buffer));
+	memset(hpf_decimated_audio_buffer, 0, sizeof(hpf_decimated_audio_buffer));
+	memset(interpolated_audio_buffer, 0, sizeof(interpolated_audio_buffer));
+	memset(burst_audio_buffer, 0, sizeof(burst_audio_buffer));
+	for (int m=0; m < AUDIO_NUM_PIPELINES; m++)
+		audio_pipeline_start(&pipelines[m]);
+}
+
+/*
+ * Clear the filter history and restart the modulator, and the burst pipeline if there is one.
+ * This is called by the audio thread as it switches to a pipeline, so it only clears memory and
+ * does not calculate anything.  The telemetry streams carry on from where they were.
+ */
+void audio_pipeline_start(audio_pipeline_t *p) {
+	memset(p->decimate_filter_xv, 0, sizeof(p->decimate_filter_xv));
+	memset(p->interpolate_filter_xv, 0, sizeof(p->interpolate_filter_xv));
+	memset(p->bit_filter_xv, 0, sizeof(p->bit_filter_xv));
+	for(int i=0; i<ARRAY_DIM; i++) {
+		p->iir_hpf_store.RegX1[i] = 0.0;
+		p->iir_hpf_store.RegX2[i] = 0.0;
+		p->iir_hpf_store.RegY1[i] = 0.0;
+		p->iir_hpf_store.RegY2[i] = 0.0;
+	}
+	p->starting_bit_modulator = true;
+	p->current_bit = 0;
+	p->bit_phase = 0;
+	p->one_bits_in_a_row = 0;
+	p->zero_bits_in_a_row = 0;
+	p->test_bits_sent = 0;
+	p->switch_ready = false;
+	p->frames_archived = p->stream->frames_started;
+	if (p->fsk.modulation != FSK_NRZ)
+		fsk_modulator_start(&p->fsk);
+	if (p->burst != NULL)
+		audio_pipeline_start(p->burst);
+}
+
+/*
+ * This is called at startup to populate the coefficients for the digital filters of a pipeline
+ */
+int init_pipeline(audio_pipeline_t *p, int mode, char *name, int bit_rate, int decimation_rate) {
+	verbose_print("Generating filters for %s ..\n", name);
+	p->name = name;
+	p->mode = mode;
+	p->bit_rate = bit_rate;
+	p->decimation_rate = decimation_rate;
+	p->samples_per_bit = (double)g_sample_rate / decimation_rate / bit_rate;
+	p->bit_phase_step = bit_rate * decimation_rate;
+	p->bit_phase_wrap = g_sample_rate;
+	p->stream = telem_processor_stream(TELEM_STREAM_MAIN);
+	p->burst = NULL;
 
 	/* Decimation filter */
 	int decimation_cutoff_freq = g_sample_rate / (2* decimation_rate);
-	int rc = gen_raised_cosine_coeffs(decimate_filter_coeffs, g_sample_rate, decimation_cutoff_freq, 0.5f, DECIMATE_FILTER_LEN);
-	for (int i=0; i< DECIMATE_FILTER_LEN; i++) decimate_filter_xv[i] = 0;
+	int rc = gen_raised_cosine_coeffs(p->decimate_filter_coeffs, g_sample_rate, decimation_cutoff_freq, 0.5f, DECIMATE_FILTER_LEN);
 
 	if (rc != 0)
 		return rc;
 
-	iir_hpf_store.MaxRegVal = 1.0E-12;
-	for(int i=0; i<ARRAY_DIM; i++) {
-		iir_hpf_store.RegX1[i] = 0.0;
-		iir_hpf_store.RegX2[i] = 0.0;
-		iir_hpf_store.RegY1[i] = 0.0;
-		iir_hpf_store.RegY2[i] = 0.0;
-	}
+	p->iir_hpf_store.MaxRegVal = 1.0E-12;
 
 	/*
 	 * Note that the IIR filters are tied to a decimated sample rate of 12kHz and need to be redefined if the
@@ -243,63 +395,141 @@ int init_filters(int bit_rate, int decimation_rate) {
 
 	/* Interpolation filter */
 	int interpolation_cutoff_freq = g_sample_rate / (2* decimation_rate);
-	for (int i=0; i< DECIMATE_FILTER_LEN; i++) interpolate_filter_xv[i] = 0;
-	rc = gen_raised_cosine_coeffs(interpolate_filter_coeffs, g_sample_rate, interpolation_cutoff_freq, 0.5f, DECIMATE_FILTER_LEN);
+	rc = gen_raised_cosine_coeffs(p->interpolate_filter_coeffs, g_sample_rate, interpolation_cutoff_freq, 0.5f, DECIMATE_FILTER_LEN);
 	if (rc != 0)
 		return rc;
 
-	/* Bit shape filter */
-	for (int i=0; i< BIT_FILTER_LEN; i++) bit_filter_xv[i] = 0;
-	// TODO HIGH SPEED
-//////	rc = gen_raised_cosine_coeffs(bit_filter_coeffs, g_sample_rate, bit_rate, 0.5f, BIT_FILTER_LEN);
-	rc = gen_raised_cosine_coeffs(bit_filter_coeffs, g_sample_rate/decimation_rate, bit_rate, 0.5f, BIT_FILTER_LEN);
+	/* Bit shape filter, designed for the bit rate and sample rate of this pipeline */
+	rc = gen_raised_cosine_coeffs(p->bit_filter_coeffs, g_sample_rate/decimation_rate, bit_rate, 0.5f, BIT_FILTER_LEN);
+	if (rc != 0)
+		return rc;
+
+	/* High speed telemetry can be sent as FSK tones instead of levels */
+	p->fsk.modulation = FSK_NRZ;
+	if (mode == AUDIO_MODE_HIGH_SPEED) {
+		int modulation = fsk_modulation_type(g_high_speed_modulation);
+		if (modulation < 0) {
+			error_print("Unknown high speed modulation %s\n", g_high_speed_modulation);
+			return EXIT_FAILURE;
+		}
+		if (modulation != FSK_NRZ) {
+			rc = fsk_modulator_init(&p->fsk, modulation, bit_rate, g_sample_rate, g_fsk_mark_freq, g_fsk_space_freq,
+					g_gfsk_bt, g_one_value, audio_pipeline_next_bit, p);
+			if (rc != 0)
+				return rc;
+		}
+	}
 
+	audio_pipeline_start(p);
 	return rc;
 }
 /*
- * Turn the bit stream into samples that can be fed into the audio loop
+ * Get the next bit for the pipeline, unless the frame is finished and the mode is about to change.
  */
-double modulate_bit() {
-	if (starting_bit_modulator ||  // starting a new packet
-			(samples_sent_for_current_bit >= samples_per_bit )) { // We are starting a new bit
-		samples_sent_for_current_bit = 0;
-		starting_bit_modulator = false;
-		if (send_test_telem) {
-			test_bits_sent++;
-			if (test_bits_sent == TEST_BIT_NUMBER) {
-				current_bit = !current_bit; // TESTING - just toggle the bit to generate tone
-				test_bits_sent = 0;
-			}
-		} else
-			current_bit = get_next_bit();
-
-		if (current_bit) {
-			one_bits_in_a_row++;
-			zero_bits_in_a_row = 0;
-		} else {
-			one_bits_in_a_row = 0;
-			zero_bits_in_a_row++;
+static inline __attribute__((always_inline)) void modulate_next_bit(audio_pipeline_t *p) {
+	if (pipeline_switch_pending && !params->send_test_telem && telem_stream_at_frame_boundary(p->stream)) {
+		/* The frame is finished.  Hold this bit until the other pipeline takes over */
+		p->switch_ready = true;
+		return;
+	}
+	if (params->send_test_telem) {
+		p->test_bits_sent++;
+		if (p->test_bits_sent == TEST_BIT_NUMBER) {
+			p->current_bit = !p->current_bit; // TESTING - just toggle the bit to generate tone
+			p->test_bits_sent = 0;
 		}
+	} else {
+		p->current_bit = telem_stream_read_bit(p->stream);
+		if (p->stream->frames_started != p->frames_archived)
+			audio_processor_archive_frame(p);
+	}
+
+	if (p->current_bit) {
+		p->one_bits_in_a_row++;
+		p->zero_bits_in_a_row = 0;
+	} else {
+		p->one_bits_in_a_row = 0;
+		p->zero_bits_in_a_row++;
+	}
+}
+
+/* The audio level for the current bit */
+static inline __attribute__((always_inline)) double modulate_bit_level(audio_pipeline_t *p, int ramp) {
+	double bit_audio_value = p->current_bit ? g_one_value : g_zero_value;
+	if (ramp) {
+		if (p->one_bits_in_a_row) bit_audio_value = bit_audio_value + (p->one_bits_in_a_row-1) * g_ramp_amount;
+		if (p->zero_bits_in_a_row) bit_audio_value = bit_audio_value - (p->zero_bits_in_a_row-1) * g_ramp_amount;
+	}
+	return bit_audio_value;
+}
+
+/*
+ * Turn the bit stream into samples that can be fed into the audio loop.  This is always
+ * inlined.  When lpf and ramp are constants the compiler removes the tests for them, which
+ * is how the specialized audio loops below are built.
+ */
+static inline __attribute__((always_inline)) double modulate_bit_body(audio_pipeline_t *p, int lpf, int ramp) {
+	if (p->starting_bit_modulator) { // starting a new packet
+		p->starting_bit_modulator = false;
+		p->bit_phase = 0;
+		modulate_next_bit(p);
 	}
-	samples_sent_for_current_bit++;
-	double bit_audio_value = current_bit ? g_one_value : g_zero_value;
-	if (!send_high_speed_telem && g_ramp_bits_to_compensate_hpf) {
-		if (one_bits_in_a_row) bit_audio_value = bit_audio_value + (one_bits_in_a_row-1) * g_ramp_amount;
-		if (zero_bits_in_a_row) bit_audio_value = bit_audio_value - (zero_bits_in_a_row-1) * g_ramp_amount;
+	double bit_audio_value = modulate_bit_level(p, ramp);
+
+	/*
+	 * The symbol clock.  Each sample moves the phase on by the bit rate and a bit lasts for the
+	 * sample rate, so the bits stay in step with the samples for any bit rate.  If a bit ends part
+	 * way through this sample then the sample is shared between the two bits in proportion.  When
+	 * the samples per bit is a whole number a bit always ends at the end of a sample.
+	 */
+	p->bit_phase += p->bit_phase_step;
+	if (p->bit_phase >= p->bit_phase_wrap && !p->switch_ready) {
+		p->bit_phase -= p->bit_phase_wrap;
+		modulate_next_bit(p);
+		if (p->bit_phase != 0 && !p->switch_ready) {
+			double fraction = (double)p->bit_phase / p->bit_phase_step; // the part of this sample in the new bit
+			bit_audio_value += fraction * (modulate_bit_level(p, ramp) - bit_audio_value);
+		}
 	}
 
-	if (lpf_bits)
-		bit_audio_value = fir_filter(bit_audio_value, bit_filter_coeffs, bit_filter_xv, BIT_FILTER_LEN);
+	if (lpf)
+		bit_audio_value = fir_filter(bit_audio_value, p->bit_filter_coeffs, p->bit_filter_xv, BIT_FILTER_LEN);
 
 	return bit_audio_value;
 }
 
-int init_bit_modulator(int bit_rate, int decimation_rate) {
-	starting_bit_modulator = true;
-	current_bit = 0;
-	samples_sent_for_current_bit = 0;
-	samples_per_bit = g_sample_rate / decimation_rate / bit_rate;
-	return EXIT_SUCCESS;
+/*
+ * A new frame has started.  Record it with the frame time of the first sample of its sync word,
+ * which is worked out from the bits sent this period, so it is correct to within a bit
+ */
+void audio_processor_archive_frame(audio_pipeline_t *p) {
+	telem_stream_t *s = p->stream;
+	p->frames_archived = s->frames_started;
+	int32_t bits = s->frame_start_bit - p->period_start_bit; // the sync word may have started last period
+	jack_nframes_t frame_time = audio_frame_time + (int32_t)lround(bits * p->samples_per_bit * p->decimation_rate);
+	frame_archive_push(s->id, frame_time, s->packed_packet[s->current_encoded_packet_num]);
+}
+
+/* Note where the stream is at the start of the period, so the time of each frame can be found */
+void audio_processor_start_period(audio_pipeline_t *p) {
+	p->period_start_bit = p->stream->bits_sent;
+	if (p->burst != NULL)
+		audio_processor_start_period(p->burst);
+}
+
+void audio_processor_set_frame_time(jack_nframes_t frame_time) {
+	audio_frame_time = frame_time;
+}
+
+/* Called by the FSK modulator at the start of each bit */
+int audio_pipeline_next_bit(void *arg) {
+	audio_pipeline_t *p = arg;
+	modulate_next_bit(p);
+	return p->current_bit;
+}
+
+double modulate_bit() {
+	return modulate_bit_body(pipeline, params->lpf_bits, pipeline->mode != AUDIO_MODE_HIGH_SPEED && g_ramp_bits_to_compensate_hpf);
 }
 
 jack_default_audio_sample_t * telem_only_audio_loop(jack_default_audio_sample_t *in,
@@ -307,7 +537,7 @@ jack_default_audio_sample_t * telem_only_audio_loop(jack_default_audio_sample_t
 
 
 	for (int i = 0; i< nframes; i++) {
-		if (send_telem) {
+		if (params->send_telem) {
 			float bit_audio_value = modulate_bit();
 			out[i] = bit_audio_value; // add the telemetry
 		} else {
@@ -317,39 +547,63 @@ jack_default_audio_sample_t * telem_only_audio_loop(jack_default_audio_sample_t
 	return out;
 }
 
-jack_default_audio_sample_t * high_speed_telem_audio_loop(jack_default_audio_sample_t *in,
-		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
-
+static inline __attribute__((always_inline)) jack_default_audio_sample_t * high_speed_telem_audio_loop_body(
+		jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, jack_nframes_t nframes,
+		int telem, int lpf) {
 
-	if (send_telem) {
+	uint64_t t = audio_perf_now();
+	if (telem) {
 		for (int i = 0; i< nframes; i++) {
-			float bit_audio_value = modulate_bit();
+			float bit_audio_value = modulate_bit_body(pipeline, lpf, false); // no ramp at high speed
 			out[i] = bit_audio_value; // add the telemetry
 			if (!clipping_reported)
 				if (out[i] > 1.0) {
-					error_print("Audio is clipping! %f",out[i]);
+					rt_error_print("Audio is clipping! %f\n",out[i]);
 					clipping_reported = 1;
 				}
 		}
 	}
+	audio_perf_stage(PERF_HIGH_SPEED_MODULATE, t);
 
 	return out;
 }
 
+jack_default_audio_sample_t * high_speed_telem_audio_loop(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
+	return high_speed_telem_audio_loop_body(in, out, nframes, params->send_telem, params->lpf_bits);
+}
+
+/* High speed telemetry as AFSK or GFSK tones, generated a period at a time */
+jack_default_audio_sample_t * high_speed_fsk_audio_loop(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
+	uint64_t t = audio_perf_now();
+	if (params->send_telem)
+		fsk_modulator_block(&pipeline->fsk, out, nframes);
+	audio_perf_stage(PERF_HIGH_SPEED_MODULATE, t);
+	return out;
+}
+
 /**
  * Prototype audio loop
  * This has too many loops within the loops, which helps with debugging, but could be optimized
  * Currently this uses FIR decimation filters which could be replaced with a more efficient alternative
  *
+ * Like modulate_bit_body() this is always inlined so that it can be specialized for each setting
  */
-jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
-		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
+static inline __attribute__((always_inline)) jack_default_audio_sample_t * duv_audio_loop_body(
+		jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, jack_nframes_t nframes,
+		int hpf, int telem, int lpf, int ramp) {
+	audio_pipeline_t *p = pipeline;
+	int decimation_rate = p->decimation_rate;
 
 	//	memcpy (out, in, sizeof (jack_default_audio_sample_t) * nframes);
 
+	/* Each stage is timed.  The time at the end of one stage is the start time for the next */
+	uint64_t t = audio_perf_now();
 	for (int i = 0; i< nframes; i++) {
-		filtered_audio_buffer[i] = fir_filter((double)in[i], decimate_filter_coeffs, decimate_filter_xv, DECIMATE_FILTER_LEN);
+		filtered_audio_buffer[i] = fir_filter((double)in[i], p->decimate_filter_coeffs, p->decimate_filter_xv, DECIMATE_FILTER_LEN);
 	}
+	t = audio_perf_stage(PERF_DECIMATE_FILTER, t);
 
 	int decimate_count = 0;
 
@@ -360,6 +614,7 @@ jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
 			decimated_audio_buffer[i/decimation_rate] = filtered_audio_buffer[i];
 		}
 	}
+	t = audio_perf_stage(PERF_DECIMATE, t);
 
 	/**
 	 * Now we high pass filter
@@ -367,21 +622,23 @@ jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
 	if (hpf) {
 	//	iir_filter_array(Elliptic8Pole300HzHighPassIIRCoeff, decimated_audio_buffer, hpf_decimated_audio_buffer, nframes/DECIMATION_RATE);
 		for (int i = 0; i< nframes/decimation_rate; i++)
-			hpf_decimated_audio_buffer[i] = iir_filter(Elliptic8Pole300HzHighPassIIRCoeff,decimated_audio_buffer[i], &iir_hpf_store);
+			hpf_decimated_audio_buffer[i] = iir_filter(Elliptic8Pole300HzHighPassIIRCoeff,decimated_audio_buffer[i], &p->iir_hpf_store);
 	//		hpf_decimated_audio_buffer[i] = cheby_iir_filter(decimated_audio_buffer[i], a_hpf_025, b_hpf_025);
 	} else {
 		for (int i = 0; i< nframes/decimation_rate; i++)
 			hpf_decimated_audio_buffer[i] = decimated_audio_buffer[i];
 	}
+	t = audio_perf_stage(PERF_HPF, t);
 
 	/**
 	 * Insert DUV telemetry.
 	 */
-	if (send_telem) {
+	if (telem) {
 		for (int i = 0; i< nframes/decimation_rate; i++) {
-			float bit_audio_value = modulate_bit();
+			float bit_audio_value = modulate_bit_body(p, lpf, ramp);
 			hpf_decimated_audio_buffer[i] += bit_audio_value; // add the telemetry
 		}
+		t = audio_perf_stage(PERF_MODULATE, t);
 	}
 
 	/**
@@ -400,30 +657,195 @@ jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
 			interpolated_audio_buffer[i] = 0.0f;
 
 	}
+	t = audio_perf_stage(PERF_INTERPOLATE, t);
 	/* Now filter out the duplications of the spectrum that interpolation introduces */
 	for (int i = 0; i< nframes; i++) {
-		out[i] = (float)fir_filter(interpolated_audio_buffer[i], interpolate_filter_coeffs, interpolate_filter_xv, DECIMATE_FILTER_LEN);
+		out[i] = (float)fir_filter(interpolated_audio_buffer[i], p->interpolate_filter_coeffs, p->interpolate_filter_xv, DECIMATE_FILTER_LEN);
 		if (!clipping_reported)
 			if (out[i] > 1.0) {
-				error_print("Audio is clipping! %f",out[i]);
+				rt_error_print("Audio is clipping! %f\n",out[i]);
 				clipping_reported = 1;
 			}
 	}
+	audio_perf_stage(PERF_INTERPOLATE_FILTER, t);
+
+	return out;
+}
+
+/* The generic loop tests each setting as it goes */
+jack_default_audio_sample_t * duv_audio_loop(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
+	return duv_audio_loop_body(in, out, nframes, params->hpf, params->send_telem, params->lpf_bits,
+			g_ramp_bits_to_compensate_hpf);
+}
+
+/*
+ * DUV with high speed telemetry on top.  There is no transponder audio, so nothing needs to be
+ * decimated or high pass filtered.  The DUV bits are modulated at the decimated rate and
+ * interpolated, and the burst is modulated at the full rate and added afterwards at
+ * g_high_speed_burst_level.  Only one in
+ * decimation_rate of the samples going into the interpolation filter is not zero, so
+ * fir_interpolate() only calculates the taps that meet a DUV sample.
+ *
+ * The burst should be AFSK or GFSK so that it leaves the sub audible DUV band clear.
+ */
+static inline __attribute__((always_inline)) jack_default_audio_sample_t * combined_audio_loop_body(
+		jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, jack_nframes_t nframes,
+		int telem, int lpf, int ramp) {
+	audio_pipeline_t *p = pipeline;
+	audio_pipeline_t *burst = p->burst;
+	int decimation_rate = p->decimation_rate;
+
+	uint64_t t = audio_perf_now();
+	if (!telem) {
+		memset(out, 0, nframes * sizeof(jack_default_audio_sample_t));
+		return out;
+	}
+	for (int i = 0; i< nframes/decimation_rate; i++) {
+		float bit_audio_value = modulate_bit_body(p, lpf, ramp);
+		hpf_decimated_audio_buffer[i] = bit_audio_value;
+	}
+	t = audio_perf_stage(PERF_MODULATE, t);
 
+	/* Apply gain equal to the decimation rate to compensate for the zeros, as in the DUV loop */
+	float gain = (float)decimation_rate;
+	for (int i = 0; i< nframes/decimation_rate; i++)
+		fir_interpolate(gain * hpf_decimated_audio_buffer[i], &interpolated_audio_buffer[i * decimation_rate],
+				decimation_rate, p->interpolate_filter_coeffs, p->interpolate_filter_xv, DECIMATE_FILTER_LEN);
+	t = audio_perf_stage(PERF_INTERPOLATE_FILTER, t);
+
+	if (burst->switch_ready) {
+		memset(burst_audio_buffer, 0, nframes * sizeof(float)); // the burst frame is finished and the mode is changing
+	} else if (burst->fsk.modulation != FSK_NRZ) {
+		fsk_modulator_block(&burst->fsk, burst_audio_buffer, nframes);
+	} else {
+		for (int i = 0; i< nframes; i++)
+			burst_audio_buffer[i] = modulate_bit_body(burst, lpf, false); // no ramp at high speed
+	}
+	t = audio_perf_stage(PERF_HIGH_SPEED_MODULATE, t);
+
+	float level = g_high_speed_burst_level;
+	for (int i = 0; i< nframes; i++) {
+		out[i] = (float)(interpolated_audio_buffer[i] + level * burst_audio_buffer[i]);
+		if (!clipping_reported)
+			if (out[i] > 1.0) {
+				rt_error_print("Audio is clipping! %f\n",out[i]);
+				clipping_reported = 1;
+			}
+	}
 	return out;
 }
 
+jack_default_audio_sample_t * combined_audio_loop(jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, jack_nframes_t nframes) {
+	return combined_audio_loop_body(in, out, nframes, params->send_telem, params->lpf_bits,
+			g_ramp_bits_to_compensate_hpf);
+}
+
+/*
+ * A copy of the audio loop for each combination of settings, with the settings fixed when it is
+ * compiled.  audio_loop() picks one from the tables at the start of each period, so there are no
+ * tests of the settings inside the loops.
+ */
+#define DUV_AUDIO_LOOP_VARIANT(HPF, TELEM, LPF, RAMP) \
+	jack_default_audio_sample_t * duv_audio_loop_##HPF##TELEM##LPF##RAMP(jack_default_audio_sample_t *in, \
+			jack_default_audio_sample_t *out, jack_nframes_t nframes) { \
+		return duv_audio_loop_body(in, out, nframes, HPF, TELEM, LPF, RAMP); \
+	}
+
+#define HIGH_SPEED_AUDIO_LOOP_VARIANT(TELEM, LPF) \
+	jack_default_audio_sample_t * high_speed_telem_audio_loop_##TELEM##LPF(jack_default_audio_sample_t *in, \
+			jack_default_audio_sample_t *out, jack_nframes_t nframes) { \
+		return high_speed_telem_audio_loop_body(in, out, nframes, TELEM, LPF); \
+	}
+
+DUV_AUDIO_LOOP_VARIANT(0,0,0,0)
+DUV_AUDIO_LOOP_VARIANT(0,0,0,1)
+DUV_AUDIO_LOOP_VARIANT(0,0,1,0)
+DUV_AUDIO_LOOP_VARIANT(0,0,1,1)
+DUV_AUDIO_LOOP_VARIANT(0,1,0,0)
+DUV_AUDIO_LOOP_VARIANT(0,1,0,1)
+DUV_AUDIO_LOOP_VARIANT(0,1,1,0)
+DUV_AUDIO_LOOP_VARIANT(0,1,1,1)
+DUV_AUDIO_LOOP_VARIANT(1,0,0,0)
+DUV_AUDIO_LOOP_VARIANT(1,0,0,1)
+DUV_AUDIO_LOOP_VARIANT(1,0,1,0)
+DUV_AUDIO_LOOP_VARIANT(1,0,1,1)
+DUV_AUDIO_LOOP_VARIANT(1,1,0,0)
+DUV_AUDIO_LOOP_VARIANT(1,1,0,1)
+DUV_AUDIO_LOOP_VARIANT(1,1,1,0)
+DUV_AUDIO_LOOP_VARIANT(1,1,1,1)
+
+#define COMBINED_AUDIO_LOOP_VARIANT(TELEM, LPF, RAMP) \
+	jack_default_audio_sample_t * combined_audio_loop_##TELEM##LPF##RAMP(jack_default_audio_sample_t *in, \
+			jack_default_audio_sample_t *out, jack_nframes_t nframes) { \
+		return combined_audio_loop_body(in, out, nframes, TELEM, LPF, RAMP); \
+	}
+
+HIGH_SPEED_AUDIO_LOOP_VARIANT(0,0)
+HIGH_SPEED_AUDIO_LOOP_VARIANT(0,1)
+HIGH_SPEED_AUDIO_LOOP_VARIANT(1,0)
+HIGH_SPEED_AUDIO_LOOP_VARIANT(1,1)
+
+COMBINED_AUDIO_LOOP_VARIANT(0,0,0)
+COMBINED_AUDIO_LOOP_VARIANT(0,0,1)
+COMBINED_AUDIO_LOOP_VARIANT(0,1,0)
+COMBINED_AUDIO_LOOP_VARIANT(0,1,1)
+COMBINED_AUDIO_LOOP_VARIANT(1,0,0)
+COMBINED_AUDIO_LOOP_VARIANT(1,0,1)
+COMBINED_AUDIO_LOOP_VARIANT(1,1,0)
+COMBINED_AUDIO_LOOP_VARIANT(1,1,1)
+
+/* Indexed by [hpf][telem][lpf][ramp] */
+audio_loop_variant_t duv_audio_loop_variants[2][2][2][2] = {
+		{{{duv_audio_loop_0000, duv_audio_loop_0001}, {duv_audio_loop_0010, duv_audio_loop_0011}},
+		 {{duv_audio_loop_0100, duv_audio_loop_0101}, {duv_audio_loop_0110, duv_audio_loop_0111}}},
+		{{{duv_audio_loop_1000, duv_audio_loop_1001}, {duv_audio_loop_1010, duv_audio_loop_1011}},
+		 {{duv_audio_loop_1100, duv_audio_loop_1101}, {duv_audio_loop_1110, duv_audio_loop_1111}}}
+};
+
+/* Indexed by [telem][lpf] */
+audio_loop_variant_t high_speed_audio_loop_variants[2][2] = {
+		{high_speed_telem_audio_loop_00, high_speed_telem_audio_loop_01},
+		{high_speed_telem_audio_loop_10, high_speed_telem_audio_loop_11}
+};
+
+/* Indexed by [telem][lpf][ramp] */
+audio_loop_variant_t combined_audio_loop_variants[2][2][2] = {
+		{{combined_audio_loop_000, combined_audio_loop_001}, {combined_audio_loop_010, combined_audio_loop_011}},
+		{{combined_audio_loop_100, combined_audio_loop_101}, {combined_audio_loop_110, combined_audio_loop_111}}
+};
+
+/* Pick the loop for the current pipeline and settings.  Called once per period */
+audio_loop_variant_t select_audio_loop_variant() {
+	if (pipeline->burst != NULL)
+		return combined_audio_loop_variants[params->send_telem != 0][params->lpf_bits != 0]
+				[g_ramp_bits_to_compensate_hpf != 0];
+	if (pipeline->mode == AUDIO_MODE_HIGH_SPEED && pipeline->fsk.modulation != FSK_NRZ)
+		return high_speed_fsk_audio_loop;
+	if (pipeline->mode == AUDIO_MODE_HIGH_SPEED)
+		return high_speed_audio_loop_variants[params->send_telem != 0][params->lpf_bits != 0];
+	return duv_audio_loop_variants[params->hpf != 0][params->send_telem != 0][params->lpf_bits != 0]
+			[g_ramp_bits_to_compensate_hpf != 0];
+}
+
 jack_default_audio_sample_t * audio_loop(jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, jack_nframes_t nframes) {
 	/* Time the loop. Use clock_gettime because gettimeofday() is moved by NTP or other time sync mechanisms */
 	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	uint64_t perf_start = audio_perf_now();
 
-	if (send_test_tone) {
+	/* Settings changed by the console only take effect at the start of a period */
+	audio_processor_update_params();
+	audio_processor_update_pipeline();
+	audio_processor_start_period(pipeline);
+
+	if (params->send_test_tone) {
 		for (int i=0; i < nframes; i++) {
-			double value = nextSample(&osc_phase, test_tone_freq, g_sample_rate, osc_sin_table, OSC_TABLE_SIZE);
+			double value = nextSample(&osc_phase, params->test_tone_freq, g_sample_rate, osc_sin_table, OSC_TABLE_SIZE);
 			if (value > 0) out[i] = g_one_value;
 			else out[i] = g_zero_value;
 		}
-	} else if (measure_test_tone) {
+	} else if (params->measure_test_tone) {
 		for (int i=0; i < nframes; i++) {
 			//out[i] = 0; // silence the output, except this does not work if we were already receiving a tone?
 			out[i] = in[i];  // play what we are measuring
@@ -437,21 +859,28 @@ jack_default_audio_sample_t * audio_loop(jack_default_audio_sample_t *in, jack_d
 		}
 		measurement_loops++;
 		if (measurement_loops >= LOOPS_PER_MEASUREMENT) {
-			printf("Peak over %d measurements: %f\n", measurements, peak_value);
+			rt_print("Peak over %d measurements: %f\n", measurements, peak_value);
 			measurement_loops = 0;
 			measurements = 0;
 			peak_value = 0;
 		}
-	} else if (send_high_speed_telem) {
-		high_speed_telem_audio_loop(in, out, nframes);
 	} else {
 		/*
-		 * Now process the data in out buffer before we sent it to the radio
+		 * Now process the data in out buffer before we sent it to the radio.  This is the
+		 * high speed or DUV loop specialized for the current settings.
 		 */
 		//telem_only_audio_loop(in, out, nframes);
-		duv_audio_loop(in, out, nframes);
+		select_audio_loop_variant()(in, out, nframes);
 	}
 
+	uint64_t perf_end = audio_perf_stage(PERF_TOTAL, perf_start);
+	if (pipeline_switch_ns >= perf_start)
+		__atomic_store_n(&last_switch_loop_ns, perf_end - perf_start, __ATOMIC_RELAXED);
+	audio_perf_end_period();
+	loop_latency_record(perf_end - perf_start);
+	audio_frame_time += nframes;
+	realtime_record_page_faults();
+
 	clock_gettime(CLOCK_MONOTONIC, &ts_end);
 	/* store the CPU time in microseconds */
 	loop_time_microsec = ((ts_end.tv_sec * 1000000 + ts_end.tv_nsec/1000) -
@@ -466,8 +895,8 @@ jack_default_audio_sample_t * audio_loop(jack_default_audio_sample_t *in, jack_d
 	if (loops_timed > LOOPS_TO_TIME) {
 		//verbose_print("INFO: Audio loop processing time: %f secs\n",total_cpu_time_used/loops_timed);
 		if (max_loop_time_microsec > 10000) // // 480 frames is 10ms of audio.  So if we take more than 10ms to process this we have an issue
-			error_print("WARNING: Loop ran for: %.2f ms\n",max_loop_time_microsec/1000);
-		verbose_print("Loop time: Max %.2fms Min: %.2fms\n",max_loop_time_microsec/1000,min_loop_time_microsec/1000);
+			rt_error_print("WARNING: Loop ran for: %.2f ms\n",max_loop_time_microsec/1000);
+		rt_verbose_print("Loop time: Max %.2fms Min: %.2fms\n",max_loop_time_microsec/1000,min_loop_time_microsec/1000);
 		total_loop_time_microsec = 0;
 		max_loop_time_microsec = 0;
 		min_loop_time_microsec = 99999;
@@ -477,6 +906,33 @@ jack_default_audio_sample_t * audio_loop(jack_default_audio_sample_t *in, jack_d
 	return out;
 }
 
+void audio_processor_print_mode_status() {
+	latency_histogram_t hist;
+	audio_pipeline_t *p = __atomic_load_n(&pipeline, __ATOMIC_ACQUIRE);
+	printf(" mode: %s at %d bps, %.2f samples per bit%s%s\n", p->name, p->bit_rate, p->samples_per_bit,
+			p->fsk.modulation == FSK_AFSK ? ", AFSK" : p->fsk.modulation == FSK_GFSK ? ", GFSK" : "",
+			__atomic_load_n(&pipeline_switch_pending, __ATOMIC_RELAXED) ? ", switch waiting for the end of the frame" : "");
+	if (p->burst != NULL)
+		printf(" with %s at %d bps, %.2f samples per bit%s\n", p->burst->name, p->burst->bit_rate, p->burst->samples_per_bit,
+				p->burst->fsk.modulation == FSK_AFSK ? ", AFSK" : p->burst->fsk.modulation == FSK_GFSK ? ", GFSK" : "");
+	for (int i=0; i < TELEM_NUM_STREAMS; i++) {
+		telem_stream_t *stream = telem_processor_stream(i);
+		printf(" %s telemetry stream: %u frames, %u bits sent\n", i == TELEM_STREAM_MAIN ? "main" : "burst",
+				__atomic_load_n(&stream->frames_sent, __ATOMIC_RELAXED), __atomic_load_n(&stream->bits_sent, __ATOMIC_RELAXED));
+		telem_scheduler_print_status(telem_thread_schedule(i), i == TELEM_STREAM_MAIN ? "main" : "burst");
+	}
+	int switches = __atomic_load_n(&pipeline_switches, __ATOMIC_RELAXED);
+	if (switches == 0)
+		return;
+	loop_latency_get(g_latency_long_window_sec, &hist);
+	printf(" mode switches: %d. Last waited %.1f ms for the end of a frame and took %.2f us. "
+			"Loop time that period %.2f ms, p99 %.2f ms\n", switches,
+			__atomic_load_n(&last_switch_wait_ns, __ATOMIC_RELAXED) / 1000000.0,
+			__atomic_load_n(&last_switch_cost_ns, __ATOMIC_RELAXED) / 1000.0,
+			__atomic_load_n(&last_switch_loop_ns, __ATOMIC_RELAXED) / 1000000.0,
+			latency_histogram_percentile(&hist, 99) / 1000000.0);
+}
+
 /******************************************************************************
  *
  * TEST FUNCTIONS
@@ -490,9 +946,9 @@ unsigned char test_parities_check[] = {0x19,0xa0,0x2c,0x20,0x59,0xf6,0x7c,0x12,0
 int test_modulate_bit() {
 	printf("TESTING modulate_bit .. ");
 	verbose_print("\n");
-	int lpf = lpf_bits; // store this value to reset after the test
+	int lpf = get_lpf_bits(); // store this value to reset after the test
 	int ramp = g_ramp_bits_to_compensate_hpf; // store this value to reset after the test
-	lpf_bits = false; // turn this off just for the test
+	set_lpf_bits(false); // turn this off just for the test
 	g_ramp_bits_to_compensate_hpf = false;// turn this off just for the test
 
 	int fail = 0;
@@ -517,7 +973,8 @@ int test_modulate_bit() {
 //	current_bit = 0;
 
 	g_sample_rate = 48000;
-	init_audio_processor(DUV_BPS, DUV_DECIMATION_RATE);
+	init_audio_processor();
+	int samples_per_bit = (int)pipeline->samples_per_bit;
 //	samples_per_duv_bit = g_sample_rate / DECIMATION_RATE / DUV_BPS;
 
 	unsigned char *test_packet = set_test_packet();
@@ -555,6 +1012,8 @@ int test_modulate_bit() {
 
 	uint16_t decode = 0;
 	int b = 9; // bit position in word
+	decode_8b10b_t decoder;
+	decode_8b10b_start(&decoder, DECODE_8B10B_RD_UNKNOWN);
 	int check_expected_results = false;
 	int bit = 0;
 	j = 0;
@@ -584,7 +1043,7 @@ int test_modulate_bit() {
 				decode += (bit << b--);
 			}
 		}
-		unsigned char c = reverse_8b10b_lookup(decode);
+		int c = decode_8b10b(&decoder, decode);
 		verbose_print(" 10b: %x 8b: %x",decode, c);
 		if (w < DUV_DATA_LENGTH) {
 			if (c != test_packet[w]) {
@@ -606,7 +1065,12 @@ int test_modulate_bit() {
 		decode = 0;
 		b = 9;
 	}
-	lpf_bits = lpf; // reset this after the test
+	verbose_print("%ld code violations, %ld disparity errors\n", decoder.code_violations, decoder.disparity_errors);
+	if (decoder.code_violations != 0 || decoder.disparity_errors != 0)
+		fail = 1;
+	set_lpf_bits(lpf); // reset this after the test
+	audio_processor_publish_params();
+	audio_processor_update_params();
 	g_ramp_bits_to_compensate_hpf = ramp; // reset after the test
 	if (fail == 0) {
 		printf(" Pass\n");
@@ -616,3 +1080,421 @@ int test_modulate_bit() {
 	return fail;
 
 }
+
+int test_audio_params() {
+	printf("TESTING audio_params .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	audio_params_t saved = console_params;
+
+	/* Changes are not seen by the audio thread until they are published and a period starts */
+	set_hpf(!saved.hpf);
+	set_send_high_speed_telem(true);
+	if (params->hpf != saved.hpf || params->send_high_speed_telem != saved.send_high_speed_telem)
+		fail = EXIT_FAILURE;
+	audio_processor_publish_params();
+	if (params->hpf != saved.hpf)
+		fail = EXIT_FAILURE;
+	audio_processor_update_params();
+	if (params->hpf == saved.hpf || params->send_high_speed_telem != true)
+		fail = EXIT_FAILURE;
+
+	/* Two publishes before the next period.  Only the last one is used */
+	set_test_tone_freq(1000);
+	set_lpf_bits(saved.lpf_bits);
+	audio_processor_publish_params();
+	set_test_tone_freq(2000);
+	set_lpf_bits(!saved.lpf_bits);
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	verbose_print(" tone %.0f lpf %d\n", params->test_tone_freq, params->lpf_bits);
+	if (params->test_tone_freq != 2000 || params->lpf_bits == saved.lpf_bits)
+		fail = EXIT_FAILURE;
+
+	/* Nothing new, so the audio thread keeps the same settings */
+	audio_params_t *before = params;
+	audio_processor_update_params();
+	if (params != before)
+		fail = EXIT_FAILURE;
+
+	console_params = saved;
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
+/*
+ * Run the audio loop until the pipeline for mode is in use and return how many periods that took
+ */
+int test_run_until_mode(int mode, jack_default_audio_sample_t *in, jack_default_audio_sample_t *out, int max_periods) {
+	int periods = 0;
+	while (periods < max_periods) {
+		audio_loop(in, out, PERIOD_SIZE);
+		if (pipeline == &pipelines[mode])
+			break;
+		periods++;
+	}
+	return periods;
+}
+
+/*
+ * Switch to high speed and back while telemetry is being sent.  Each switch must wait for the end
+ * of the frame, and the first bits from the new pipeline must be a sync word.
+ */
+int test_audio_pipeline() {
+	printf("TESTING audio_pipeline .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	audio_params_t saved = console_params;
+	int ramp = g_ramp_bits_to_compensate_hpf; // store this value to reset after the test
+	g_ramp_bits_to_compensate_hpf = false;
+	char modulation[MAX_LINE_LENGTH]; // the bits are read back as levels, so test without FSK
+	strncpy(modulation, g_high_speed_modulation, MAX_LINE_LENGTH);
+	strncpy(g_high_speed_modulation, FSK_MODULATION_NRZ, MAX_LINE_LENGTH);
+	static jack_default_audio_sample_t in[PERIOD_SIZE];
+	static jack_default_audio_sample_t out[PERIOD_SIZE];
+	int frame_bits = (DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD;
+	memset(in, 0, sizeof(in));
+
+	set_send_telem(true);
+	set_send_high_speed_telem(false);
+	set_send_test_telem(false);
+	set_send_test_tone(false);
+	set_measure_test_tone(false);
+	set_hpf(false);
+	set_lpf_bits(false);
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	init_audio_processor();
+
+	/* Part way into the first DUV frame ask for high speed */
+	int start_periods = 10;
+	for (int i=0; i < start_periods; i++)
+		audio_loop(in, out, PERIOD_SIZE);
+	audio_pipeline_t *duv = &pipelines[AUDIO_MODE_DUV];
+	int duv_frame_periods = frame_bits * duv->samples_per_bit / (PERIOD_SIZE / duv->decimation_rate);
+	set_send_high_speed_telem(true);
+	audio_processor_publish_params();
+	int periods = test_run_until_mode(AUDIO_MODE_HIGH_SPEED, in, out, 2 * duv_frame_periods);
+	verbose_print(" switched to high speed after %d periods, frame is %d periods\n", periods, duv_frame_periods);
+	if (pipeline != &pipelines[AUDIO_MODE_HIGH_SPEED] || abs(periods + start_periods - duv_frame_periods) > 1)
+		fail = EXIT_FAILURE;
+
+	/* The period that switched was sent by the new pipeline, starting with the sync word */
+	int samples_per_bit = (int)pipeline->samples_per_bit;
+	uint16_t word = 0;
+	for (int b=0; b < BITS_PER_10b_WORD; b++) {
+		float first = out[b * samples_per_bit];
+		float last = out[(b + 1) * samples_per_bit - 1];
+		if (first != last || (first != (float)g_one_value && first != (float)g_zero_value))
+			fail = EXIT_FAILURE;
+		word = (word << 1) | (first == (float)g_one_value);
+	}
+	verbose_print(" first word after the switch %x\n", word);
+	if (word != 0xfa && word != (0x3ff ^ 0xfa))
+		fail = EXIT_FAILURE;
+
+	/* Straight back again.  This waits for the whole high speed frame */
+	int hs_frame_periods = frame_bits * samples_per_bit / PERIOD_SIZE;
+	set_send_high_speed_telem(false);
+	audio_processor_publish_params();
+	periods = test_run_until_mode(AUDIO_MODE_DUV, in, out, 2 * hs_frame_periods);
+	verbose_print(" switched to DUV after %d periods, frame is %d periods\n", periods, hs_frame_periods);
+	if (pipeline != &pipelines[AUDIO_MODE_DUV] || abs(periods - hs_frame_periods) > 1 || pipeline_switches < 2)
+		fail = EXIT_FAILURE;
+
+	/* With telemetry off there is no frame to wait for */
+	set_send_telem(false);
+	set_send_high_speed_telem(true);
+	audio_processor_publish_params();
+	periods = test_run_until_mode(AUDIO_MODE_HIGH_SPEED, in, out, 2);
+	if (periods != 0)
+		fail = EXIT_FAILURE;
+
+	console_params = saved;
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	pipeline = audio_processor_target_pipeline();
+	audio_processor_reset_state();
+	pipeline_switches = 0;
+	clipping_reported = 0;
+	g_ramp_bits_to_compensate_hpf = ramp; // reset after the test
+	strncpy(g_high_speed_modulation, modulation, MAX_LINE_LENGTH);
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
+/*
+ * Run the modulator at a bit rate that does not divide the sample rate.  Each sample is the
+ * average of the bits over that sample, so the running total of the samples must match the
+ * time spent sending ones, with no drift over a second of bits.
+ */
+int test_symbol_clock() {
+	printf("TESTING symbol_clock .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	audio_params_t saved = console_params;
+	audio_pipeline_t *saved_pipeline = pipeline;
+	static audio_pipeline_t test_pipeline;
+	int bit_rate = 9000; // 5.33 samples per bit at 48k
+	int samples = g_sample_rate;
+	int check_every = 997;
+
+	set_send_test_telem(true); // toggles every TEST_BIT_NUMBER bits
+	set_lpf_bits(false);
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	init_pipeline(&test_pipeline, AUDIO_MODE_HIGH_SPEED, "Test", bit_rate, 1);
+	pipeline = &test_pipeline;
+
+	double bit_len = (double)g_sample_rate / bit_rate;
+	double total = 0;
+	int shared_samples = 0;
+	for (int n=0; n < samples; n++) {
+		double value = modulate_bit_body(&test_pipeline, false, false);
+		double ones = (value - g_zero_value) / (g_one_value - g_zero_value);
+		if (ones != 0.0 && ones != 1.0)
+			shared_samples++;
+		total += ones;
+		if ((n + 1) % check_every == 0 || n == samples - 1) {
+			/* Bit k is a one if ((k+1)/TEST_BIT_NUMBER) is odd.  Add up the time in ones before the end of this sample */
+			double expected = 0;
+			for (int k=0; k * bit_len < n + 1; k++)
+				if (((k + 1) / TEST_BIT_NUMBER) % 2) {
+					double end = (k + 1) * bit_len < n + 1 ? (k + 1) * bit_len : n + 1;
+					expected += end - k * bit_len;
+				}
+			if (fabs(total - expected) > 1E-6) {
+				verbose_print(" at sample %d total %.6f expected %.6f\n", n, total, expected);
+				fail = EXIT_FAILURE;
+			}
+		}
+	}
+	verbose_print(" %d bps, %.3f samples per bit, %d samples shared between bits, time in ones %.3f\n",
+			bit_rate, test_pipeline.samples_per_bit, shared_samples, total);
+	/* A bit is 16/3 samples, so two in three of the edges where the level changes fall inside a sample */
+	if (shared_samples != 2 * bit_rate / (3 * TEST_BIT_NUMBER))
+		fail = EXIT_FAILURE;
+
+	pipeline = saved_pipeline;
+	console_params = saved;
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
+/*
+ * Send DUV with high speed on top.  The output must be the sum of what the DUV and high speed
+ * pipelines send on their own, with the high speed at the burst level, each telemetry stream must move on at its own bit rate, and a
+ * change of mode must wait for the DUV frame to end.
+ */
+#define TEST_COMBINED_PERIODS 20
+int test_combined_pipeline() {
+	printf("TESTING combined_pipeline .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	audio_params_t saved = console_params;
+	int ramp = g_ramp_bits_to_compensate_hpf; // store this value to reset after the test
+	g_ramp_bits_to_compensate_hpf = false;
+	static jack_default_audio_sample_t in[PERIOD_SIZE];
+	static jack_default_audio_sample_t combined_out[TEST_COMBINED_PERIODS * PERIOD_SIZE];
+	static jack_default_audio_sample_t duv_out[TEST_COMBINED_PERIODS * PERIOD_SIZE];
+	static jack_default_audio_sample_t burst_out[TEST_COMBINED_PERIODS * PERIOD_SIZE];
+	audio_pipeline_t *combined = &pipelines[AUDIO_MODE_COMBINED];
+	audio_pipeline_t *burst = &pipelines[AUDIO_PIPELINE_BURST];
+	memset(in, 0, sizeof(in));
+
+	/* Test bits, so that each pipeline sends the same bits every time it starts */
+	set_send_telem(true);
+	set_send_high_speed_telem(true);
+	set_send_duv_with_high_speed(true);
+	set_send_test_telem(true);
+	set_send_test_tone(false);
+	set_measure_test_tone(false);
+	set_hpf(false);
+	set_lpf_bits(true);
+	audio_processor_publish_params();
+	audio_processor_update_params();
+
+	audio_pipeline_start(combined);
+	pipeline = combined;
+	for (int i=0; i < TEST_COMBINED_PERIODS; i++)
+		combined_audio_loop(in, &combined_out[i * PERIOD_SIZE], PERIOD_SIZE);
+	audio_pipeline_start(&pipelines[AUDIO_MODE_DUV]);
+	pipeline = &pipelines[AUDIO_MODE_DUV];
+	for (int i=0; i < TEST_COMBINED_PERIODS; i++)
+		duv_audio_loop(in, &duv_out[i * PERIOD_SIZE], PERIOD_SIZE);
+	audio_pipeline_start(burst);
+	pipeline = burst;
+	for (int i=0; i < TEST_COMBINED_PERIODS; i++)
+		select_audio_loop_variant()(in, &burst_out[i * PERIOD_SIZE], PERIOD_SIZE);
+
+	double max_err = 0, max_duv = 0, max_burst = 0;
+	for (int i=0; i < TEST_COMBINED_PERIODS * PERIOD_SIZE; i++) {
+		double err = fabs(combined_out[i] - (duv_out[i] + (float)g_high_speed_burst_level * burst_out[i]));
+		if (err > max_err) max_err = err;
+		if (fabs(duv_out[i]) > max_duv) max_duv = fabs(duv_out[i]);
+		if (fabs(burst_out[i]) > max_burst) max_burst = fabs(burst_out[i]);
+	}
+	verbose_print(" peak duv %.3f burst %.3f, max difference from the sum %g\n", max_duv, max_burst, max_err);
+	if (max_err > 1E-6 || max_duv == 0 || max_burst == 0)
+		fail = EXIT_FAILURE;
+
+	/* Real telemetry.  Each stream fetches a bit at the start and then one at the end of each bit */
+	set_send_test_telem(false);
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	audio_pipeline_start(combined);
+	pipeline = combined;
+	for (int i=0; i < TEST_COMBINED_PERIODS; i++)
+		audio_loop(in, combined_out, PERIOD_SIZE);
+	telem_stream_t *main_stream = telem_processor_stream(TELEM_STREAM_MAIN);
+	telem_stream_t *burst_stream = telem_processor_stream(TELEM_STREAM_BURST);
+	int duv_bits = (int)(TEST_COMBINED_PERIODS * PERIOD_SIZE / (combined->samples_per_bit * combined->decimation_rate)) + 1;
+	int burst_bits = (int)(TEST_COMBINED_PERIODS * PERIOD_SIZE / burst->samples_per_bit) + 1;
+	verbose_print(" bits sent: main stream %u expected %d, burst stream %u expected %d\n", main_stream->bits_sent, duv_bits,
+			burst_stream->bits_sent, burst_bits);
+	if (abs((int)main_stream->bits_sent - duv_bits) > 1 || abs((int)burst_stream->bits_sent - burst_bits) > 1)
+		fail = EXIT_FAILURE;
+
+	/* Back to DUV.  This waits for the DUV frame, and the burst is silent once its own frame ends */
+	int frame_bits = (DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD;
+	int duv_frame_periods = frame_bits * combined->samples_per_bit / (PERIOD_SIZE / combined->decimation_rate);
+	set_send_high_speed_telem(false);
+	set_send_duv_with_high_speed(false);
+	audio_processor_publish_params();
+	int periods = test_run_until_mode(AUDIO_MODE_DUV, in, combined_out, 2 * duv_frame_periods);
+	verbose_print(" switched to DUV after %d periods, frame is %d periods, burst held after %u bits\n", periods,
+			duv_frame_periods, burst_stream->bits_sent);
+	if (pipeline != &pipelines[AUDIO_MODE_DUV] || abs(periods + TEST_COMBINED_PERIODS - duv_frame_periods) > 1
+			|| !burst->switch_ready || !telem_stream_at_frame_boundary(burst_stream))
+		fail = EXIT_FAILURE;
+
+	console_params = saved;
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	pipeline = audio_processor_target_pipeline();
+	audio_processor_reset_state();
+	pipeline_switches = 0;
+	clipping_reported = 0;
+	g_ramp_bits_to_compensate_hpf = ramp; // reset after the test
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
+/******************************************************************************
+ *
+ * BENCHMARK FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* Put the pipelines and the telemetry encoder back to the start so that runs can be compared */
+void audio_processor_reset_state() {
+	for (int m=0; m < AUDIO_NUM_PIPELINES; m++)
+		audio_pipeline_start(&pipelines[m]);
+	pipeline_switch_pending = false;
+	osc_phase = 0;
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+}
+
+void audio_processor_start_mode(int mode) {
+	set_send_high_speed_telem(mode != AUDIO_MODE_DUV);
+	set_send_duv_with_high_speed(mode == AUDIO_MODE_COMBINED);
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	pipeline = audio_processor_target_pipeline();
+	audio_processor_reset_state();
+}
+
+/* Run the loop from the start state and return the time per sample in ns.  The output of the last period is left in out */
+double bench_audio_loop_run(audio_loop_variant_t loop, jack_default_audio_sample_t *in,
+		jack_default_audio_sample_t *out, int periods) {
+	audio_processor_reset_state();
+	uint64_t start = audio_perf_now();
+	for (int p=0; p < periods; p++)
+		loop(in + (p % 4) * PERIOD_SIZE, out, PERIOD_SIZE);
+	uint64_t end = audio_perf_now();
+	return (double)(end - start) / ((double)periods * PERIOD_SIZE);
+}
+
+/*
+ * Time the generic loop, which tests each setting as it goes, against the loop specialized for
+ * the settings.  Both must give exactly the same output.
+ */
+int bench_audio_loop_variants(int periods) {
+	typedef struct {
+		char *name;
+		int mode, hpf, telem, lpf;
+	} bench_mode_t;
+	bench_mode_t modes[] = {
+			{"duv", AUDIO_MODE_DUV, true, true, true},
+			{"duv no hpf", AUDIO_MODE_DUV, false, true, true},
+			{"duv no lpf", AUDIO_MODE_DUV, true, true, false},
+			{"duv no telem", AUDIO_MODE_DUV, true, false, false},
+			{"high speed", AUDIO_MODE_HIGH_SPEED, false, true, true},
+			{"high speed no lpf", AUDIO_MODE_HIGH_SPEED, false, true, false},
+			{"duv with high speed", AUDIO_MODE_COMBINED, false, true, true}
+	};
+	audio_loop_variant_t generic_loops[AUDIO_NUM_MODES] = {duv_audio_loop, high_speed_telem_audio_loop, combined_audio_loop};
+	int fail = EXIT_SUCCESS;
+	audio_params_t saved = console_params;
+	int saved_modulation = pipelines[AUDIO_MODE_HIGH_SPEED].fsk.modulation;
+	static jack_default_audio_sample_t in[4 * PERIOD_SIZE];
+	static jack_default_audio_sample_t generic_out[PERIOD_SIZE];
+	static jack_default_audio_sample_t specialized_out[PERIOD_SIZE];
+
+	/* Transponder audio is a tone plus a little noise */
+	srand(1);
+	for (int i=0; i < 4 * PERIOD_SIZE; i++)
+		in[i] = 0.3 * sin(2 * M_PI * 1000.0 * i / g_sample_rate) + 0.01 * ((double)rand() / RAND_MAX - 0.5);
+
+	/* The FSK loop has no generic version, it is timed by bench_fsk_modulator() */
+	pipelines[AUDIO_MODE_HIGH_SPEED].fsk.modulation = FSK_NRZ;
+	printf("BENCHMARK audio loop variants, %d periods of %d samples\n", periods, PERIOD_SIZE);
+	printf(" %-20s %16s %16s %8s %6s\n", "mode", "generic ns/samp", "special ns/samp", "speedup", "match");
+	for (int m=0; m < sizeof(modes)/sizeof(modes[0]); m++) {
+		set_send_high_speed_telem(modes[m].mode != AUDIO_MODE_DUV);
+		set_send_duv_with_high_speed(modes[m].mode == AUDIO_MODE_COMBINED);
+		set_hpf(modes[m].hpf);
+		set_send_telem(modes[m].telem);
+		set_lpf_bits(modes[m].lpf);
+		audio_processor_publish_params();
+		audio_processor_update_params();
+		pipeline = &pipelines[modes[m].mode];
+
+		audio_loop_variant_t generic = generic_loops[modes[m].mode];
+		double generic_ns = bench_audio_loop_run(generic, in, generic_out, periods);
+		double specialized_ns = bench_audio_loop_run(select_audio_loop_variant(), in, specialized_out, periods);
+		int match = memcmp(generic_out, specialized_out, sizeof(generic_out)) == 0;
+		if (!match)
+			fail = EXIT_FAILURE;
+		printf(" %-20s %16.1f %16.1f %8.2f %6s\n", modes[m].name, generic_ns, specialized_ns,
+				generic_ns / specialized_ns, match ? "yes" : "NO");
+	}
+
+	pipelines[AUDIO_MODE_HIGH_SPEED].fsk.modulation = saved_modulation;
+	console_params = saved;
+	audio_processor_publish_params();
+	audio_processor_update_params();
+	pipeline = audio_processor_target_pipeline();
+	audio_processor_reset_state();
+	return fail;
+}
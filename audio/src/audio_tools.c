@@ -27,10 +27,11 @@
   * Convert a byte buffer from an audio source into a float buffer that we can use for
   * DSP processing.
   * The bytes are first converted to a 16 bit signed int that runs from -32768 to +32767
+  * The low byte is unsigned so that it is not sign extended.
   */
  int get_floats_from_bytes(char * byte_buffer, float * float_buffer, int buf_len) {
 	 for (int i = 0; i< buf_len/2; i++) {
-		 signed int int_value = (signed int)((byte_buffer[2*i] ) + (byte_buffer[2*i+1] <<8));
+		 signed int int_value = (signed int)((unsigned char)byte_buffer[2*i] + (byte_buffer[2*i+1] <<8));
 		 float_buffer[i] = (float)int_value / 32768.0f;
 	 }
 	 return 0;
@@ -0,0 +1,440 @@
+/*
+ * ber_sim.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Eb/N0 is set from the measured power of the audio.  The noise is white across the whole audio
+ * band, so with sigma squared the noise power in each sample, N0 = 2 sigma^2 / sample rate and
+ * Eb = signal power / bit rate.
+ *
+ * An extra frame is sent first, while the demodulator finds the bit timing, and is not counted.
+ * The frames are matched to the ones that were sent by the sample where their sync word ended.
+ * A sync word found in the wrong place, because the real one had an error, is ignored.  So bit
+ * errors are only counted in frames that were received, and a missed frame counts as a frame error.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_processor.h"
+#include "duv_demodulator.h"
+#include "ber_sim.h"
+#include "../../telem_send/inc/telem_thread.h"
+#include "../../telem_send/inc/TelemEncoding.h"
+
+/* Forward function declarations */
+void ber_sim_frame(duv_frame_t *frame, void *arg);
+void *ber_sim_thread(void *arg);
+
+#define BER_SIM_BLOCK 4096 // samples passed through the channel at a time
+
+/* splitmix64.  Each pass seeds its own, so the passes do not share any state */
+typedef struct {
+	uint64_t state;
+	int have_spare;
+	double spare;
+} ber_sim_rng_t;
+
+/* A pass through the channel and demodulator */
+typedef struct {
+	ber_sim_tx_t *tx;
+	ber_sim_point_t *point;
+	int received[BER_SIM_TX_FRAMES + 1];
+	long first_sync_sample; // where the first frame starts, or -1 if it is not known yet
+	long last_sync_sample;
+} ber_sim_rx_t;
+
+/* The passes that are shared out between the threads */
+typedef struct {
+	ber_sim_tx_t *tx;
+	ber_sim_point_t *points;
+	int num_points;
+	int passes;
+	int next_item;
+	pthread_mutex_t mutex;
+} ber_sim_work_t;
+
+static inline uint64_t ber_sim_random(ber_sim_rng_t *r) {
+	uint64_t z = (r->state += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/* Uniform between 0 and 1, but never 0 */
+static inline double ber_sim_uniform(ber_sim_rng_t *r) {
+	return ((ber_sim_random(r) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/* Box Muller.  This makes two values at a time */
+static inline double ber_sim_gaussian(ber_sim_rng_t *r) {
+	if (r->have_spare) {
+		r->have_spare = false;
+		return r->spare;
+	}
+	double radius = sqrt(-2.0 * log(ber_sim_uniform(r)));
+	double angle = 2.0 * M_PI * ber_sim_uniform(r);
+	r->spare = radius * sin(angle);
+	r->have_spare = true;
+	return radius * cos(angle);
+}
+
+int ber_sim_transmit(ber_sim_tx_t *tx, int frames, uint64_t seed) {
+	memset(tx, 0, sizeof(ber_sim_tx_t));
+	if (frames < 1 || frames > BER_SIM_TX_FRAMES) {
+		error_print("Can not simulate %d frames, it must be 1 to %d\n", frames, BER_SIM_TX_FRAMES);
+		return EXIT_FAILURE;
+	}
+	double samples_per_bit = (double)g_sample_rate / g_duv_bit_rate;
+	int sent = frames + 1;
+	tx->frames = frames;
+	tx->samples_per_frame = (long)((DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD * samples_per_bit);
+	/* Two extra words so the last frame gets through the filters */
+	int periods = (int)((sent * (DUV_PACKET_LENGTH + 1) + 3) * BITS_PER_10b_WORD * samples_per_bit / PERIOD_SIZE) + 1;
+	tx->samples = (long)periods * PERIOD_SIZE;
+	tx->audio = malloc(tx->samples * sizeof(float));
+	tx->bytes = malloc(sent * sizeof(*tx->bytes));
+	tx->words = malloc(sent * sizeof(*tx->words));
+	if (tx->audio == NULL || tx->bytes == NULL || tx->words == NULL) {
+		error_print("Could not allocate %ld samples for the simulation\n", tx->samples);
+		ber_sim_free_tx(tx);
+		return EXIT_FAILURE;
+	}
+	ber_sim_rng_t rng = { seed, false, 0 };
+	for (int f=0; f < sent; f++)
+		for (int i=0; i < DUV_DATA_LENGTH; i++)
+			tx->bytes[f][i] = ber_sim_random(&rng) & 0xff;
+
+	/* DUV telemetry on its own, with the filter and ramp settings from the config */
+	int send_telem = get_send_telem();
+	int send_high_speed_telem = get_send_high_speed_telem();
+	int send_duv_with_high_speed = get_send_duv_with_high_speed();
+	int send_test_telem = get_send_test_telem();
+	int send_test_tone = get_send_test_tone();
+	int measure_test_tone = get_measure_test_tone();
+	set_send_telem(true);
+	set_send_high_speed_telem(false);
+	set_send_duv_with_high_speed(false);
+	set_send_test_telem(false);
+	set_send_test_tone(false);
+	set_measure_test_tone(false);
+
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	int rc = init_audio_processor();
+	if (rc == EXIT_SUCCESS) {
+		static float in[PERIOD_SIZE];
+		telem_stream_t *stream = telem_processor_stream(TELEM_STREAM_MAIN);
+		int next = 0;
+		memset(in, 0, sizeof(in));
+		for (int p=0; p < periods; p++) {
+			/* After the last frame keep sending the first one so the stream is never empty */
+			if (telem_thread_supply_packet(TELEM_STREAM_MAIN, tx->bytes[next % sent])) {
+				if (next < sent)
+					memcpy(tx->words[next], stream->encoded_packet[telem_thread_get_packet_num(TELEM_STREAM_MAIN)],
+							sizeof(tx->words[next]));
+				next++;
+			}
+			audio_loop(in, &tx->audio[(long)p * PERIOD_SIZE], PERIOD_SIZE);
+		}
+	}
+
+	set_send_telem(send_telem);
+	set_send_high_speed_telem(send_high_speed_telem);
+	set_send_duv_with_high_speed(send_duv_with_high_speed);
+	set_send_test_telem(send_test_telem);
+	set_send_test_tone(send_test_tone);
+	set_measure_test_tone(measure_test_tone);
+	audio_processor_publish_params();
+	if (rc != EXIT_SUCCESS) {
+		ber_sim_free_tx(tx);
+		return rc;
+	}
+
+	double sum = 0;
+	for (long i=0; i < tx->samples; i++)
+		sum += (double)tx->audio[i] * tx->audio[i];
+	tx->signal_power = sum / tx->samples;
+
+	/*
+	 * Decode it with no noise to find where the frames start.  The first frame may be missed while
+	 * the demodulator finds the bit timing, so count back from the last one.  Then decode it again
+	 * and check that every frame is there.
+	 */
+	ber_sim_point_t point;
+	memset(&point, 0, sizeof(point));
+	tx->first_sync_sample = -1;
+	ber_sim_pass(tx, -1, 0, 0, &point);
+	ber_sim_pass(tx, -1, 0, 0, &point);
+	verbose_print(" sent %d frames in %ld samples, signal power %.4f, first frame at sample %ld\n", frames,
+			tx->samples, tx->signal_power, tx->first_sync_sample);
+	if (tx->first_sync_sample < 0 || point.frames_missed != 0 || point.frames_failed != 0 || point.bit_errors != 0) {
+		error_print("The audio loop output could not be decoded. %ld frames missed, %ld failed, %ld bit errors\n",
+				point.frames_missed, point.frames_failed, point.bit_errors);
+		ber_sim_free_tx(tx);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void ber_sim_free_tx(ber_sim_tx_t *tx) {
+	free(tx->audio);
+	free(tx->bytes);
+	free(tx->words);
+	tx->audio = NULL;
+	tx->bytes = NULL;
+	tx->words = NULL;
+}
+
+void ber_sim_pass(ber_sim_tx_t *tx, double ebn0_db, double hpf_freq, uint64_t seed, ber_sim_point_t *point) {
+	duv_demodulator_t demod;
+	ber_sim_rx_t rx;
+	memset(&rx, 0, sizeof(rx));
+	rx.tx = tx;
+	rx.point = point;
+	rx.first_sync_sample = tx->first_sync_sample;
+	duv_demodulator_init(&demod, g_sample_rate, DUV_DECIMATION_RATE, g_duv_bit_rate, ber_sim_frame, &rx);
+
+	ber_sim_rng_t rng = { seed, false, 0 };
+	double sigma = 0;
+	if (ebn0_db >= 0) {
+		double ebn0 = pow(10.0, ebn0_db / 10.0);
+		sigma = sqrt(tx->signal_power * g_sample_rate / (2.0 * g_duv_bit_rate * ebn0));
+	}
+	double hpf_alpha = 1.0;
+	if (hpf_freq > 0) {
+		double rc = 1.0 / (2 * M_PI * hpf_freq);
+		hpf_alpha = rc / (rc + 1.0 / g_sample_rate);
+	}
+	double last_x = 0, last_y = 0;
+
+	float block[BER_SIM_BLOCK];
+	for (long start=0; start < tx->samples; start += BER_SIM_BLOCK) {
+		int n = tx->samples - start < BER_SIM_BLOCK ? tx->samples - start : BER_SIM_BLOCK;
+		for (int i=0; i < n; i++) {
+			double x = tx->audio[start + i];
+			double y = x;
+			if (hpf_freq > 0) {
+				y = hpf_alpha * (last_y + x - last_x);
+				last_x = x;
+				last_y = y;
+			}
+			if (sigma > 0)
+				y += sigma * ber_sim_gaussian(&rng);
+			block[i] = y;
+		}
+		duv_demodulator_process(&demod, block, n);
+	}
+
+	if (tx->first_sync_sample < 0) {
+		/* Only finding the frames.  The last one is always there */
+		if (rx.last_sync_sample > 0)
+			tx->first_sync_sample = rx.last_sync_sample - tx->frames * tx->samples_per_frame;
+		return;
+	}
+	point->frames += tx->frames;
+	for (int f=1; f <= tx->frames; f++)
+		if (!rx.received[f])
+			point->frames_missed++;
+}
+
+/* Called by the demodulator for each frame */
+void ber_sim_frame(duv_frame_t *frame, void *arg) {
+	ber_sim_rx_t *rx = arg;
+	ber_sim_tx_t *tx = rx->tx;
+	if (rx->first_sync_sample < 0) {
+		rx->last_sync_sample = frame->sample;
+		return;
+	}
+	long from_first = frame->sample - rx->first_sync_sample;
+	long f = (from_first + tx->samples_per_frame / 2) / tx->samples_per_frame;
+	long offset = from_first - f * tx->samples_per_frame;
+	long half_bit = g_sample_rate / g_duv_bit_rate / 2;
+	if (from_first < -half_bit || f > tx->frames || rx->received[f] || labs(offset) > half_bit)
+		return;
+	rx->received[f] = true;
+	if (f == 0)
+		return; // the demodulator was still finding the bit timing
+
+	rx->point->bits += DUV_PACKET_LENGTH * BITS_PER_10b_WORD;
+	for (int i=0; i < DUV_PACKET_LENGTH; i++)
+		rx->point->bit_errors += __builtin_popcount((frame->words[i] ^ tx->words[f][i]) & CHARACTER_MASK);
+	if (!frame->rs_ok)
+		rx->point->frames_failed++;
+	else if (frame->rs_corrected > 0)
+		rx->point->frames_corrected++;
+	rx->point->symbols_corrected += frame->rs_corrected;
+}
+
+void *ber_sim_thread(void *arg) {
+	ber_sim_work_t *work = arg;
+	int items = work->num_points * work->passes;
+	while (true) {
+		int item = __atomic_fetch_add(&work->next_item, 1, __ATOMIC_RELAXED);
+		if (item >= items)
+			break;
+		ber_sim_point_t *point = &work->points[item / work->passes];
+		ber_sim_point_t result;
+		memset(&result, 0, sizeof(result));
+		uint64_t seed = BER_SIM_SEED ^ ((uint64_t)(item / work->passes) << 32) ^ (item % work->passes);
+		ber_sim_pass(work->tx, point->ebn0_db, BER_SIM_HPF_FREQ, seed, &result);
+
+		pthread_mutex_lock(&work->mutex);
+		point->frames += result.frames;
+		point->bits += result.bits;
+		point->bit_errors += result.bit_errors;
+		point->frames_missed += result.frames_missed;
+		point->frames_failed += result.frames_failed;
+		point->frames_corrected += result.frames_corrected;
+		point->symbols_corrected += result.symbols_corrected;
+		pthread_mutex_unlock(&work->mutex);
+	}
+	return NULL;
+}
+
+int ber_sim_run(int frames) {
+	ber_sim_tx_t tx;
+	ber_sim_work_t work;
+	struct timespec start, end;
+
+	printf("\nDUV bit and frame error rate simulation\n");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int tx_frames = frames < BER_SIM_TX_FRAMES ? frames : BER_SIM_TX_FRAMES;
+	int rc = ber_sim_transmit(&tx, tx_frames, BER_SIM_SEED);
+	if (rc != EXIT_SUCCESS)
+		return rc;
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double tx_sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1E9;
+
+	memset(&work, 0, sizeof(work));
+	pthread_mutex_init(&work.mutex, NULL);
+	work.tx = &tx;
+	work.passes = (frames + tx_frames - 1) / tx_frames;
+	work.num_points = BER_SIM_MAX_EBN0_DB - BER_SIM_MIN_EBN0_DB + 1;
+	ber_sim_point_t points[work.num_points];
+	memset(points, 0, sizeof(points));
+	for (int p=0; p < work.num_points; p++)
+		points[p].ebn0_db = BER_SIM_MIN_EBN0_DB + p;
+	work.points = points;
+
+	int num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads < 1)
+		num_threads = 1;
+	if (num_threads > work.num_points * work.passes)
+		num_threads = work.num_points * work.passes;
+	printf("%d frames of %d bits at each Eb/N0 in %d passes, %.1f Hz radio high pass filter, %d threads\n",
+			work.passes * tx_frames, (DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD, work.passes, BER_SIM_HPF_FREQ, num_threads);
+	printf("Audio loop generated %d frames in %.1f sec\n", tx_frames, tx_sec);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_t threads[num_threads];
+	int started = 0;
+	for (int t=0; t < num_threads; t++) {
+		if (pthread_create(&threads[t], NULL, ber_sim_thread, &work) != 0) {
+			error_print("Could not start simulation thread %d\n", t);
+			break;
+		}
+		started++;
+	}
+	if (started == 0)
+		ber_sim_thread(&work);
+	for (int t=0; t < started; t++)
+		pthread_join(threads[t], NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double sim_sec = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1E9;
+
+	/* The FER before FEC counts the frames that needed correcting, after FEC only those that could not be corrected */
+	printf(" Eb/N0 dB |   frames |       bits | bit errors |       BER | theory BER |  missed | RS fixed |"
+			" RS bytes | RS fail |   pre FEC FER |       FER\n");
+	for (int p=0; p < work.num_points; p++) {
+		ber_sim_point_t *pt = &points[p];
+		double ber = pt->bits ? (double)pt->bit_errors / pt->bits : 0;
+		double theory = 0.5 * erfc(sqrt(pow(10.0, pt->ebn0_db / 10.0)));
+		double fer = pt->frames ? (double)(pt->frames_missed + pt->frames_failed) / pt->frames : 0;
+		double pre_fer = pt->frames ? (double)(pt->frames_missed + pt->frames_failed + pt->frames_corrected) / pt->frames : 0;
+		printf(" %8.1f | %8ld | %10ld | %10ld | %9.2e | %10.2e | %7ld | %8ld | %8ld | %7ld | %13.2e | %9.2e\n",
+				pt->ebn0_db, pt->frames, pt->bits, pt->bit_errors, ber, theory, pt->frames_missed,
+				pt->frames_corrected, pt->symbols_corrected, pt->frames_failed, pre_fer, fer);
+	}
+	printf("Simulated %.1f hours of audio in %.1f sec\n",
+			(double)tx.samples * work.passes * work.num_points / g_sample_rate / 3600, sim_sec);
+
+	pthread_mutex_destroy(&work.mutex);
+	ber_sim_free_tx(&tx);
+	return EXIT_SUCCESS;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+#define TEST_BER_SIM_FRAMES 2
+#define TEST_BER_SIM_HIGH_EBN0_DB 20
+
+/*
+ * Loopback through the audio loop.  ber_sim_transmit() checks that the frames decode with no
+ * noise.  Then there should be no errors at a high Eb/N0, errors at 0 dB, and the same seed
+ * should give the same errors.
+ */
+int test_ber_sim() {
+	printf("TESTING ber_sim .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	ber_sim_tx_t tx;
+	if (ber_sim_transmit(&tx, TEST_BER_SIM_FRAMES, BER_SIM_SEED) != EXIT_SUCCESS) {
+		printf(" Fail\n");
+		return EXIT_FAILURE;
+	}
+
+	ber_sim_point_t high, low, again;
+	memset(&high, 0, sizeof(high));
+	memset(&low, 0, sizeof(low));
+	memset(&again, 0, sizeof(again));
+	ber_sim_pass(&tx, TEST_BER_SIM_HIGH_EBN0_DB, BER_SIM_HPF_FREQ, 1, &high);
+	ber_sim_pass(&tx, 0, BER_SIM_HPF_FREQ, 2, &low);
+	ber_sim_pass(&tx, 0, BER_SIM_HPF_FREQ, 2, &again);
+	verbose_print(" %d dB: %ld bit errors in %ld bits, %ld frames missed, %ld failed\n", TEST_BER_SIM_HIGH_EBN0_DB,
+			high.bit_errors, high.bits, high.frames_missed, high.frames_failed);
+	verbose_print(" 0 dB: %ld bit errors in %ld bits, %ld frames missed, %ld failed\n",
+			low.bit_errors, low.bits, low.frames_missed, low.frames_failed);
+	if (high.bit_errors != 0 || high.frames_missed != 0 || high.frames_failed != 0)
+		fail = EXIT_FAILURE;
+	if (low.bit_errors + low.frames_missed == 0)
+		fail = EXIT_FAILURE;
+	if (memcmp(&low, &again, sizeof(low)) != 0)
+		fail = EXIT_FAILURE;
+
+	ber_sim_free_tx(&tx);
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,299 @@
+/*
+ * duv_demodulator.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The demodulator keeps all of its state in duv_demodulator_t, so several can run at once in
+ * different threads.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "duv_demodulator.h"
+#include "../../telem_send/inc/TelemEncoding.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/rs_decoder.h"
+
+/* Forward function declarations */
+void duv_demodulator_bit(duv_demodulator_t *d, int bit);
+void duv_demodulator_end_frame(duv_demodulator_t *d);
+
+int duv_demodulator_init(duv_demodulator_t *d, int sample_rate, int decimation_rate, int bit_rate,
+		duv_frame_callback_t callback, void *arg) {
+	memset(d, 0, sizeof(duv_demodulator_t));
+	d->decimation_rate = decimation_rate;
+	d->samples_per_bit = sample_rate / decimation_rate / bit_rate;
+	if (d->samples_per_bit < 2 || d->samples_per_bit > DUV_DEMOD_MAX_SAMPLES_PER_BIT) {
+		error_print("Can not demodulate %d bps with %d samples per bit\n", bit_rate, d->samples_per_bit);
+		return EXIT_FAILURE;
+	}
+	d->bit_phase_step = (double)bit_rate * decimation_rate / sample_rate;
+	d->frame_callback = callback;
+	d->frame_callback_arg = arg;
+	d->bits_after_frame = BITS_PER_10b_WORD; // no frame yet, so the first sync word must be exact
+	return EXIT_SUCCESS;
+}
+
+int duv_demodulator_decode_word(duv_demodulator_t *d, uint16_t word) {
+	uint16_t entry = decode_8b10b_lookup(word);
+	if (!(entry & (DECODE_8B10B_RD_MINUS | DECODE_8B10B_RD_PLUS)) || (entry & DECODE_8B10B_SYNC))
+		return DUV_DEMOD_INVALID_WORD;
+	return entry & DECODE_8B10B_DATA;
+}
+
+void duv_demodulator_process(duv_demodulator_t *d, float *in, int nframes) {
+	for (int i=0; i < nframes; i++) {
+		d->samples++;
+		d->decimate_sum += in[i];
+		if (++d->decimate_count < d->decimation_rate)
+			continue;
+		double x = d->decimate_sum / d->decimation_rate;
+		d->decimate_count = 0;
+		d->decimate_sum = 0;
+
+		/* Integrate over the last bit */
+		d->filter_sum += x - d->filter_xv[d->filter_pos];
+		d->filter_xv[d->filter_pos] = x;
+		if (++d->filter_pos == d->samples_per_bit)
+			d->filter_pos = 0;
+		double y = d->filter_sum;
+
+		/*
+		 * Until the timing is found, jump to each zero crossing, which is half way between two bits.
+		 * Noise gives crossings at any time, so the timing is found once several crossings in a row
+		 * are where they were expected.
+		 */
+		double phase = d->bit_phase;
+		d->bit_phase += d->bit_phase_step;
+		if (!d->timing_locked && d->last_filter_value != 0 && (y < 0) != (d->last_filter_value < 0)) {
+			double fraction = d->last_filter_value / (d->last_filter_value - y);
+			double error = phase + fraction * d->bit_phase_step - 0.5;
+			error -= floor(error + 0.5);
+			if (fabs(error) < DUV_DEMOD_ACQUIRE_TOLERANCE)
+				d->good_crossings++;
+			else
+				d->good_crossings = 0;
+			d->timing_locked = d->good_crossings >= DUV_DEMOD_ACQUIRE_CROSSINGS;
+			d->bit_phase = 0.5 + (1 - fraction) * d->bit_phase_step;
+		}
+		d->last_filter_value = y;
+		if (phase < 0.5 && d->bit_phase >= 0.5)
+			d->mid_value = y;
+
+		if (d->bit_phase >= 1.0) {
+			d->bit_phase -= 1.0;
+			/*
+			 * Gardner timing error.  If there was a change between the last bit and this one then
+			 * the value half way between them should be zero.  The filter output changes by twice
+			 * the amplitude over one bit, so this gives how late the bits are as a fraction of a bit.
+			 */
+			int bit = y > 0;
+			if (bit != d->last_bit && d->amplitude > 0) {
+				double late = d->mid_value / (2 * d->amplitude);
+				if (!bit) late = -late;
+				if (late > 0.5) late = 0.5;
+				if (late < -0.5) late = -0.5;
+				d->bit_phase += DUV_DEMOD_TIMING_GAIN * late;
+			}
+			d->amplitude += DUV_DEMOD_AMPLITUDE_GAIN * (fabs(y) - d->amplitude);
+			d->last_bit = bit;
+			duv_demodulator_bit(d, bit);
+		}
+	}
+}
+
+/* Look for the sync word, or add the bit to the frame */
+void duv_demodulator_bit(duv_demodulator_t *d, int bit) {
+	d->bits++;
+	d->shift_reg = (d->shift_reg << 1) | bit;
+	uint16_t word = d->shift_reg & CHARACTER_MASK;
+	if (!d->in_frame) {
+		if (!d->timing_locked)
+			return; // the bits are noise or have the wrong timing
+		int errors = __builtin_popcount(word ^ DUV_DEMOD_SYNC_WORD);
+		int inverse_errors = __builtin_popcount(word ^ (~DUV_DEMOD_SYNC_WORD & CHARACTER_MASK));
+		if (inverse_errors < errors)
+			errors = inverse_errors;
+		/* The next sync word should follow straight after a frame, so it can have a few errors */
+		d->bits_after_frame++;
+		int allowed = d->bits_after_frame == BITS_PER_10b_WORD ? DUV_DEMOD_SYNC_ERRORS : 0;
+		if (errors <= allowed) {
+			d->in_frame = true;
+			d->bits_in_frame = 0;
+			d->frame.sample = d->samples;
+		}
+		return;
+	}
+	d->bits_in_frame++;
+	if (d->bits_in_frame % BITS_PER_10b_WORD == 0)
+		d->frame.words[d->bits_in_frame / BITS_PER_10b_WORD - 1] = word;
+	if (d->bits_in_frame == DUV_PACKET_LENGTH * BITS_PER_10b_WORD)
+		duv_demodulator_end_frame(d);
+}
+
+/* Decode the words and correct them with the parities.  The next frame starts with the sync word after this one */
+void duv_demodulator_end_frame(duv_demodulator_t *d) {
+	duv_frame_t *f = &d->frame;
+	d->in_frame = false;
+	d->bits_after_frame = 0;
+	f->invalid_words = 0;
+	/* The sync word may have had bit errors, so the running disparity is taken from the first word */
+	decode_8b10b_t decoder;
+	decode_8b10b_start(&decoder, DECODE_8B10B_RD_UNKNOWN);
+	for (int i=0; i < DUV_PACKET_LENGTH; i++) {
+		int c = decode_8b10b(&decoder, f->words[i]);
+		if (c < 0) {
+			f->invalid_words++;
+			c = 0;
+		}
+		f->bytes[i] = c;
+	}
+	f->disparity_errors = decoder.disparity_errors;
+	/* An invalid word is a zero byte, which the decoder corrects like any other error */
+	int corrected = rs_decode(f->bytes, DUV_DATA_LENGTH, NULL);
+	f->rs_ok = corrected != RS_DECODE_FAILED;
+	f->rs_corrected = f->rs_ok ? corrected : 0;
+
+	d->frames++;
+	if (f->rs_ok)
+		d->frames_rs_ok++;
+	d->rs_corrected += f->rs_corrected;
+	if (d->frame_callback != NULL)
+		d->frame_callback(f, d->frame_callback_arg);
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+#define TEST_DEMOD_FRAMES 2
+
+duv_frame_t test_demod_frames[TEST_DEMOD_FRAMES];
+int test_demod_frames_received = 0;
+
+void test_demod_frame(duv_frame_t *frame, void *arg) {
+	if (test_demod_frames_received < TEST_DEMOD_FRAMES)
+		test_demod_frames[test_demod_frames_received] = *frame;
+	test_demod_frames_received++;
+}
+
+/*
+ * Send two frames as plain levels, starting part way through a bit and with the bit rate a
+ * little fast, so that the timing recovery has to work.  Then check the bytes and the parities.
+ * The second frame has a code word changed to another valid one, so only the RS check finds it,
+ * and one word that is not a code word.
+ */
+int test_duv_demodulator() {
+	printf("TESTING duv_demodulator .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	duv_demodulator_t *d = malloc(sizeof(duv_demodulator_t));
+	int words_len = 3 + TEST_DEMOD_FRAMES * (DUV_PACKET_LENGTH + 1) + 2;
+	uint16_t words[words_len];
+	unsigned char bytes[DUV_PACKET_LENGTH];
+	int sample_rate = 48000;
+	double samples_per_bit = (double)sample_rate / DUV_BPS / 1.002;
+	int len = (int)((words_len * BITS_PER_10b_WORD + 2) * samples_per_bit) + 200;
+	float *audio = calloc(len, sizeof(float));
+
+	if (d == NULL || audio == NULL || duv_demodulator_init(d, sample_rate, 4, DUV_BPS, test_demod_frame, NULL) != EXIT_SUCCESS) {
+		printf(" Fail\n");
+		free(d);
+		free(audio);
+		return EXIT_FAILURE;
+	}
+
+	/* Two words so that the timing is found before the first sync word */
+	int rd = 0;
+	int w = 0;
+	words[w++] = encode_8b10b(&rd, 0x4a);
+	words[w++] = encode_8b10b(&rd, 0x4a);
+	words[w++] = encode_8b10b(&rd, -1);
+	for (int f=0; f < TEST_DEMOD_FRAMES; f++) {
+		unsigned char parities[DUV_PARITIES_LENGTH];
+		memset(parities, 0, sizeof(parities));
+		for (int i=0; i < DUV_DATA_LENGTH; i++) {
+			bytes[i] = (i * 37 + f * 11) & 0xff;
+			update_rs(parities, bytes[i]);
+		}
+		memcpy(&bytes[DUV_DATA_LENGTH], parities, DUV_PARITIES_LENGTH);
+		for (int i=0; i < DUV_PACKET_LENGTH; i++)
+			words[w++] = encode_8b10b(&rd, bytes[i]);
+		words[w++] = encode_8b10b(&rd, -1);
+	}
+	words[w++] = encode_8b10b(&rd, 0x55);
+	words[w++] = encode_8b10b(&rd, 0x55);
+	int changed = 3 + DUV_PACKET_LENGTH + 1 + 10; // word 10 of the second frame, which is not zero
+	int state = 0;
+	words[changed] = encode_8b10b(&state, 0x00);
+	words[changed + 20] = 0x000; // not a code word
+
+	/* 123 samples of silence, then the bits */
+	for (int b=0; b < w * BITS_PER_10b_WORD; b++) {
+		int bit = (words[b / BITS_PER_10b_WORD] >> (9 - b % BITS_PER_10b_WORD)) & 1;
+		for (int s = 123 + (int)(b * samples_per_bit); s < 123 + (int)((b + 1) * samples_per_bit); s++)
+			audio[s] = bit ? 0.5 : -0.5;
+	}
+	test_demod_frames_received = 0;
+	duv_demodulator_process(d, audio, len);
+
+	verbose_print(" frames %d, first ok %d with %d invalid words, second ok %d with %d invalid words,"
+			" %d disparity errors and %d bytes corrected\n",
+			test_demod_frames_received, test_demod_frames[0].rs_ok, test_demod_frames[0].invalid_words,
+			test_demod_frames[1].rs_ok, test_demod_frames[1].invalid_words, test_demod_frames[1].disparity_errors,
+			test_demod_frames[1].rs_corrected);
+	if (test_demod_frames_received != TEST_DEMOD_FRAMES)
+		fail = EXIT_FAILURE;
+	else {
+		for (int i=0; i < DUV_DATA_LENGTH; i++)
+			if (test_demod_frames[0].bytes[i] != ((i * 37) & 0xff)) {
+				verbose_print(" byte %d is %x\n", i, test_demod_frames[0].bytes[i]);
+				fail = EXIT_FAILURE;
+			}
+		if (!test_demod_frames[0].rs_ok || test_demod_frames[0].invalid_words != 0
+				|| test_demod_frames[0].disparity_errors != 0 || test_demod_frames[0].rs_corrected != 0)
+			fail = EXIT_FAILURE;
+		/* The changed byte and the invalid word are both corrected */
+		if (!test_demod_frames[1].rs_ok || test_demod_frames[1].invalid_words != 1
+				|| test_demod_frames[1].rs_corrected != 2)
+			fail = EXIT_FAILURE;
+		for (int i=0; i < DUV_DATA_LENGTH; i++)
+			if (test_demod_frames[1].bytes[i] != ((i * 37 + 11) & 0xff))
+				fail = EXIT_FAILURE;
+		if (d->frames_rs_ok != 2 || d->rs_corrected != 2)
+			fail = EXIT_FAILURE;
+	}
+
+	free(d);
+	free(audio);
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
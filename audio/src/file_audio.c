@@ -0,0 +1,347 @@
+/*
+ * file_audio.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * File and null audio backends.  These call the process callback one period at a
+ * time, as fast as possible, from their own thread.  This lets us benchmark and
+ * regression test the audio pipeline without jackd or a sound card.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_processor.h"
+#include "audio_backend.h"
+#include "audio_tools.h"
+#include "file_audio.h"
+#include "TelemEncoding.h"
+
+/* Forward function declarations */
+int file_audio_open(audio_process_callback_t process);
+int null_audio_open(audio_process_callback_t process);
+int file_audio_start(void);
+int file_audio_stop(void);
+int file_audio_wait(void);
+int file_audio_get_buffer_size(void);
+int file_audio_get_sample_rate(void);
+int file_audio_get_xruns(void);
+int file_audio_read_wav_header(FILE *file);
+void file_audio_write_wav_header(FILE *file, unsigned int data_bytes);
+int file_audio_read_period(jack_default_audio_sample_t *in);
+void *file_audio_process(void *arg);
+
+audio_backend_t file_audio_backend = {
+		.name = "file",
+		.open = file_audio_open,
+		.start = file_audio_start,
+		.stop = file_audio_stop,
+		.wait = file_audio_wait,
+		.get_buffer_size = file_audio_get_buffer_size,
+		.get_sample_rate = file_audio_get_sample_rate,
+		.get_xruns = file_audio_get_xruns
+};
+
+audio_backend_t null_audio_backend = {
+		.name = "null",
+		.open = null_audio_open,
+		.start = file_audio_start,
+		.stop = file_audio_stop,
+		.wait = file_audio_wait,
+		.get_buffer_size = file_audio_get_buffer_size,
+		.get_sample_rate = file_audio_get_sample_rate,
+		.get_xruns = file_audio_get_xruns
+};
+
+#define WAV_FORMAT_PCM 1
+#define WAV_FORMAT_FLOAT 3
+#define WAV_HEADER_LEN 44
+
+char *file_audio_input_name = NULL;
+char *file_audio_output_name = NULL;
+int file_audio_max_periods = 0;
+
+FILE *file_audio_in = NULL;
+FILE *file_audio_out = NULL;
+audio_process_callback_t file_process_callback;
+pthread_t file_audio_pthread;
+int file_audio_thread_started = false;
+int file_audio_running = false; // set by the control thread and read by the process thread
+
+/* Format of the input.  Raw files use the defaults */
+int in_channels = 1;
+int in_bits_per_sample = 16;
+int in_format = WAV_FORMAT_PCM;
+int in_sample_rate = 0;
+unsigned int out_data_bytes = 0;
+
+/* Results of the last run */
+int periods_processed = 0;
+double run_time_sec = 0.0;
+double realtime_factor = 0.0;
+
+void file_audio_configure(char *input_file, char *output_file, int periods) {
+	file_audio_input_name = input_file;
+	file_audio_output_name = output_file;
+	file_audio_max_periods = periods;
+}
+
+double file_audio_get_realtime_factor() { return realtime_factor; }
+int file_audio_get_buffer_size(void) { return PERIOD_SIZE; }
+int file_audio_get_sample_rate(void) { return in_sample_rate; }
+int file_audio_get_xruns(void) { return 0; } /* We never run out of time, we just run slower */
+
+/*
+ * Open the input and output files.  If the input name ends in .wav then the header is
+ * read to get the format, otherwise it is read as raw 16 bit samples.
+ */
+int file_audio_open(audio_process_callback_t process) {
+	file_process_callback = process;
+	in_sample_rate = g_sample_rate;
+	in_channels = 1;
+	in_bits_per_sample = 16;
+	in_format = WAV_FORMAT_PCM;
+
+	if (file_audio_input_name != NULL) {
+		file_audio_in = fopen(file_audio_input_name, "rb");
+		if (file_audio_in == NULL) {
+			error_print("Could not open audio input file: %s\n", file_audio_input_name);
+			return EXIT_FAILURE;
+		}
+		int len = strlen(file_audio_input_name);
+		if (len > 4 && strcasecmp(&file_audio_input_name[len-4], ".wav") == 0) {
+			if (file_audio_read_wav_header(file_audio_in) != EXIT_SUCCESS) {
+				fclose(file_audio_in);
+				file_audio_in = NULL;
+				return EXIT_FAILURE;
+			}
+		}
+		verbose_print("Audio input: %s %d Hz %d channels %d bits\n", file_audio_input_name,
+				in_sample_rate, in_channels, in_bits_per_sample);
+	}
+
+	if (file_audio_output_name != NULL) {
+		file_audio_out = fopen(file_audio_output_name, "wb");
+		if (file_audio_out == NULL) {
+			error_print("Could not open audio output file: %s\n", file_audio_output_name);
+			if (file_audio_in != NULL) {
+				fclose(file_audio_in);
+				file_audio_in = NULL;
+			}
+			return EXIT_FAILURE;
+		}
+		out_data_bytes = 0;
+		file_audio_write_wav_header(file_audio_out, out_data_bytes);
+	}
+	return EXIT_SUCCESS;
+}
+
+/*
+ * The null backend is the file backend without any files
+ */
+int null_audio_open(audio_process_callback_t process) {
+	file_audio_input_name = NULL;
+	file_audio_output_name = NULL;
+	return file_audio_open(process);
+}
+
+/*
+ * Read the RIFF chunks until we find the data chunk.  We support 16 bit PCM and 32 bit
+ * float with any number of channels.  Only the first channel is processed.
+ */
+int file_audio_read_wav_header(FILE *file) {
+	unsigned char hdr[12];
+	if (fread(hdr, 1, 12, file) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(&hdr[8], "WAVE", 4) != 0) {
+		error_print("Not a WAV file\n");
+		return EXIT_FAILURE;
+	}
+	unsigned char chunk[8];
+	while (fread(chunk, 1, 8, file) == 8) {
+		uint32_t chunk_len = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((uint32_t)chunk[7] << 24);
+		if (memcmp(chunk, "fmt ", 4) == 0) {
+			unsigned char fmt[16];
+			if (chunk_len < 16 || fread(fmt, 1, 16, file) != 16) {
+				error_print("WAV format chunk is too short\n");
+				return EXIT_FAILURE;
+			}
+			in_format = fmt[0] | (fmt[1] << 8);
+			in_channels = fmt[2] | (fmt[3] << 8);
+			in_sample_rate = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | (fmt[7] << 24);
+			in_bits_per_sample = fmt[14] | (fmt[15] << 8);
+			fseek(file, chunk_len - 16 + (chunk_len & 1), SEEK_CUR);
+		} else if (memcmp(chunk, "data", 4) == 0) {
+			if (!((in_format == WAV_FORMAT_PCM && in_bits_per_sample == 16)
+					|| (in_format == WAV_FORMAT_FLOAT && in_bits_per_sample == 32)) || in_channels < 1) {
+				error_print("Unsupported WAV format %d with %d bits\n", in_format, in_bits_per_sample);
+				return EXIT_FAILURE;
+			}
+			return EXIT_SUCCESS; /* The file is now positioned at the first sample */
+		} else {
+			fseek(file, chunk_len + (chunk_len & 1), SEEK_CUR);
+		}
+	}
+	error_print("No data chunk in WAV file\n");
+	return EXIT_FAILURE;
+}
+
+/*
+ * Write a mono 16 bit PCM header.  This is written with a zero length when the file is
+ * opened and rewritten with the real length when it is closed.
+ */
+void file_audio_write_wav_header(FILE *file, unsigned int data_bytes) {
+	int bytes_per_sample = 2;
+	fwrite("RIFF", 1, 4, file);
+	write_little_endian(WAV_HEADER_LEN - 8 + data_bytes, 4, file);
+	fwrite("WAVE", 1, 4, file);
+	fwrite("fmt ", 1, 4, file);
+	write_little_endian(16, 4, file); /* fmt chunk length */
+	write_little_endian(WAV_FORMAT_PCM, 2, file);
+	write_little_endian(1, 2, file); /* channels */
+	write_little_endian(g_sample_rate, 4, file);
+	write_little_endian(g_sample_rate * bytes_per_sample, 4, file); /* byte rate */
+	write_little_endian(bytes_per_sample, 2, file); /* block align */
+	write_little_endian(16, 2, file); /* bits per sample */
+	fwrite("data", 1, 4, file);
+	write_little_endian(data_bytes, 4, file);
+}
+
+/*
+ * Read one period of samples from the first channel of the input.  A short final period
+ * is padded with silence.  Returns the number of frames read, zero at the end of the file.
+ */
+int file_audio_read_period(jack_default_audio_sample_t *in) {
+	static unsigned char raw[PERIOD_SIZE * 8 * 4]; /* Room for 8 channels of 32 bit samples */
+	static char mono[PERIOD_SIZE * 2];
+	int bytes_per_frame = in_channels * in_bits_per_sample / 8;
+	if (bytes_per_frame * PERIOD_SIZE > (int)sizeof(raw)) {
+		error_print("Too many channels in the input file: %d\n", in_channels);
+		return 0;
+	}
+	int frames = fread(raw, bytes_per_frame, PERIOD_SIZE, file_audio_in);
+	if (in_format == WAV_FORMAT_FLOAT) {
+		for (int i=0; i < frames; i++)
+			memcpy(&in[i], &raw[i * bytes_per_frame], sizeof(float));
+	} else {
+		for (int i=0; i < frames; i++) {
+			mono[2*i] = raw[i * bytes_per_frame];
+			mono[2*i+1] = raw[i * bytes_per_frame + 1];
+		}
+		get_floats_from_bytes(mono, in, frames * 2);
+	}
+	for (int i=frames; i < PERIOD_SIZE; i++)
+		in[i] = 0.0f;
+	return frames;
+}
+
+/*
+ * Process thread.  Read a period, call the process callback and write the result.  There
+ * is no pacing, so this measures how much faster than realtime the pipeline runs.
+ */
+void *file_audio_process(void *arg) {
+	static jack_default_audio_sample_t in[PERIOD_SIZE];
+	static jack_default_audio_sample_t out[PERIOD_SIZE];
+	static char out_bytes[PERIOD_SIZE * 2];
+	struct timespec ts_start, ts_end;
+
+	int max_periods = file_audio_max_periods;
+	if (max_periods == 0 && file_audio_in == NULL)
+		max_periods = NULL_AUDIO_DEFAULT_PERIODS;
+	for (int i=0; i < PERIOD_SIZE; i++)
+		in[i] = 0.0f;
+
+	periods_processed = 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts_start);
+	while (__atomic_load_n(&file_audio_running, __ATOMIC_RELAXED)) {
+		if (max_periods && periods_processed >= max_periods)
+			break;
+		if (file_audio_in != NULL)
+			if (file_audio_read_period(in) == 0)
+				break;
+
+		file_process_callback(in, out, PERIOD_SIZE);
+		periods_processed++;
+
+		if (file_audio_out != NULL) {
+			/* Clip rather than let the 16 bit value wrap around */
+			for (int i=0; i < PERIOD_SIZE; i++) {
+				if (out[i] > 32767.0f/32768.0f) out[i] = 32767.0f/32768.0f;
+				if (out[i] < -1.0f) out[i] = -1.0f;
+			}
+			get_bytes_from_floats(out, out_bytes, sizeof(out_bytes));
+			out_data_bytes += fwrite(out_bytes, 1, sizeof(out_bytes), file_audio_out);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &ts_end);
+
+	run_time_sec = (ts_end.tv_sec - ts_start.tv_sec) + (ts_end.tv_nsec - ts_start.tv_nsec) / 1E9;
+	double audio_sec = (double)periods_processed * PERIOD_SIZE / g_sample_rate;
+	realtime_factor = run_time_sec > 0 ? audio_sec / run_time_sec : 0;
+	printf("Processed %d periods (%.2f s of audio) in %.3f s.  Realtime factor: %.1f\n",
+			periods_processed, audio_sec, run_time_sec, realtime_factor);
+	__atomic_store_n(&file_audio_running, false, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+int file_audio_start(void) {
+	__atomic_store_n(&file_audio_running, true, __ATOMIC_RELAXED);
+	int rc = pthread_create(&file_audio_pthread, NULL, file_audio_process, NULL);
+	if (rc != EXIT_SUCCESS) {
+		error_print("Could not start the file audio thread\n");
+		__atomic_store_n(&file_audio_running, false, __ATOMIC_RELAXED);
+		return EXIT_FAILURE;
+	}
+	file_audio_thread_started = true;
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Wait for the process thread to reach the end of the input
+ */
+int file_audio_wait(void) {
+	if (file_audio_thread_started) {
+		pthread_join(file_audio_pthread, NULL);
+		file_audio_thread_started = false;
+	}
+	return EXIT_SUCCESS;
+}
+
+int file_audio_stop(void) {
+	__atomic_store_n(&file_audio_running, false, __ATOMIC_RELAXED);
+	file_audio_wait();
+	if (file_audio_in != NULL) {
+		fclose(file_audio_in);
+		file_audio_in = NULL;
+	}
+	if (file_audio_out != NULL) {
+		/* Now we know the length, rewrite the header */
+		fseek(file_audio_out, 0, SEEK_SET);
+		file_audio_write_wav_header(file_audio_out, out_data_bytes);
+		fclose(file_audio_out);
+		file_audio_out = NULL;
+	}
+	return EXIT_SUCCESS;
+}
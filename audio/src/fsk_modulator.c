@@ -0,0 +1,272 @@
+/*
+ * fsk_modulator.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The frequency at each sample is the sum of the last few bits, each weighted by the pulse at
+ * its distance from this sample.  The pulse weights always add up to one, so a run of the same
+ * bit sits exactly on the mark or space frequency.  The oscillator phase is a 32 bit number that
+ * wraps at one cycle, and the top bits index the sine table.
+ *
+ * The Gaussian frequency pulse is a one bit rectangle filtered by a Gaussian with bandwidth BT:
+ *   g(t) = 0.5 * (erf(c * (t + 0.5)) - erf(c * (t - 0.5))), c = pi * BT * sqrt(2 / ln 2)
+ * with t in bits from the center of the bit.  It is delayed by (span - 1) / 2 bits so that it
+ * only depends on bits that have already been sent.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "oscillator.h"
+#include "audio_perf.h"
+#include "audio_processor.h"
+#include "fsk_modulator.h"
+
+/* Forward function declarations */
+double fsk_gaussian_pulse(double t, double bt);
+
+#define FSK_PHASE_PER_CYCLE 4294967296.0 /* 2^32 */
+
+int fsk_modulation_type(char *name) {
+	if (strcmp(name, FSK_MODULATION_NRZ) == 0)
+		return FSK_NRZ;
+	if (strcmp(name, FSK_MODULATION_AFSK) == 0)
+		return FSK_AFSK;
+	if (strcmp(name, FSK_MODULATION_GFSK) == 0)
+		return FSK_GFSK;
+	return -1;
+}
+
+double fsk_gaussian_pulse(double t, double bt) {
+	double c = M_PI * bt * sqrt(2.0 / log(2.0));
+	return 0.5 * (erf(c * (t + 0.5)) - erf(c * (t - 0.5)));
+}
+
+int fsk_modulator_init(fsk_modulator_t *m, int modulation, int bit_rate, int sample_rate, double mark_freq,
+		double space_freq, double bt, double amplitude, fsk_next_bit_t next_bit, void *next_bit_arg) {
+	if (bit_rate <= 0 || bit_rate > sample_rate / 2 || bt <= 0) {
+		error_print("Can not modulate %d bps with BT %.2f at %d samples per second\n", bit_rate, bt, sample_rate);
+		return EXIT_FAILURE;
+	}
+	m->modulation = modulation;
+	m->bit_rate = bit_rate;
+	m->mark_freq = mark_freq;
+	m->space_freq = space_freq;
+	m->amplitude = amplitude;
+	m->bit_phase_step = bit_rate;
+	m->bit_phase_wrap = sample_rate;
+	m->center_step = (mark_freq + space_freq) / 2 * FSK_PHASE_PER_CYCLE / sample_rate;
+	m->deviation_step = (mark_freq - space_freq) / 2 * FSK_PHASE_PER_CYCLE / sample_rate;
+	m->next_bit = next_bit;
+	m->next_bit_arg = next_bit_arg;
+
+	/* AFSK changes frequency at the bit edge, so the pulse is one bit of 1 */
+	m->span = modulation == FSK_GFSK ? FSK_PULSE_SPAN_BITS : 1;
+	double delay = (m->span - 1) / 2.0;
+	for (int s=0; s <= FSK_PULSE_STEPS_PER_BIT; s++) {
+		double total = 0;
+		for (int j=0; j < m->span; j++) {
+			double t = j + (double)s / FSK_PULSE_STEPS_PER_BIT - 0.5 - delay;
+			m->pulse[j][s] = m->span == 1 ? 1.0 : fsk_gaussian_pulse(t, bt);
+			total += m->pulse[j][s];
+		}
+		/* The truncated tails are lost, so scale so that the weights add to one */
+		for (int j=0; j < m->span; j++)
+			m->pulse[j][s] = m->pulse[j][s] / total;
+	}
+
+	double sin_table[FSK_SIN_TABLE_SIZE];
+	gen_sin_table(sin_table, FSK_SIN_TABLE_SIZE);
+	for (int i=0; i < FSK_SIN_TABLE_SIZE; i++)
+		m->sin_table[i] = (float)(amplitude * sin_table[i]);
+
+	fsk_modulator_start(m);
+	return EXIT_SUCCESS;
+}
+
+void fsk_modulator_start(fsk_modulator_t *m) {
+	m->bit_phase = 0;
+	m->nco_phase = 0;
+	m->starting = true;
+	m->last_freq = 0;
+	for (int j=0; j < FSK_PULSE_SPAN_BITS; j++)
+		m->symbols[j] = -1.0; // idle on the space frequency
+}
+
+void fsk_modulator_block(fsk_modulator_t *m, float *out, int nframes) {
+	int span = m->span;
+	double shape = 0;
+	if (m->starting) {
+		m->starting = false;
+		m->symbols[0] = m->next_bit(m->next_bit_arg) ? 1.0 : -1.0;
+	}
+	for (int i=0; i < nframes; i++) {
+		/* Where we are in the current bit, in steps of the pulse table, and the fraction between two steps */
+		double position = (double)m->bit_phase * FSK_PULSE_STEPS_PER_BIT / m->bit_phase_wrap;
+		int s = (int)position;
+		double fraction = position - s;
+		shape = 0;
+		for (int j=0; j < span; j++) {
+			double weight = m->pulse[j][s] + fraction * (m->pulse[j][s+1] - m->pulse[j][s]);
+			shape += m->symbols[j] * weight;
+		}
+		m->nco_phase += (uint32_t)(int64_t)(m->center_step + shape * m->deviation_step);
+		out[i] = m->sin_table[m->nco_phase >> (32 - FSK_SIN_TABLE_BITS)];
+
+		m->bit_phase += m->bit_phase_step;
+		if (m->bit_phase >= m->bit_phase_wrap) {
+			m->bit_phase -= m->bit_phase_wrap;
+			for (int j=span-1; j > 0; j--)
+				m->symbols[j] = m->symbols[j-1];
+			m->symbols[0] = m->next_bit(m->next_bit_arg) ? 1.0 : -1.0;
+		}
+	}
+	m->last_freq = (m->mark_freq + m->space_freq) / 2 + shape * (m->mark_freq - m->space_freq) / 2;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_fsk_bits[] = {1,1,1,1,1,1,0,0,0,0,0,0,1,0,1,0,1,0,1,0,1,0,1,0,1,1,1,1,1,1};
+int test_fsk_bit_num = 0;
+
+int test_fsk_next_bit(void *arg) {
+	int n = sizeof(test_fsk_bits) / sizeof(test_fsk_bits[0]);
+	return test_fsk_bits[test_fsk_bit_num++ % n];
+}
+
+/*
+ * Send a run of ones, a run of zeros and then alternate bits.  A run must sit exactly on the mark
+ * or space frequency, the phase must never jump and the tone must be at the right frequency.
+ */
+int test_fsk_modulator() {
+	printf("TESTING fsk_modulator .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	static fsk_modulator_t m;
+	int sample_rate = 48000;
+	int modulations[] = {FSK_AFSK, FSK_GFSK};
+	int bit_rates[] = {1200, 1800}; // 1800 is 26.67 samples per bit
+	float out[2];
+
+	for (int t=0; t < 2; t++) {
+		int rc = fsk_modulator_init(&m, modulations[t], bit_rates[t], sample_rate, FSK_DEFAULT_MARK_FREQ,
+				FSK_DEFAULT_SPACE_FREQ, FSK_DEFAULT_GFSK_BT, 0.5, test_fsk_next_bit, NULL);
+		if (rc != EXIT_SUCCESS)
+			fail = EXIT_FAILURE;
+		test_fsk_bit_num = 0;
+		double samples_per_bit = (double)sample_rate / bit_rates[t];
+		double max_step = 2 * M_PI * FSK_DEFAULT_SPACE_FREQ / sample_rate * 0.5 + 2 * M_PI / FSK_SIN_TABLE_SIZE;
+		double max_jump = 0, min_alternate = 1E9, max_alternate = -1E9;
+		float last = 0;
+		int crossings = 0;
+
+		for (int n=0; n < 30 * samples_per_bit; n++) {
+			fsk_modulator_block(&m, out, 1);
+			double bit_time = n / samples_per_bit; // bits since the start
+			/* The last bit of a run of six is only a one if the whole pulse is in the run */
+			if (bit_time >= m.span && bit_time < 5) {
+				if (fabs(m.last_freq - FSK_DEFAULT_MARK_FREQ) > 1E-6)
+					fail = EXIT_FAILURE;
+				if (last <= 0 && out[0] > 0)
+					crossings++;
+			}
+			if (bit_time >= 6 + m.span && bit_time < 11)
+				if (fabs(m.last_freq - FSK_DEFAULT_SPACE_FREQ) > 1E-6)
+					fail = EXIT_FAILURE;
+			if (bit_time >= 12 + m.span && bit_time < 23) {
+				if (m.last_freq < min_alternate) min_alternate = m.last_freq;
+				if (m.last_freq > max_alternate) max_alternate = m.last_freq;
+			}
+			if (n > 0 && fabs(out[0] - last) > max_jump)
+				max_jump = fabs(out[0] - last);
+			last = out[0];
+		}
+		double run_time = (5 - m.span) / (double)bit_rates[t];
+		verbose_print(" %s %d bps: max step %.4f limit %.4f, alternate bits %.0f to %.0f Hz, %d cycles of mark in %.2f ms\n",
+				t == 0 ? "afsk" : "gfsk", bit_rates[t], max_jump, max_step, min_alternate, max_alternate, crossings, run_time * 1000);
+		if (max_jump > max_step)
+			fail = EXIT_FAILURE;
+		if (abs(crossings - (int)(run_time * FSK_DEFAULT_MARK_FREQ)) > 1)
+			fail = EXIT_FAILURE;
+		/* AFSK reaches both tones on every bit.  GFSK does not have time, but stays between them */
+		if (modulations[t] == FSK_AFSK && (min_alternate != FSK_DEFAULT_MARK_FREQ || max_alternate != FSK_DEFAULT_SPACE_FREQ))
+			fail = EXIT_FAILURE;
+		if (modulations[t] == FSK_GFSK && (min_alternate <= FSK_DEFAULT_MARK_FREQ || max_alternate >= FSK_DEFAULT_SPACE_FREQ
+				|| max_alternate - min_alternate < 100))
+			fail = EXIT_FAILURE;
+	}
+
+	if (fsk_modulation_type("gfsk") != FSK_GFSK || fsk_modulation_type("fm") != -1)
+		fail = EXIT_FAILURE;
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
+/******************************************************************************
+ *
+ * BENCHMARK FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* A PRBS-9 so the benchmark bits are not all the same */
+int bench_fsk_next_bit(void *arg) {
+	uint16_t *lfsr = arg;
+	int bit = ((*lfsr >> 8) ^ (*lfsr >> 4)) & 1;
+	*lfsr = ((*lfsr << 1) | bit) & 0x1ff;
+	return bit;
+}
+
+int bench_fsk_modulator(int periods) {
+	static fsk_modulator_t m;
+	static float out[PERIOD_SIZE];
+	uint16_t lfsr = 1;
+	int modulations[] = {FSK_AFSK, FSK_GFSK, FSK_GFSK, FSK_GFSK};
+	int bit_rates[] = {1200, 1200, 4800, 9600};
+
+	printf("BENCHMARK fsk modulator, %d periods of %d samples at %d\n", periods, PERIOD_SIZE, g_sample_rate);
+	printf(" %-6s %6s %10s %14s %12s\n", "mod", "bps", "ns/samp", "Msamples/sec", "x realtime");
+	for (int t=0; t < 4; t++) {
+		int rc = fsk_modulator_init(&m, modulations[t], bit_rates[t], g_sample_rate, FSK_DEFAULT_MARK_FREQ,
+				FSK_DEFAULT_SPACE_FREQ, FSK_DEFAULT_GFSK_BT, 0.5, bench_fsk_next_bit, &lfsr);
+		if (rc != EXIT_SUCCESS)
+			return rc;
+		uint64_t start = audio_perf_now();
+		for (int p=0; p < periods; p++)
+			fsk_modulator_block(&m, out, PERIOD_SIZE);
+		uint64_t end = audio_perf_now();
+		double ns = (double)(end - start) / ((double)periods * PERIOD_SIZE);
+		printf(" %-6s %6d %10.1f %14.2f %12.0f\n", modulations[t] == FSK_AFSK ? "afsk" : "gfsk", bit_rates[t],
+				ns, 1000.0 / ns, 1E9 / ns / g_sample_rate);
+	}
+	return EXIT_SUCCESS;
+}
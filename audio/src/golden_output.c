@@ -0,0 +1,409 @@
+/*
+ * golden_output.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Compare the audio loop output with the golden reference files.  See golden_output.h
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "audio_processor.h"
+#include "fsk_modulator.h"
+#include "golden_output.h"
+#include "TelemEncoding.h"
+#include "telem_processor.h"
+#include "telem_thread.h"
+
+#define GOLDEN_WAV_FORMAT_FLOAT 3
+#define GOLDEN_WAV_HEADER_LEN 44
+#define GOLDEN_NOISE_SEED 0x12345678
+
+/* One run of the audio loop that has a reference file */
+typedef struct {
+	char *name;
+	int mode;
+	char *modulation;
+	int hpf;
+	int lpf;
+	int ramp;
+	int test_tone;
+	int periods; // enough to cover the start of the first frame, and the end of it where that is quick
+} golden_case_t;
+
+golden_case_t golden_cases[] = {
+		{"duv", AUDIO_MODE_DUV, FSK_MODULATION_NRZ, true, true, true, false, 64},
+		{"duv_no_lpf", AUDIO_MODE_DUV, FSK_MODULATION_NRZ, false, false, false, false, 32},
+		{"high_speed_nrz", AUDIO_MODE_HIGH_SPEED, FSK_MODULATION_NRZ, false, true, false, false, 80},
+		{"high_speed_afsk", AUDIO_MODE_HIGH_SPEED, FSK_MODULATION_AFSK, false, true, false, false, 40},
+		{"high_speed_gfsk", AUDIO_MODE_HIGH_SPEED, FSK_MODULATION_GFSK, false, true, false, false, 80},
+		{"combined_gfsk", AUDIO_MODE_COMBINED, FSK_MODULATION_GFSK, false, true, true, false, 64},
+		{"test_tone", AUDIO_MODE_DUV, FSK_MODULATION_NRZ, true, true, true, true, 8}
+};
+#define GOLDEN_NUM_CASES (int)(sizeof(golden_cases)/sizeof(golden_cases[0]))
+
+/* The settings that are changed for the golden runs, so they can be put back */
+typedef struct {
+	int sample_rate;
+	double one_value;
+	double zero_value;
+	double ramp_amount;
+	int ramp_bits_to_compensate_hpf;
+	int duv_bit_rate;
+	int high_speed_bit_rate;
+	char high_speed_modulation[MAX_LINE_LENGTH];
+	double fsk_mark_freq;
+	double fsk_space_freq;
+	double gfsk_bt;
+	double high_speed_burst_level;
+	int hpf;
+	int lpf_bits;
+	int send_telem;
+	int send_high_speed_telem;
+	int send_duv_with_high_speed;
+	int send_test_telem;
+	int send_test_tone;
+	int measure_test_tone;
+	double test_tone_freq;
+} golden_settings_t;
+
+/* Forward declarations */
+void golden_output_save_settings(golden_settings_t *s);
+void golden_output_restore_settings(golden_settings_t *s);
+int golden_output_generate(golden_case_t *c, float *out);
+int golden_output_write(char *path, float *audio, long samples);
+long golden_output_read(char *path, float *audio, long max_samples);
+
+void golden_output_save_settings(golden_settings_t *s) {
+	s->sample_rate = g_sample_rate;
+	s->one_value = g_one_value;
+	s->zero_value = g_zero_value;
+	s->ramp_amount = g_ramp_amount;
+	s->ramp_bits_to_compensate_hpf = g_ramp_bits_to_compensate_hpf;
+	s->duv_bit_rate = g_duv_bit_rate;
+	s->high_speed_bit_rate = g_high_speed_bit_rate;
+	strcpy(s->high_speed_modulation, g_high_speed_modulation);
+	s->fsk_mark_freq = g_fsk_mark_freq;
+	s->fsk_space_freq = g_fsk_space_freq;
+	s->gfsk_bt = g_gfsk_bt;
+	s->high_speed_burst_level = g_high_speed_burst_level;
+	s->hpf = get_hpf();
+	s->lpf_bits = get_lpf_bits();
+	s->send_telem = get_send_telem();
+	s->send_high_speed_telem = get_send_high_speed_telem();
+	s->send_duv_with_high_speed = get_send_duv_with_high_speed();
+	s->send_test_telem = get_send_test_telem();
+	s->send_test_tone = get_send_test_tone();
+	s->measure_test_tone = get_measure_test_tone();
+	s->test_tone_freq = get_test_tone_freq();
+}
+
+/* Put the settings back and rebuild the pipelines with them */
+void golden_output_restore_settings(golden_settings_t *s) {
+	g_sample_rate = s->sample_rate;
+	g_one_value = s->one_value;
+	g_zero_value = s->zero_value;
+	g_ramp_amount = s->ramp_amount;
+	g_ramp_bits_to_compensate_hpf = s->ramp_bits_to_compensate_hpf;
+	g_duv_bit_rate = s->duv_bit_rate;
+	g_high_speed_bit_rate = s->high_speed_bit_rate;
+	strcpy(g_high_speed_modulation, s->high_speed_modulation);
+	g_fsk_mark_freq = s->fsk_mark_freq;
+	g_fsk_space_freq = s->fsk_space_freq;
+	g_gfsk_bt = s->gfsk_bt;
+	g_high_speed_burst_level = s->high_speed_burst_level;
+	set_hpf(s->hpf);
+	set_lpf_bits(s->lpf_bits);
+	set_send_telem(s->send_telem);
+	set_send_high_speed_telem(s->send_high_speed_telem);
+	set_send_duv_with_high_speed(s->send_duv_with_high_speed);
+	set_send_test_telem(s->send_test_telem);
+	set_send_test_tone(s->send_test_tone);
+	set_measure_test_tone(s->measure_test_tone);
+	set_test_tone_freq(s->test_tone_freq);
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	init_audio_processor();
+}
+
+/*
+ * Run the audio loop for the case from the start.  Every frame is the test packet and the input
+ * is a tone plus noise from a fixed generator, so the output is the same each time.
+ */
+int golden_output_generate(golden_case_t *c, float *out) {
+	g_sample_rate = GOLDEN_SAMPLE_RATE;
+	g_one_value = GOLDEN_ONE_VALUE;
+	g_zero_value = GOLDEN_ZERO_VALUE;
+	g_ramp_amount = GOLDEN_RAMP_AMOUNT;
+	g_ramp_bits_to_compensate_hpf = c->ramp;
+	g_duv_bit_rate = GOLDEN_DUV_BIT_RATE;
+	g_high_speed_bit_rate = GOLDEN_HIGH_SPEED_BIT_RATE;
+	strcpy(g_high_speed_modulation, c->modulation);
+	g_fsk_mark_freq = FSK_DEFAULT_MARK_FREQ;
+	g_fsk_space_freq = FSK_DEFAULT_SPACE_FREQ;
+	g_gfsk_bt = FSK_DEFAULT_GFSK_BT;
+	g_high_speed_burst_level = GOLDEN_BURST_LEVEL;
+	set_hpf(c->hpf);
+	set_lpf_bits(c->lpf);
+	set_send_telem(true);
+	set_send_test_telem(false);
+	set_send_test_tone(c->test_tone);
+	set_measure_test_tone(false);
+	set_test_tone_freq(GOLDEN_TONE_FREQ);
+
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	unsigned char *packet = set_test_packet();
+	int rc = init_audio_processor();
+	if (rc != EXIT_SUCCESS)
+		return rc;
+	audio_processor_start_mode(c->mode);
+	for (int s=0; s < TELEM_NUM_STREAMS; s++)
+		telem_thread_restart(s);
+
+	static float in[PERIOD_SIZE];
+	uint32_t noise = GOLDEN_NOISE_SEED;
+	for (int p=0; p < c->periods; p++) {
+		for (int i=0; i < PERIOD_SIZE; i++) {
+			long n = (long)p * PERIOD_SIZE + i;
+			in[i] = GOLDEN_TONE_LEVEL * sin(2 * M_PI * GOLDEN_TONE_FREQ * n / GOLDEN_SAMPLE_RATE)
+					+ GOLDEN_NOISE_LEVEL * ((double)(test_random(&noise) >> 8) / (1 << 24) - 0.5);
+		}
+		for (int s=0; s < TELEM_NUM_STREAMS; s++)
+			telem_thread_supply_packet(s, packet);
+		audio_loop(in, &out[(long)p * PERIOD_SIZE], PERIOD_SIZE);
+	}
+	return EXIT_SUCCESS;
+}
+
+/* Write a mono 32 bit float WAV file.  The samples are written in the byte order of this machine, which is little endian on the Pi */
+int golden_output_write(char *path, float *audio, long samples) {
+	FILE *file = fopen(path, "wb");
+	if (file == NULL) {
+		error_print("Could not open %s\n", path);
+		return EXIT_FAILURE;
+	}
+	unsigned int data_bytes = samples * sizeof(float);
+	fwrite("RIFF", 1, 4, file);
+	write_little_endian(GOLDEN_WAV_HEADER_LEN - 8 + data_bytes, 4, file);
+	fwrite("WAVE", 1, 4, file);
+	fwrite("fmt ", 1, 4, file);
+	write_little_endian(16, 4, file); /* fmt chunk length */
+	write_little_endian(GOLDEN_WAV_FORMAT_FLOAT, 2, file);
+	write_little_endian(1, 2, file); /* channels */
+	write_little_endian(GOLDEN_SAMPLE_RATE, 4, file);
+	write_little_endian(GOLDEN_SAMPLE_RATE * sizeof(float), 4, file); /* byte rate */
+	write_little_endian(sizeof(float), 2, file); /* block align */
+	write_little_endian(32, 2, file); /* bits per sample */
+	fwrite("data", 1, 4, file);
+	write_little_endian(data_bytes, 4, file);
+	long written = fwrite(audio, sizeof(float), samples, file);
+	if (fclose(file) != 0 || written != samples) {
+		error_print("Could not write %s\n", path);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/* Read a file written by golden_output_write().  Returns the number of samples, or -1 */
+long golden_output_read(char *path, float *audio, long max_samples) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		error_print("Could not open %s\n", path);
+		return -1;
+	}
+	unsigned char hdr[GOLDEN_WAV_HEADER_LEN];
+	if (fread(hdr, 1, GOLDEN_WAV_HEADER_LEN, file) != GOLDEN_WAV_HEADER_LEN || memcmp(hdr, "RIFF", 4) != 0
+			|| memcmp(&hdr[8], "WAVE", 4) != 0 || memcmp(&hdr[36], "data", 4) != 0
+			|| (hdr[20] | (hdr[21] << 8)) != GOLDEN_WAV_FORMAT_FLOAT || (hdr[22] | (hdr[23] << 8)) != 1) {
+		error_print("%s is not a mono float WAV file\n", path);
+		fclose(file);
+		return -1;
+	}
+	long samples = fread(audio, sizeof(float), max_samples, file);
+	fclose(file);
+	return samples;
+}
+
+long golden_output_ulps(float a, float b) {
+	int32_t ia, ib;
+	memcpy(&ia, &a, sizeof(ia));
+	memcpy(&ib, &b, sizeof(ib));
+	/* Map the sign and magnitude bits onto a line, so that -0 and +0 are the same and neighbours differ by one */
+	int64_t oa = ia < 0 ? (int64_t)INT32_MIN - ia : ia;
+	int64_t ob = ib < 0 ? (int64_t)INT32_MIN - ib : ib;
+	return oa > ob ? oa - ob : ob - oa;
+}
+
+void golden_output_compare(float *expected, float *actual, long samples, double abs_tolerance, long ulp_tolerance,
+		golden_result_t *result) {
+	double signal = 0;
+	double error = 0;
+	memset(result, 0, sizeof(*result));
+	result->samples = samples;
+	result->first_mismatch = -1;
+	for (long i=0; i < samples; i++) {
+		double diff = fabs((double)actual[i] - expected[i]);
+		long ulps = golden_output_ulps(expected[i], actual[i]);
+		signal += (double)expected[i] * expected[i];
+		error += diff * diff;
+		if (diff > result->max_abs_error)
+			result->max_abs_error = diff;
+		if (ulps > result->max_ulp_error)
+			result->max_ulp_error = ulps;
+		if (diff > abs_tolerance && ulps > ulp_tolerance) {
+			if (result->first_mismatch < 0) {
+				result->first_mismatch = i;
+				result->expected = expected[i];
+				result->actual = actual[i];
+			}
+			result->mismatches++;
+		}
+	}
+	result->snr_db = error > 0 ? 10 * log10(signal / error) : INFINITY;
+}
+
+void golden_output_dir(char *dir, size_t len) {
+	if (g_golden_dir[0] != '\0') {
+		snprintf(dir, len, "%s", g_golden_dir);
+		return;
+	}
+	char exe[MAX_LINE_LENGTH];
+	ssize_t n = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+	if (n <= 0) {
+		snprintf(dir, len, "%s", GOLDEN_DIR_NAME);
+		return;
+	}
+	exe[n] = '\0';
+	/* Strip the name of the executable and then its directory */
+	for (int i=0; i < 2; i++) {
+		char *slash = strrchr(exe, '/');
+		if (slash == NULL)
+			break;
+		*slash = '\0';
+	}
+	snprintf(dir, len, "%s/%s", exe, GOLDEN_DIR_NAME);
+}
+
+int golden_output_run(char *dir, int update, int print) {
+	int fail = EXIT_SUCCESS;
+	char path[MAX_LINE_LENGTH];
+	golden_settings_t saved;
+	golden_output_save_settings(&saved);
+
+	if (print) {
+		if (update)
+			printf("Writing golden reference files to %s\n", dir);
+		else
+			printf("Comparing with the golden reference files in %s, tolerance %g or %d ulp\n", dir,
+					g_golden_abs_tolerance, g_golden_ulp_tolerance);
+		printf(" %-16s %8s %10s %12s %8s %8s  %s\n", "case", "samples", "mismatches", "max abs err", "max ulp",
+				"SNR dB", "first mismatch");
+	}
+	for (int c=0; c < GOLDEN_NUM_CASES; c++) {
+		golden_case_t *gc = &golden_cases[c];
+		long samples = (long)gc->periods * PERIOD_SIZE;
+		float *actual = malloc(samples * sizeof(float));
+		float *expected = malloc(samples * sizeof(float));
+		if (actual == NULL || expected == NULL) {
+			error_print("Could not allocate %ld samples for %s\n", samples, gc->name);
+			free(actual);
+			free(expected);
+			fail = EXIT_FAILURE;
+			break;
+		}
+		snprintf(path, sizeof(path), "%s/%s.wav", dir, gc->name);
+		int rc = golden_output_generate(gc, actual);
+		if (rc == EXIT_SUCCESS && update) {
+			rc = golden_output_write(path, actual, samples);
+			if (print && rc == EXIT_SUCCESS)
+				printf(" %-16s %8ld written\n", gc->name, samples);
+		} else if (rc == EXIT_SUCCESS) {
+			long read = golden_output_read(path, expected, samples);
+			if (read != samples) {
+				if (read >= 0)
+					error_print("%s has %ld samples, expected %ld\n", path, read, samples);
+				rc = EXIT_FAILURE;
+			} else {
+				golden_result_t result;
+				golden_output_compare(expected, actual, samples, g_golden_abs_tolerance, g_golden_ulp_tolerance, &result);
+				if (result.mismatches)
+					rc = EXIT_FAILURE;
+				if (print || result.mismatches) {
+					printf(" %-16s %8ld %10ld %12.3g %8ld %8.1f", gc->name, result.samples, result.mismatches,
+							result.max_abs_error, result.max_ulp_error, result.snr_db);
+					if (result.mismatches)
+						printf("  sample %ld (period %ld) expected %.9g got %.9g", result.first_mismatch,
+								result.first_mismatch / PERIOD_SIZE, result.expected, result.actual);
+					printf("\n");
+				}
+			}
+		}
+		if (rc != EXIT_SUCCESS)
+			fail = EXIT_FAILURE;
+		free(actual);
+		free(expected);
+	}
+
+	golden_output_restore_settings(&saved);
+	return fail;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_golden_output() {
+	printf("TESTING golden output .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+
+	/* Check the comparison first, so a failure below is the audio and not the test */
+	float expected[] = {0.5f, -0.25f, 0.0f, 1.0f};
+	float actual[] = {0.5f, -0.25f, -0.0f, 1.0f};
+	golden_result_t result;
+	golden_output_compare(expected, actual, 4, 0, 0, &result);
+	if (result.mismatches != 0 || !isinf(result.snr_db))
+		fail = EXIT_FAILURE;
+	actual[1] = nextafterf(-0.25f, -1.0f);
+	actual[3] = 1.001f;
+	golden_output_compare(expected, actual, 4, 1E-5, 1, &result);
+	if (result.mismatches != 1 || result.first_mismatch != 3 || result.max_ulp_error != golden_output_ulps(1.0f, 1.001f)
+			|| golden_output_ulps(-0.0f, nextafterf(0.0f, 1.0f)) != 1 || golden_output_ulps(-1E-30f, 1E-30f) <= 2)
+		fail = EXIT_FAILURE;
+
+	char dir[MAX_LINE_LENGTH];
+	golden_output_dir(dir, sizeof(dir));
+	if (golden_output_run(dir, false, g_verbose) != EXIT_SUCCESS)
+		fail = EXIT_FAILURE;
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -32,15 +32,37 @@
 #include "debug.h"
 #include "cmd_console.h"
 #include "audio_processor.h"
+#include "audio_backend.h"
+#include "jack_audio.h"
 
 #include "../../telem_send/inc/telem_thread.h"
 
+/* Forward function declarations */
+int jack_audio_open(audio_process_callback_t process);
+int jack_audio_start(void);
+int jack_audio_stop(void);
+int jack_audio_get_buffer_size(void);
+int jack_audio_get_sample_rate(void);
+int jack_audio_get_xruns(void);
+
+audio_backend_t jack_audio_backend = {
+		.name = "jack",
+		.open = jack_audio_open,
+		.start = jack_audio_start,
+		.stop = jack_audio_stop,
+		.wait = NULL,
+		.get_buffer_size = jack_audio_get_buffer_size,
+		.get_sample_rate = jack_audio_get_sample_rate,
+		.get_xruns = jack_audio_get_xruns
+};
+
 jack_port_t *input_port;
 jack_port_t *output_port;
 jack_client_t *client;
+audio_process_callback_t jack_process_callback;
 static int xruns = 0;
 
-int get_xruns_since_start() { return xruns; }
+int jack_audio_get_xruns(void) { return xruns; }
 
 /**
  * JACK calls this shutdown_callback if the server ever shuts down or
@@ -64,7 +86,7 @@ int jack_xrun_callback(void *arg)  {
  *
  * Each buffer contains 480 ALSA frames, specified when jackd was started
  *
- * This calls the core audio_loop()
+ * This calls the process callback, which is the core audio_loop()
  *
  */
 int process_audio (jack_nframes_t nframes, void *arg) {
@@ -75,7 +97,8 @@ int process_audio (jack_nframes_t nframes, void *arg) {
 	in = jack_port_get_buffer (input_port, nframes);
 	out = jack_port_get_buffer (output_port, nframes);
 
-	audio_loop(in, out, nframes);
+	audio_processor_set_frame_time(jack_last_frame_time(client));
+	jack_process_callback(in, out, nframes);
 
 	return 0;
 }
@@ -83,11 +106,9 @@ int process_audio (jack_nframes_t nframes, void *arg) {
 /**
  * Setup and initialize the connection to the jack server
  * Register the call backs for process_audio() and jack_shutdown()
- * Call the command interpreter if we are in interactive mode
  *
  */
-int start_jack_audio_processor (void) {
-	const char **ports;
+int jack_audio_open(audio_process_callback_t process) {
 	const char *client_name = "telem_radio";
 	const char *server_name = NULL;
 	jack_options_t options = JackNullOption;
@@ -116,6 +137,7 @@ int start_jack_audio_processor (void) {
 	/* tell the JACK server to call `process()' whenever
 	   there is work to be done.
 	 */
+	jack_process_callback = process;
 	jack_set_process_callback (client, process_audio, 0);
 
 	/* tell the JACK server to call `jack_shutdown()' if
@@ -127,10 +149,6 @@ int start_jack_audio_processor (void) {
 	/* Setup a callback to track XRUNS */
 	jack_set_xrun_callback(client, jack_xrun_callback, 0);
 
-	/* check the current sample rate */
-	int rate = jack_get_sample_rate (client);
-	assert(rate == g_sample_rate);
-
 	/* create two ports */
 	input_port = jack_port_register (client, "input",
 			JACK_DEFAULT_AUDIO_TYPE,
@@ -143,6 +161,16 @@ int start_jack_audio_processor (void) {
 		error_print("no more JACK ports available\n");
 		exit (1);
 	}
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Activate the client so that process_audio() is called and connect our ports
+ * to the physical capture and playback ports.
+ *
+ */
+int jack_audio_start(void) {
+	const char **ports;
 
 	/* Tell the JACK server that we are ready to roll.  Our
 	 * process() callback will loop_start_timeval running now. */
@@ -190,10 +218,19 @@ int start_jack_audio_processor (void) {
 	return EXIT_SUCCESS;
 }
 
-int stop_jack_audio_processor (void) {
-
+int jack_audio_stop(void) {
+	if (client == NULL)
+		return EXIT_SUCCESS;
 	jack_client_close (client);
+	client = NULL;
 	debug_print("Jack client closed down\n");
 	return EXIT_SUCCESS;
 }
 
+int jack_audio_get_buffer_size(void) {
+	return jack_get_buffer_size(client);
+}
+
+int jack_audio_get_sample_rate(void) {
+	return jack_get_sample_rate(client);
+}
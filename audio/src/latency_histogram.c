@@ -0,0 +1,153 @@
+/*
+ * latency_histogram.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "latency_histogram.h"
+
+void latency_histogram_clear(latency_histogram_t *hist) {
+	memset(hist, 0, sizeof(latency_histogram_t));
+}
+
+/*
+ * Map a time to a bucket.  Values up to LATENCY_SUB_BUCKETS are their own bucket.  Above that
+ * the top LATENCY_SUB_BUCKET_BITS+1 bits give the power of two and the position within it.
+ */
+int latency_histogram_bucket(uint64_t ns) {
+	if (ns < LATENCY_SUB_BUCKETS)
+		return ns;
+	int msb = 63 - __builtin_clzll(ns);
+	int bucket = (msb - LATENCY_SUB_BUCKET_BITS + 1) * LATENCY_SUB_BUCKETS
+			+ ((ns >> (msb - LATENCY_SUB_BUCKET_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+	if (bucket >= LATENCY_HISTOGRAM_BUCKETS)
+		bucket = LATENCY_HISTOGRAM_BUCKETS - 1;
+	return bucket;
+}
+
+/* The largest time that falls in this bucket */
+uint64_t latency_histogram_bucket_upper_ns(int bucket) {
+	if (bucket < LATENCY_SUB_BUCKETS)
+		return bucket;
+	int msb = bucket / LATENCY_SUB_BUCKETS + LATENCY_SUB_BUCKET_BITS - 1;
+	uint64_t width = 1ULL << (msb - LATENCY_SUB_BUCKET_BITS);
+	uint64_t lower = (uint64_t)(LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) * width;
+	return lower + width - 1;
+}
+
+void latency_histogram_record(latency_histogram_t *hist, uint64_t ns) {
+	hist->count++;
+	hist->total_ns += ns;
+	if (ns > hist->max_ns)
+		hist->max_ns = ns > UINT32_MAX ? UINT32_MAX : ns;
+	hist->buckets[latency_histogram_bucket(ns)]++;
+}
+
+void latency_histogram_add(latency_histogram_t *dest, latency_histogram_t *src) {
+	dest->count += src->count;
+	dest->total_ns += src->total_ns;
+	if (src->max_ns > dest->max_ns)
+		dest->max_ns = src->max_ns;
+	for (int b=0; b < LATENCY_HISTOGRAM_BUCKETS; b++)
+		dest->buckets[b] += src->buckets[b];
+}
+
+/*
+ * This returns the top of the bucket that holds the percentile, so it may be up to
+ * 1/LATENCY_SUB_BUCKETS high, but it is never more than the max.
+ */
+double latency_histogram_percentile(latency_histogram_t *hist, double percentile) {
+	if (hist->count == 0)
+		return 0;
+	uint64_t rank = (uint64_t)(percentile / 100.0 * hist->count + 0.999999);
+	if (rank < 1) rank = 1;
+	uint64_t seen = 0;
+	for (int b=0; b < LATENCY_HISTOGRAM_BUCKETS; b++) {
+		seen += hist->buckets[b];
+		if (seen >= rank) {
+			uint64_t upper = latency_histogram_bucket_upper_ns(b);
+			return upper < hist->max_ns ? upper : hist->max_ns;
+		}
+	}
+	return hist->max_ns;
+}
+
+double latency_histogram_mean(latency_histogram_t *hist) {
+	if (hist->count == 0)
+		return 0;
+	return hist->total_ns / (double)hist->count;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_latency_histogram() {
+	printf("TESTING latency_histogram .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+
+	/* Every time must fall in a bucket whose upper bound is within 1/8 above it */
+	uint64_t test_ns[] = {0, 7, 8, 15, 16, 100, 1000, 12345, 999999, 10000000};
+	for (int i=0; i < sizeof(test_ns)/sizeof(test_ns[0]); i++) {
+		uint64_t upper = latency_histogram_bucket_upper_ns(latency_histogram_bucket(test_ns[i]));
+		verbose_print(" %llu ns -> bucket %d upper %llu\n", (unsigned long long)test_ns[i],
+				latency_histogram_bucket(test_ns[i]), (unsigned long long)upper);
+		if (upper < test_ns[i] || upper > test_ns[i] + test_ns[i] / LATENCY_SUB_BUCKETS) {
+			verbose_print(" **err bucket for %llu\n", (unsigned long long)test_ns[i]);
+			fail = EXIT_FAILURE;
+		}
+	}
+
+	/* 1000 values from 1 to 1000us, split across two histograms and then combined */
+	latency_histogram_t a, b;
+	latency_histogram_clear(&a);
+	latency_histogram_clear(&b);
+	for (int i=1; i <= 1000; i++)
+		latency_histogram_record(i % 2 ? &a : &b, i * 1000);
+	latency_histogram_add(&a, &b);
+	double expected[] = {50, 90, 99, 99.9};
+	for (int i=0; i < 4; i++) {
+		double p = latency_histogram_percentile(&a, expected[i]);
+		verbose_print(" p%.1f %.0f\n", expected[i], p);
+		if (p < expected[i] * 10000 || p > expected[i] * 10000 * (1 + 1.0/LATENCY_SUB_BUCKETS))
+			fail = EXIT_FAILURE;
+	}
+	if (a.count != 1000 || a.max_ns != 1000000 || latency_histogram_mean(&a) != 500500)
+		fail = EXIT_FAILURE;
+	if (latency_histogram_percentile(&a, 100) != 1000000)
+		fail = EXIT_FAILURE;
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,226 @@
+/*
+ * loop_latency.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The audio thread is the only writer.  Each histogram has a sequence number that is odd
+ * while it is being written.  Readers copy the histogram and try again if the sequence
+ * number was odd or changed during the copy.  The audio thread never waits for a reader.
+ *
+ * The recent history is a ring of one second slots.  When a slot is full the audio thread
+ * clears the oldest one and moves on to it.  A window is the sum of the current slot and
+ * the slots before it.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sched.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_processor.h"
+#include "loop_latency.h"
+
+/* Forward function declarations */
+void loop_latency_copy(uint32_t *seq, latency_histogram_t *src, latency_histogram_t *dest);
+
+#define LOOP_LATENCY_SLOTS (LOOP_LATENCY_MAX_WINDOW_SEC + 1)
+
+typedef struct {
+	uint32_t seq;
+	latency_histogram_t hist;
+} loop_latency_slot_t;
+
+loop_latency_slot_t since_start;
+loop_latency_slot_t slots[LOOP_LATENCY_SLOTS];
+int current_slot = 0;
+int slots_completed = 0;
+
+/* Only used by the audio thread */
+int periods_per_slot = 1;
+int periods_in_slot = 0;
+
+void loop_latency_init() {
+	memset(&since_start, 0, sizeof(since_start));
+	memset(slots, 0, sizeof(slots));
+	current_slot = 0;
+	slots_completed = 0;
+	periods_in_slot = 0;
+	periods_per_slot = (g_sample_rate + PERIOD_SIZE/2) / PERIOD_SIZE;
+	if (periods_per_slot < 1)
+		periods_per_slot = 1;
+}
+
+double loop_latency_deadline_ns() {
+	return PERIOD_SIZE * 1000000000.0 / g_sample_rate;
+}
+
+void loop_latency_record(uint64_t ns) {
+	loop_latency_slot_t *slot = &slots[current_slot];
+
+	__atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	latency_histogram_record(&slot->hist, ns);
+	__atomic_store_n(&slot->seq, slot->seq + 1, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&since_start.seq, since_start.seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	latency_histogram_record(&since_start.hist, ns);
+	__atomic_store_n(&since_start.seq, since_start.seq + 1, __ATOMIC_RELEASE);
+
+	periods_in_slot++;
+	if (periods_in_slot >= periods_per_slot) {
+		/* Move to the next slot, clearing whatever was in it */
+		int next = (current_slot + 1) % LOOP_LATENCY_SLOTS;
+		loop_latency_slot_t *next_slot = &slots[next];
+		__atomic_store_n(&next_slot->seq, next_slot->seq + 1, __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_RELEASE);
+		latency_histogram_clear(&next_slot->hist);
+		__atomic_store_n(&next_slot->seq, next_slot->seq + 1, __ATOMIC_RELEASE);
+
+		periods_in_slot = 0;
+		if (slots_completed < LOOP_LATENCY_SLOTS - 1)
+			__atomic_store_n(&slots_completed, slots_completed + 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&current_slot, next, __ATOMIC_RELEASE);
+	}
+}
+
+/*
+ * Take a consistent copy of a histogram that the audio thread may be writing.
+ */
+void loop_latency_copy(uint32_t *seq, latency_histogram_t *src, latency_histogram_t *dest) {
+	uint32_t seq1, seq2;
+	do {
+		seq1 = __atomic_load_n(seq, __ATOMIC_ACQUIRE);
+		if (seq1 & 1) {
+			sched_yield();
+			continue;
+		}
+		memcpy(dest, src, sizeof(latency_histogram_t));
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		seq2 = __atomic_load_n(seq, __ATOMIC_RELAXED);
+		if (seq1 == seq2)
+			break;
+	} while (true);
+}
+
+void loop_latency_get(int window_sec, latency_histogram_t *hist) {
+	latency_histogram_t slot_hist;
+	if (window_sec <= 0) {
+		loop_latency_copy(&since_start.seq, &since_start.hist, hist);
+		return;
+	}
+	if (window_sec > LOOP_LATENCY_MAX_WINDOW_SEC)
+		window_sec = LOOP_LATENCY_MAX_WINDOW_SEC;
+
+	latency_histogram_clear(hist);
+	int slot = __atomic_load_n(&current_slot, __ATOMIC_ACQUIRE);
+	int completed = __atomic_load_n(&slots_completed, __ATOMIC_RELAXED);
+	/* The current slot is partly full, so the window is it plus window_sec-1 full slots */
+	int n = window_sec - 1 < completed ? window_sec - 1 : completed;
+	for (int i=0; i <= n; i++) {
+		int s = (slot - i + LOOP_LATENCY_SLOTS) % LOOP_LATENCY_SLOTS;
+		loop_latency_copy(&slots[s].seq, &slots[s].hist, &slot_hist);
+		latency_histogram_add(hist, &slot_hist);
+	}
+}
+
+void loop_latency_print_window(char *name, latency_histogram_t *hist) {
+	double deadline = loop_latency_deadline_ns();
+	printf(" %-12s %9d %8.2f %8.2f %8.2f %8.2f %8.2f %7.1f%%\n", name, hist->count,
+			latency_histogram_percentile(hist, 50) / 1000000.0,
+			latency_histogram_percentile(hist, 90) / 1000000.0,
+			latency_histogram_percentile(hist, 99) / 1000000.0,
+			latency_histogram_percentile(hist, 99.9) / 1000000.0,
+			hist->max_ns / 1000000.0,
+			100.0 * hist->max_ns / deadline);
+}
+
+void loop_latency_print() {
+	latency_histogram_t hist;
+	char name[32];
+	printf("Audio loop time in ms.  Deadline is %.2f ms per period\n", loop_latency_deadline_ns() / 1000000.0);
+	printf(" %-12s %9s %8s %8s %8s %8s %8s %8s\n", "window", "periods", "p50", "p90", "p99", "p99.9", "max", "deadline");
+	loop_latency_get(g_latency_short_window_sec, &hist);
+	snprintf(name, sizeof(name), "last %ds", g_latency_short_window_sec);
+	loop_latency_print_window(name, &hist);
+	loop_latency_get(g_latency_long_window_sec, &hist);
+	snprintf(name, sizeof(name), "last %ds", g_latency_long_window_sec);
+	loop_latency_print_window(name, &hist);
+	loop_latency_get(0, &hist);
+	loop_latency_print_window("since start", &hist);
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_loop_latency() {
+	printf("TESTING loop_latency .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	latency_histogram_t hist;
+
+	loop_latency_init();
+	/* 20 seconds at 1ms, then 5 seconds at 2ms */
+	for (int i=0; i < 20 * periods_per_slot; i++)
+		loop_latency_record(1000000);
+	for (int i=0; i < 5 * periods_per_slot; i++)
+		loop_latency_record(2000000);
+
+	loop_latency_get(0, &hist);
+	verbose_print(" since start %d periods max %d\n", hist.count, hist.max_ns);
+	if (hist.count != 25 * periods_per_slot || hist.max_ns != 2000000)
+		fail = EXIT_FAILURE;
+
+	/* The current slot is empty, so 6 seconds is the 5 seconds at 2ms and nothing else */
+	loop_latency_get(6, &hist);
+	verbose_print(" 6 sec %d periods p50 %.0f\n", hist.count, latency_histogram_percentile(&hist, 50));
+	if (hist.count != 5 * periods_per_slot || latency_histogram_percentile(&hist, 50) < 2000000)
+		fail = EXIT_FAILURE;
+
+	/* 11 seconds is 5 seconds at 2ms and 5 at 1ms */
+	loop_latency_get(11, &hist);
+	double p50 = latency_histogram_percentile(&hist, 50);
+	double p90 = latency_histogram_percentile(&hist, 90);
+	verbose_print(" 11 sec %d periods p50 %.0f p90 %.0f\n", hist.count, p50, p90);
+	if (hist.count != 10 * periods_per_slot || p50 < 1000000 || p50 > 1125000 || p90 < 2000000)
+		fail = EXIT_FAILURE;
+
+	/* Run past the end of the ring and make sure old slots are cleared.  The current slot is empty again */
+	for (int i=0; i < LOOP_LATENCY_SLOTS * periods_per_slot; i++)
+		loop_latency_record(500000);
+	loop_latency_get(LOOP_LATENCY_MAX_WINDOW_SEC, &hist);
+	verbose_print(" %d sec %d periods max %d\n", LOOP_LATENCY_MAX_WINDOW_SEC, hist.count, hist.max_ns);
+	if (hist.max_ns != 500000 || hist.count != (LOOP_LATENCY_MAX_WINDOW_SEC - 1) * periods_per_slot)
+		fail = EXIT_FAILURE;
+
+	loop_latency_init();
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
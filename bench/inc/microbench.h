@@ -0,0 +1,86 @@
+/*
+ * microbench.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * A small harness to time the DSP and telemetry functions.  Each benchmark is a function that
+ * runs a number of iterations.  The number is doubled until one repetition takes long enough to
+ * time accurately.  Then it is run a few times to warm the caches and the branch predictors, and
+ * then timed over several repetitions.  The minimum, median, mean and maximum are kept, as the
+ * time per unit of work, so that a sample, a byte or a bit can be compared across builds.
+ *
+ * The results can be written as JSON with a description of the machine and the build.
+ *
+ */
+
+#ifndef MICROBENCH_H_
+#define MICROBENCH_H_
+
+#include <stdio.h>
+
+#define MICROBENCH_DEFAULT_WARMUP 3
+#define MICROBENCH_DEFAULT_REPETITIONS 15
+#define MICROBENCH_MAX_REPETITIONS 1000
+#define MICROBENCH_TARGET_NS 2000000 // time for one repetition, so the clock resolution does not matter
+#define MICROBENCH_MAX_ITERATIONS (1L << 30)
+#define MICROBENCH_MAX_RESULTS 64
+#define MICROBENCH_NAME_LENGTH 48
+#define MICROBENCH_UNIT_LENGTH 16
+
+/* Run the work iterations times.  Each iteration is units_per_iteration units of work */
+typedef void (*microbench_fn_t)(void *arg, long iterations);
+
+typedef struct {
+	char name[MICROBENCH_NAME_LENGTH];
+	char unit[MICROBENCH_UNIT_LENGTH]; // what the times are per.  e.g. sample, byte or bit
+	long iterations; // in each repetition
+	long units; // in each repetition
+	double min_ns; // per unit
+	double median_ns;
+	double mean_ns;
+	double max_ns;
+	double stddev_ns;
+} microbench_result_t;
+
+typedef struct {
+	int warmup;
+	int repetitions;
+	int cpu; // the cpu the benchmarks are pinned to, or -1
+	char *filter; // only run benchmarks with this in their name, or NULL for all
+	int count;
+	microbench_result_t results[MICROBENCH_MAX_RESULTS];
+} microbench_t;
+
+void microbench_init(microbench_t *b, int warmup, int repetitions, int cpu, char *filter);
+
+/*
+ * Time fn and print a line with the result.  The result is kept for microbench_write_json().
+ * Returns EXIT_FAILURE if there is no room for another result.  Nothing is run if the name does
+ * not match the filter.
+ */
+int microbench_run(microbench_t *b, char *name, char *unit, long units_per_iteration,
+		microbench_fn_t fn, void *arg);
+
+/* True if the benchmark with this name will be run */
+int microbench_selected(microbench_t *b, char *name);
+
+void microbench_print_header(microbench_t *b);
+
+/* Write the machine, the build and all of the results */
+int microbench_write_json(microbench_t *b, FILE *f);
+
+#endif /* MICROBENCH_H_ */
@@ -0,0 +1,176 @@
+/*
+ * microbench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Timing harness for telem_bench.  See microbench.h
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "config.h"
+#include "debug.h"
+#include "audio_perf.h"
+#include "microbench.h"
+
+/* Forward declarations */
+uint64_t microbench_time(microbench_fn_t fn, void *arg, long iterations);
+int microbench_compare(const void *a, const void *b);
+
+void microbench_init(microbench_t *b, int warmup, int repetitions, int cpu, char *filter) {
+	memset(b, 0, sizeof(*b));
+	b->warmup = warmup < 0 ? 0 : warmup;
+	b->repetitions = repetitions;
+	if (b->repetitions < 1)
+		b->repetitions = 1;
+	if (b->repetitions > MICROBENCH_MAX_REPETITIONS)
+		b->repetitions = MICROBENCH_MAX_REPETITIONS;
+	b->cpu = cpu;
+	b->filter = filter;
+}
+
+uint64_t microbench_time(microbench_fn_t fn, void *arg, long iterations) {
+	uint64_t start = audio_perf_now();
+	fn(arg, iterations);
+	return audio_perf_now() - start;
+}
+
+int microbench_compare(const void *a, const void *b) {
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+int microbench_selected(microbench_t *b, char *name) {
+	return b->filter == NULL || strstr(name, b->filter) != NULL;
+}
+
+void microbench_print_header(microbench_t *b) {
+	printf("BENCHMARK %d warmup and %d timed repetitions of at least %.1f ms", b->warmup, b->repetitions,
+			MICROBENCH_TARGET_NS / 1000000.0);
+	if (b->cpu >= 0)
+		printf(" on cpu %d", b->cpu);
+	printf("\n %-24s %-8s %10s %10s %10s %10s %7s %12s\n", "name", "unit", "units/rep", "min ns", "median ns",
+			"mean ns", "+/- %", "Munits/sec");
+}
+
+int microbench_run(microbench_t *b, char *name, char *unit, long units_per_iteration,
+		microbench_fn_t fn, void *arg) {
+	static double ns[MICROBENCH_MAX_REPETITIONS];
+	if (!microbench_selected(b, name))
+		return EXIT_SUCCESS;
+	if (b->count >= MICROBENCH_MAX_RESULTS) {
+		error_print("No room for the result of %s\n", name);
+		return EXIT_FAILURE;
+	}
+
+	/* Find how many iterations take long enough to time */
+	long iterations = 1;
+	while (iterations < MICROBENCH_MAX_ITERATIONS && microbench_time(fn, arg, iterations) < MICROBENCH_TARGET_NS)
+		iterations *= 2;
+
+	for (int r=0; r < b->warmup; r++)
+		microbench_time(fn, arg, iterations);
+
+	long units = iterations * units_per_iteration;
+	double sum = 0;
+	for (int r=0; r < b->repetitions; r++) {
+		ns[r] = (double)microbench_time(fn, arg, iterations) / units;
+		sum += ns[r];
+	}
+	double mean = sum / b->repetitions;
+	double var = 0;
+	for (int r=0; r < b->repetitions; r++)
+		var += (ns[r] - mean) * (ns[r] - mean);
+	qsort(ns, b->repetitions, sizeof(ns[0]), microbench_compare);
+
+	microbench_result_t *res = &b->results[b->count++];
+	strncpy(res->name, name, MICROBENCH_NAME_LENGTH-1);
+	strncpy(res->unit, unit, MICROBENCH_UNIT_LENGTH-1);
+	res->iterations = iterations;
+	res->units = units;
+	res->min_ns = ns[0];
+	res->max_ns = ns[b->repetitions-1];
+	if (b->repetitions % 2)
+		res->median_ns = ns[b->repetitions/2];
+	else
+		res->median_ns = (ns[b->repetitions/2 - 1] + ns[b->repetitions/2]) / 2;
+	res->mean_ns = mean;
+	res->stddev_ns = b->repetitions > 1 ? sqrt(var / (b->repetitions - 1)) : 0;
+
+	printf(" %-24s %-8s %10ld %10.2f %10.2f %10.2f %7.1f %12.2f\n", res->name, res->unit, res->units,
+			res->min_ns, res->median_ns, res->mean_ns, 100.0 * res->stddev_ns / res->mean_ns,
+			1000.0 / res->median_ns);
+	return EXIT_SUCCESS;
+}
+
+int microbench_write_json(microbench_t *b, FILE *f) {
+	struct utsname host;
+	if (uname(&host) != 0) {
+		strcpy(host.machine, "unknown");
+		strcpy(host.nodename, "unknown");
+		strcpy(host.release, "unknown");
+	}
+	time_t now = time(NULL);
+	struct tm utc;
+	char timestamp[32];
+	gmtime_r(&now, &utc);
+	strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"build\": \"%s\",\n", VERSION);
+	fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef __OPTIMIZE__
+	fprintf(f, "  \"optimized\": true,\n");
+#else
+	fprintf(f, "  \"optimized\": false,\n");
+#endif
+#ifdef RASPBERRY_PI
+	fprintf(f, "  \"platform\": \"raspberry_pi\",\n");
+#else
+	fprintf(f, "  \"platform\": \"linux\",\n");
+#endif
+	fprintf(f, "  \"host\": \"%s\",\n", host.nodename);
+	fprintf(f, "  \"machine\": \"%s\",\n", host.machine);
+	fprintf(f, "  \"kernel\": \"%s\",\n", host.release);
+	fprintf(f, "  \"cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+	fprintf(f, "  \"cpu\": %d,\n", b->cpu);
+	fprintf(f, "  \"time\": \"%s\",\n", timestamp);
+	fprintf(f, "  \"sample_rate\": %d,\n", g_sample_rate);
+	fprintf(f, "  \"warmup\": %d,\n", b->warmup);
+	fprintf(f, "  \"repetitions\": %d,\n", b->repetitions);
+	fprintf(f, "  \"results\": [\n");
+	for (int i=0; i < b->count; i++) {
+		microbench_result_t *res = &b->results[i];
+		fprintf(f, "    {\"name\": \"%s\", \"unit\": \"%s\", \"iterations\": %ld, \"units\": %ld, "
+				"\"min_ns\": %.3f, \"median_ns\": %.3f, \"mean_ns\": %.3f, \"max_ns\": %.3f, \"stddev_ns\": %.3f}%s\n",
+				res->name, res->unit, res->iterations, res->units, res->min_ns, res->median_ns, res->mean_ns,
+				res->max_ns, res->stddev_ns, i < b->count - 1 ? "," : "");
+	}
+	fprintf(f, "  ]\n}\n");
+	if (ferror(f)) {
+		error_print("Could not write the benchmark results\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,571 @@
+/*
+ * TELEM RADIO
+ * telem_bench.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ *
+ * The main program for telem_bench.  It is linked with the same objects as telem_radio, except
+ * main.c, and times the filters, the telemetry encoder, the modulator and the whole audio loop
+ * in each mode.  It runs on one cpu so the results from different boards and builds can be
+ * compared.  Use -j to save them as JSON.
+ *
+ * The audio loop benchmarks do the work of the telem thread as well, so a frame is encoded
+ * each time the audio loop asks for one.
+ *
+ */
+
+/* System include files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+
+/* project include files */
+#include "config.h"
+#include "debug.h"
+#include "microbench.h"
+#include "audio_processor.h"
+#include "fir_filter.h"
+#include "iir_filter.h"
+#include "oscillator.h"
+#include "realtime.h"
+#include "TelemEncoding.h"
+#include "gf256.h"
+#include "rs_encoder.h"
+#include "rs_decoder.h"
+#include "decode_8b10b.h"
+#include "hs_frame.h"
+#include "frame_archive.h"
+#include "telem_processor.h"
+#include "telem_thread.h"
+
+#define BENCH_INPUT_LENGTH 1024 // must be a power of 2
+#define BENCH_OSC_TABLE_SIZE 9600
+#define BENCH_RS_BATCH 256 // frames given to rs_encode_frames() at once
+#define BENCH_RS_CODEWORDS 16 // different error patterns for the decoder, must be a power of 2
+#define BENCH_BITS_PER_SUPPLY 256 // a frame is much longer than this, so a packet is always ready in time
+#define BENCH_ARCHIVE_DIR "archive_bench"
+#define BENCH_ARCHIVE_SECONDS (24 * 60 * 60) // a day of frames at the high speed bit rate
+#define BENCH_ARCHIVE_LOOKUP_STEP 86 // seconds between the times looked up
+
+/* Forward declarations */
+void bench_supply_packets();
+int bench_run_all(microbench_t *b);
+
+typedef struct {
+	double coeffs[DECIMATE_FILTER_LEN];
+	double xv[DECIMATE_FILTER_LEN];
+	int len;
+} bench_fir_t;
+
+double bench_input[BENCH_INPUT_LENGTH];
+unsigned char bench_bytes[BENCH_INPUT_LENGTH];
+unsigned char bench_packet[DUV_DATA_LENGTH];
+jack_default_audio_sample_t bench_audio_in[4 * PERIOD_SIZE];
+jack_default_audio_sample_t bench_audio_out[PERIOD_SIZE];
+double bench_sin_table[BENCH_OSC_TABLE_SIZE];
+volatile double bench_sink; // results are written here so the work is not optimized away
+
+/* The work the telem thread would do.  A packet is only encoded if a stream has asked for one */
+void bench_supply_packets() {
+	for (int s=0; s < TELEM_NUM_STREAMS; s++)
+		telem_thread_supply_packet(s, bench_packet);
+}
+
+void bench_fir_filter(void *arg, long iterations) {
+	bench_fir_t *f = arg;
+	double sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += fir_filter(bench_input[i & (BENCH_INPUT_LENGTH-1)], f->coeffs, f->xv, f->len);
+	bench_sink = sum;
+}
+
+void bench_iir_filter(void *arg, long iterations) {
+	TIIRStorage *store = arg;
+	double sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += iir_filter(Elliptic8Pole300HzHighPassIIRCoeff, bench_input[i & (BENCH_INPUT_LENGTH-1)], store);
+	bench_sink = sum;
+}
+
+void bench_next_sample(void *arg, long iterations) {
+	double *phase = arg;
+	double sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += nextSample(phase, 1000.0, g_sample_rate, bench_sin_table, BENCH_OSC_TABLE_SIZE);
+	bench_sink = sum;
+}
+
+/* The parities are cleared at the start of each frame, as they are when a packet is encoded */
+void bench_update_rs(void *arg, long iterations) {
+	unsigned char *parities = arg;
+	for (long i=0; i < iterations; i++) {
+		if (i % DUV_DATA_LENGTH == 0)
+			memset(parities, 0, PARITY_BYTES_PER_CODEWORD);
+		update_rs(parities, bench_bytes[i & (BENCH_INPUT_LENGTH-1)]);
+	}
+	bench_sink = parities[0];
+}
+
+void bench_update_rs_table(void *arg, long iterations) {
+	unsigned char *parities = arg;
+	for (long i=0; i < iterations; i++) {
+		if (i % DUV_DATA_LENGTH == 0)
+			memset(parities, 0, PARITY_BYTES_PER_CODEWORD);
+		update_rs_table(parities, bench_bytes[i & (BENCH_INPUT_LENGTH-1)]);
+	}
+	bench_sink = parities[0];
+}
+
+/* The parities for whole DUV frames, a byte at a time as the packet encoder used to */
+void bench_rs_frame_update_rs(void *arg, long iterations) {
+	unsigned char *parities = arg;
+	for (long f=0; f < iterations; f++) {
+		unsigned char *data = &bench_bytes[(f * DUV_DATA_LENGTH) & (BENCH_INPUT_LENGTH-1)];
+		memset(parities, 0, PARITY_BYTES_PER_CODEWORD);
+		for (int i=0; i < DUV_DATA_LENGTH; i++)
+			update_rs(parities, data[i]);
+	}
+	bench_sink = parities[0];
+}
+
+void bench_rs_frame_encode_rs(void *arg, long iterations) {
+	unsigned char *parities = arg;
+	for (long f=0; f < iterations; f++)
+		encode_rs(parities, &bench_bytes[(f * DUV_DATA_LENGTH) & (BENCH_INPUT_LENGTH-1)], DUV_DATA_LENGTH);
+	bench_sink = parities[0];
+}
+
+/* Each iteration is one call with BENCH_RS_BATCH frames that are already set up */
+void bench_rs_encode_frames(void *arg, long iterations) {
+	rs_frame_t *frames = arg;
+	for (long i=0; i < iterations; i++)
+		rs_encode_frames(frames, BENCH_RS_BATCH);
+	bench_sink = frames[0].parity[0];
+}
+
+/* A block the size of an RS group, times a different constant each time */
+void bench_gf256_mul_add_region(void *arg, long iterations) {
+	unsigned char *dst = arg;
+	for (long i=0; i < iterations; i++)
+		gf256_mul_add_region(dst, &bench_bytes[i & (BENCH_INPUT_LENGTH/2-1)], i | 1, RS_BATCH_LANES);
+	bench_sink = dst[0];
+}
+
+/* DUV codewords with the same number of errors in each, which are copied before they are decoded */
+typedef struct {
+	unsigned char received[BENCH_RS_CODEWORDS][DUV_DATA_LENGTH + PARITY_BYTES_PER_CODEWORD];
+	unsigned char codeword[DUV_DATA_LENGTH + PARITY_BYTES_PER_CODEWORD];
+} bench_rs_decode_t;
+
+void bench_rs_decode(void *arg, long iterations) {
+	bench_rs_decode_t *d = arg;
+	int sum = 0;
+	for (long i=0; i < iterations; i++) {
+		memcpy(d->codeword, d->received[i & (BENCH_RS_CODEWORDS-1)], sizeof(d->codeword));
+		sum += rs_decode(d->codeword, DUV_DATA_LENGTH, NULL);
+	}
+	bench_sink = sum;
+}
+
+/* RS and 8b10b encoding of a whole frame, as the telem thread does */
+void bench_encode_next_packet(void *arg, long iterations) {
+	for (long f=0; f < iterations; f++)
+		encode_next_packet(TELEM_STREAM_MAIN, &bench_bytes[(f * DUV_DATA_LENGTH) & (BENCH_INPUT_LENGTH-1)], f & 1);
+	bench_sink = telem_processor_stream(TELEM_STREAM_MAIN)->encoded_packet[0][0];
+}
+
+void bench_encode_8b10b(void *arg, long iterations) {
+	int *rd = arg;
+	int sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += encode_8b10b(rd, bench_bytes[i & (BENCH_INPUT_LENGTH-1)]);
+	bench_sink = sum;
+}
+
+/* Words from a stream encoded at the start, so the running disparity is right */
+uint16_t bench_words[BENCH_INPUT_LENGTH];
+
+void bench_decode_8b10b(void *arg, long iterations) {
+	decode_8b10b_t *d = arg;
+	int sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += decode_8b10b(d, bench_words[i & (BENCH_INPUT_LENGTH-1)]);
+	bench_sink = sum;
+}
+
+/* A high speed frame of the default size, RS and 8b10b encoded */
+typedef struct {
+	hs_frame_encoder_t encoder;
+	unsigned char data[HS_FRAME_DEFAULT_DATA_LENGTH];
+	uint16_t words[HS_FRAME_MAX_WORDS];
+	int rd;
+} bench_hs_frame_t;
+
+void bench_hs_frame_encode(void *arg, long iterations) {
+	bench_hs_frame_t *h = arg;
+	for (long f=0; f < iterations; f++) {
+		h->data[0] = f;
+		hs_frame_encode(&h->encoder, &h->rd, h->data, h->words);
+	}
+	bench_sink = h->words[0];
+}
+
+/* The archive of a day of frames, written once before it is read */
+typedef struct {
+	time_t start;
+	long frames;
+	FILE *out;
+} bench_archive_t;
+
+/* Each iteration prints the whole archive */
+void bench_frame_archive_dump(void *arg, long iterations) {
+	bench_archive_t *a = arg;
+	long sum = 0;
+	for (long i=0; i < iterations; i++)
+		sum += frame_archive_dump(BENCH_ARCHIVE_DIR, a->out, 0, UINT64_MAX);
+	bench_sink = sum;
+}
+
+/* Each iteration finds a time a little later in the day */
+void bench_frame_archive_find(void *arg, long iterations) {
+	bench_archive_t *a = arg;
+	uint32_t segment;
+	long record, sum = 0;
+	for (long i=0; i < iterations; i++) {
+		time_t t = a->start + (i * BENCH_ARCHIVE_LOOKUP_STEP) % BENCH_ARCHIVE_SECONDS;
+		if (frame_archive_find(BENCH_ARCHIVE_DIR, frame_archive_time_key(t), &segment, &record) == EXIT_SUCCESS)
+			sum += record;
+	}
+	bench_sink = sum;
+}
+
+void bench_get_next_bit(void *arg, long iterations) {
+	int sum = 0;
+	for (long i=0; i < iterations; i++) {
+		if (i % BENCH_BITS_PER_SUPPLY == 0)
+			bench_supply_packets();
+		sum += get_next_bit();
+	}
+	bench_sink = sum;
+}
+
+/* Each iteration is a block of *arg bits */
+void bench_next_bits(void *arg, long iterations) {
+	int n = *(int *)arg;
+	telem_stream_t *stream = telem_processor_stream(TELEM_STREAM_MAIN);
+	uint64_t sum = 0;
+	for (long i=0; i < iterations; i++) {
+		if ((i * n) % BENCH_BITS_PER_SUPPLY < n)
+			bench_supply_packets();
+		sum += telem_stream_next_bits(stream, n);
+	}
+	bench_sink = sum;
+}
+
+void bench_read_bit(void *arg, long iterations) {
+	telem_stream_t *stream = telem_processor_stream(TELEM_STREAM_MAIN);
+	int sum = 0;
+	for (long i=0; i < iterations; i++) {
+		if (i % BENCH_BITS_PER_SUPPLY == 0)
+			bench_supply_packets();
+		sum += telem_stream_read_bit(stream);
+	}
+	bench_sink = sum;
+}
+
+/* A sample of the bits at the decimated rate.  A new bit is needed every samples_per_bit samples */
+void bench_modulate_bit(void *arg, long iterations) {
+	double sum = 0;
+	for (long i=0; i < iterations; i++) {
+		if (i % BENCH_BITS_PER_SUPPLY == 0)
+			bench_supply_packets();
+		sum += modulate_bit();
+	}
+	bench_sink = sum;
+}
+
+/* Each iteration is one period */
+void bench_audio_loop(void *arg, long iterations) {
+	for (long p=0; p < iterations; p++) {
+		bench_supply_packets();
+		audio_loop(bench_audio_in + (p % 4) * PERIOD_SIZE, bench_audio_out, PERIOD_SIZE);
+	}
+	bench_sink = bench_audio_out[0];
+}
+
+int bench_run_all(microbench_t *b) {
+	int fail = EXIT_SUCCESS;
+	int rc;
+	static bench_fir_t fir;
+	int fir_lengths[] = {60, BIT_FILTER_LEN, DECIMATE_FILTER_LEN};
+	char name[MICROBENCH_NAME_LENGTH];
+
+	for (int i=0; i < sizeof(fir_lengths)/sizeof(fir_lengths[0]); i++) {
+		fir.len = fir_lengths[i];
+		memset(fir.xv, 0, sizeof(fir.xv));
+		gen_raised_cosine_coeffs(fir.coeffs, g_sample_rate / DUV_DECIMATION_RATE, g_duv_bit_rate, 0.5f, fir.len);
+		snprintf(name, sizeof(name), "fir_filter_%d", fir.len);
+		rc = microbench_run(b, name, "sample", 1, bench_fir_filter, &fir); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+
+	TIIRStorage store;
+	memset(&store, 0, sizeof(store));
+	store.MaxRegVal = 1.0E-12;
+	rc = microbench_run(b, "iir_filter", "sample", 1, bench_iir_filter, &store); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	double phase = 0;
+	rc = microbench_run(b, "nextSample", "sample", 1, bench_next_sample, &phase); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	unsigned char parities[PARITY_BYTES_PER_CODEWORD];
+	rc = microbench_run(b, "update_rs", "byte", 1, bench_update_rs, parities); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = microbench_run(b, "update_rs_table", "byte", 1, bench_update_rs_table, parities); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = microbench_run(b, "rs_frame_update_rs", "frame", 1, bench_rs_frame_update_rs, parities); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = microbench_run(b, "rs_frame_encode_rs", "frame", 1, bench_rs_frame_encode_rs, parities); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = microbench_run(b, "encode_next_packet", "frame", 1, bench_encode_next_packet, NULL); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	static rs_frame_t frames[BENCH_RS_BATCH];
+	int rs_lengths[] = {DUV_DATA_LENGTH, DATA_BYTES_PER_CODE_WORD};
+	for (int i=0; i < sizeof(rs_lengths)/sizeof(rs_lengths[0]); i++) {
+		for (int f=0; f < BENCH_RS_BATCH; f++) {
+			frames[f].data = &bench_bytes[(f * 37) & (BENCH_INPUT_LENGTH/2-1)];
+			frames[f].len = rs_lengths[i];
+		}
+		snprintf(name, sizeof(name), "rs_encode_frames_%d", rs_lengths[i]);
+		rc = microbench_run(b, name, "frame", BENCH_RS_BATCH, bench_rs_encode_frames, frames); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+
+	static bench_rs_decode_t decode;
+	int rs_errors[] = {0, 4, RS_MAX_ERRORS};
+	for (int i=0; i < sizeof(rs_errors)/sizeof(rs_errors[0]); i++) {
+		for (int c=0; c < BENCH_RS_CODEWORDS; c++) {
+			unsigned char *r = decode.received[c];
+			memcpy(r, &bench_bytes[c * 17], DUV_DATA_LENGTH);
+			encode_rs(&r[DUV_DATA_LENGTH], r, DUV_DATA_LENGTH);
+			/* Spread the errors over the codeword, in different places in each one */
+			for (int e=0; e < rs_errors[i]; e++)
+				r[(c + e * 6) % sizeof(decode.codeword)] ^= 1 + bench_bytes[c + e] % 255;
+		}
+		snprintf(name, sizeof(name), "rs_decode_%d", rs_errors[i]);
+		rc = microbench_run(b, name, "frame", 1, bench_rs_decode, &decode); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+
+	unsigned char region[RS_BATCH_LANES];
+	memset(region, 0, sizeof(region));
+	int kernel = gf256_get_kernel();
+	for (int k=0; k < GF256_NUM_KERNELS; k++) {
+		if (gf256_set_kernel(k) != EXIT_SUCCESS)
+			continue;
+		snprintf(name, sizeof(name), "gf256_region_%s", gf256_kernel_name(k));
+		rc = microbench_run(b, name, "byte", RS_BATCH_LANES, bench_gf256_mul_add_region, region); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+	gf256_set_kernel(kernel);
+
+	static bench_hs_frame_t hs;
+	hs.rd = -1;
+	if (hs_frame_init(&hs.encoder, HS_FRAME_DEFAULT_CODEWORDS, HS_FRAME_DEFAULT_DATA_LENGTH) != EXIT_SUCCESS)
+		fail = EXIT_FAILURE;
+	for (int i=0; i < HS_FRAME_DEFAULT_DATA_LENGTH; i++)
+		hs.data[i] = bench_bytes[i & (BENCH_INPUT_LENGTH-1)];
+	for (int k=0; k < GF256_NUM_KERNELS; k++) {
+		if (gf256_set_kernel(k) != EXIT_SUCCESS)
+			continue;
+		snprintf(name, sizeof(name), "hs_frame_encode_%s", gf256_kernel_name(k));
+		rc = microbench_run(b, name, "frame", 1, bench_hs_frame_encode, &hs); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+	gf256_set_kernel(kernel);
+
+	/* The archive is only written if one of its benchmarks will run, because it is large */
+	if (microbench_selected(b, "frame_archive_dump") || microbench_selected(b, "frame_archive_find")) {
+		bench_archive_t archive;
+		int bits_per_frame = (DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD;
+		archive.frames = (long)BENCH_ARCHIVE_SECONDS * g_high_speed_bit_rate / bits_per_frame;
+		archive.start = time(NULL) - BENCH_ARCHIVE_SECONDS;
+		archive.out = fopen("/dev/null", "w");
+		if (archive.out == NULL
+				|| bench_frame_archive_make(BENCH_ARCHIVE_DIR, archive.frames, g_high_speed_bit_rate, archive.start)
+				!= EXIT_SUCCESS) {
+			error_print("Could not make the archive for the benchmark\n");
+			fail = EXIT_FAILURE;
+		} else {
+			rc = microbench_run(b, "frame_archive_dump", "frame", archive.frames, bench_frame_archive_dump, &archive); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+			rc = microbench_run(b, "frame_archive_find", "lookup", 1, bench_frame_archive_find, &archive); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+		}
+		if (archive.out != NULL)
+			fclose(archive.out);
+		test_frame_archive_remove(BENCH_ARCHIVE_DIR);
+	}
+
+	int rd = -1;
+	rc = microbench_run(b, "encode_8b10b", "byte", 1, bench_encode_8b10b, &rd); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	/* There may be a disparity error where the words wrap round, which takes the same time */
+	rd = 0;
+	for (int i=0; i < BENCH_INPUT_LENGTH; i++)
+		bench_words[i] = encode_8b10b(&rd, bench_bytes[i]);
+	decode_8b10b_t decoder;
+	decode_8b10b_start(&decoder, DECODE_8B10B_RD_UNKNOWN);
+	rc = microbench_run(b, "decode_8b10b", "byte", 1, bench_decode_8b10b, &decoder); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	audio_processor_start_mode(AUDIO_MODE_DUV);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	rc = microbench_run(b, "get_next_bit", "bit", 1, bench_get_next_bit, NULL); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	int block_sizes[] = {8, 32, 64};
+	for (int i=0; i < sizeof(block_sizes)/sizeof(block_sizes[0]); i++) {
+		audio_processor_start_mode(AUDIO_MODE_DUV);
+		telem_thread_restart(TELEM_STREAM_MAIN);
+		snprintf(name, sizeof(name), "next_bits_%d", block_sizes[i]);
+		rc = microbench_run(b, name, "bit", block_sizes[i], bench_next_bits, &block_sizes[i]); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+
+	audio_processor_start_mode(AUDIO_MODE_DUV);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	rc = microbench_run(b, "read_bit", "bit", 1, bench_read_bit, NULL); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	audio_processor_start_mode(AUDIO_MODE_DUV);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	rc = microbench_run(b, "modulate_bit", "sample", 1, bench_modulate_bit, NULL); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	char *mode_names[AUDIO_NUM_MODES] = {"audio_loop_duv", "audio_loop_high_speed", "audio_loop_combined"};
+	for (int m=0; m < AUDIO_NUM_MODES; m++) {
+		if (!microbench_selected(b, mode_names[m]))
+			continue;
+		audio_processor_start_mode(m);
+		for (int s=0; s < TELEM_NUM_STREAMS; s++)
+			telem_thread_restart(s);
+		rc = microbench_run(b, mode_names[m], "sample", PERIOD_SIZE, bench_audio_loop, NULL); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	}
+	audio_processor_start_mode(AUDIO_MODE_DUV);
+	return fail;
+}
+
+/**
+ * Print this help if the -h or --help command line options are used
+ */
+void help(void) {
+	printf(
+			"Usage: telem_bench [OPTION]... \n"
+			"-h,--help                        help\n"
+			"-c,--cpu <num>                   run on cpu <num>, -1 for any cpu.  The default is the last cpu\n"
+			"-w,--warmup <num>                untimed repetitions before timing starts\n"
+			"-r,--repetitions <num>           timed repetitions of each benchmark\n"
+			"-f,--filter <text>               only run the benchmarks with <text> in their name\n"
+			"-j,--json <file>                 write the results as JSON to <file>, - for stdout\n"
+	);
+	exit(EXIT_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+	int cpu = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	int warmup = MICROBENCH_DEFAULT_WARMUP;
+	int repetitions = MICROBENCH_DEFAULT_REPETITIONS;
+	char *filter = NULL;
+	char *json_file = NULL;
+
+	struct option long_option[] =
+	{
+			{"help", 0, NULL, 'h'},
+			{"cpu", 1, NULL, 'c'},
+			{"warmup", 1, NULL, 'w'},
+			{"repetitions", 1, NULL, 'r'},
+			{"filter", 1, NULL, 'f'},
+			{"json", 1, NULL, 'j'},
+			{NULL, 0, NULL, 0},
+	};
+
+	while (1) {
+		int c;
+		if ((c = getopt_long(argc, argv, "hc:w:r:f:j:", long_option, NULL)) < 0)
+			break;
+		switch (c) {
+		case 'h': // help
+			help();
+			break;
+		case 'c': // cpu to run on
+			cpu = atoi(optarg);
+			break;
+		case 'w': // warmup repetitions
+			warmup = atoi(optarg);
+			break;
+		case 'r': // timed repetitions
+			repetitions = atoi(optarg);
+			break;
+		case 'f': // only run matching benchmarks
+			filter = optarg;
+			break;
+		case 'j': // JSON output
+			json_file = optarg;
+			break;
+		}
+	}
+
+	/* The benchmarks use the same settings as telem_radio */
+	load_config();
+	printf("TELEM Radio Benchmarks\n");
+	printf("Build: %s\n", VERSION);
+
+	if (realtime_set_cpu(cpu) != EXIT_SUCCESS)
+		cpu = -1;
+
+	int rc = init_telemetry_processor(DUV_PACKET_LENGTH);
+	if (rc != EXIT_SUCCESS) {
+		error_print("FATAL. Could not initialize the telemetry processor.\n");
+		exit(rc);
+	}
+	rc = init_audio_processor();
+	if (rc != EXIT_SUCCESS) {
+		error_print("Initialization error with audio processor\n");
+		exit(rc);
+	}
+	rc = gen_sin_table(bench_sin_table, BENCH_OSC_TABLE_SIZE);
+	if (rc != EXIT_SUCCESS)
+		exit(rc);
+
+	/* Noise for the filters, random bytes for the encoders, and transponder audio of a tone plus a little noise */
+	srand(1);
+	for (int i=0; i < BENCH_INPUT_LENGTH; i++) {
+		bench_input[i] = (double)rand() / RAND_MAX - 0.5;
+		bench_bytes[i] = rand() & 0xff;
+	}
+	for (int i=0; i < DUV_DATA_LENGTH; i++)
+		bench_packet[i] = rand() & 0xff;
+	for (int i=0; i < 4 * PERIOD_SIZE; i++)
+		bench_audio_in[i] = 0.3 * sin(2 * M_PI * 1000.0 * i / g_sample_rate) + 0.01 * ((double)rand() / RAND_MAX - 0.5);
+
+	static microbench_t bench;
+	microbench_init(&bench, warmup, repetitions, cpu, filter);
+	microbench_print_header(&bench);
+	rc = bench_run_all(&bench);
+
+	if (json_file != NULL) {
+		FILE *f = strcmp(json_file, "-") == 0 ? stdout : fopen(json_file, "w");
+		if (f == NULL) {
+			error_print("Could not open %s\n", json_file);
+			exit(EXIT_FAILURE);
+		}
+		if (microbench_write_json(&bench, f) != EXIT_SUCCESS)
+			rc = EXIT_FAILURE;
+		if (f != stdout)
+			fclose(f);
+	}
+	exit(rc);
+}
@@ -16,6 +16,14 @@
  */
 double fir_filter(double in, double *coeffs, double *xv, int len);
 
+/*
+ * Interpolate one sample by rate through an FIR filter.  This gives the same rate outputs as
+ * passing rate-1 zeros and then the sample through fir_filter(), but only the taps that meet a
+ * sample are calculated.  xv stores the last (len + rate - 1) / rate input samples.
+ *
+ */
+void fir_interpolate(double in, double *out, int rate, double *coeffs, double *xv, int len);
+
 /*
  * Generate a raised cosine filter kernel and return the result in coeffs.  The caller is responsible
  * for allocating the needed space for the array.
@@ -30,5 +38,6 @@ int gen_root_raised_cosine_coeffs(double * coeffs, double sampleRate, double fre
 
 
 int test_fir_filter(int print_filter_test_output);
+int test_fir_interpolate();
 
 #endif /* FIR_FILTER_H_ */
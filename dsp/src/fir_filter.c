@@ -44,6 +44,28 @@ double fir_filter(double in, double *coeffs, double *xv, int len) {
 	return sum;
 }
 
+/*
+ * The zeros before the sample are filtered first.  For each output only every rate-th tap lines
+ * up with a sample, starting from the tap that meets the most recent one.  The taps are summed
+ * in the same order as fir_filter() so the results are the same.
+ */
+void fir_interpolate(double in, double *out, int rate, double *coeffs, double *xv, int len) {
+	int M = len-1;
+	int n = (len + rate - 1) / rate;
+	for (int r = 0; r < rate; r++) {
+		if (r == rate - 1) {
+			for (int i = 0; i < n - 1; i++)
+				xv[i] = xv[i+1];
+			xv[n-1] = in;
+		}
+		int newest = (r + 1) % rate; // taps from the end to the most recent sample
+		double sum = 0.0;
+		for (int i = (M - newest) % rate; i <= M - newest; i += rate)
+			sum += coeffs[i] * xv[n - 1 - (M - newest - i) / rate];
+		out[r] = sum;
+	}
+}
+
 int gen_root_raised_cosine_coeffs(double *coeffs, double sampleRate, double freq, double alpha, int len) {
 	verbose_print("  Root Raised Cosine Filter Rate: %d Freq:%d Alpha:%f Len:%d\n", (int)sampleRate, (int)freq, alpha, len);
 	int M = len-1;
@@ -177,3 +199,45 @@ int test_fir_filter(int print_filter_test_output) {
 
 	return rc;
 }
+
+/*
+ * Interpolate a random signal and check it against zero stuffing and the full filter
+ */
+int test_fir_interpolate() {
+	printf("TESTING fir_interpolate .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	int lens[] = {480, 60, 61};
+	int rates[] = {4, 3, 5};
+	for (int t=0; t < 3; t++) {
+		int len = lens[t];
+		int rate = rates[t];
+		double coeffs[len];
+		double xv[len];
+		double sparse_xv[len];
+		memset(xv, 0, sizeof(xv));
+		memset(sparse_xv, 0, sizeof(sparse_xv));
+		gen_raised_cosine_coeffs(coeffs, 48000, 24000 / rate, 0.5, len);
+		srand(t + 1);
+		double max_err = 0;
+		for (int n=0; n < 3 * len; n++) {
+			double value = (double)rand() / RAND_MAX - 0.5;
+			double out[rate];
+			fir_interpolate(value, out, rate, coeffs, sparse_xv, len);
+			for (int r=0; r < rate; r++) {
+				double expected = fir_filter(r == rate - 1 ? value : 0.0, coeffs, xv, len);
+				if (fabs(out[r] - expected) > max_err)
+					max_err = fabs(out[r] - expected);
+			}
+		}
+		verbose_print(" len %d rate %d max error %g\n", len, rate, max_err);
+		if (max_err != 0)
+			fail = EXIT_FAILURE;
+	}
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
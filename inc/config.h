@@ -46,8 +46,39 @@
 #define ZERO_VALUE "zero_value"
 #define RAMP_AMOUNT "ramp_amount"
 #define RAMP_BITS_TO_COMPENSATE_HPF "ramp_bits_to_compensate_hpf"
+#define DUV_BIT_RATE "duv_bit_rate"
+#define HIGH_SPEED_BIT_RATE "high_speed_bit_rate"
+#define HIGH_SPEED_MODULATION "high_speed_modulation"
+#define FSK_MARK_FREQ "fsk_mark_freq"
+#define FSK_SPACE_FREQ "fsk_space_freq"
+#define GFSK_BT "gfsk_bt"
+#define HIGH_SPEED_BURST_LEVEL "high_speed_burst_level"
+#define ALSA_DEVICE "alsa_device"
+#define ALSA_PERIODS "alsa_periods"
+#define ALSA_RT_PRIORITY "alsa_rt_priority"
+#define LATENCY_SHORT_WINDOW_SEC "latency_short_window_sec"
+#define LATENCY_LONG_WINDOW_SEC "latency_long_window_sec"
+#define LOCK_MEMORY "lock_memory"
+#define PREFAULT_HEAP_KB "prefault_heap_kb"
+#define PREFAULT_STACK_KB "prefault_stack_kb"
+#define TELEM_CPU "telem_cpu"
+#define CONSOLE_CPU "console_cpu"
+#define TELEM_SCHED_POLICY "telem_sched_policy"
+#define FRAME_PATTERN "frame_pattern"
+#define FRAME_QUEUE_DEPTH "frame_queue_depth"
+#define WOD_FILE "wod_file"
+#define WOD_RECORDS "wod_records"
+#define WOD_PERIOD_SEC "wod_period_sec"
+#define WOD_SYNC_RECORDS "wod_sync_records"
+#define ARCHIVE_FRAMES "archive_frames"
+#define ARCHIVE_DIR "archive_dir"
+#define ARCHIVE_SEGMENT_RECORDS "archive_segment_records"
+#define ARCHIVE_MAX_SEGMENTS "archive_max_segments"
+#define GOLDEN_DIR "golden_dir"
+#define GOLDEN_ABS_TOLERANCE "golden_abs_tolerance"
+#define GOLDEN_ULP_TOLERANCE "golden_ulp_tolerance"
 
-/* Global variables declared here. All must start with g_ They are defined in main.c */
+/* Global variables declared here. All must start with g_ They are defined in config.c */
 extern int g_verbose;          /* set from command line switch or from the cmd console */
 extern int g_sample_rate;      /* sample rate used by the audio processor */
 
@@ -57,9 +88,58 @@ extern double g_zero_value;
 extern double g_ramp_amount; /* When bits have the same value ramp the amount up to compensate for HPF in the radio transmitter */
 extern int g_ramp_bits_to_compensate_hpf; /* Apply a slight ramp to the bits to compensate for high pass filter in the radio */
 
+/* Telemetry bit rates.  These do not need to divide the sample rate */
+extern int g_duv_bit_rate;
+extern int g_high_speed_bit_rate;
+
+/* High speed modulation, see fsk_modulator.h */
+extern char g_high_speed_modulation[MAX_LINE_LENGTH]; /* nrz, afsk or gfsk */
+extern double g_fsk_mark_freq; /* tone for a one */
+extern double g_fsk_space_freq; /* tone for a zero */
+extern double g_gfsk_bt; /* bandwidth of the Gaussian filter times the bit period */
+extern double g_high_speed_burst_level; /* scale for the high speed telemetry when it is sent on top of DUV */
+
 extern int g_ptt_state; /* PTT state for RTS or GPIO control */
 extern int g_serial_fd; /* the file descriptor for the serial port */
 
+/* Settings for the ALSA audio backend */
+extern char g_alsa_device[MAX_LINE_LENGTH]; /* ALSA pcm name, e.g. hw:1,0 or null for testing */
+extern int g_alsa_periods; /* number of periods in the ALSA buffer */
+extern int g_alsa_rt_priority; /* SCHED_FIFO priority of the ALSA audio thread */
+
+/* Windows in seconds over which the audio loop time percentiles are reported */
+extern int g_latency_short_window_sec;
+extern int g_latency_long_window_sec;
+
+/* Realtime setup, see realtime.h */
+extern int g_lock_memory; /* mlockall so the audio thread never waits for a page */
+extern int g_prefault_heap_kb; /* heap to touch at startup */
+extern int g_prefault_stack_kb; /* stack to touch at startup in main and the telem thread */
+extern int g_telem_cpu; /* cpu for the telem thread, or -1 for any */
+extern int g_console_cpu; /* cpu for the command console, or -1 for any */
+extern char g_telem_sched_policy[MAX_LINE_LENGTH]; /* other or idle */
+
+/* Telemetry frames, see telem_scheduler.h */
+extern char g_frame_pattern[MAX_LINE_LENGTH]; /* frame types in the order they are sent, e.g. RT,EXP,EXP,RT */
+extern int g_frame_queue_depth; /* frames built ahead of the one being sent */
+
+/* Whole orbit data store, see wod_store.h */
+extern char g_wod_file[MAX_LINE_LENGTH]; /* the ring file of past samples */
+extern int g_wod_records; /* samples kept in the file */
+extern int g_wod_period_sec; /* seconds between samples */
+extern int g_wod_sync_records; /* samples between each write to the card */
+
+/* Archive of the frames sent, see frame_archive.h */
+extern int g_archive_frames; /* 1 to record each frame as it is sent */
+extern char g_archive_dir[MAX_LINE_LENGTH]; /* the directory of segment files */
+extern int g_archive_segment_records; /* frames in each segment file */
+extern int g_archive_max_segments; /* the oldest are deleted when there are more, 0 to keep them all */
+
+/* Where the golden reference files are and how far the audio can be from them, see golden_output.h */
+extern char g_golden_dir[MAX_LINE_LENGTH]; /* empty to find them from the executable */
+extern double g_golden_abs_tolerance;
+extern int g_golden_ulp_tolerance;
+
 void load_config();
 
 #endif /* CONFIG_H_ */
@@ -0,0 +1,67 @@
+/*
+ * realtime.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Setup so that the audio thread does not stall on a page fault, and so that the other
+ * threads keep out of its way.  Memory is locked and touched before the audio starts,
+ * the telem thread can be run at a low priority and the telem thread and console can be kept
+ * on a different core to the audio thread.
+ *
+ */
+
+#ifndef REALTIME_H_
+#define REALTIME_H_
+
+#include <pthread.h>
+
+/* Defaults if they are not in the config file.  A cpu of -1 means the thread can run on any core */
+#define REALTIME_DEFAULT_LOCK_MEMORY 1
+#define REALTIME_DEFAULT_PREFAULT_HEAP_KB 1024
+#define REALTIME_DEFAULT_PREFAULT_STACK_KB 256
+#define REALTIME_DEFAULT_CPU -1
+
+/* Values for telem_sched_policy in the config file */
+#define REALTIME_POLICY_OTHER "other"
+#define REALTIME_POLICY_IDLE "idle"
+#define REALTIME_DEFAULT_TELEM_POLICY REALTIME_POLICY_OTHER
+
+/*
+ * Lock memory, stop malloc from giving memory back to the kernel, then touch the heap, the
+ * stack and the DSP buffers so that they are all resident.  Call this from main() before
+ * any threads are started.
+ */
+int realtime_init();
+
+/* Touch kb of the calling thread's stack so that it is resident */
+void realtime_prefault_stack(int kb);
+
+/* Fill in attributes for the telem thread with its policy, cpu and a stack of a known size */
+int realtime_telem_thread_attr(pthread_attr_t *attr);
+
+/* Keep the calling thread on one cpu.  Nothing is changed if cpu is -1 */
+int realtime_set_cpu(int cpu);
+
+/* Called from the audio thread at the end of each period to count page faults in that period */
+void realtime_record_page_faults();
+
+/* Print the memory locking state and page fault counts */
+void realtime_print_status();
+
+int test_realtime();
+
+#endif /* REALTIME_H_ */
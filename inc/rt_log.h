@@ -0,0 +1,70 @@
+/*
+ * rt_log.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Logging for the audio thread.  Writing to a terminal can block, which would cause an xrun,
+ * so the audio thread formats each message into a fixed size record in a ring buffer and the
+ * logger thread prints it later.  If the ring is full the message is dropped and counted.
+ *
+ * Only one thread may write to the ring.  That is the audio thread once it is running.
+ *
+ */
+
+#ifndef RT_LOG_H_
+#define RT_LOG_H_
+
+#include <stdio.h>
+
+#include "config.h"
+
+#define RT_LOG_RECORD_LEN 160 /* longer messages are truncated */
+#define RT_LOG_RECORDS 64     /* must be a power of 2 */
+
+#define RT_LOG_INFO 0    /* printed to stdout */
+#define RT_LOG_ERROR 1   /* printed to stderr */
+
+/* -- Macro Definitions
+ * These match debug_print, verbose_print and error_print in debug.h, but are safe to call from
+ * the audio thread.
+ */
+#define rt_print(fmt, ...) \
+            rt_log(RT_LOG_INFO, fmt, ##__VA_ARGS__);
+
+#define rt_verbose_print(fmt, ...) \
+            if (g_verbose) rt_log(RT_LOG_INFO, fmt, ##__VA_ARGS__);
+
+#define rt_error_print(fmt, ...) \
+            rt_log(RT_LOG_ERROR, "ERROR: %s:%d:%s(): " fmt, __FILE__, \
+                                __LINE__, __func__, ##__VA_ARGS__);
+
+/* Format a message into the ring.  This never blocks */
+void rt_log(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/* Print everything in the ring.  Returns the number of records printed */
+int rt_log_drain(FILE *out, FILE *err);
+
+/*
+ * Start the logger thread which drains the ring.  Stopping it drains anything that is
+ * left so that messages logged just before exit are not lost.
+ */
+int rt_log_start();
+void rt_log_stop();
+
+int test_rt_log();
+
+#endif /* RT_LOG_H_ */
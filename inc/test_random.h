@@ -0,0 +1,37 @@
+/*
+ * test_random.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Random numbers for the self tests.  A linear congruential generator gives the same numbers
+ * on every platform, unlike rand(), so a failing test can be run again with the same data.
+ * The caller keeps the state and picks the seed.
+ *
+ */
+
+#ifndef TEST_RANDOM_H_
+#define TEST_RANDOM_H_
+
+#include <stdint.h>
+
+/* Move the state on and return it.  The top bits are the most random */
+uint32_t test_random(uint32_t *state);
+
+/* Fill len bytes with the top byte of each number */
+void test_random_fill(uint32_t *state, unsigned char *buf, int len);
+
+#endif /* TEST_RANDOM_H_ */
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+#
+# Generate the pack and unpack functions for the telemetry layouts
+#
+# The layouts are described in telem_send/layout as csv files with the columns from the AMSAT
+# Spacecraft Editor.  The first line has the number of fields and the column names.  Each line
+# after that is a field, in the order it is sent:
+#     num,FIELD,BITS,UNIT,DESCRIPTION
+#
+# The fields are packed like the __packed__ bitfields in duv_telem_layout.h that gcc makes on a
+# little endian machine: the first field starts at bit 0 of byte 0 and each field follows on
+# from the last, least significant bit first.  Each byte of the frame is written in one go from
+# the fields that overlap it, with shifts and masks and no branches, so the result is the same
+# on any compiler and byte order.
+#
+# Run from the top of the repo after a layout changes:
+#     python3 scripts/gen_layout_codec.py
+# With --check it only reports if the generated files are out of date.
+#
+
+import os
+import sys
+
+LAYOUT_DIR = "telem_send/layout"
+HEADER = "telem_send/inc/layout_codec.h"
+SOURCE = "telem_send/src/layout_codec.c"
+
+# The name of each layout, its file and the struct it matches in duv_telem_layout.h or exp_layout.h
+LAYOUTS = [
+    ("duv_header", "duv_header.csv", "duv_header_t"),
+    ("rttelemetry", "rttelemetry.csv", "rttelemetry_t"),
+    ("exptelemetry", "exptelemetry.csv", "exptelemetry_t"),
+]
+
+LICENSE = """ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+"""
+
+def read_layout(filename):
+    """Return a list of (name, bits, offset, unit, description) and the length in bytes"""
+    with open(filename) as f:
+        lines = [l.strip() for l in f if l.strip()]
+    count = int(lines[0].split(",")[0])
+    fields = []
+    offset = 0
+    for line in lines[1:]:
+        num, name, bits, unit, description = line.split(",", 4)
+        bits = int(bits)
+        if int(num) != len(fields):
+            sys.exit("%s: field %s is out of order" % (filename, name))
+        if bits < 1 or bits > 32:
+            sys.exit("%s: field %s must be 1 to 32 bits" % (filename, name))
+        fields.append((name, bits, offset, unit, description))
+        offset += bits
+    if count != len(fields):
+        sys.exit("%s: has %d fields but the first line says %d" % (filename, len(fields), count))
+    if offset % 8 != 0:
+        sys.exit("%s: is %d bits, which is not a whole number of bytes" % (filename, offset))
+    return fields, offset // 8
+
+def shift(expr, amount):
+    """expr shifted left by amount, or right if it is negative"""
+    if amount > 0:
+        return "(%s << %d)" % (expr, amount)
+    if amount < 0:
+        return "(%s >> %d)" % (expr, -amount)
+    return expr
+
+def overlaps(fields, byte):
+    """The fields in a byte with the shift from the field to the byte and the mask in the byte"""
+    parts = []
+    for name, bits, offset, unit, description in fields:
+        first = max(offset, byte * 8)
+        last = min(offset + bits, byte * 8 + 8)
+        if first < last:
+            mask = ((1 << (last - first)) - 1) << (first - byte * 8)
+            parts.append((name, offset - byte * 8, mask))
+    return parts
+
+def gen_header(layouts):
+    out = []
+    out.append("/*\n * layout_codec.h\n *\n * Generated by scripts/gen_layout_codec.py from the layouts in %s.\n"
+               " * Do not edit, change the layout and run the script again.\n *\n" % LAYOUT_DIR)
+    out.append(LICENSE)
+    out.append(" *\n * Each layout has a struct with a field for each value and functions to pack it into the\n"
+               " * bytes of a frame and to unpack it again.  The bytes are the same as the __packed__ struct\n"
+               " * of the same name that gcc makes on a little endian machine.\n *\n */\n\n")
+    out.append("#ifndef LAYOUT_CODEC_H_\n#define LAYOUT_CODEC_H_\n\n#include <stdint.h>\n\n")
+    for name, fields, length, struct in layouts:
+        out.append("/* %s, the same bytes as %s */\n" % (name, struct))
+        out.append("#define %s_PACKED_LENGTH %d\n\n" % (name.upper(), length))
+        out.append("typedef struct {\n")
+        for fname, bits, offset, unit, description in fields:
+            out.append("\tuint32_t %s; // %d bit%s, %s\n" % (fname, bits, "" if bits == 1 else "s", description))
+        out.append("} %s_fields_t;\n\n" % name)
+        out.append("void %s_pack(const %s_fields_t *f, unsigned char *buf);\n" % (name, name))
+        out.append("void %s_unpack(const unsigned char *buf, %s_fields_t *f);\n\n" % (name, name))
+    out.append("#endif /* LAYOUT_CODEC_H_ */\n")
+    return "".join(out)
+
+def gen_source(layouts):
+    out = []
+    out.append("/*\n * layout_codec.c\n *\n * Generated by scripts/gen_layout_codec.py from the layouts in %s.\n"
+               " * Do not edit, change the layout and run the script again.\n *\n" % LAYOUT_DIR)
+    out.append(LICENSE)
+    out.append(" *\n */\n\n#include \"../../telem_send/inc/layout_codec.h\"\n")
+    for name, fields, length, struct in layouts:
+        out.append("\nvoid %s_pack(const %s_fields_t *f, unsigned char *buf) {\n" % (name, name))
+        for byte in range(length):
+            terms = ["%s & 0x%02x" % (shift("f->" + fname, s), mask) for fname, s, mask in overlaps(fields, byte)]
+            out.append("\tbuf[%d] = (unsigned char)(%s);\n" % (byte, " | ".join("(%s)" % t for t in terms)))
+        out.append("}\n")
+        out.append("\nvoid %s_unpack(const unsigned char *buf, %s_fields_t *f) {\n" % (name, name))
+        for fname, bits, offset, unit, description in fields:
+            terms = []
+            for byte in range(offset // 8, (offset + bits + 7) // 8):
+                for oname, s, mask in overlaps(fields, byte):
+                    if oname == fname:
+                        terms.append(shift("(uint32_t)(buf[%d] & 0x%02x)" % (byte, mask), -s))
+            out.append("\tf->%s = %s;\n" % (fname, " | ".join(terms)))
+        out.append("}\n")
+    return "".join(out)
+
+USAGE = "usage: scripts/gen_layout_codec.py [--check]"
+
+def main():
+    args = sys.argv[1:]
+    if len(args) > 1 or (args and args[0] != "--check"):
+        sys.exit(USAGE)
+    check = bool(args)
+    layouts = []
+    for name, filename, struct in LAYOUTS:
+        fields, length = read_layout(os.path.join(LAYOUT_DIR, filename))
+        layouts.append((name, fields, length, struct))
+    files = [(HEADER, gen_header(layouts)), (SOURCE, gen_source(layouts))]
+    if check:
+        stale = [path for path, text in files if not os.path.exists(path) or open(path).read() != text]
+        for path in stale:
+            print(path + " is out of date, run scripts/gen_layout_codec.py")
+        sys.exit(1 if stale else 0)
+    for path, text in files:
+        with open(path, "w") as f:
+            f.write(text)
+        print("Wrote " + path)
+
+main()
@@ -13,6 +13,9 @@
 #include "config.h"
 #include "debug.h"
 #include "audio_processor.h"
+#include "audio_perf.h"
+#include "loop_latency.h"
+#include "realtime.h"
 #include "oscillator.h"
 #include "gpio_interface.h"
 #include "serial.h"
@@ -33,12 +36,15 @@ char *help_str =
 		" (l)ow pass filter   - Toggle bit low high pass filter on/off\n"
 		" (t)elem       - Toggle DUV telemetry on/off\n"
 		" (hs)highspeed - Toggle High Speed telemetry on/off\n"
+		" (b)oth        - Toggle High Speed telemetry on top of DUV on/off\n"
 		" (p)tt         - Toggle the radio on/off\n"
 		" test          - DUV telem contains only 101010 on/off\n"
 		" tone          - Generate test tone\n"
 		" freq <Hz>     - Set freq of test tone\n"
 		" time <YY MM DD HH MM SS>     - Set time of the RTC\n"
 		" measure       - Display measurement for input tone\n"
+		" perf [reset]  - Display audio loop stage times, or reset them\n"
+		" latency       - Display audio loop time percentiles and deadline used\n"
 		" (v)verbose    - Toggle verbose output for debugging"
 		" (h)help       - show this help\n"
 		" (q)uit        - Shutdown and exit\n\n";
@@ -59,7 +65,7 @@ void print_full_status() {
 	printf("TELEM Radio status:\n");
 	int rate = g_sample_rate/get_decimation_rate();
 	printf(" audio engine sample rate: %" PRIu32 " with decimation by %d to %d\n", g_sample_rate,get_decimation_rate(), rate);
-	printf(" samples per bit: %d. Ramp to compensate HPF: %d", get_samples_per_bit(), g_ramp_bits_to_compensate_hpf);
+	printf(" samples per bit: %.2f. Ramp to compensate HPF: %d", get_samples_per_bit(), g_ramp_bits_to_compensate_hpf);
 	if (g_ramp_bits_to_compensate_hpf)
 		printf(" amount %.2f", g_ramp_amount);
 	printf("\n");
@@ -68,12 +74,15 @@ void print_full_status() {
 	print_status("Bit Low Pass Filter", get_lpf_bits());
 	print_status("DUV Telemetry", get_send_telem());
 	print_status("High Speed Telemetry", get_send_high_speed_telem());
+	print_status("DUV with High Speed", get_send_duv_with_high_speed());
 	print_status("Test Telem", get_send_test_telem());
 	print_status("Transmitter", g_ptt_state);
 
 	print_status("Generate test tone", get_send_test_tone());
 	print_status("Measure input test tone", get_measure_test_tone());
 	print_status("Verbose Output", g_verbose);
+	audio_processor_print_mode_status();
+	realtime_print_status();
 }
 
 void stop_cmd_console() { cmd_console_running = false; }
@@ -110,24 +119,22 @@ int start_cmd_console() {
 				print_status("Bit Low Pass Filter", get_lpf_bits());
 			} else if (strcmp(token, "telem") == 0 || strcmp(token, "t") == 0) {
 				set_send_telem(!get_send_telem());
-				set_send_high_speed_telem(false);
-				if (get_send_telem() == true) { // reset the modulator
-					rc = init_bit_modulator(DUV_BPS, DUV_DECIMATION_RATE);
-					if (rc != EXIT_SUCCESS) {
-						error_print("Issue initializing the modulator.  It may not work correctly..");
-					}
-				}
+				set_send_high_speed_telem(false); // the DUV pipeline takes over at the end of the frame
+				set_send_duv_with_high_speed(false);
 				print_status("Telemetry", get_send_telem());
 			} else if (strcmp(token, "highspeed") == 0 || strcmp(token, "hs") == 0) {
 				set_send_high_speed_telem(!get_send_high_speed_telem());
-				set_send_telem(get_send_high_speed_telem());
-				if (get_send_high_speed_telem() == true) { // reset the modulator
-					rc = init_bit_modulator(FSK_1200_BPS, 1);
-					if (rc != EXIT_SUCCESS) {
-						error_print("Issue initializing the high speed bit modulator.  It may not work correctly..");
-					}
-				}
+				set_send_duv_with_high_speed(false);
+				set_send_telem(get_send_high_speed_telem()); // the mode changes at the end of the frame
 				print_status("Telemetry", get_send_telem());
+			} else if (strcmp(token, "both") == 0 || strcmp(token, "b") == 0) {
+				set_send_duv_with_high_speed(!get_send_duv_with_high_speed());
+				set_send_high_speed_telem(get_send_duv_with_high_speed());
+				set_send_telem(true); // DUV carries on when the high speed telemetry is turned off
+				print_status("DUV with High Speed", get_send_duv_with_high_speed());
+				if (get_send_duv_with_high_speed() && fsk_modulation_type(g_high_speed_modulation) == FSK_NRZ)
+					printf("High speed modulation is %s.  Use %s or %s to keep the DUV band clear\n",
+							g_high_speed_modulation, FSK_MODULATION_AFSK, FSK_MODULATION_GFSK);
 			} else if (strcmp(token, "ptt") == 0 || strcmp(token, "p") == 0) {
 				g_ptt_state = !g_ptt_state;
 #ifdef PTT_WITH_GPIO
@@ -187,6 +194,15 @@ int start_cmd_console() {
 			} else if (strcmp(token, "tone") == 0) {
 				set_send_test_tone(!get_send_test_tone());
 				print_status("Send Test Tone", get_send_test_tone());
+			} else if (strcmp(token, "perf") == 0) {
+				token = strsep(&line, " ");
+				if (token != NULL && strcmp(token, "reset") == 0) {
+					audio_perf_reset();
+					printf("Audio loop stage times reset\n");
+				} else
+					audio_perf_print();
+			} else if (strcmp(token, "latency") == 0) {
+				loop_latency_print();
 			} else if (strcmp(token, "status") == 0 || strcmp(token, "s") == 0) {
 				print_full_status();
 			} else if (strcmp(token, "help") == 0 || strcmp(token, "h") == 0) {
@@ -196,6 +212,8 @@ int start_cmd_console() {
 			} else {
 				printf("Unknown command: %s\n", line);
 			}
+			/* Any settings changed by the command reach the audio thread together at the next period */
+			audio_processor_publish_params();
 		}
 	}
 	free(line);
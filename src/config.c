@@ -28,6 +28,62 @@
 #include <stdlib.h>
 
 #include "config.h"
+#include "fsk_modulator.h"
+#include "alsa_audio.h"
+#include "loop_latency.h"
+#include "realtime.h"
+#include "telem_processor.h"
+#include "golden_output.h"
+#include "telem_scheduler.h"
+#include "wod_store.h"
+#include "frame_archive.h"
+
+/*
+ *  GLOBAL VARIABLES defined here.  They are declared in config.h
+ *  These are the default values.  Many can be updated with a value
+ *  in telem_radio.config or can be over riden on the command line.
+ *  They are here rather than in main.c so that telem_bench can use them too.
+ *
+ */
+int g_verbose = false;
+int g_sample_rate = 48000;
+double g_one_value = 0.2;
+double g_zero_value = -0.2;
+double g_ramp_amount = 0.02;
+int g_ramp_bits_to_compensate_hpf = true;
+int g_duv_bit_rate = DUV_BPS;
+int g_high_speed_bit_rate = FSK_1200_BPS;
+char g_high_speed_modulation[MAX_LINE_LENGTH] = FSK_MODULATION_NRZ;
+double g_fsk_mark_freq = FSK_DEFAULT_MARK_FREQ;
+double g_fsk_space_freq = FSK_DEFAULT_SPACE_FREQ;
+double g_gfsk_bt = FSK_DEFAULT_GFSK_BT;
+double g_high_speed_burst_level = 0.5;
+int g_ptt_state = 0;
+int g_serial_fd = -1;
+char g_alsa_device[MAX_LINE_LENGTH] = ALSA_DEFAULT_DEVICE;
+int g_alsa_periods = ALSA_DEFAULT_PERIODS;
+int g_alsa_rt_priority = ALSA_DEFAULT_RT_PRIORITY;
+int g_latency_short_window_sec = LOOP_LATENCY_DEFAULT_SHORT_WINDOW_SEC;
+int g_latency_long_window_sec = LOOP_LATENCY_DEFAULT_LONG_WINDOW_SEC;
+int g_lock_memory = REALTIME_DEFAULT_LOCK_MEMORY;
+int g_prefault_heap_kb = REALTIME_DEFAULT_PREFAULT_HEAP_KB;
+int g_prefault_stack_kb = REALTIME_DEFAULT_PREFAULT_STACK_KB;
+int g_telem_cpu = REALTIME_DEFAULT_CPU;
+int g_console_cpu = REALTIME_DEFAULT_CPU;
+char g_telem_sched_policy[MAX_LINE_LENGTH] = REALTIME_DEFAULT_TELEM_POLICY;
+char g_frame_pattern[MAX_LINE_LENGTH] = TELEM_SCHEDULER_DEFAULT_PATTERN;
+int g_frame_queue_depth = TELEM_SCHEDULER_DEFAULT_QUEUE_DEPTH;
+char g_wod_file[MAX_LINE_LENGTH] = WOD_STORE_DEFAULT_FILE;
+int g_wod_records = WOD_STORE_DEFAULT_RECORDS;
+int g_wod_period_sec = WOD_STORE_DEFAULT_PERIOD_SEC;
+int g_wod_sync_records = WOD_STORE_DEFAULT_SYNC_RECORDS;
+int g_archive_frames = false;
+char g_archive_dir[MAX_LINE_LENGTH] = FRAME_ARCHIVE_DEFAULT_DIR;
+int g_archive_segment_records = FRAME_ARCHIVE_DEFAULT_SEGMENT_RECORDS;
+int g_archive_max_segments = FRAME_ARCHIVE_DEFAULT_MAX_SEGMENTS;
+char g_golden_dir[MAX_LINE_LENGTH] = "";
+double g_golden_abs_tolerance = GOLDEN_DEFAULT_ABS_TOLERANCE;
+int g_golden_ulp_tolerance = GOLDEN_DEFAULT_ULP_TOLERANCE;
 
 char filename[] = "telem_radio.config";
 
@@ -68,6 +124,99 @@ void load_config() {
 				} else if (strcmp(key, RAMP_BITS_TO_COMPENSATE_HPF) == 0) {
 					int intval = atoi(value);
 					g_ramp_bits_to_compensate_hpf = intval;
+				} else if (strcmp(key, DUV_BIT_RATE) == 0) {
+					int intval = atoi(value);
+					g_duv_bit_rate = intval;
+				} else if (strcmp(key, HIGH_SPEED_BIT_RATE) == 0) {
+					int intval = atoi(value);
+					g_high_speed_bit_rate = intval;
+				} else if (strcmp(key, HIGH_SPEED_MODULATION) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_high_speed_modulation, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, FSK_MARK_FREQ) == 0) {
+					float fval = atof(value);
+					g_fsk_mark_freq = fval;
+				} else if (strcmp(key, FSK_SPACE_FREQ) == 0) {
+					float fval = atof(value);
+					g_fsk_space_freq = fval;
+				} else if (strcmp(key, GFSK_BT) == 0) {
+					float fval = atof(value);
+					g_gfsk_bt = fval;
+				} else if (strcmp(key, HIGH_SPEED_BURST_LEVEL) == 0) {
+					float fval = atof(value);
+					g_high_speed_burst_level = fval;
+				} else if (strcmp(key, ALSA_DEVICE) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_alsa_device, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, ALSA_PERIODS) == 0) {
+					int intval = atoi(value);
+					g_alsa_periods = intval;
+				} else if (strcmp(key, ALSA_RT_PRIORITY) == 0) {
+					int intval = atoi(value);
+					g_alsa_rt_priority = intval;
+				} else if (strcmp(key, LATENCY_SHORT_WINDOW_SEC) == 0) {
+					int intval = atoi(value);
+					g_latency_short_window_sec = intval;
+				} else if (strcmp(key, LATENCY_LONG_WINDOW_SEC) == 0) {
+					int intval = atoi(value);
+					g_latency_long_window_sec = intval;
+				} else if (strcmp(key, LOCK_MEMORY) == 0) {
+					int intval = atoi(value);
+					g_lock_memory = intval;
+				} else if (strcmp(key, PREFAULT_HEAP_KB) == 0) {
+					int intval = atoi(value);
+					g_prefault_heap_kb = intval;
+				} else if (strcmp(key, PREFAULT_STACK_KB) == 0) {
+					int intval = atoi(value);
+					g_prefault_stack_kb = intval;
+				} else if (strcmp(key, TELEM_CPU) == 0) {
+					int intval = atoi(value);
+					g_telem_cpu = intval;
+				} else if (strcmp(key, CONSOLE_CPU) == 0) {
+					int intval = atoi(value);
+					g_console_cpu = intval;
+				} else if (strcmp(key, TELEM_SCHED_POLICY) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_telem_sched_policy, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, FRAME_PATTERN) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_frame_pattern, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, FRAME_QUEUE_DEPTH) == 0) {
+					int intval = atoi(value);
+					g_frame_queue_depth = intval;
+				} else if (strcmp(key, WOD_FILE) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_wod_file, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, WOD_RECORDS) == 0) {
+					int intval = atoi(value);
+					g_wod_records = intval;
+				} else if (strcmp(key, WOD_PERIOD_SEC) == 0) {
+					int intval = atoi(value);
+					g_wod_period_sec = intval;
+				} else if (strcmp(key, WOD_SYNC_RECORDS) == 0) {
+					int intval = atoi(value);
+					g_wod_sync_records = intval;
+				} else if (strcmp(key, ARCHIVE_FRAMES) == 0) {
+					int intval = atoi(value);
+					g_archive_frames = intval;
+				} else if (strcmp(key, ARCHIVE_DIR) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_archive_dir, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, ARCHIVE_SEGMENT_RECORDS) == 0) {
+					int intval = atoi(value);
+					g_archive_segment_records = intval;
+				} else if (strcmp(key, ARCHIVE_MAX_SEGMENTS) == 0) {
+					int intval = atoi(value);
+					g_archive_max_segments = intval;
+				} else if (strcmp(key, GOLDEN_DIR) == 0) {
+					value[strcspn(value, "\r\n")] = '\0';
+					strncpy(g_golden_dir, value, MAX_LINE_LENGTH-1);
+				} else if (strcmp(key, GOLDEN_ABS_TOLERANCE) == 0) {
+					double dval = atof(value);
+					g_golden_abs_tolerance = dval;
+				} else if (strcmp(key, GOLDEN_ULP_TOLERANCE) == 0) {
+					int intval = atoi(value);
+					g_golden_ulp_tolerance = intval;
 				} else {
 					error_print("Unknown key in %s file: %s\n",filename, key);
 				}
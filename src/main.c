@@ -46,9 +46,21 @@
 #include "debug.h"
 #include "jack_audio.h"
 #include "audio_processor.h"
+#include "fsk_modulator.h"
+#include "duv_demodulator.h"
+#include "ber_sim.h"
+#include "golden_output.h"
+#include "audio_backend.h"
+#include "audio_perf.h"
+#include "latency_histogram.h"
+#include "loop_latency.h"
+#include "file_audio.h"
+#include "alsa_audio.h"
 #include "gpio_interface.h"
 #include "cmd_console.h"
 #include "serial.h"
+#include "rt_log.h"
+#include "realtime.h"
 
 #include "device_lps25hb.h"
 #include "device_ds3231.h"
@@ -62,28 +74,52 @@
 #include "oscillator.h"
 #include "../telem_send/inc/telem_processor.h"
 #include "../telem_send/inc/telem_thread.h"
-
-/*
- *  GLOBAL VARIABLES defined here.  They are declared in config.h
- *  These are the default values.  Many can be updated with a value
- *  in telem_radio.config or can be over riden on the command line.
- *
- */
-int g_verbose = false;
-int g_sample_rate = 48000;
-double g_one_value = 0.2;
-double g_zero_value = -0.2;
-double g_ramp_amount = 0.02;
-int g_ramp_bits_to_compensate_hpf = true;
-int g_ptt_state = 0;
-int g_serial_fd = -1;
+#include "../telem_send/inc/telem_scheduler.h"
+#include "../telem_send/inc/wod_store.h"
+#include "../telem_send/inc/frame_archive.h"
+#include "../telem_send/inc/hs_frame.h"
+#include "../telem_send/inc/gf256.h"
+#include "../telem_send/inc/rs_encoder.h"
+#include "../telem_send/inc/rs_decoder.h"
+#include "../telem_send/inc/decode_8b10b.h"
 
 /* local variables for this file */
 pthread_t telem_pthread;
 int run_tests = false;
+int run_bench = false;
+int ber_sim_frames = 0;
+int run_golden = false;
+int update_golden = false;
 int more_help = false;
 int filter_test_num = 0;
 int print_filter_test_output = true;
+char *audio_backend_name = DEFAULT_AUDIO_BACKEND;
+char *audio_input_file = NULL;
+char *audio_output_file = NULL;
+int audio_periods = 0;
+char *dump_archive_dir = NULL;
+uint64_t dump_from = 0;
+uint64_t dump_to = UINT64_MAX;
+
+#define BENCH_PERIODS 400
+
+int run_benchmarks() {
+	int rc = EXIT_SUCCESS;
+	int fail = EXIT_SUCCESS;
+	printf("\nRunning Benchmarks..\n");
+	rc = init_audio_processor();
+	if (rc != EXIT_SUCCESS)
+		return rc;
+
+	rc = bench_audio_loop_variants(BENCH_PERIODS); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = bench_fsk_modulator(BENCH_PERIODS); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+
+	if (fail == EXIT_SUCCESS)
+		printf("Benchmarks complete\n\n");
+	else
+		printf("Some Benchmarks gave the wrong output\n\n");
+	return fail;
+}
 
 int run_self_test() {
 	int rc = EXIT_SUCCESS;
@@ -92,11 +128,35 @@ int run_self_test() {
 	//rc = test_oscillator(); exit(1);
 
 	rc = test_rs_encoder();    if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_gf256();         if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_rs_encode_frames(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_rs_decoder();    if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_hs_frame();      if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_decode_8b10b();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 	rc = test_sync_word();     if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 	rc = test_get_next_bit();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_get_next_bits(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 	rc = test_modulate_bit();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;  ////////// WHY SOMETIMES FAILS??
+	rc = test_audio_params();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_audio_pipeline(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_symbol_clock();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_fsk_modulator(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_fir_interpolate(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_combined_pipeline(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_duv_demodulator(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_ber_sim();       if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_golden_output(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 	rc = test_encode_packet();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_layout_codec();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 	rc = test_gather_duv_telemetry(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_telem_scheduler(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_wod_store();     if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_frame_archive(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_latency_histogram(); if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_audio_perf();    if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_loop_latency();  if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_rt_log();        if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
+	rc = test_realtime();      if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE;
 
 	//	rc = test_audio_tools();   if (rc != EXIT_SUCCESS) fail = EXIT_FAILURE; // audio tools not currently used
 
@@ -139,8 +199,19 @@ void help(void) {
 			"Usage: telem_radio [OPTION]... \n"
 			"-h,--help                        help\n"
 			"-v,--verbose                     print additional status and progress messages\n"
+			"-a,--audio <backend>             audio backend: jack (default), alsa, file or null\n"
+			"--input <file>                   WAV or raw 16 bit input file for the file backend\n"
+			"--output <file>                  WAV output file for the file backend\n"
+			"--periods <num>                  stop the file or null backend after <num> periods\n"
+			"--dump-archive <dir>             print the frames in the archive and exit\n"
+			"--from <epoch>:<uptime>          dump the frames sent from this time\n"
+			"--to <epoch>:<uptime>            dump the frames sent up to this time\n"
 #ifdef DEBUG
 			"-t,--test                        run self tests before starting the audio\n"
+			"-b,--bench                       run the benchmarks and exit\n"
+			"--ber-sim <frames>               simulate DUV with noise, print the bit and frame error rates and exit\n"
+			"--golden                         compare the audio with the golden reference files and exit\n"
+			"--golden-update                  write new golden reference files and exit\n"
 			"-f,--filter-test <num>           Run a test on filter <num>\n"
 			"-i, --print-filter-test-input    Print the input test wave instead of the filter output\n"
 			"Valid filter tests are:\n"
@@ -152,13 +223,25 @@ void help(void) {
 	exit(EXIT_SUCCESS);
 }
 
+/* An archive time is <epoch>:<uptime>, or just the epoch for the start of the year */
+uint64_t parse_archive_time(char *text) {
+	unsigned int epoch = 0, uptime = 0;
+	if (sscanf(text, "%u:%u", &epoch, &uptime) < 1) {
+		error_print("Archive time should be <epoch>:<uptime>: %s\n", text);
+		exit(EXIT_FAILURE);
+	}
+	return FRAME_ARCHIVE_KEY(epoch, uptime);
+}
+
 void signal_handler (int sig) {
 	debug_print (" Signal received, exiting ...\n");
 	closeserial(g_serial_fd);
 	telem_thread_stop();
 	stop_cmd_console();
-	stop_jack_audio_processor();
+	audio_backend_stop();
 	sleep(1); // give jack time to close
+	rt_log_stop();
+	frame_archive_stop();
 	cleanup_telem_processor();
 
 	exit (0);
@@ -178,17 +261,28 @@ int main(int argc, char *argv[]) {
 	{
 			{"help", 0, NULL, 'h'},
 			{"test", 0, NULL, 't'},
+			{"bench", 0, NULL, 'b'},
 			{"verbose", 0, NULL, 'v'},
 			{"filter-test", 1, NULL, 'f'},
 			{"print-filter-test-input", 0, NULL, 'i'},
 			{"print_filter_test_kernel", 0, NULL, 'k'},
+			{"audio", 1, NULL, 'a'},
+			{"input", 1, NULL, 'I'},
+			{"output", 1, NULL, 'O'},
+			{"periods", 1, NULL, 'P'},
+			{"ber-sim", 1, NULL, 'B'},
+			{"golden", 0, NULL, 'G'},
+			{"golden-update", 0, NULL, 'U'},
+			{"dump-archive", 1, NULL, 'D'},
+			{"from", 1, NULL, 'F'},
+			{"to", 1, NULL, 'T'},
 			{NULL, 0, NULL, 0},
 	};
 
 	int err = 0;
 	while (1) {
 		int c;
-		if ((c = getopt_long(argc, argv, "htvfi:", long_option, NULL)) < 0)
+		if ((c = getopt_long(argc, argv, "htbvfi:a:", long_option, NULL)) < 0)
 			break;
 		switch (c) {
 		case 'h': // help
@@ -207,9 +301,44 @@ int main(int argc, char *argv[]) {
 		case 't': // self test
 			run_tests = true;
 			break;
+		case 'b': // benchmarks
+			run_bench = true;
+			break;
 		case 'v': // verbose
 			g_verbose = true;
 			break;
+		case 'a': // audio backend
+			audio_backend_name = optarg;
+			break;
+		case 'I': // input file for the file backend
+			audio_input_file = optarg;
+			break;
+		case 'O': // output file for the file backend
+			audio_output_file = optarg;
+			break;
+		case 'P': // number of periods to run the file or null backend
+			audio_periods = atoi(optarg);
+			break;
+		case 'B': // frames at each Eb/N0 for the bit error rate simulation
+			ber_sim_frames = atoi(optarg);
+			if (ber_sim_frames <= 0)
+				ber_sim_frames = BER_SIM_DEFAULT_FRAMES;
+			break;
+		case 'G': // compare with the golden reference files
+			run_golden = true;
+			break;
+		case 'U': // write the golden reference files
+			update_golden = true;
+			break;
+		case 'D': // print the frame archive
+			dump_archive_dir = optarg;
+			break;
+		case 'F': // the first time to print from the archive
+			dump_from = parse_archive_time(optarg);
+			break;
+		case 'T': // the last time to print from the archive
+			dump_to = parse_archive_time(optarg);
+			break;
 		}
 	}
 
@@ -218,6 +347,16 @@ int main(int argc, char *argv[]) {
 		return 0;
 	}
 
+	if (dump_archive_dir != NULL) {
+		long frames = frame_archive_dump(dump_archive_dir, stdout, dump_from, dump_to);
+		if (frames < 0) {
+			error_print("Could not read the archive in %s\n", dump_archive_dir);
+			exit(EXIT_FAILURE);
+		}
+		verbose_print("%ld frames\n", frames);
+		exit(EXIT_SUCCESS);
+	}
+
 	if (!filter_test_num) {
 		printf("TELEM Radio Platform\n");
 	    printf("Build: %s\n", VERSION);
@@ -274,6 +413,9 @@ int main(int argc, char *argv[]) {
 	set_rts(g_serial_fd, g_ptt_state);
 #endif
 
+	/* Shared by the demodulators of all the threads, so it is made before any start */
+	decode_8b10b_init();
+
 #ifdef DEBUG
 	if (filter_test_num) {
 		rc = run_filter_test(filter_test_num, print_filter_test_output);
@@ -284,37 +426,86 @@ int main(int argc, char *argv[]) {
 		if (rc != EXIT_SUCCESS)
     		exit(rc);
     }
+	if (run_bench) {
+		rc = run_benchmarks();
+		exit(rc);
+	}
+	if (ber_sim_frames) {
+		rc = ber_sim_run(ber_sim_frames);
+		exit(rc);
+	}
+	if (run_golden || update_golden) {
+		char golden_dir[MAX_LINE_LENGTH];
+		golden_output_dir(golden_dir, sizeof(golden_dir));
+		rc = golden_output_run(golden_dir, update_golden, true);
+		exit(rc);
+	}
 #endif
 
-	rc = init_telemetry_processor(DUV_PACKET_LENGTH);
+	rc = audio_backend_select(audio_backend_name);
 	if (rc != EXIT_SUCCESS) {
-		error_print("FATAL. Could not initialize the telemetry processor.\n");
+		printf("Valid audio backends are: ");
+		audio_backend_print_list();
+		printf("\n");
 		exit(rc);
 	}
+	file_audio_configure(audio_input_file, audio_output_file, audio_periods);
 
-	char *name = "Telem Thread";
-	rc = pthread_create( &telem_pthread, NULL, telem_thread_process, (void*) name);
+	rc = init_telemetry_processor(DUV_PACKET_LENGTH);
 	if (rc != EXIT_SUCCESS) {
-		error_print("FATAL. Could not start the telemetry thread.\n");
+		error_print("FATAL. Could not initialize the telemetry processor.\n");
 		exit(rc);
 	}
 
-	rc = init_audio_processor(DUV_BPS,DUV_DECIMATION_RATE);
-//	rc = init_audio_processor(FSK_1200_BPS,1);
+	rc = init_audio_processor();
 	if (rc != EXIT_SUCCESS) {
 		error_print("Initialization error with audio processor\n");
 		return rc;
 	}
 
-    rc = start_jack_audio_processor();
+	/* Lock and touch memory before any threads start, so the audio thread does not page fault */
+	realtime_init();
+
+	/* The audio thread logs through the logger thread so it never blocks on the terminal */
+	rc = rt_log_start();
+	if (rc != EXIT_SUCCESS) {
+		error_print("FATAL. Could not start the logger thread.\n");
+		exit(rc);
+	}
+
+	/* The frames are archived as they are sent.  Carry on without the archive if it can not be opened */
+	rc = frame_archive_start();
+	if (rc != EXIT_SUCCESS)
+		error_print("Could not start the frame archive in %s\n", g_archive_dir);
+
+	char *name = "Telem Thread";
+	pthread_attr_t telem_attr;
+	realtime_telem_thread_attr(&telem_attr);
+	rc = pthread_create( &telem_pthread, &telem_attr, telem_thread_process, (void*) name);
+	if (rc != EXIT_SUCCESS) {
+		error_print("Could not set the telem thread policy or cpu, starting it with the defaults\n");
+		rc = pthread_create( &telem_pthread, NULL, telem_thread_process, (void*) name);
+	}
+	pthread_attr_destroy(&telem_attr);
+	if (rc != EXIT_SUCCESS) {
+		error_print("FATAL. Could not start the telemetry thread.\n");
+		exit(rc);
+	}
+
+    rc = audio_backend_start();
     if (rc != EXIT_SUCCESS) {
-    		error_print("FATAL. Could not start the jack audio thread.\n");
+    		error_print("FATAL. Could not start the %s audio backend.\n", audio_backend_get()->name);
     		exit(rc);
     	}
-    rc = start_cmd_console();  // this will run until the user exits (or until we receive a signal)
-    if (rc != EXIT_SUCCESS) {
-    	error_print("FATAL. Error with the command console.\n");
-    	exit(rc);
+    if (audio_backend_is_continuous()) {
+    	realtime_set_cpu(g_console_cpu); // after the audio backend has started its threads
+    	rc = start_cmd_console();  // this will run until the user exits (or until we receive a signal)
+    	if (rc != EXIT_SUCCESS) {
+    		error_print("FATAL. Error with the command console.\n");
+    		exit(rc);
+    	}
+    } else {
+    	rc = audio_backend_wait(); // the file and null backends run until the input is used up
     }
 
 #ifdef RASPBERRY_PI
@@ -325,6 +516,8 @@ int main(int argc, char *argv[]) {
     cleanup_telem_processor();
 
 	printf("Exiting TELEM radio platform ..\n");
-	stop_jack_audio_processor();
+	audio_backend_stop();
+	rt_log_stop();
+	frame_archive_stop();
 	return rc;
 }
@@ -0,0 +1,242 @@
+/*
+ * realtime.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Page faults are counted with getrusage(RUSAGE_THREAD) in the audio thread, which counts
+ * only that thread's faults.  Once memory is locked and touched this should stay at zero.
+ *
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "audio_processor.h"
+#include "realtime.h"
+
+/* Forward function declarations */
+long realtime_thread_page_faults();
+
+#define REALTIME_STACK_MARGIN_KB 64 /* stack for the telem thread above what is prefaulted */
+
+int memory_locked = false;
+
+/* Page fault counts written by the audio thread */
+pthread_t fault_thread;
+int fault_thread_known = false;
+long last_thread_faults = 0;
+long last_period_faults = 0;
+long max_period_faults = 0;
+long total_period_faults = 0;
+long periods_with_faults = 0;
+
+int realtime_init() {
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	/* Keep freed memory in the heap so that later mallocs do not fault, and do not use mmap for big blocks */
+	mallopt(M_TRIM_THRESHOLD, -1);
+	mallopt(M_MMAP_MAX, 0);
+
+	if (g_lock_memory) {
+		if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+			error_print("Could not lock memory, page faults may cause xruns: %s\n", strerror(errno));
+		} else {
+			memory_locked = true;
+			verbose_print("Memory locked\n");
+		}
+	}
+
+	/* Grow the heap and touch every page.  This stays in the heap when it is freed */
+	if (g_prefault_heap_kb > 0) {
+		size_t len = (size_t)g_prefault_heap_kb * 1024;
+		unsigned char *heap = malloc(len);
+		if (heap == NULL) {
+			error_print("Could not allocate %d kB to prefault the heap\n", g_prefault_heap_kb);
+		} else {
+			for (size_t i=0; i < len; i += page_size)
+				heap[i] = 0;
+			free(heap);
+		}
+	}
+
+	realtime_prefault_stack(g_prefault_stack_kb);
+	audio_processor_touch_buffers();
+	return EXIT_SUCCESS;
+}
+
+void realtime_prefault_stack(int kb) {
+	if (kb <= 0)
+		return;
+	long page_size = sysconf(_SC_PAGESIZE);
+	unsigned char stack[kb * 1024];
+	volatile unsigned char *touch = stack; // volatile so the writes are not optimized away
+	for (int i=0; i < kb * 1024; i += page_size)
+		touch[i] = 0;
+}
+
+int realtime_telem_thread_attr(pthread_attr_t *attr) {
+	pthread_attr_init(attr);
+
+	if (g_prefault_stack_kb > 0) {
+		size_t stack_size = (size_t)(g_prefault_stack_kb + REALTIME_STACK_MARGIN_KB) * 1024;
+		if (stack_size < PTHREAD_STACK_MIN)
+			stack_size = PTHREAD_STACK_MIN;
+		pthread_attr_setstacksize(attr, stack_size);
+	}
+
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	pthread_attr_setinheritsched(attr, PTHREAD_EXPLICIT_SCHED);
+	int policy = SCHED_OTHER;
+	if (strcmp(g_telem_sched_policy, REALTIME_POLICY_IDLE) == 0)
+		policy = SCHED_IDLE;
+	else if (strcmp(g_telem_sched_policy, REALTIME_POLICY_OTHER) != 0)
+		error_print("Unknown telem thread policy %s, using %s\n", g_telem_sched_policy, REALTIME_POLICY_OTHER);
+	pthread_attr_setschedpolicy(attr, policy);
+	pthread_attr_setschedparam(attr, &param);
+
+	if (g_telem_cpu >= 0) {
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(g_telem_cpu, &cpus);
+		pthread_attr_setaffinity_np(attr, sizeof(cpus), &cpus);
+	}
+	return EXIT_SUCCESS;
+}
+
+int realtime_set_cpu(int cpu) {
+	if (cpu < 0)
+		return EXIT_SUCCESS;
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(cpu, &cpus);
+	int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	if (rc != 0) {
+		error_print("Could not run on cpu %d: %s\n", cpu, strerror(rc));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+long realtime_thread_page_faults() {
+	struct rusage usage;
+	if (getrusage(RUSAGE_THREAD, &usage) != 0)
+		return -1;
+	return usage.ru_minflt + usage.ru_majflt;
+}
+
+void realtime_record_page_faults() {
+	long faults = realtime_thread_page_faults();
+	if (faults < 0)
+		return;
+	/* The first period on a new audio thread just sets the starting count */
+	if (!fault_thread_known || !pthread_equal(fault_thread, pthread_self())) {
+		fault_thread = pthread_self();
+		fault_thread_known = true;
+		last_thread_faults = faults;
+		return;
+	}
+	long period_faults = faults - last_thread_faults;
+	last_thread_faults = faults;
+	__atomic_store_n(&last_period_faults, period_faults, __ATOMIC_RELAXED);
+	if (period_faults > 0) {
+		__atomic_store_n(&total_period_faults, total_period_faults + period_faults, __ATOMIC_RELAXED);
+		__atomic_store_n(&periods_with_faults, periods_with_faults + 1, __ATOMIC_RELAXED);
+		if (period_faults > max_period_faults)
+			__atomic_store_n(&max_period_faults, period_faults, __ATOMIC_RELAXED);
+	}
+}
+
+void realtime_print_status() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	printf(" memory locked: %s. Process page faults: %ld minor %ld major\n", memory_locked ? "yes" : "no",
+			usage.ru_minflt, usage.ru_majflt);
+	printf(" audio thread page faults: %ld total, %ld periods with faults, max %ld per period, %ld last period\n",
+			__atomic_load_n(&total_period_faults, __ATOMIC_RELAXED),
+			__atomic_load_n(&periods_with_faults, __ATOMIC_RELAXED),
+			__atomic_load_n(&max_period_faults, __ATOMIC_RELAXED),
+			__atomic_load_n(&last_period_faults, __ATOMIC_RELAXED));
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/*
+ * Touch memory that has never been used between two periods and check that the faults are
+ * counted.  This must run before realtime_init(), otherwise the new memory is already locked.
+ */
+int test_realtime() {
+	printf("TESTING realtime .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	int pages = 16;
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	fault_thread_known = false;
+	total_period_faults = 0;
+	periods_with_faults = 0;
+	max_period_faults = 0;
+	realtime_record_page_faults();
+	realtime_record_page_faults();
+	long quiet = last_period_faults;
+
+	unsigned char *mem = mmap(NULL, pages * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED) {
+		printf(" Fail\n");
+		return EXIT_FAILURE;
+	}
+	for (int i=0; i < pages; i++)
+		mem[i * page_size] = 1;
+	realtime_record_page_faults();
+	verbose_print(" faults with no memory touched %ld, after touching %d pages %ld\n", quiet, pages, last_period_faults);
+	if (last_period_faults < pages || periods_with_faults < 1 || max_period_faults < pages)
+		fail = EXIT_FAILURE;
+	munmap(mem, pages * page_size);
+
+	/* Counting starts again on the audio thread */
+	fault_thread_known = false;
+	total_period_faults = 0;
+	periods_with_faults = 0;
+	max_period_faults = 0;
+	last_period_faults = 0;
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
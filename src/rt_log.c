@@ -0,0 +1,182 @@
+/*
+ * rt_log.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The ring has one writer and one reader, so it needs no locks.  The writer owns head and
+ * the reader owns tail.  A record is filled in before head is moved past it, and is not
+ * reused until the reader has moved tail past it.
+ *
+ */
+
+/* System */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+/* Program */
+#include "config.h"
+#include "debug.h"
+#include "rt_log.h"
+
+/* Forward function declarations */
+void *rt_log_process(void *arg);
+
+#define RT_LOG_POLL_MICROSEC 20000
+
+typedef struct {
+	int level;
+	char text[RT_LOG_RECORD_LEN];
+} rt_log_record_t;
+
+rt_log_record_t rt_log_ring[RT_LOG_RECORDS];
+uint32_t rt_log_head = 0;
+uint32_t rt_log_tail = 0;
+uint32_t rt_log_dropped = 0;
+
+pthread_t rt_log_pthread;
+int rt_log_running = false;
+
+void rt_log(int level, const char *fmt, ...) {
+	uint32_t head = __atomic_load_n(&rt_log_head, __ATOMIC_RELAXED);
+	uint32_t tail = __atomic_load_n(&rt_log_tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= RT_LOG_RECORDS) {
+		__atomic_fetch_add(&rt_log_dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	rt_log_record_t *record = &rt_log_ring[head & (RT_LOG_RECORDS - 1)];
+	record->level = level;
+	va_list args;
+	va_start(args, fmt);
+	vsnprintf(record->text, RT_LOG_RECORD_LEN, fmt, args);
+	va_end(args);
+	__atomic_store_n(&rt_log_head, head + 1, __ATOMIC_RELEASE);
+}
+
+int rt_log_drain(FILE *out, FILE *err) {
+	int printed = 0;
+	uint32_t tail = __atomic_load_n(&rt_log_tail, __ATOMIC_RELAXED);
+	uint32_t head = __atomic_load_n(&rt_log_head, __ATOMIC_ACQUIRE);
+	while (tail != head) {
+		rt_log_record_t *record = &rt_log_ring[tail & (RT_LOG_RECORDS - 1)];
+		fputs(record->text, record->level == RT_LOG_ERROR ? err : out);
+		tail++;
+		__atomic_store_n(&rt_log_tail, tail, __ATOMIC_RELEASE);
+		printed++;
+	}
+	uint32_t dropped = __atomic_exchange_n(&rt_log_dropped, 0, __ATOMIC_RELAXED);
+	if (dropped)
+		fprintf(err, "ERROR: %d log messages from the audio thread were dropped\n", dropped);
+	if (printed) {
+		fflush(out);
+		fflush(err);
+	}
+	return printed;
+}
+
+void *rt_log_process(void *arg) {
+	while (__atomic_load_n(&rt_log_running, __ATOMIC_RELAXED)) {
+		rt_log_drain(stdout, stderr);
+		usleep(RT_LOG_POLL_MICROSEC);
+	}
+	return NULL;
+}
+
+int rt_log_start() {
+	if (rt_log_running)
+		return EXIT_SUCCESS;
+	rt_log_running = true;
+	int rc = pthread_create(&rt_log_pthread, NULL, rt_log_process, NULL);
+	if (rc != 0) {
+		error_print("Could not start the logger thread\n");
+		rt_log_running = false;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void rt_log_stop() {
+	if (rt_log_running) {
+		__atomic_store_n(&rt_log_running, false, __ATOMIC_RELAXED);
+		pthread_join(rt_log_pthread, NULL);
+	}
+	rt_log_drain(stdout, stderr);
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* This must run before the logger thread is started, because it reads the ring itself */
+int test_rt_log() {
+	printf("TESTING rt_log .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	char *out_text, *err_text;
+	size_t out_len, err_len;
+
+	rt_log_drain(stdout, stderr); // anything logged before the test
+	FILE *out = open_memstream(&out_text, &out_len);
+	FILE *err = open_memstream(&err_text, &err_len);
+
+	rt_print("info %d\n", 1);
+	rt_error_print("error %.1f\n", 2.5);
+	int printed = rt_log_drain(out, err);
+	fflush(out);
+	fflush(err);
+	verbose_print(" out: %s err: %s", out_text, err_text);
+	if (printed != 2 || strcmp(out_text, "info 1\n") != 0 || strstr(err_text, "rt_log.c") == NULL
+			|| strstr(err_text, "test_rt_log(): error 2.5\n") == NULL)
+		fail = EXIT_FAILURE;
+
+	/* Overfill the ring.  The extra messages are dropped and reported */
+	for (int i=0; i < RT_LOG_RECORDS + 5; i++)
+		rt_print("message %d\n", i);
+	printed = rt_log_drain(out, err);
+	fflush(out);
+	fflush(err);
+	verbose_print(" printed %d\n", printed);
+	if (printed != RT_LOG_RECORDS || strstr(err_text, "5 log messages from the audio thread were dropped") == NULL)
+		fail = EXIT_FAILURE;
+
+	/* Long messages are truncated to fit the record */
+	char long_text[RT_LOG_RECORD_LEN * 2];
+	memset(long_text, 'x', sizeof(long_text) - 1);
+	long_text[sizeof(long_text) - 1] = '\0';
+	rt_print("%s", long_text);
+	rt_log_drain(out, err);
+	fflush(out);
+	if (strlen(strrchr(out_text, '\n') + 1) != RT_LOG_RECORD_LEN - 1)
+		fail = EXIT_FAILURE;
+
+	fclose(out);
+	fclose(err);
+	free(out_text);
+	free(err_text);
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,34 @@
+/*
+ * test_random.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The constants are from Numerical Recipes.
+ *
+ */
+
+#include "test_random.h"
+
+uint32_t test_random(uint32_t *state) {
+	*state = *state * 1664525 + 1013904223;
+	return *state;
+}
+
+void test_random_fill(uint32_t *state, unsigned char *buf, int len) {
+	for (int i=0; i < len; i++)
+		buf[i] = test_random(state) >> 24;
+}
@@ -22,6 +22,7 @@
 #define TELEMENCODING_H_
 
 #include <stdint.h>
+#include <stdio.h>
 
 #define CHARACTER_BITS 10
 #define CHARACTERS_PER_LONGWORD 3
@@ -37,9 +38,26 @@ void update_rs(
    unsigned char c          // Current data byte to update
 );
 
+/*
+ * Table driven versions of update_rs(), with the same results.  The table is built on first use,
+ * or call init_rs_table() at startup.  encode_rs() encodes a whole frame of up to 223 bytes
+ */
+void init_rs_table(void);
+void update_rs_table(
+   unsigned char parity[32], // 32-byte encoder state; zero before each frame
+   unsigned char c          // Current data byte to update
+);
+void encode_rs(
+   unsigned char parity[32], // the parities for the frame are written here
+   const unsigned char *data,
+   int len);
+
 int encode_8b10b(
     int *state, // pointer to encoder state (run disparity, RD)
     int16_t data);
 
+/* Write the least significant num_bytes of word to the file, least significant byte first */
+void write_little_endian(unsigned int word, int num_bytes, FILE *wav_file);
+
 
 #endif /* TELEMENCODING_H_ */
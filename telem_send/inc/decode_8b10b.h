@@ -0,0 +1,88 @@
+/*
+ * decode_8b10b.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * 8b10b decoder for the receive side: the self tests, the demodulator and replay tools.
+ *
+ * A table with an entry for each of the 1024 10b words is made from encode_8b10b() when it is
+ * first needed, so the decoder can not disagree with the encoder.  Each entry has the byte, and
+ * the running disparity the word may be sent with.  A word that the encoder never sends has
+ * neither, and is a code violation.
+ *
+ * The streaming decoder keeps the running disparity from word to word.  A valid word that was
+ * sent with the wrong running disparity is a disparity error, which means a bit error in this
+ * word or an earlier one.
+ *
+ */
+
+#ifndef DECODE_8B10B_H_
+#define DECODE_8B10B_H_
+
+#include <stdint.h>
+
+#include "TelemEncoding.h"
+
+/* The bits in a table entry */
+#define DECODE_8B10B_DATA 0x0ff
+#define DECODE_8B10B_SYNC 0x100 // K.28.5.  The data bits are zero
+#define DECODE_8B10B_RD_MINUS 0x200 // valid when the running disparity is -1
+#define DECODE_8B10B_RD_PLUS 0x400 // valid when the running disparity is +1
+
+/* What decode_8b10b() returns if the word is not a byte */
+#define DECODE_8B10B_SYNC_WORD SYNC_CHARACTER
+#define DECODE_8B10B_INVALID -2
+
+/* The error for the last word */
+#define DECODE_8B10B_OK 0
+#define DECODE_8B10B_CODE_VIOLATION 1
+#define DECODE_8B10B_DISPARITY_ERROR 2
+
+/* The running disparity, with the same values as the encoder state */
+#define DECODE_8B10B_RD_UNKNOWN -1 // take it from the first word
+
+typedef struct {
+	int rd;
+	int error; // for the last word
+	long words;
+	long code_violations;
+	long disparity_errors;
+} decode_8b10b_t;
+
+extern uint16_t decode_8b10b_table[1 << CHARACTER_BITS];
+
+/* Make the table, once.  Call it at startup, before any thread decodes */
+void decode_8b10b_init();
+
+/* The table entry for a word, without checking the running disparity */
+static inline uint16_t decode_8b10b_lookup(uint16_t word) {
+	return decode_8b10b_table[word & CHARACTER_MASK];
+}
+
+/* Start a stream.  rd is the encoder state of the sender, or DECODE_8B10B_RD_UNKNOWN */
+void decode_8b10b_start(decode_8b10b_t *d, int rd);
+
+/*
+ * Decode the next word of a stream.  Returns the byte, DECODE_8B10B_SYNC_WORD or
+ * DECODE_8B10B_INVALID for a code violation.  The byte is still returned if there is a
+ * disparity error, and d->error says which error there was
+ */
+int decode_8b10b(decode_8b10b_t *d, uint16_t word);
+
+int test_decode_8b10b();
+
+#endif /* DECODE_8B10B_H_ */
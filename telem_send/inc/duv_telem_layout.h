@@ -23,6 +23,7 @@
 #define DUV_TELEM_LAYOUT_H_
 
 #include "exp_layout.h"
+#include "layout_codec.h"
 
 /* Header */
 typedef struct __attribute__((__packed__)) {
@@ -45,8 +46,8 @@ typedef struct __attribute__((__packed__)) {
     unsigned int xruns : 16;
     unsigned int loop_time : 8;
     unsigned int cpu_speed : 8;
-    unsigned int data2 : 8;
-    unsigned int data3 : 8;
+    unsigned int loop_time_p99 : 8;
+    unsigned int deadline_used : 8;
     unsigned int pad1 : 32;
     unsigned int pad2 : 32;
     unsigned int pad3 : 32;
@@ -73,4 +74,15 @@ typedef struct __attribute__((__packed__)) {
 	exptelemetry_t payload;
 } exp_packet_t;
 
+/*
+ * All of the telemetry from one sample of the sensors, before it is split into frames.  The
+ * fields are packed into the frames with the generated functions in layout_codec.h, so the
+ * bytes sent do not depend on how the compiler lays out bitfields
+ */
+typedef struct {
+    duv_header_fields_t header;
+    rttelemetry_fields_t rtHealth;
+    exptelemetry_fields_t exp;
+} telem_buffer_t;
+
 #endif /* DUV_TELEM_LAYOUT_H_ */
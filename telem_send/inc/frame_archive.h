@@ -0,0 +1,124 @@
+/*
+ * frame_archive.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * A record of every frame that was sent on air.  When a frame starts the audio thread copies
+ * the packed 10b words and the JACK frame time of the first sample of the sync word into a ring,
+ * like rt_log.  It never blocks and drops the frame if the ring is full.  The archive thread
+ * takes the frames from the ring, decodes the payload and appends a fixed size record to the
+ * current segment file.
+ *
+ * The segments are frames_00000001.dat and so on in the archive directory.  A new segment is
+ * started when one is full, when the program starts, and when the clock goes backwards, so the
+ * records in each segment are in order of the time they were sent.  When there are more than the
+ * maximum number of segments the oldest is deleted, so the archive does not fill the SD card.
+ *
+ * index.dat in the archive directory has an entry for each segment, in the order they were made,
+ * with the first and last time in it.  The writer updates the entry of the current segment each
+ * time it flushes, and makes the index again from the segments when it is opened if it does not
+ * match them.  A reader sorts the entries by the first time and finds a time with a binary search
+ * of the index and then of the records in the segment.  After the clock goes back the segments
+ * can overlap, so the search starts at the first one that reaches the time.
+ *
+ * The time of a record is the epoch and uptime of the wall clock when it was sent, worked out as
+ * in gather_duv_telemetry().  The frame header in the payload has the time the telemetry was
+ * gathered, which is older, or much older for a WOD frame.
+ *
+ */
+
+#ifndef FRAME_ARCHIVE_H_
+#define FRAME_ARCHIVE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "../../telem_send/inc/telem_processor.h"
+
+#define FRAME_ARCHIVE_RECORDS 32 // in the ring, must be a power of 2
+#define FRAME_ARCHIVE_DEFAULT_DIR "archive"
+#define FRAME_ARCHIVE_DEFAULT_SEGMENT_RECORDS 4096 // about an hour of frames at 1200 bps
+#define FRAME_ARCHIVE_DEFAULT_MAX_SEGMENTS 24 // about a day at 1200 bps, 27 MB
+
+/* The record for each frame in a segment file */
+typedef struct __attribute__((__packed__)) {
+	uint32_t seq; // counts the frames sent since the archive was opened
+	uint16_t epoch; // years since 2020 when the frame was sent
+	uint32_t uptime; // seconds since the start of the year when the frame was sent
+	uint32_t frame_time; // JACK frame time of the first sample of the sync word
+	uint8_t stream; // TELEM_STREAM_MAIN or TELEM_STREAM_BURST
+	uint8_t type; // from the frame header
+	uint8_t payload[DUV_DATA_LENGTH];
+	uint16_t words[DUV_PACKET_LENGTH+1]; // the 10b words as sent, with the sync word at the end
+} frame_archive_record_t;
+
+/* The entry for each segment in the index file */
+typedef struct __attribute__((__packed__)) {
+	uint32_t segment;
+	uint32_t records;
+	uint64_t first_key;
+	uint64_t last_key;
+} frame_archive_index_t;
+
+#define FRAME_ARCHIVE_INDEX_FILE "index.dat"
+
+/* The sort key of a record */
+#define FRAME_ARCHIVE_KEY(epoch, uptime) (((uint64_t)(epoch) << 32) | (uint32_t)(uptime))
+
+/* The key of a wall clock time, with the epoch and uptime worked out as for a record */
+uint64_t frame_archive_time_key(time_t t);
+
+/*
+ * Record a frame that is starting.  This is called by the audio thread and never blocks.
+ * Nothing is done unless the archive is open.
+ */
+void frame_archive_push(int stream, uint32_t frame_time, const uint64_t *packed_packet);
+
+/*
+ * Open the archive in dir and start a new segment.  The directory is made if needed.  The
+ * oldest segments are deleted to keep max_segments, or all of them are kept if it is 0
+ */
+int frame_archive_open(char *dir, int segment_records, int max_segments);
+
+/* Write the frames in the ring to the archive.  Returns the number written */
+int frame_archive_drain();
+
+/* Drain and close the archive */
+void frame_archive_close();
+
+/* Open the archive from the config and start the archive thread which drains the ring */
+int frame_archive_start();
+void frame_archive_stop();
+
+/*
+ * Print the records sent from the from key to the to key, one per line, with the payload in
+ * hex.  Returns the number printed or -1 if the archive can not be read
+ */
+long frame_archive_dump(char *dir, FILE *out, uint64_t from, uint64_t to);
+
+/*
+ * Find the first record sent at or after key.  Sets the segment number and the record in it.
+ * Returns EXIT_FAILURE if there is none
+ */
+int frame_archive_find(char *dir, uint64_t key, uint32_t *segment, long *record);
+
+int test_frame_archive();
+void test_frame_archive_remove(char *dir);
+int bench_frame_archive_make(char *dir, long frames, int bit_rate, time_t start);
+
+#endif /* FRAME_ARCHIVE_H_ */
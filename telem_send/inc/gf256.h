@@ -0,0 +1,95 @@
+/*
+ * gf256.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Arithmetic in GF(256) with the field polynomial used by the CCSDS Reed-Solomon code in
+ * TelemEncoding.c, x^8 + x^7 + x^2 + x + 1.
+ *
+ * The scalar functions use log and antilog tables.  The region functions multiply a whole
+ * block of bytes by one constant.  They split each byte into two nibbles and look both up in
+ * 16 entry tables for the constant, which is one byte shuffle instruction for 16 or 32 bytes at
+ * a time: PSHUFB with SSSE3 or AVX2 on x86, and TBL with NEON on ARM.  On x86 the kernel is
+ * picked when the program starts from what the cpu supports, so the default build can use it.
+ * On ARM NEON is used if the compiler has it enabled.
+ *
+ */
+
+#ifndef GF256_H_
+#define GF256_H_
+
+#include <stdint.h>
+
+#define GF256_POLY 0x187
+#define GF256_ORDER 255 // non zero elements
+
+/* The region kernels */
+#define GF256_KERNEL_SCALAR 0
+#define GF256_KERNEL_SSSE3 1
+#define GF256_KERNEL_AVX2 2
+#define GF256_KERNEL_NEON 3
+#define GF256_NUM_KERNELS 4
+
+/* Antilog and log tables.  gf256_log[0] is not used */
+extern uint8_t gf256_exp[2 * GF256_ORDER];
+extern uint8_t gf256_log[256];
+
+/* Build the tables and pick the fastest kernel.  Safe to call more than once */
+void gf256_init();
+
+static inline uint8_t gf256_mul(uint8_t a, uint8_t b) {
+	if (a == 0 || b == 0)
+		return 0;
+	return gf256_exp[gf256_log[a] + gf256_log[b]];
+}
+
+/* a / b.  b must not be zero */
+static inline uint8_t gf256_div(uint8_t a, uint8_t b) {
+	if (a == 0)
+		return 0;
+	return gf256_exp[gf256_log[a] + GF256_ORDER - gf256_log[b]];
+}
+
+/* alpha to the power n, for any n >= 0 */
+static inline uint8_t gf256_pow_alpha(int n) {
+	return gf256_exp[n % GF256_ORDER];
+}
+
+/* dst[i] ^= c * src[i] for len bytes */
+void gf256_mul_add_region(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+
+/* dst[i] = c * src[i] for len bytes.  dst and src may be the same */
+void gf256_mul_region(uint8_t *dst, const uint8_t *src, uint8_t c, int len);
+
+/*
+ * dst[r * stride + i] ^= c[r] * src[i] for rows rows of len bytes.  The same src multiplied by a
+ * set of constants, which is faster than a call for each row because src is only split once
+ */
+void gf256_mul_add_rows(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len);
+
+/* Use a kernel, for testing.  Returns EXIT_FAILURE if this cpu or build does not have it */
+int gf256_set_kernel(int kernel);
+int gf256_get_kernel();
+int gf256_kernel_supported(int kernel);
+char *gf256_kernel_name(int kernel);
+
+/* The bytes a kernel does at once.  Shorter regions, and the bytes left over, are done one at a time */
+int gf256_kernel_width(int kernel);
+
+int test_gf256();
+
+#endif /* GF256_H_ */
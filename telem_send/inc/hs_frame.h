@@ -0,0 +1,78 @@
+/*
+ * hs_frame.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * High speed frames, like the Fox high speed format.  A frame is made of several Reed-Solomon
+ * codewords that are interleaved byte by byte, so a burst of errors on the air is spread over
+ * all of them.  Byte i of the data goes in codeword i % codewords.  After the data the parities
+ * are sent in the same way, parity 0 of each codeword, then parity 1 and so on.  The frame is
+ * 8b10b encoded as it is sent and ends with the sync word.
+ *
+ * If the data does not fill the codewords they are shortened.  The first codewords get the
+ * extra byte when the data does not divide evenly.
+ *
+ * The RS registers of all the codewords are updated side by side, one codeword per byte of a
+ * vector, as in rs_encoder.c.  Each group of codewords bytes in the data is one byte for every
+ * register, so they are updated with one gf256_mul_add_rows() and no bytes are moved.
+ *
+ */
+
+#ifndef HS_FRAME_H_
+#define HS_FRAME_H_
+
+#include <stdint.h>
+
+#include "TelemEncoding.h"
+
+#define HS_FRAME_MAX_CODEWORDS 32 // a multiple of the widest gf256 kernel, see hs_frame_encode()
+#define HS_FRAME_DEFAULT_CODEWORDS 8
+#define HS_FRAME_DEFAULT_DATA_LENGTH (HS_FRAME_DEFAULT_CODEWORDS * DATA_BYTES_PER_CODE_WORD)
+#define HS_FRAME_MAX_DATA_LENGTH (HS_FRAME_MAX_CODEWORDS * DATA_BYTES_PER_CODE_WORD)
+/* The 10b words of the largest frame, with the sync word at the end */
+#define HS_FRAME_MAX_WORDS (HS_FRAME_MAX_CODEWORDS * (DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD) + 1)
+
+typedef struct {
+	int codewords;
+	int data_length;
+	int rows; // bytes in the longest codeword
+	int words; // 10b words in the frame, with the sync word
+	unsigned char coef[PARITY_BYTES_PER_CODEWORD]; // the generator, as in rs_encoder.c
+	/* The registers slide down the window as in rs_encode_group(), one column for each codeword */
+	unsigned char window[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD][HS_FRAME_MAX_CODEWORDS]
+			__attribute__((aligned(32)));
+} hs_frame_encoder_t;
+
+/* Set the number of codewords and the data bytes in a frame.  Returns EXIT_FAILURE if they do not fit */
+int hs_frame_init(hs_frame_encoder_t *e, int codewords, int data_length);
+
+/*
+ * Encode a frame of e->data_length bytes into e->words 10b words, with the running disparity
+ * carried on in rd_state from the last frame
+ */
+void hs_frame_encode(hs_frame_encoder_t *e, int *rd_state, const unsigned char *data, uint16_t *words);
+
+/*
+ * Decode the words of a frame, without the sync word, and correct each codeword.  Returns the
+ * number of bytes corrected or RS_DECODE_FAILED if a codeword could not be corrected.  The data
+ * is written either way
+ */
+int hs_frame_decode(hs_frame_encoder_t *e, const uint16_t *words, unsigned char *data);
+
+int test_hs_frame();
+
+#endif /* HS_FRAME_H_ */
@@ -0,0 +1,111 @@
+/*
+ * layout_codec.h
+ *
+ * Generated by scripts/gen_layout_codec.py from the layouts in telem_send/layout.
+ * Do not edit, change the layout and run the script again.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Each layout has a struct with a field for each value and functions to pack it into the
+ * bytes of a frame and to unpack it again.  The bytes are the same as the __packed__ struct
+ * of the same name that gcc makes on a little endian machine.
+ *
+ */
+
+#ifndef LAYOUT_CODEC_H_
+#define LAYOUT_CODEC_H_
+
+#include <stdint.h>
+
+/* duv_header, the same bytes as duv_header_t */
+#define DUV_HEADER_PACKED_LENGTH 7
+
+typedef struct {
+	uint32_t id; // 3 bits, Spacecraft id or 0 for an extended id
+	uint32_t epoch; // 16 bits, Years since 2020
+	uint32_t uptime; // 25 bits, Seconds since the start of the year
+	uint32_t type; // 4 bits, Frame type
+	uint32_t extended_id; // 5 bits, Spacecraft id minus 8 when id is 0
+	uint32_t safe_mode; // 1 bit, In safe mode
+	uint32_t health_mode; // 1 bit, In health mode
+	uint32_t science_mode; // 1 bit, In science mode
+} duv_header_fields_t;
+
+void duv_header_pack(const duv_header_fields_t *f, unsigned char *buf);
+void duv_header_unpack(const unsigned char *buf, duv_header_fields_t *f);
+
+/* rttelemetry, the same bytes as rttelemetry_t */
+#define RTTELEMETRY_PACKED_LENGTH 57
+
+typedef struct {
+	uint32_t pi_temperature; // 16 bits, CPU temperature
+	uint32_t xruns; // 16 bits, Audio xruns since start
+	uint32_t loop_time; // 8 bits, Audio loop time
+	uint32_t cpu_speed; // 8 bits, CPU clock
+	uint32_t loop_time_p99; // 8 bits, 99th percentile audio loop time
+	uint32_t deadline_used; // 8 bits, Share of the period used by the audio loop
+	uint32_t pad1; // 32 bits, Unused
+	uint32_t pad2; // 32 bits, Unused
+	uint32_t pad3; // 32 bits, Unused
+	uint32_t pad4; // 32 bits, Unused
+	uint32_t pad5; // 32 bits, Unused
+	uint32_t pad6; // 32 bits, Unused
+	uint32_t pad7; // 32 bits, Unused
+	uint32_t pad8; // 32 bits, Unused
+	uint32_t pad9; // 32 bits, Unused
+	uint32_t pad10; // 32 bits, Unused
+	uint32_t pad11; // 32 bits, Unused
+	uint32_t pad12; // 32 bits, Unused
+	uint32_t pad13; // 8 bits, Unused
+} rttelemetry_fields_t;
+
+void rttelemetry_pack(const rttelemetry_fields_t *f, unsigned char *buf);
+void rttelemetry_unpack(const unsigned char *buf, rttelemetry_fields_t *f);
+
+/* exptelemetry, the same bytes as exptelemetry_t */
+#define EXPTELEMETRY_PACKED_LENGTH 57
+
+typedef struct {
+	uint32_t temperature; // 16 bits, Experiment temperature
+	uint32_t pressure; // 32 bits, Pressure
+	uint32_t humidity; // 16 bits, Humidity
+	uint32_t gas_sensor1; // 16 bits, Gas sensor 1
+	uint32_t gas_sensor2; // 16 bits, Gas sensor 2
+	uint32_t gas_sensor3; // 16 bits, Gas sensor 3
+	uint32_t gyro0; // 12 bits, Gyro axis reading 0
+	uint32_t gyro1; // 12 bits, Gyro axis reading 1
+	uint32_t gyro2; // 12 bits, Gyro axis reading 2
+	uint32_t gyro3; // 12 bits, Gyro axis reading 3
+	uint32_t gyro4; // 12 bits, Gyro axis reading 4
+	uint32_t gyro5; // 12 bits, Gyro axis reading 5
+	uint32_t gyro6; // 12 bits, Gyro axis reading 6
+	uint32_t gyro7; // 12 bits, Gyro axis reading 7
+	uint32_t gyro8; // 12 bits, Gyro axis reading 8
+	uint32_t photoresistor; // 16 bits, Light level
+	uint32_t realtimeclock; // 32 bits, Real time clock
+	uint32_t mvps_voltage; // 16 bits, MVPS voltage
+	uint32_t mvps_current; // 16 bits, MVPS current
+	uint32_t radiation; // 16 bits, Radiation
+	uint32_t cosmic_rays; // 16 bits, Cosmic ray count
+	uint32_t pad1; // 12 bits, Unused
+	uint32_t pad2; // 16 bits, Unused
+	uint32_t pad3; // 32 bits, Unused
+	uint32_t pad4; // 32 bits, Unused
+	uint32_t pad5; // 32 bits, Unused
+} exptelemetry_fields_t;
+
+void exptelemetry_pack(const exptelemetry_fields_t *f, unsigned char *buf);
+void exptelemetry_unpack(const unsigned char *buf, exptelemetry_fields_t *f);
+
+#endif /* LAYOUT_CODEC_H_ */
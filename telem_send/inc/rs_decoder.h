@@ -0,0 +1,54 @@
+/*
+ * rs_decoder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Decoder for the CCSDS RS(255,223) code that update_rs() encodes, for the loopback tests, the
+ * frame archive and ground replay.  It corrects up to 16 symbol errors in a codeword, and works
+ * with shortened codewords such as the 64 data and 32 parity bytes of a DUV frame.
+ *
+ * Most frames have no errors, so the data is first encoded again with encode_rs() and the
+ * parities compared.  That is the same as checking that the syndromes are zero, and if they are
+ * the decoder stops.  Otherwise the syndromes are found from the 32 byte remainder rather than
+ * the whole codeword, Berlekamp-Massey gives the error locator, a Chien search finds the error
+ * positions and the Forney algorithm gives the error values.
+ *
+ */
+
+#ifndef RS_DECODER_H_
+#define RS_DECODER_H_
+
+#include "TelemEncoding.h"
+
+/* The roots of the generator are alpha^(RS_PRIM * (RS_FCR + i)) for i = 0 to 31 */
+#define RS_FCR 112
+#define RS_PRIM 11
+#define RS_IPRIM 116 // RS_PRIM * RS_IPRIM = 1 mod 255
+#define RS_MAX_ERRORS (PARITY_BYTES_PER_CODEWORD / 2)
+#define RS_DECODE_FAILED -1
+
+/*
+ * Correct the codeword in place.  It is len bytes of data followed by the 32 parities, so len
+ * is up to DATA_BYTES_PER_CODE_WORD.  Returns the number of symbols corrected, or
+ * RS_DECODE_FAILED if there are too many errors, in which case the codeword is not changed.
+ * If positions is not NULL the byte offsets of the corrected symbols are written to it
+ */
+int rs_decode(unsigned char *codeword, int len, int positions[RS_MAX_ERRORS]);
+
+int test_rs_decoder();
+
+#endif /* RS_DECODER_H_ */
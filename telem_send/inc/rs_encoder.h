@@ -0,0 +1,49 @@
+/*
+ * rs_encoder.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Reed-Solomon encoder for many frames at once, for the ground station simulator when it replays
+ * or stress tests a large number of frames.  It gives the same parities as update_rs().
+ *
+ * The frames are encoded side by side in groups of RS_BATCH_LANES, one frame per byte of a
+ * vector.  At each byte position the feedback bytes of all the frames in the group are
+ * multiplied by each generator coefficient with gf256_mul_add_rows(), so the SIMD kernel does
+ * the work for the whole group.  Frames of different lengths can be mixed.  A shorter frame is
+ * lined up with the end of the longest one, because leading zero bytes do not change the parities.
+ *
+ */
+
+#ifndef RS_ENCODER_H_
+#define RS_ENCODER_H_
+
+#include "TelemEncoding.h"
+
+#define RS_BATCH_LANES 64 // frames encoded side by side
+
+typedef struct {
+	const unsigned char *data;
+	int len; // up to DATA_BYTES_PER_CODE_WORD.  64 for a shortened DUV frame
+	unsigned char parity[PARITY_BYTES_PER_CODEWORD]; // written by rs_encode_frames()
+} rs_frame_t;
+
+/* Calculate the parities of n frames.  Returns EXIT_FAILURE if a frame is too long */
+int rs_encode_frames(rs_frame_t *frames, int n);
+
+int test_rs_encode_frames();
+
+#endif /* RS_ENCODER_H_ */
@@ -38,6 +38,38 @@
 #define FSK_1200_PARITIES_LENGTH 32
 
 #define BITS_PER_10b_WORD 10
+/* A packet and its sync word as a bitstream in 64 bit words, with a spare word so a read can run past the end */
+#define TELEM_PACKED_LENGTH (((DUV_PACKET_LENGTH+1) * BITS_PER_10b_WORD + 63) / 64 + 1)
+
+/*
+ * The telemetry streams.  Each has its own frame state and pair of encoded packets, so two can
+ * be sent at once.  The main stream is sent by whichever mode is running.  The burst stream is
+ * only used for the high speed telemetry when it is sent at the same time as DUV.
+ */
+#define TELEM_STREAM_MAIN 0
+#define TELEM_STREAM_BURST 1
+#define TELEM_NUM_STREAMS 2
+
+typedef struct {
+	int id; // TELEM_STREAM_MAIN or TELEM_STREAM_BURST
+	int packet_length; // initialized at startup to equal the length of a packet.
+	int first_packet_to_be_sent; // flag that tells us if a sync word is needed at the start of the packet
+	int bits_sent_for_current_word; // how many bits have we sent for the current 10b word
+	int words_sent_for_current_packet; // how many 10b words we have sent for the current packet
+	int rd_state; // 8b10b Encoder state
+	uint16_t encoded_packet[2][DUV_PACKET_LENGTH+1]; /* This is the 10b encoded packet with parities. It includes space for SYNC WORD at the end. */
+	int current_encoded_packet_num; /* We have two encoded packets.  One is being sent and the other is being built. */
+	uint64_t packed_packet[2][TELEM_PACKED_LENGTH]; /* The same packets packed, first bit in the top bit of the first word */
+	uint64_t bit_buffer; // bits taken by telem_stream_read_bit() and not sent yet, in the low bits
+	int bits_buffered;
+	uint32_t bits_sent; // since the stream was initialized
+	uint32_t frames_sent;
+	uint32_t frames_started; // counts the start of the first data word of each frame
+	uint32_t frame_start_bit; // bits_sent at the start of the sync word of the last frame started
+} telem_stream_t;
+
+/* The state of a stream, TELEM_STREAM_MAIN or TELEM_STREAM_BURST */
+telem_stream_t *telem_processor_stream(int id);
 
 /* Getters for variables */
 double get_loop_time_microsec();
@@ -51,21 +83,58 @@ void init_rd_state();
 
 /*
  * Ask the telem processor to set the a packet ready for transmission.  it
- * is encoded into the specified packet buffer.  The caller needs to know
+ * is encoded into the specified packet buffer of the stream.  The caller needs to know
  * which buffer is available
  *
  */
-int encode_next_packet(unsigned char *packet, int encoded_packet_num);
+int encode_next_packet(int stream, unsigned char *packet, int encoded_packet_num);
 
 /*
- * Get the next bit for the encoded packet.
+ * Get the next bit for the encoded packet.  get_next_bit() is for the main stream.
  */
 int get_next_bit();
+int telem_stream_next_bit(telem_stream_t *stream);
+
+/*
+ * Get the next n bits, 1 to 64, as if telem_stream_next_bit() was called n times.  The first bit
+ * is the most significant of the n.  Within a packet the bits are copied from the packed packet,
+ * so the counters are only updated once.
+ */
+uint64_t telem_stream_next_bits(telem_stream_t *stream, int n);
+
+/* The bits until telem_stream_at_frame_boundary() is next true, counting a whole frame if it is now */
+int telem_stream_bits_to_frame_boundary(telem_stream_t *stream);
+
+/* Fill the bit buffer with up to 64 bits, but not past the end of the frame or a sync word */
+void telem_stream_fill_bit_buffer(telem_stream_t *stream);
+
+/*
+ * The next bit for the modulator.  The bits are taken from the stream in blocks, so most bits
+ * are a shift and a mask with no call
+ */
+static inline int telem_stream_read_bit(telem_stream_t *stream) {
+	if (stream->bits_buffered == 0)
+		telem_stream_fill_bit_buffer(stream);
+	stream->bits_buffered--;
+	stream->bits_sent++;
+	return (stream->bit_buffer >> stream->bits_buffered) & 1;
+}
+
+/* Pack 10b words into a bitstream, most significant bit first */
+void telem_pack_words(const uint16_t *words, int num_words, uint64_t *packed);
+
+/*
+ * True if the next bit is the first bit of a sync word, so that a frame has just finished or
+ * nothing has been sent yet.  The audio processor only changes mode here.  Bits that are still in
+ * the bit buffer have not been sent.
+ */
+int telem_processor_at_frame_boundary();
+int telem_stream_at_frame_boundary(telem_stream_t *stream);
 
 /*
  * Initialize the telemetry processor ready to send telemetry.  This should be called
- * whenever the telemetry is stopped and restarted.  Cleanup should be called when
- * it is no longer needed
+ * whenever the telemetry is stopped and restarted.  All of the streams are initialized
+ * with the same packet length.  Cleanup should be called when it is no longer needed
  */
 int init_telemetry_processor(int packet_len);
 void cleanup_telem_processor();
@@ -76,9 +145,11 @@ void cleanup_telem_processor();
 unsigned char * set_test_packet();
 int test_telem_encoder(unsigned char *packet, uint16_t *encoded_packet);
 int test_encode_packet();
+int test_layout_codec();
 unsigned char reverse_8b10b_lookup(uint16_t word);
 int test_rs_encoder();
 int test_sync_word();
 int test_get_next_bit();
+int test_get_next_bits();
 
 #endif /* TELEM_PROCESSOR_H_ */
@@ -0,0 +1,105 @@
+/*
+ * telem_scheduler.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The frame scheduler decides which type of frame is sent next on a telemetry stream and holds
+ * the frames that have been built ahead of time.  The order of the types is a pattern from the
+ * config file, e.g. RT,EXP,EXP,RT, that repeats.
+ *
+ * The telem thread gathers the telemetry and adds a frame of the next type in the pattern
+ * whenever the queue has room.  When the modulator asks for a packet the frame at the head of
+ * the queue is encoded straight away, so a slow sensor read only delays the frames behind it.
+ * The frames are queued before they are encoded because the 8b10b running disparity depends on
+ * the frame sent before.
+ *
+ * Only the telem thread adds and takes frames.  The counters are updated atomically so the
+ * console can read them.
+ *
+ */
+
+#ifndef TELEM_SCHEDULER_H_
+#define TELEM_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include "../../telem_send/inc/telem_processor.h"
+
+/* Frame types.  These are the type in the header of the frame */
+#define TELEM_FRAME_RT 1 // realtime health, duv_packet_t
+#define TELEM_FRAME_EXP 2 // experiment, exp_packet_t
+#define TELEM_FRAME_WOD 3 // whole orbit data, a past sample from the wod_store in a duv_packet_t
+#define TELEM_NUM_FRAME_TYPES 4 // types start at one
+
+#define TELEM_SCHEDULER_MAX_PATTERN 32
+#define TELEM_SCHEDULER_MAX_QUEUE 8
+#define TELEM_SCHEDULER_DEFAULT_PATTERN "RT,EXP,WOD,EXP"
+#define TELEM_SCHEDULER_DEFAULT_QUEUE_DEPTH 3
+
+typedef struct {
+	int type;
+	unsigned char data[DUV_DATA_LENGTH]; // zero after the end of the frame
+} telem_frame_t;
+
+typedef struct {
+	int pattern[TELEM_SCHEDULER_MAX_PATTERN];
+	int pattern_length;
+	int next_in_pattern;
+	int depth; // frames to build ahead, up to TELEM_SCHEDULER_MAX_QUEUE
+	telem_frame_t queue[TELEM_SCHEDULER_MAX_QUEUE];
+	uint32_t frames_added; // the queue holds frames_added - frames_taken frames
+	uint32_t frames_taken;
+	uint32_t frames_sent[TELEM_NUM_FRAME_TYPES];
+	uint32_t late; // times a packet was asked for when the queue was empty
+} telem_schedule_t;
+
+/*
+ * Read a pattern of frame names separated by commas into types.  Spaces and case are ignored.
+ * Returns the number of frames, or -1 if a name is not known or there are too many
+ */
+int telem_scheduler_parse_pattern(char *text, int *pattern, int max);
+
+/* The name of a frame type, as used in the pattern */
+char *telem_scheduler_frame_name(int type);
+
+/* Set the pattern and queue depth and empty the queue.  Returns EXIT_FAILURE if either is not valid */
+int telem_scheduler_init(telem_schedule_t *s, char *pattern, int depth);
+
+/* The type of the next frame to build.  Moves on to the next in the pattern */
+int telem_scheduler_next_type(telem_schedule_t *s);
+
+/* Copy a frame of len bytes to the end of the queue.  Returns EXIT_FAILURE if it is full */
+int telem_scheduler_add(telem_schedule_t *s, int type, unsigned char *data, int len);
+
+/* The frame at the head of the queue, or NULL if it is empty */
+telem_frame_t *telem_scheduler_head(telem_schedule_t *s);
+
+/* Remove the head frame once it has been encoded and count it as sent */
+void telem_scheduler_frame_sent(telem_schedule_t *s);
+
+/* Count a request for a packet that found the queue empty */
+void telem_scheduler_frame_late(telem_schedule_t *s);
+
+/* Frames waiting in the queue.  Safe to call from any thread */
+int telem_scheduler_queue_length(telem_schedule_t *s);
+
+/* One line with the queue and the frames sent of each type, for the console */
+void telem_scheduler_print_status(telem_schedule_t *s, char *name);
+
+int test_telem_scheduler();
+
+#endif /* TELEM_SCHEDULER_H_ */
@@ -22,6 +22,8 @@
 #ifndef TELEM_THREAD_H_
 #define TELEM_THREAD_H_
 
+#include "../../telem_send/inc/telem_scheduler.h"
+
 /**
  * Start the telem thread and run the main process
  */
@@ -33,13 +35,29 @@ void *telem_thread_process( void *arg );
 void telem_thread_stop();
 
 /**
- * Tell the telem thread that it should gather new telemetry and build the next packet.
- * This returns imediately and the processing happens in the background
+ * Tell the telem thread that it should gather new telemetry and build the next packet for a
+ * telemetry stream.  This returns imediately and the processing happens in the background
+ */
+void telem_thread_fill_next_packet(int stream);
+
+/* The frame pattern, queue and counters of a telemetry stream */
+telem_schedule_t *telem_thread_schedule(int stream);
+
+/* Find out which packet is ready to be sent on a telemetry stream */
+int telem_thread_get_packet_num(int stream);
+
+/*
+ * Start a stream again so that its first packet goes in buffer zero, to match the stream after
+ * init_telemetry_processor()
  */
-void telem_thread_fill_next_packet();
+void telem_thread_restart(int stream);
 
-/* Find out which packet is ready to be sent */
-int telem_thread_get_packet_num();
+/*
+ * Encode a packet from the caller in place of gathered telemetry.  This is for simulations that
+ * run the audio loop without the telem thread.  Nothing is done unless the stream has asked for
+ * a packet.  Returns true if the packet was used.
+ */
+int telem_thread_supply_packet(int stream, unsigned char *packet);
 
 /* Test functions */
 int test_gather_duv_telemetry();
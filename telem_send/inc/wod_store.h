@@ -0,0 +1,114 @@
+/*
+ * wod_store.h
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Whole orbit data store.  Past samples of the telemetry are kept in a ring of fixed size
+ * records in a file, so they can be sent again as WOD frames after a restart.  The file is
+ * memory mapped, so adding a sample is a copy into the next record.
+ *
+ * The file is made at full size when it is created, so blocks are not allocated on the SD card
+ * as it fills.  The records are only written to the card with msync() every sync_records
+ * samples, followed by the header.  There is no fsync() for each sample.
+ *
+ * A crash must not lose the store:
+ * - Each record has its sequence number and a checksum, so a record that was half written is
+ *   not sent
+ * - There are two copies of the header in different sectors and they are written in turn.
+ *   The newer copy with a good checksum is used when the file is opened
+ * - The header can be behind the records, because the kernel also writes the mapped pages back
+ *   on its own.  When the file is opened the records after the header are checked and any that
+ *   follow on in sequence are kept
+ *
+ * The file is native endian and has the size of telem_buffer_t in the header.  If the layout or
+ * the number of records changes the store is started again empty.
+ *
+ */
+
+#ifndef WOD_STORE_H_
+#define WOD_STORE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../../telem_send/inc/duv_telem_layout.h"
+
+#define WOD_STORE_MAGIC 0x31444f57 // WOD1
+#define WOD_STORE_HEADER_COPY_SIZE 512 // one sector for each copy of the header
+#define WOD_STORE_HEADER_SIZE 4096 // the header copies in their own page
+#define WOD_STORE_DEFAULT_FILE "wod.dat"
+#define WOD_STORE_DEFAULT_RECORDS 1440 // a day at one sample a minute
+#define WOD_STORE_DEFAULT_PERIOD_SEC 60
+#define WOD_STORE_DEFAULT_SYNC_RECORDS 10
+
+typedef struct {
+	uint32_t magic;
+	uint32_t record_size;
+	uint32_t capacity; // records in the ring
+	uint32_t generation; // counts the header writes.  The newer good copy is used
+	uint32_t next_seq; // the sequence number of the next record.  The first is 1
+	uint32_t checksum; // of the fields above
+} wod_store_header_t;
+
+typedef struct {
+	uint32_t seq; // 0 if the record has not been written
+	uint32_t checksum; // of seq and the sample
+	telem_buffer_t sample;
+} wod_record_t;
+
+typedef struct {
+	int fd; // -1 if the store is not open
+	unsigned char *map;
+	size_t map_size;
+	wod_record_t *records;
+	uint32_t capacity;
+	uint32_t generation;
+	uint32_t next_seq;
+	uint32_t read_seq; // the next record wod_store_next() returns
+	int sync_records;
+	int unsynced; // records added since the last sync
+	uint32_t dirty_first; // the range of records to sync, as sequence numbers
+	uint32_t syncs;
+} wod_store_t;
+
+/*
+ * Open the store in filename, or create it with capacity records if it does not exist or has
+ * a different layout.  The records are synced to the file every sync_records samples.
+ */
+int wod_store_open(wod_store_t *store, char *filename, int capacity, int sync_records);
+
+/* Add a sample, overwriting the oldest if the ring is full */
+int wod_store_append(wod_store_t *store, telem_buffer_t *sample);
+
+/*
+ * Copy the next stored sample, from the oldest to the newest and then from the oldest again.
+ * Returns EXIT_FAILURE if there are no samples
+ */
+int wod_store_next(wod_store_t *store, telem_buffer_t *sample);
+
+/* The samples in the store */
+int wod_store_count(wod_store_t *store);
+
+/* Write the records added since the last sync to the file and then the header */
+int wod_store_sync(wod_store_t *store);
+
+/* Sync and close */
+void wod_store_close(wod_store_t *store);
+
+int test_wod_store();
+
+#endif /* WOD_STORE_H_ */
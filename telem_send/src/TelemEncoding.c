@@ -26,6 +26,7 @@
    the shift register in place and returns void. At the end of each frame, it contains
    the parities ready for transmission, starting with parity[0].
    Be sure to zero this array before each new frame!
+   update_rs_table() does the same with a table, and encode_rs() encodes a whole frame.
 
    encode_8b10b() is the 8b10b encoder. Its first argument is a pointer to a single integer
    with the 1-bit encoder state (the current run disparity, or RD). Initialize it to 0
@@ -58,6 +59,7 @@
 
 
 #include "../../telem_send/inc/TelemEncoding.h"
+#include "../../telem_send/inc/decode_8b10b.h"
 
 #include <string.h>
 #include <assert.h>
@@ -159,6 +161,72 @@ void update_rs(
   //taskYIELD();
 }
 
+// Table driven encoder. The register update is linear, so for any register it is the
+// register shifted left one byte XOR what update_rs() does to an all zero register.
+// That only depends on the feedback byte, so it is stored for all 256 of them. Each data
+// byte is then one table row and a 32-byte XOR. The table is built with update_rs() so
+// the two encoders can not disagree.
+static unsigned char RS_feedback_table[256][NP] __attribute__((aligned(32)));
+static int RS_table_ready = 0;
+
+void init_rs_table(void){
+  int f;
+
+  for(f=0;f<256;f++){
+    memset(RS_feedback_table[f],0,NP);
+    update_rs(RS_feedback_table[f],(unsigned char)f);
+  }
+  RS_table_ready = 1;
+}
+
+// XOR 32 bytes as four 64 bit words. The compiler turns this into vector instructions
+static inline void xor_parity(unsigned char *dst,const unsigned char *src){
+  uint64_t d[NP/8],s[NP/8];
+  int i;
+
+  memcpy(d,dst,NP);
+  memcpy(s,src,NP);
+  for(i=0;i<(int)(NP/8);i++)
+    d[i] ^= s[i];
+  memcpy(dst,d,NP);
+}
+
+// Same as update_rs(), using the table
+void update_rs_table(
+   unsigned char parity[32], // 32-byte encoder state; zero before each frame
+   unsigned char c)          // Current data byte to update
+{
+  unsigned char feedback;
+
+  assert(parity != NULL);
+  if(!RS_table_ready)
+    init_rs_table();
+  feedback = c ^ parity[0];
+  memmove(&parity[0],&parity[1],NP-1);
+  parity[NP-1] = 0;
+  xor_parity(parity,RS_feedback_table[feedback]);
+}
+
+// Encode a whole frame of len <= 223 data bytes. There is no need to zero parity first.
+// Rather than shifting the register for each byte, it slides along a buffer and the
+// parities are the last 32 bytes.
+void encode_rs(
+   unsigned char parity[32], // the parities for the frame are written here
+   const unsigned char *data,
+   int len)
+{
+  unsigned char reg[DATA_BYTES_PER_CODE_WORD+NP] __attribute__((aligned(32)));
+  int i;
+
+  assert(parity != NULL && len >= 0 && len <= DATA_BYTES_PER_CODE_WORD);
+  if(!RS_table_ready)
+    init_rs_table();
+  memset(reg,0,len+NP);
+  for(i=0;i<len;i++)
+    xor_parity(&reg[i+1],RS_feedback_table[data[i] ^ reg[i]]);
+  memcpy(parity,&reg[len],NP);
+}
+
 #define SYNC  (0x0fa) // K.28.5, RD=-1
 
 int Encode_8b10b[2][256] = {
@@ -704,15 +772,12 @@ int encode_8b10b(
   return w & 0x3ff;
 }
 
+/* The byte for a 10b word, or 0xff if it is not a data word.  Uses the decode table */
 unsigned char reverse_8b10b_lookup(uint16_t word) {
-	for (int rd=0; rd<2; rd++)
-		for (int i=0; i<256; i++) {
-			int testValue = Encode_8b10b[rd][i];
-			if ((testValue & 0x3ff) == word) {
-				return (unsigned char)i; // return the position in the lookup table where we found the code word
-			}
-		}
-	return -1;
+	uint16_t entry = decode_8b10b_lookup(word);
+	if (!(entry & (DECODE_8B10B_RD_MINUS | DECODE_8B10B_RD_PLUS)) || (entry & DECODE_8B10B_SYNC))
+		return -1;
+	return entry & DECODE_8B10B_DATA;
 }
 
 void write_little_endian(unsigned int word, int num_bytes, FILE *wav_file)
@@ -0,0 +1,182 @@
+/*
+ * decode_8b10b.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * 8b10b decoder.  See decode_8b10b.h
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/telem_processor.h"
+
+/* Forward declarations */
+void decode_8b10b_make_table();
+
+uint16_t decode_8b10b_table[1 << CHARACTER_BITS];
+pthread_once_t decode_8b10b_once = PTHREAD_ONCE_INIT;
+
+/* The table is only made once, so a thread can not clear it while another is decoding */
+void decode_8b10b_init() {
+	pthread_once(&decode_8b10b_once, decode_8b10b_make_table);
+}
+
+void decode_8b10b_make_table() {
+	memset(decode_8b10b_table, 0, sizeof(decode_8b10b_table));
+	for (int rd=0; rd < 2; rd++) {
+		uint16_t valid = rd ? DECODE_8B10B_RD_PLUS : DECODE_8B10B_RD_MINUS;
+		for (int i=0; i < 256; i++) {
+			int state = rd;
+			int word = encode_8b10b(&state, i);
+			decode_8b10b_table[word] |= valid | i;
+		}
+		int state = rd;
+		int word = encode_8b10b(&state, SYNC_CHARACTER);
+		decode_8b10b_table[word] |= valid | DECODE_8B10B_SYNC;
+	}
+}
+
+void decode_8b10b_start(decode_8b10b_t *d, int rd) {
+	decode_8b10b_init();
+	memset(d, 0, sizeof(decode_8b10b_t));
+	d->rd = rd;
+}
+
+int decode_8b10b(decode_8b10b_t *d, uint16_t word) {
+	uint16_t entry = decode_8b10b_lookup(word);
+	d->words++;
+	d->error = DECODE_8B10B_OK;
+	if (!(entry & (DECODE_8B10B_RD_MINUS | DECODE_8B10B_RD_PLUS))) {
+		d->error = DECODE_8B10B_CODE_VIOLATION;
+		d->code_violations++;
+	} else if (d->rd != DECODE_8B10B_RD_UNKNOWN
+			&& !(entry & (d->rd ? DECODE_8B10B_RD_PLUS : DECODE_8B10B_RD_MINUS))) {
+		d->error = DECODE_8B10B_DISPARITY_ERROR;
+		d->disparity_errors++;
+	}
+
+	/* A word with more ones than zeros leaves the disparity at +1, and with fewer at -1 */
+	int ones = __builtin_popcount(word & CHARACTER_MASK);
+	if (ones > CHARACTER_BITS / 2)
+		d->rd = 1;
+	else if (ones < CHARACTER_BITS / 2)
+		d->rd = 0;
+
+	if (d->error == DECODE_8B10B_CODE_VIOLATION)
+		return DECODE_8B10B_INVALID;
+	if (entry & DECODE_8B10B_SYNC)
+		return DECODE_8B10B_SYNC_WORD;
+	return entry & DECODE_8B10B_DATA;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_decode_8b10b() {
+	printf("TESTING decode_8b10b .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	decode_8b10b_t d;
+	decode_8b10b_start(&d, 0);
+
+	/* Every byte with both disparities, and a word must not be two different bytes */
+	int valid_words = 0;
+	for (int w=0; w < (1 << CHARACTER_BITS); w++)
+		if (decode_8b10b_table[w] & (DECODE_8B10B_RD_MINUS | DECODE_8B10B_RD_PLUS))
+			valid_words++;
+	for (int rd=0; rd < 2; rd++)
+		for (int i=0; i < 256; i++) {
+			int state = rd;
+			uint16_t entry = decode_8b10b_lookup(encode_8b10b(&state, i));
+			if ((entry & DECODE_8B10B_DATA) != i || (entry & DECODE_8B10B_SYNC)
+					|| !(entry & (rd ? DECODE_8B10B_RD_PLUS : DECODE_8B10B_RD_MINUS))) {
+				verbose_print(" byte %x with rd %d decodes as %x\n", i, rd, entry);
+				fail = EXIT_FAILURE;
+			}
+		}
+	verbose_print(" %d valid words\n", valid_words);
+	if (reverse_8b10b_lookup(0x274) != 0x00 || reverse_8b10b_lookup(0x0fa) != 0xff
+			|| reverse_8b10b_lookup(0x000) != 0xff)
+		fail = EXIT_FAILURE;
+
+	/* A stream with sync words, as it is sent, has no errors */
+	uint16_t words[300];
+	int bytes[300];
+	int rd = 0;
+	uint32_t seed = 3;
+	for (int i=0; i < 300; i++) {
+		uint32_t r = test_random(&seed);
+		bytes[i] = (i % 97 == 96) ? DECODE_8B10B_SYNC_WORD : (int)(r >> 24);
+		words[i] = encode_8b10b(&rd, bytes[i]);
+	}
+	for (int i=0; i < 300; i++)
+		if (decode_8b10b(&d, words[i]) != bytes[i] || d.error != DECODE_8B10B_OK) {
+			verbose_print(" word %d %x decoded as %x\n", i, words[i], decode_8b10b_lookup(words[i]));
+			fail = EXIT_FAILURE;
+		}
+	if (d.words != 300 || d.code_violations != 0 || d.disparity_errors != 0)
+		fail = EXIT_FAILURE;
+
+	/* A word that is not in the code, and one sent with the wrong disparity */
+	decode_8b10b_start(&d, DECODE_8B10B_RD_UNKNOWN);
+	if (decode_8b10b(&d, 0x000) != DECODE_8B10B_INVALID || d.error != DECODE_8B10B_CODE_VIOLATION)
+		fail = EXIT_FAILURE;
+	rd = 0;
+	uint16_t sync = encode_8b10b(&rd, DECODE_8B10B_SYNC_WORD); // has more ones, so the disparity is now +1
+	uint16_t byte = encode_8b10b(&rd, 0x00);
+	decode_8b10b_start(&d, DECODE_8B10B_RD_UNKNOWN);
+	decode_8b10b(&d, sync);
+	if (decode_8b10b(&d, sync) != DECODE_8B10B_SYNC_WORD || d.error != DECODE_8B10B_DISPARITY_ERROR)
+		fail = EXIT_FAILURE;
+	if (decode_8b10b(&d, byte) != 0x00 || d.error != DECODE_8B10B_OK || d.disparity_errors != 1)
+		fail = EXIT_FAILURE;
+
+	/*
+	 * A single bit error is seen as a violation or a disparity error, but it can be a few words
+	 * later, when a word has the wrong disparity.  So there are some words after the error
+	 */
+	int missed = 0;
+	for (int i=0; i < 280; i++)
+		for (int b=0; b < CHARACTER_BITS; b++) {
+			decode_8b10b_start(&d, 0);
+			for (int j=0; j < 300; j++)
+				decode_8b10b(&d, j == i ? words[j] ^ (1 << b) : words[j]);
+			if (d.code_violations == 0 && d.disparity_errors == 0)
+				missed++;
+		}
+	verbose_print(" %d of %d single bit errors not seen\n", missed, 280 * CHARACTER_BITS);
+	if (missed != 0)
+		fail = EXIT_FAILURE;
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,816 @@
+/*
+ * frame_archive.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The ring between the audio thread and the archive thread has one writer and one reader, as in
+ * rt_log.c.  The segment files are only appended to.  They are flushed after each batch of
+ * frames, but not synced, so the kernel writes them to the SD card in its own time.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "debug.h"
+#include "../../telem_send/inc/frame_archive.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/TelemEncoding.h"
+#include "../../telem_send/inc/telem_scheduler.h"
+#include "../../telem_send/inc/layout_codec.h"
+
+#define FRAME_ARCHIVE_POLL_MICROSEC 100000
+#define FRAME_ARCHIVE_DUMP_RECORDS 512 // read at a time by the dump
+
+/* What the audio thread puts in the ring for each frame */
+typedef struct {
+	int stream;
+	uint32_t frame_time;
+	time_t sent;
+	uint64_t packed_packet[TELEM_PACKED_LENGTH];
+} frame_archive_entry_t;
+
+/* Forward declarations */
+void *frame_archive_process(void *arg);
+void frame_archive_make_record(frame_archive_entry_t *entry, frame_archive_record_t *record);
+int frame_archive_next_segment();
+void frame_archive_prune();
+void frame_archive_write_index();
+int frame_archive_open_index(char *dir, uint32_t *segments, int num_segments);
+int frame_archive_list_segments(char *dir, uint32_t **segments);
+int frame_archive_open_segment(char *dir, uint32_t segment, long *records);
+int frame_archive_scan_segment(char *dir, uint32_t segment, frame_archive_index_t *entry);
+int frame_archive_load_index(char *dir, frame_archive_index_t **index, uint64_t **reach);
+int frame_archive_index_search(uint64_t *reach, int entries, uint64_t key);
+uint64_t frame_archive_read_key(int fd, long record);
+long frame_archive_search(int fd, long records, uint64_t key);
+
+frame_archive_entry_t frame_archive_ring[FRAME_ARCHIVE_RECORDS];
+uint32_t frame_archive_head = 0;
+uint32_t frame_archive_tail = 0;
+uint32_t frame_archive_dropped = 0;
+int frame_archive_is_open = false;
+
+/* The writer.  Only the archive thread uses these once it is started */
+char frame_archive_dir[MAX_LINE_LENGTH];
+int frame_archive_segment_records;
+int frame_archive_max_segments;
+uint32_t frame_archive_segment; // the number of the current segment
+FILE *frame_archive_file = NULL;
+int frame_archive_records_in_segment;
+uint64_t frame_archive_last_key;
+uint32_t frame_archive_seq;
+int frame_archive_index_fd = -1;
+long frame_archive_index_slot; // the entry of the current segment in the index file
+long frame_archive_oldest_slot; // the entry of the oldest segment that has not been deleted
+frame_archive_index_t frame_archive_index_entry;
+
+pthread_t frame_archive_pthread;
+int frame_archive_running = false;
+
+void frame_archive_push(int stream, uint32_t frame_time, const uint64_t *packed_packet) {
+	if (!__atomic_load_n(&frame_archive_is_open, __ATOMIC_RELAXED))
+		return;
+	uint32_t head = __atomic_load_n(&frame_archive_head, __ATOMIC_RELAXED);
+	uint32_t tail = __atomic_load_n(&frame_archive_tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= FRAME_ARCHIVE_RECORDS) {
+		__atomic_fetch_add(&frame_archive_dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	frame_archive_entry_t *entry = &frame_archive_ring[head & (FRAME_ARCHIVE_RECORDS - 1)];
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now); // from the vdso, so it does not block
+	entry->stream = stream;
+	entry->frame_time = frame_time;
+	entry->sent = now.tv_sec;
+	memcpy(entry->packed_packet, packed_packet, sizeof(entry->packed_packet));
+	__atomic_store_n(&frame_archive_head, head + 1, __ATOMIC_RELEASE);
+}
+
+uint64_t frame_archive_time_key(time_t t) {
+	struct tm timeinfo;
+	if (localtime_r(&t, &timeinfo) != &timeinfo)
+		return 0;
+	return FRAME_ARCHIVE_KEY(timeinfo.tm_year - 120, timeinfo.tm_sec + timeinfo.tm_min*60
+			+ timeinfo.tm_hour*60*60 + timeinfo.tm_yday*24*60*60);
+}
+
+/* Unpack the 10b words and decode the payload */
+void frame_archive_make_record(frame_archive_entry_t *entry, frame_archive_record_t *record) {
+	memset(record, 0, sizeof(*record));
+	record->seq = frame_archive_seq++;
+	record->frame_time = entry->frame_time;
+	record->stream = entry->stream;
+
+	/* The same time stamp as gather_duv_telemetry() */
+	struct tm timeinfo;
+	if (localtime_r(&entry->sent, &timeinfo) == &timeinfo) {
+		record->epoch = timeinfo.tm_year - 120;
+		record->uptime = timeinfo.tm_sec + timeinfo.tm_min*60 + timeinfo.tm_hour*60*60 + timeinfo.tm_yday*24*60*60;
+	}
+
+	for (int i=0; i < DUV_PACKET_LENGTH+1; i++) {
+		int pos = i * BITS_PER_10b_WORD;
+		int offset = pos & 63;
+		uint64_t w = entry->packed_packet[pos >> 6] << offset;
+		if (offset > 64 - BITS_PER_10b_WORD)
+			w |= entry->packed_packet[(pos >> 6) + 1] >> (64 - offset);
+		record->words[i] = w >> (64 - BITS_PER_10b_WORD);
+	}
+	for (int i=0; i < DUV_DATA_LENGTH; i++)
+		record->payload[i] = decode_8b10b_lookup(record->words[i]) & DECODE_8B10B_DATA;
+	duv_header_fields_t header;
+	duv_header_unpack(record->payload, &header);
+	record->type = header.type;
+}
+
+int frame_archive_next_segment() {
+	if (frame_archive_file != NULL) {
+		fclose(frame_archive_file);
+		frame_archive_write_index();
+	}
+	frame_archive_segment++;
+	frame_archive_records_in_segment = 0;
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/frames_%08u.dat", frame_archive_dir, frame_archive_segment);
+	frame_archive_file = fopen(path, "wb");
+	if (frame_archive_file == NULL) {
+		error_print("Could not create the frame archive segment %s: %s\n", path, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	frame_archive_index_slot++;
+	memset(&frame_archive_index_entry, 0, sizeof(frame_archive_index_entry));
+	frame_archive_index_entry.segment = frame_archive_segment;
+	frame_archive_write_index();
+	frame_archive_prune();
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Delete the oldest segments until there are max_segments.  Their index entries are left with
+ * no records, so readers skip them, and are removed when the index is made again on open
+ */
+void frame_archive_prune() {
+	if (frame_archive_max_segments < 1 || frame_archive_index_fd < 0)
+		return;
+	while (frame_archive_index_slot - frame_archive_oldest_slot >= frame_archive_max_segments) {
+		frame_archive_index_t entry;
+		off_t pos = frame_archive_oldest_slot * sizeof(frame_archive_index_t);
+		if (pread(frame_archive_index_fd, &entry, sizeof(entry), pos) != sizeof(entry))
+			return;
+		char path[MAX_LINE_LENGTH * 2];
+		snprintf(path, sizeof(path), "%s/frames_%08u.dat", frame_archive_dir, entry.segment);
+		if (unlink(path) != 0 && errno != ENOENT)
+			error_print("Could not delete the frame archive segment %s: %s\n", path, strerror(errno));
+		entry.records = 0;
+		if (pwrite(frame_archive_index_fd, &entry, sizeof(entry), pos) != sizeof(entry))
+			error_print("Could not write the frame archive index: %s\n", strerror(errno));
+		frame_archive_oldest_slot++;
+	}
+}
+
+/* Write the entry of the current segment to the index, after its records are flushed */
+void frame_archive_write_index() {
+	if (frame_archive_index_fd < 0)
+		return;
+	off_t pos = frame_archive_index_slot * sizeof(frame_archive_index_t);
+	if (pwrite(frame_archive_index_fd, &frame_archive_index_entry, sizeof(frame_archive_index_entry), pos)
+			!= sizeof(frame_archive_index_entry))
+		error_print("Could not write the frame archive index: %s\n", strerror(errno));
+}
+
+/*
+ * Open the index for writing.  If it does not have an entry for each segment it is made again
+ * from them.  Otherwise only the last entry is read again, because it may be behind its segment
+ * after a crash
+ */
+int frame_archive_open_index(char *dir, uint32_t *segments, int num_segments) {
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/%s", dir, FRAME_ARCHIVE_INDEX_FILE);
+	frame_archive_index_fd = open(path, O_RDWR | O_CREAT, 0644);
+	struct stat st;
+	if (frame_archive_index_fd < 0 || fstat(frame_archive_index_fd, &st) != 0) {
+		error_print("Could not open the frame archive index %s: %s\n", path, strerror(errno));
+		if (frame_archive_index_fd >= 0)
+			close(frame_archive_index_fd);
+		frame_archive_index_fd = -1;
+		return EXIT_FAILURE;
+	}
+	int first = 0;
+	frame_archive_index_t entry;
+	if (st.st_size == num_segments * (off_t)sizeof(frame_archive_index_t) && num_segments > 0
+			&& pread(frame_archive_index_fd, &entry, sizeof(entry), st.st_size - sizeof(entry)) == sizeof(entry)
+			&& entry.segment == segments[num_segments - 1])
+		first = num_segments - 1;
+	else if (ftruncate(frame_archive_index_fd, 0) != 0)
+		error_print("Could not clear the frame archive index %s: %s\n", path, strerror(errno));
+	for (frame_archive_index_slot=first; frame_archive_index_slot < num_segments; frame_archive_index_slot++) {
+		frame_archive_scan_segment(dir, segments[frame_archive_index_slot], &frame_archive_index_entry);
+		frame_archive_write_index();
+	}
+	frame_archive_index_slot = num_segments - 1; // the next segment is new
+	frame_archive_oldest_slot = 0;
+	return EXIT_SUCCESS;
+}
+
+int frame_archive_open(char *dir, int segment_records, int max_segments) {
+	if (segment_records < 1) {
+		error_print("Frame archive segments need at least one record, not %d\n", segment_records);
+		return EXIT_FAILURE;
+	}
+	if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+		error_print("Could not make the frame archive directory %s: %s\n", dir, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	uint32_t *segments;
+	int num_segments = frame_archive_list_segments(dir, &segments);
+	if (num_segments < 0)
+		return EXIT_FAILURE;
+	frame_archive_segment = num_segments ? segments[num_segments - 1] : 0; // the next one is new
+	int rc = frame_archive_open_index(dir, segments, num_segments);
+	free(segments);
+	if (rc != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	decode_8b10b_init();
+	strncpy(frame_archive_dir, dir, MAX_LINE_LENGTH-1);
+	frame_archive_segment_records = segment_records;
+	frame_archive_max_segments = max_segments;
+	frame_archive_file = NULL;
+	frame_archive_seq = 0;
+	frame_archive_last_key = 0;
+	__atomic_store_n(&frame_archive_tail, __atomic_load_n(&frame_archive_head, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+	__atomic_store_n(&frame_archive_dropped, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&frame_archive_is_open, true, __ATOMIC_RELEASE);
+	return EXIT_SUCCESS;
+}
+
+int frame_archive_drain() {
+	int written = 0;
+	uint32_t tail = __atomic_load_n(&frame_archive_tail, __ATOMIC_RELAXED);
+	uint32_t head = __atomic_load_n(&frame_archive_head, __ATOMIC_ACQUIRE);
+	while (tail != head) {
+		frame_archive_record_t record;
+		frame_archive_make_record(&frame_archive_ring[tail & (FRAME_ARCHIVE_RECORDS - 1)], &record);
+		tail++;
+		__atomic_store_n(&frame_archive_tail, tail, __ATOMIC_RELEASE);
+
+		/* Keep each segment in time order, so it can be searched */
+		uint64_t key = FRAME_ARCHIVE_KEY(record.epoch, record.uptime);
+		if (frame_archive_file == NULL || frame_archive_records_in_segment >= frame_archive_segment_records
+				|| key < frame_archive_last_key)
+			if (frame_archive_next_segment() != EXIT_SUCCESS)
+				continue;
+		if (fwrite(&record, sizeof(record), 1, frame_archive_file) != 1) {
+			error_print("Could not write to the frame archive: %s\n", strerror(errno));
+			continue;
+		}
+		frame_archive_records_in_segment++;
+		frame_archive_last_key = key;
+		if (frame_archive_index_entry.records++ == 0)
+			frame_archive_index_entry.first_key = key;
+		frame_archive_index_entry.last_key = key;
+		written++;
+	}
+	uint32_t dropped = __atomic_exchange_n(&frame_archive_dropped, 0, __ATOMIC_RELAXED);
+	if (dropped)
+		error_print("%d frames were not archived because the ring was full\n", dropped);
+	if (written) {
+		fflush(frame_archive_file);
+		frame_archive_write_index();
+	}
+	return written;
+}
+
+void frame_archive_close() {
+	if (!frame_archive_is_open)
+		return;
+	__atomic_store_n(&frame_archive_is_open, false, __ATOMIC_RELEASE);
+	frame_archive_drain();
+	if (frame_archive_file != NULL)
+		fclose(frame_archive_file);
+	frame_archive_file = NULL;
+	if (frame_archive_index_fd >= 0)
+		close(frame_archive_index_fd);
+	frame_archive_index_fd = -1;
+}
+
+void *frame_archive_process(void *arg) {
+	while (__atomic_load_n(&frame_archive_running, __ATOMIC_RELAXED)) {
+		frame_archive_drain();
+		usleep(FRAME_ARCHIVE_POLL_MICROSEC);
+	}
+	return NULL;
+}
+
+int frame_archive_start() {
+	if (!g_archive_frames || frame_archive_running)
+		return EXIT_SUCCESS;
+	if (frame_archive_open(g_archive_dir, g_archive_segment_records, g_archive_max_segments) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	frame_archive_running = true;
+	int rc = pthread_create(&frame_archive_pthread, NULL, frame_archive_process, NULL);
+	if (rc != 0) {
+		error_print("Could not start the frame archive thread\n");
+		frame_archive_running = false;
+		frame_archive_close();
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void frame_archive_stop() {
+	if (frame_archive_running) {
+		__atomic_store_n(&frame_archive_running, false, __ATOMIC_RELAXED);
+		pthread_join(frame_archive_pthread, NULL);
+	}
+	frame_archive_close();
+}
+
+/******************************************************************************
+ *
+ * READING THE ARCHIVE
+ *
+ ******************************************************************************/
+
+int frame_archive_compare_segments(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+/* The segment numbers in dir, in order.  Returns how many, or -1 */
+int frame_archive_list_segments(char *dir, uint32_t **segments) {
+	*segments = NULL;
+	DIR *d = opendir(dir);
+	if (d == NULL) {
+		error_print("Could not read the frame archive %s: %s\n", dir, strerror(errno));
+		return -1;
+	}
+	int num = 0, size = 0;
+	struct dirent *e;
+	while ((e = readdir(d)) != NULL) {
+		uint32_t segment;
+		char end;
+		if (sscanf(e->d_name, "frames_%8u.da%c", &segment, &end) != 2 || end != 't' || strlen(e->d_name) != 19)
+			continue;
+		if (num == size) {
+			size = size ? size * 2 : 64;
+			uint32_t *bigger = realloc(*segments, size * sizeof(uint32_t));
+			if (bigger == NULL) {
+				error_print("Could not list the frame archive %s: out of memory\n", dir);
+				free(*segments);
+				*segments = NULL;
+				closedir(d);
+				return -1;
+			}
+			*segments = bigger;
+		}
+		(*segments)[num++] = segment;
+	}
+	closedir(d);
+	if (num > 0)
+		qsort(*segments, num, sizeof(uint32_t), frame_archive_compare_segments);
+	return num;
+}
+
+/* Open a segment and count its records.  A record that was half written at a crash is ignored */
+int frame_archive_open_segment(char *dir, uint32_t segment, long *records) {
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/frames_%08u.dat", dir, segment);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+	*records = st.st_size / sizeof(frame_archive_record_t);
+	return fd;
+}
+
+/* Make the index entry of a segment from its first and last records */
+int frame_archive_scan_segment(char *dir, uint32_t segment, frame_archive_index_t *entry) {
+	long records;
+	memset(entry, 0, sizeof(*entry));
+	entry->segment = segment;
+	int fd = frame_archive_open_segment(dir, segment, &records);
+	if (fd < 0)
+		return EXIT_FAILURE;
+	if (records > 0) {
+		entry->records = records;
+		entry->first_key = frame_archive_read_key(fd, 0);
+		entry->last_key = frame_archive_read_key(fd, records - 1);
+	}
+	close(fd);
+	return EXIT_SUCCESS;
+}
+
+int frame_archive_compare_index(const void *a, const void *b) {
+	const frame_archive_index_t *x = a;
+	const frame_archive_index_t *y = b;
+	if (x->first_key != y->first_key)
+		return (x->first_key > y->first_key) - (x->first_key < y->first_key);
+	return (x->segment > y->segment) - (x->segment < y->segment);
+}
+
+/*
+ * Read the index, without the empty segments, and sort it by the first key.  reach[i] is the
+ * latest last key of entries 0 to i, so it only goes up and can be searched.  If there is no
+ * index file it is made from the segments.  Returns the number of entries, or -1
+ */
+int frame_archive_load_index(char *dir, frame_archive_index_t **index, uint64_t **reach) {
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/%s", dir, FRAME_ARCHIVE_INDEX_FILE);
+	*index = NULL;
+	*reach = NULL;
+	int entries = 0;
+	int fd = open(path, O_RDONLY);
+	struct stat st;
+	if (fd >= 0 && fstat(fd, &st) == 0) {
+		entries = st.st_size / sizeof(frame_archive_index_t);
+		*index = malloc((entries ? entries : 1) * sizeof(frame_archive_index_t));
+		if (*index != NULL && pread(fd, *index, entries * sizeof(frame_archive_index_t), 0)
+				!= (ssize_t)(entries * sizeof(frame_archive_index_t)))
+			entries = 0;
+	} else {
+		uint32_t *segments;
+		entries = frame_archive_list_segments(dir, &segments);
+		if (entries < 0) {
+			if (fd >= 0)
+				close(fd);
+			return -1;
+		}
+		*index = malloc((entries ? entries : 1) * sizeof(frame_archive_index_t));
+		for (int s=0; s < entries && *index != NULL; s++)
+			frame_archive_scan_segment(dir, segments[s], &(*index)[s]);
+		free(segments);
+	}
+	if (fd >= 0)
+		close(fd);
+	*reach = malloc((entries ? entries : 1) * sizeof(uint64_t));
+	if (*index == NULL || *reach == NULL) {
+		error_print("Could not read the frame archive index %s: out of memory\n", path);
+		free(*index);
+		free(*reach);
+		*index = NULL;
+		*reach = NULL;
+		return -1;
+	}
+
+	int n = 0;
+	for (int i=0; i < entries; i++)
+		if ((*index)[i].records > 0)
+			(*index)[n++] = (*index)[i];
+	if (n > 0)
+		qsort(*index, n, sizeof(frame_archive_index_t), frame_archive_compare_index);
+	for (int i=0; i < n; i++)
+		(*reach)[i] = (i > 0 && (*reach)[i-1] > (*index)[i].last_key) ? (*reach)[i-1] : (*index)[i].last_key;
+	return n;
+}
+
+/* Binary search for the first entry of the sorted index that reaches key.  Returns entries if none do */
+int frame_archive_index_search(uint64_t *reach, int entries, uint64_t key) {
+	int lo = 0, hi = entries;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (reach[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+uint64_t frame_archive_read_key(int fd, long record) {
+	struct __attribute__((__packed__)) {
+		uint16_t epoch;
+		uint32_t uptime;
+	} time;
+	off_t pos = record * sizeof(frame_archive_record_t) + offsetof(frame_archive_record_t, epoch);
+	if (pread(fd, &time, sizeof(time), pos) != sizeof(time))
+		return UINT64_MAX;
+	return FRAME_ARCHIVE_KEY(time.epoch, time.uptime);
+}
+
+/* Binary search for the first record at or after key.  Returns records if there is none */
+long frame_archive_search(int fd, long records, uint64_t key) {
+	long lo = 0, hi = records;
+	while (lo < hi) {
+		long mid = lo + (hi - lo) / 2;
+		if (frame_archive_read_key(fd, mid) < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/*
+ * The segments after the first one that reaches key are only read while they start before the
+ * best record found so far, which is once unless the clock went back
+ */
+int frame_archive_find(char *dir, uint64_t key, uint32_t *segment, long *record) {
+	frame_archive_index_t *index;
+	uint64_t *reach;
+	int entries = frame_archive_load_index(dir, &index, &reach);
+	if (entries < 0)
+		return EXIT_FAILURE;
+	int rc = EXIT_FAILURE;
+	uint64_t best = UINT64_MAX;
+	for (int i=frame_archive_index_search(reach, entries, key); i < entries && index[i].first_key < best; i++) {
+		if (index[i].last_key < key)
+			continue;
+		long records;
+		int fd = frame_archive_open_segment(dir, index[i].segment, &records);
+		if (fd < 0)
+			continue;
+		if (records > index[i].records)
+			records = index[i].records;
+		long r = frame_archive_search(fd, records, key);
+		uint64_t found = r < records ? frame_archive_read_key(fd, r) : UINT64_MAX;
+		close(fd);
+		if (found < best) {
+			best = found;
+			*segment = index[i].segment;
+			*record = r;
+			rc = EXIT_SUCCESS;
+		}
+	}
+	free(index);
+	free(reach);
+	return rc;
+}
+
+long frame_archive_dump(char *dir, FILE *out, uint64_t from, uint64_t to) {
+	static const char hex[] = "0123456789abcdef";
+	frame_archive_index_t *index;
+	uint64_t *reach;
+	int entries = frame_archive_load_index(dir, &index, &reach);
+	if (entries < 0)
+		return -1;
+	frame_archive_record_t *buffer = malloc(FRAME_ARCHIVE_DUMP_RECORDS * sizeof(frame_archive_record_t));
+	char line[128 + 2 * DUV_DATA_LENGTH];
+	long printed = 0;
+	for (int i=frame_archive_index_search(reach, entries, from); i < entries && index[i].first_key <= to; i++) {
+		if (index[i].last_key < from)
+			continue;
+		long records;
+		int fd = frame_archive_open_segment(dir, index[i].segment, &records);
+		if (fd < 0)
+			continue;
+		if (records > index[i].records)
+			records = index[i].records;
+		long r = frame_archive_search(fd, records, from);
+		lseek(fd, r * sizeof(frame_archive_record_t), SEEK_SET);
+		int done = false;
+		while (r < records && !done) {
+			long n = records - r;
+			if (n > FRAME_ARCHIVE_DUMP_RECORDS)
+				n = FRAME_ARCHIVE_DUMP_RECORDS;
+			ssize_t bytes = read(fd, buffer, n * sizeof(frame_archive_record_t));
+			if (bytes <= 0)
+				break;
+			n = bytes / sizeof(frame_archive_record_t);
+			for (long i=0; i < n; i++) {
+				frame_archive_record_t *record = &buffer[i];
+				if (FRAME_ARCHIVE_KEY(record->epoch, record->uptime) > to) {
+					done = true;
+					break;
+				}
+				int len = snprintf(line, sizeof(line), "%u %u %u %u %s %s ", record->seq, record->epoch,
+						record->uptime, record->frame_time, record->stream == TELEM_STREAM_MAIN ? "main" : "burst",
+						telem_scheduler_frame_name(record->type));
+				for (int b=0; b < DUV_DATA_LENGTH; b++) {
+					line[len++] = hex[record->payload[b] >> 4];
+					line[len++] = hex[record->payload[b] & 0xf];
+				}
+				line[len++] = '\n';
+				fwrite(line, 1, len, out);
+				printed++;
+			}
+			r += n;
+		}
+		close(fd);
+	}
+	free(buffer);
+	free(index);
+	free(reach);
+	return printed;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* Remove a test or bench archive */
+void test_frame_archive_remove(char *dir) {
+	if (access(dir, F_OK) != 0) return;
+	uint32_t *segments;
+	int num_segments = frame_archive_list_segments(dir, &segments);
+	for (int s=0; s < num_segments; s++) {
+		char path[MAX_LINE_LENGTH * 2];
+		snprintf(path, sizeof(path), "%s/frames_%08u.dat", dir, segments[s]);
+		unlink(path);
+	}
+	free(segments);
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/%s", dir, FRAME_ARCHIVE_INDEX_FILE);
+	unlink(path);
+	rmdir(dir);
+}
+
+/* The words of test frame n */
+void test_frame_archive_packet(int n, uint16_t *words, uint64_t *packed) {
+	unsigned char packet[DUV_PACKET_LENGTH];
+	int rd = 0;
+	for (int i=0; i < DUV_PACKET_LENGTH; i++)
+		packet[i] = n * 7 + i;
+	((duv_header_t *)packet)->type = 1 + n % 3;
+	for (int i=0; i < DUV_PACKET_LENGTH; i++)
+		words[i] = encode_8b10b(&rd, packet[i]);
+	words[DUV_PACKET_LENGTH] = encode_8b10b(&rd, SYNC_CHARACTER);
+	telem_pack_words(words, DUV_PACKET_LENGTH+1, packed);
+}
+
+/* Push test frame n, with its time moved to sent */
+void test_frame_archive_push(int n, time_t sent) {
+	uint16_t words[DUV_PACKET_LENGTH+1];
+	uint64_t packed[TELEM_PACKED_LENGTH];
+	test_frame_archive_packet(n, words, packed);
+	frame_archive_push(n % 2, n * 1000, packed);
+	frame_archive_ring[(frame_archive_head - 1) & (FRAME_ARCHIVE_RECORDS - 1)].sent = sent;
+}
+
+/*
+ * Write an archive of frames sent back to back at bit_rate from start, for telem_bench.  This
+ * reads the ring itself, so the archive thread must not be running
+ */
+int bench_frame_archive_make(char *dir, long frames, int bit_rate, time_t start) {
+	int bits_per_frame = (DUV_PACKET_LENGTH + 1) * BITS_PER_10b_WORD;
+	test_frame_archive_remove(dir);
+	if (frame_archive_open(dir, FRAME_ARCHIVE_DEFAULT_SEGMENT_RECORDS, 0) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	for (long n=0; n < frames; n++) {
+		test_frame_archive_push(n, start + n * bits_per_frame / bit_rate);
+		if ((n & (FRAME_ARCHIVE_RECORDS - 1)) == FRAME_ARCHIVE_RECORDS - 1)
+			frame_archive_drain();
+	}
+	frame_archive_close();
+	return EXIT_SUCCESS;
+}
+
+/* This must run before the archive thread is started, because it reads the ring itself */
+int test_frame_archive() {
+	printf("TESTING frame_archive .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	char *dir = "archive_test";
+	test_frame_archive_remove(dir);
+
+	uint16_t words[DUV_PACKET_LENGTH+1];
+	uint64_t packed[TELEM_PACKED_LENGTH];
+	memset(packed, 0, sizeof(packed));
+	frame_archive_push(0, 0, packed); // nothing happens until it is open
+	if (frame_archive_open(dir, 4, 0) != EXIT_SUCCESS) {
+		printf(" Fail\n");
+		return EXIT_FAILURE;
+	}
+
+	/* Ten frames a minute apart go into segments of 4, 4 and 2 */
+	time_t start = time(NULL) - 3600;
+	for (int n=0; n < 10; n++)
+		test_frame_archive_push(n, start + n * 60);
+	if (frame_archive_drain() != 10 || frame_archive_segment != 3) {
+		verbose_print(" frames did not go into 3 segments\n");
+		fail = EXIT_FAILURE;
+	}
+
+	/* The clock goes back, so the next frame starts segment 4 */
+	test_frame_archive_push(10, start - 60);
+	frame_archive_drain();
+	if (frame_archive_segment != 4) {
+		verbose_print(" the clock went back in segment %d\n", frame_archive_segment);
+		fail = EXIT_FAILURE;
+	}
+
+	/* If the archive thread falls behind, the frames that do not fit in the ring are dropped */
+	for (int n=0; n < FRAME_ARCHIVE_RECORDS + 3; n++)
+		test_frame_archive_push(n, start + 3600);
+	if (frame_archive_drain() != FRAME_ARCHIVE_RECORDS)
+		fail = EXIT_FAILURE;
+	frame_archive_close();
+
+	/* Read back the last frame and check it is as sent */
+	int n = FRAME_ARCHIVE_RECORDS - 1;
+	test_frame_archive_packet(n, words, packed);
+	long records;
+	int fd = frame_archive_open_segment(dir, frame_archive_segment, &records);
+	frame_archive_record_t record;
+	if (fd < 0 || pread(fd, &record, sizeof(record), (records - 1) * sizeof(record)) != sizeof(record)) {
+		verbose_print(" could not read the last record\n");
+		fail = EXIT_FAILURE;
+	} else {
+		if (memcmp(record.words, words, sizeof(words)) != 0 || record.payload[10] != (unsigned char)(n * 7 + 10)
+				|| record.type != 1 + n % 3 || record.stream != n % 2 || record.frame_time != n * 1000) {
+			verbose_print(" last record is not the frame that was sent\n");
+			fail = EXIT_FAILURE;
+		}
+	}
+	if (fd >= 0)
+		close(fd);
+
+	/* Look up a time between frames 5 and 6, and after the last frame */
+	uint64_t key = frame_archive_time_key(start + 5 * 60 + 30);
+	uint32_t segment;
+	long r;
+	if (frame_archive_find(dir, key, &segment, &r) != EXIT_SUCCESS || segment != 2 || r != 2) {
+		verbose_print(" frame 6 was not found\n");
+		fail = EXIT_FAILURE;
+	}
+	if (frame_archive_find(dir, key + 7200, &segment, &r) != EXIT_FAILURE) {
+		verbose_print(" found a frame after the last one\n");
+		fail = EXIT_FAILURE;
+	}
+
+	/* Without the index file the segments are read instead, and it is made again when opened */
+	char path[MAX_LINE_LENGTH * 2];
+	snprintf(path, sizeof(path), "%s/%s", dir, FRAME_ARCHIVE_INDEX_FILE);
+	unlink(path);
+	if (frame_archive_find(dir, key, &segment, &r) != EXIT_SUCCESS || segment != 2 || r != 2) {
+		verbose_print(" frame 6 was not found without the index\n");
+		fail = EXIT_FAILURE;
+	}
+	uint32_t last_segment = frame_archive_segment;
+	frame_archive_open(dir, 4, 0);
+	frame_archive_close();
+	struct stat st;
+	if (stat(path, &st) != 0 || st.st_size != last_segment * (off_t)sizeof(frame_archive_index_t)) {
+		verbose_print(" the index was not made again\n");
+		fail = EXIT_FAILURE;
+	}
+
+	/* Dump frames 6 to 9 */
+	char *text;
+	size_t len;
+	FILE *out = open_memstream(&text, &len);
+	long printed = frame_archive_dump(dir, out, key, key + 210);
+	fclose(out);
+	verbose_print("%s", text);
+	if (printed != 4 || strncmp(text, "6 ", 2) != 0) {
+		verbose_print(" dumped %ld frames\n", printed);
+		fail = EXIT_FAILURE;
+	}
+	free(text);
+	test_frame_archive_remove(dir);
+
+	/* With at most 3 segments of 4 the first 8 of 20 frames are deleted */
+	frame_archive_open(dir, 4, 3);
+	for (int n=0; n < 20; n++)
+		test_frame_archive_push(n, start + n * 60);
+	frame_archive_drain();
+	frame_archive_close();
+	uint32_t *segments;
+	int num_segments = frame_archive_list_segments(dir, &segments);
+	if (num_segments != 3 || segments[0] != 3 || frame_archive_find(dir, key, &segment, &r) != EXIT_SUCCESS
+			|| segment != 3 || r != 0) {
+		verbose_print(" the oldest segments were not deleted\n");
+		fail = EXIT_FAILURE;
+	}
+	free(segments);
+	test_frame_archive_remove(dir);
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,356 @@
+/*
+ * gf256.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * GF(256) arithmetic.  See gf256.h
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define GF256_X86
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "../../telem_send/inc/gf256.h"
+
+uint8_t gf256_exp[2 * GF256_ORDER];
+uint8_t gf256_log[256];
+
+/*
+ * Split nibble tables.  c * x = gf256_mul_lo[c][x & 0xf] ^ gf256_mul_hi[c][x >> 4], because
+ * multiplication by c is linear over XOR
+ */
+uint8_t gf256_mul_lo[256][16] __attribute__((aligned(16)));
+uint8_t gf256_mul_hi[256][16] __attribute__((aligned(16)));
+
+/* dst[r * stride + i] = c[r] * src[i], or ^= if add is true */
+typedef void (*gf256_region_fn_t)(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len,
+		int add);
+int gf256_kernel = GF256_KERNEL_SCALAR;
+gf256_region_fn_t gf256_region = NULL;
+int gf256_ready = false;
+
+/* Forward declarations */
+void gf256_region_scalar(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add);
+void gf256_region_ssse3(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add);
+void gf256_region_avx2(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add);
+void gf256_region_neon(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add);
+gf256_region_fn_t gf256_region_kernels[GF256_NUM_KERNELS] = {
+		gf256_region_scalar, gf256_region_ssse3, gf256_region_avx2, gf256_region_neon};
+
+void gf256_init() {
+	if (gf256_ready)
+		return;
+	int x = 1;
+	for (int i=0; i < GF256_ORDER; i++) {
+		gf256_exp[i] = x;
+		gf256_exp[i + GF256_ORDER] = x;
+		gf256_log[x] = i;
+		x <<= 1;
+		if (x & 0x100)
+			x ^= GF256_POLY;
+	}
+	gf256_log[0] = 0;
+	for (int c=0; c < 256; c++)
+		for (int n=0; n < 16; n++) {
+			gf256_mul_lo[c][n] = gf256_mul(c, n);
+			gf256_mul_hi[c][n] = gf256_mul(c, n << 4);
+		}
+	for (int k=GF256_NUM_KERNELS-1; k >= 0; k--)
+		if (gf256_kernel_supported(k)) {
+			gf256_set_kernel(k);
+			break;
+		}
+	gf256_ready = true;
+}
+
+int gf256_kernel_supported(int kernel) {
+	switch (kernel) {
+	case GF256_KERNEL_SCALAR:
+		return true;
+#ifdef GF256_X86
+	case GF256_KERNEL_SSSE3:
+		return __builtin_cpu_supports("ssse3");
+	case GF256_KERNEL_AVX2:
+		return __builtin_cpu_supports("avx2");
+#endif
+#if defined(__ARM_NEON)
+	case GF256_KERNEL_NEON:
+		return true;
+#endif
+	}
+	return false;
+}
+
+int gf256_set_kernel(int kernel) {
+	if (kernel < 0 || kernel >= GF256_NUM_KERNELS || !gf256_kernel_supported(kernel))
+		return EXIT_FAILURE;
+	gf256_kernel = kernel;
+	gf256_region = gf256_region_kernels[kernel];
+	return EXIT_SUCCESS;
+}
+
+int gf256_get_kernel() {
+	return gf256_kernel;
+}
+
+int gf256_kernel_width(int kernel) {
+	int widths[GF256_NUM_KERNELS] = {1, 16, 32, 16};
+	if (kernel < 0 || kernel >= GF256_NUM_KERNELS)
+		return 1;
+	return widths[kernel];
+}
+
+char *gf256_kernel_name(int kernel) {
+	char *names[GF256_NUM_KERNELS] = {"scalar", "ssse3", "avx2", "neon"};
+	if (kernel < 0 || kernel >= GF256_NUM_KERNELS)
+		return "unknown";
+	return names[kernel];
+}
+
+void gf256_mul_add_region(uint8_t *dst, const uint8_t *src, uint8_t c, int len) {
+	if (!gf256_ready)
+		gf256_init();
+	gf256_region(dst, 0, src, &c, 1, len, true);
+}
+
+void gf256_mul_region(uint8_t *dst, const uint8_t *src, uint8_t c, int len) {
+	if (!gf256_ready)
+		gf256_init();
+	gf256_region(dst, 0, src, &c, 1, len, false);
+}
+
+void gf256_mul_add_rows(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len) {
+	if (!gf256_ready)
+		gf256_init();
+	gf256_region(dst, stride, src, c, rows, len, true);
+}
+
+/* Also used for the bytes left over at the end by the vector kernels */
+void gf256_region_scalar(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	for (int r=0; r < rows; r++) {
+		const uint8_t *lo = gf256_mul_lo[c[r]];
+		const uint8_t *hi = gf256_mul_hi[c[r]];
+		uint8_t *d = &dst[r * stride];
+		for (int i=0; i < len; i++) {
+			uint8_t p = lo[src[i] & 0x0f] ^ hi[src[i] >> 4];
+			d[i] = add ? d[i] ^ p : p;
+		}
+	}
+}
+
+/*
+ * The vector kernels split each block of src into nibbles once and then do every row with it.
+ * The tables for the row constants are loaded each time, but they stay in the L1 cache
+ */
+#ifdef GF256_X86
+__attribute__((target("ssse3")))
+void gf256_region_ssse3(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	__m128i mask = _mm_set1_epi8(0x0f);
+	int i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i x = _mm_loadu_si128((const __m128i *)&src[i]);
+		__m128i l = _mm_and_si128(x, mask);
+		__m128i h = _mm_and_si128(_mm_srli_epi64(x, 4), mask);
+		for (int r=0; r < rows; r++) {
+			__m128i *d = (__m128i *)&dst[r * stride + i];
+			__m128i p = _mm_xor_si128(_mm_shuffle_epi8(_mm_load_si128((const __m128i *)gf256_mul_lo[c[r]]), l),
+					_mm_shuffle_epi8(_mm_load_si128((const __m128i *)gf256_mul_hi[c[r]]), h));
+			if (add)
+				p = _mm_xor_si128(p, _mm_loadu_si128(d));
+			_mm_storeu_si128(d, p);
+		}
+	}
+	if (i < len)
+		gf256_region_scalar(&dst[i], stride, &src[i], c, rows, len - i, add);
+}
+
+__attribute__((target("avx2")))
+void gf256_region_avx2(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	__m256i mask = _mm256_set1_epi8(0x0f);
+	int i = 0;
+	for (; i + 32 <= len; i += 32) {
+		__m256i x = _mm256_loadu_si256((const __m256i *)&src[i]);
+		__m256i l = _mm256_and_si256(x, mask);
+		__m256i h = _mm256_and_si256(_mm256_srli_epi64(x, 4), mask);
+		for (int r=0; r < rows; r++) {
+			/* The shuffle works within each 128 bit half, so both halves get the same table */
+			__m256i lo = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)gf256_mul_lo[c[r]]));
+			__m256i hi = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)gf256_mul_hi[c[r]]));
+			__m256i *d = (__m256i *)&dst[r * stride + i];
+			__m256i p = _mm256_xor_si256(_mm256_shuffle_epi8(lo, l), _mm256_shuffle_epi8(hi, h));
+			if (add)
+				p = _mm256_xor_si256(p, _mm256_loadu_si256(d));
+			_mm256_storeu_si256(d, p);
+		}
+	}
+	/*
+	 * Clear the upper halves of the registers before any code that is not AVX runs.  The compiler
+	 * does not always do this before a tail call, and the cpu is very slow if it is not done
+	 */
+	_mm256_zeroupper();
+	if (i < len)
+		gf256_region_scalar(&dst[i], stride, &src[i], c, rows, len - i, add);
+}
+#else
+void gf256_region_ssse3(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	gf256_region_scalar(dst, stride, src, c, rows, len, add);
+}
+
+void gf256_region_avx2(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	gf256_region_scalar(dst, stride, src, c, rows, len, add);
+}
+#endif /* GF256_X86 */
+
+#if defined(__ARM_NEON)
+void gf256_region_neon(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	uint8x16_t mask = vdupq_n_u8(0x0f);
+	int i = 0;
+	for (; i + 16 <= len; i += 16) {
+		uint8x16_t x = vld1q_u8(&src[i]);
+		uint8x16_t l = vandq_u8(x, mask);
+		uint8x16_t h = vshrq_n_u8(x, 4);
+		for (int r=0; r < rows; r++) {
+			uint8_t *d = &dst[r * stride + i];
+#if defined(__aarch64__)
+			uint8x16_t p = veorq_u8(vqtbl1q_u8(vld1q_u8(gf256_mul_lo[c[r]]), l),
+					vqtbl1q_u8(vld1q_u8(gf256_mul_hi[c[r]]), h));
+#else
+			/* 32 bit ARM only has the 8 byte lookup, so do each half of the vector */
+			uint8x8x2_t lo = {{vld1_u8(gf256_mul_lo[c[r]]), vld1_u8(&gf256_mul_lo[c[r]][8])}};
+			uint8x8x2_t hi = {{vld1_u8(gf256_mul_hi[c[r]]), vld1_u8(&gf256_mul_hi[c[r]][8])}};
+			uint8x16_t p = veorq_u8(vcombine_u8(vtbl2_u8(lo, vget_low_u8(l)), vtbl2_u8(lo, vget_high_u8(l))),
+					vcombine_u8(vtbl2_u8(hi, vget_low_u8(h)), vtbl2_u8(hi, vget_high_u8(h))));
+#endif
+			if (add)
+				p = veorq_u8(p, vld1q_u8(d));
+			vst1q_u8(d, p);
+		}
+	}
+	if (i < len)
+		gf256_region_scalar(&dst[i], stride, &src[i], c, rows, len - i, add);
+}
+#else
+void gf256_region_neon(uint8_t *dst, int stride, const uint8_t *src, const uint8_t *c, int rows, int len, int add) {
+	gf256_region_scalar(dst, stride, src, c, rows, len, add);
+}
+#endif /* __ARM_NEON */
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* Multiply the slow way, one bit at a time */
+uint8_t test_gf256_mul_bits(uint8_t a, uint8_t b) {
+	int p = 0;
+	int x = a;
+	for (int i=0; i < 8; i++) {
+		if (b & (1 << i))
+			p ^= x;
+		x <<= 1;
+		if (x & 0x100)
+			x ^= GF256_POLY;
+	}
+	return p;
+}
+
+int test_gf256() {
+	printf("TESTING gf256 .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	gf256_init();
+	int saved = gf256_get_kernel();
+
+	for (int a=0; a < 256; a++)
+		for (int b=0; b < 256; b++) {
+			uint8_t p = gf256_mul(a, b);
+			if (p != test_gf256_mul_bits(a, b) || (b != 0 && gf256_div(p, b) != a)) {
+				verbose_print(" multiply failed with %d * %d\n", a, b);
+				fail = EXIT_FAILURE;
+			}
+		}
+
+	/* Every kernel must give what the scalar one does, with lengths that leave bytes over at the end */
+	static uint8_t src[300], dst[300], expected[300];
+	uint32_t seed = 7;
+	test_random_fill(&seed, src, sizeof(src));
+	int lengths[] = {0, 1, 15, 16, 17, 31, 32, 33, 64, 223, 300};
+	for (int k=0; k < GF256_NUM_KERNELS; k++) {
+		if (gf256_set_kernel(k) != EXIT_SUCCESS)
+			continue;
+		verbose_print(" kernel %s\n", gf256_kernel_name(k));
+		for (int n=0; n < (int)(sizeof(lengths)/sizeof(lengths[0])); n++)
+			for (int c=0; c < 256; c += 37) {
+				int len = lengths[n];
+				for (int i=0; i < len; i++) {
+					dst[i] = i;
+					expected[i] = i ^ test_gf256_mul_bits(c, src[i]);
+				}
+				gf256_mul_add_region(dst, src, c, len);
+				if (memcmp(dst, expected, len) != 0) {
+					verbose_print(" %s mul_add failed with %d bytes times %d\n", gf256_kernel_name(k), len, c);
+					fail = EXIT_FAILURE;
+				}
+				for (int i=0; i < len; i++)
+					expected[i] = test_gf256_mul_bits(c, src[i]);
+				gf256_mul_region(dst, src, c, len);
+				if (memcmp(dst, expected, len) != 0) {
+					verbose_print(" %s mul failed with %d bytes times %d\n", gf256_kernel_name(k), len, c);
+					fail = EXIT_FAILURE;
+				}
+			}
+
+		/* Several rows at once, as the RS encoder does */
+		static uint8_t rows[5][320], expected_rows[5][320];
+		uint8_t c[5] = {0, 1, 2, 0x87, 0xff};
+		for (int n=0; n < (int)(sizeof(lengths)/sizeof(lengths[0])); n++) {
+			int len = lengths[n];
+			for (int r=0; r < 5; r++)
+				for (int i=0; i < len; i++) {
+					rows[r][i] = r + i;
+					expected_rows[r][i] = (r + i) ^ test_gf256_mul_bits(c[r], src[i]);
+				}
+			gf256_mul_add_rows(rows[0], sizeof(rows[0]), src, c, 5, len);
+			for (int r=0; r < 5; r++)
+				if (memcmp(rows[r], expected_rows[r], len) != 0) {
+					verbose_print(" %s mul_add_rows failed with %d bytes in row %d\n", gf256_kernel_name(k), len, r);
+					fail = EXIT_FAILURE;
+				}
+		}
+	}
+	gf256_set_kernel(saved);
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
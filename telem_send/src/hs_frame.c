@@ -0,0 +1,215 @@
+/*
+ * hs_frame.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Interleaved high speed frame encoder.  See hs_frame.h
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "../../telem_send/inc/hs_frame.h"
+#include "../../telem_send/inc/gf256.h"
+#include "../../telem_send/inc/rs_decoder.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/telem_processor.h"
+
+/* Forward declarations */
+int hs_frame_codeword_length(hs_frame_encoder_t *e, int c);
+
+int hs_frame_init(hs_frame_encoder_t *e, int codewords, int data_length) {
+	if (codewords < 1 || codewords > HS_FRAME_MAX_CODEWORDS || data_length < codewords
+			|| data_length > codewords * DATA_BYTES_PER_CODE_WORD) {
+		error_print("Can not make a high speed frame of %d bytes in %d codewords\n", data_length, codewords);
+		return EXIT_FAILURE;
+	}
+	gf256_init();
+	e->codewords = codewords;
+	e->data_length = data_length;
+	e->rows = (data_length + codewords - 1) / codewords;
+	e->words = data_length + codewords * PARITY_BYTES_PER_CODEWORD + 1;
+	memset(e->coef, 0, sizeof(e->coef));
+	update_rs(e->coef, 1);
+	return EXIT_SUCCESS;
+}
+
+/* The data bytes in codeword c.  The first data_length % codewords have one more */
+int hs_frame_codeword_length(hs_frame_encoder_t *e, int c) {
+	return e->data_length / e->codewords + (c < e->data_length % e->codewords);
+}
+
+/*
+ * A short codeword is one byte behind the others, so it is lined up with the end of the window
+ * by a leading zero, as in rs_encode_group().  Each row is encoded to 8b10b as it is added to
+ * the registers, so the data is only read once.
+ *
+ * The rows are padded with zero feedback to the width of the gf256 kernel, so the vector kernels
+ * are used with fewer codewords than bytes in a vector.  The padding registers stay zero
+ */
+void hs_frame_encode(hs_frame_encoder_t *e, int *rd_state, const unsigned char *data, uint16_t *words) {
+	unsigned char feedback[HS_FRAME_MAX_CODEWORDS] __attribute__((aligned(32)));
+	int n = e->codewords;
+	int full = e->data_length - (e->rows - 1) * n; // the codewords with every row, and the bytes in the last row
+	int width = gf256_kernel_width(gf256_get_kernel());
+	width = (n + width - 1) / width * width; // never more than HS_FRAME_MAX_CODEWORDS
+	memset(e->window, 0, (e->rows + PARITY_BYTES_PER_CODEWORD) * sizeof(e->window[0]));
+	memset(&feedback[n], 0, width - n);
+
+	int w = 0;
+	for (int r=0; r < e->rows; r++) {
+		const unsigned char *row = &data[r * n];
+		for (int c=0; c < full; c++)
+			feedback[c] = e->window[r][c] ^ row[c];
+		for (int c=full; c < n; c++)
+			feedback[c] = e->window[r][c] ^ (r > 0 ? row[c - n] : 0);
+		gf256_mul_add_rows(e->window[r + 1], HS_FRAME_MAX_CODEWORDS, feedback, e->coef, PARITY_BYTES_PER_CODEWORD, width);
+
+		int bytes = r < e->rows - 1 ? n : full;
+		for (int c=0; c < bytes; c++)
+			words[w++] = encode_8b10b(rd_state, row[c]);
+	}
+	for (int k=0; k < (int)PARITY_BYTES_PER_CODEWORD; k++)
+		for (int c=0; c < n; c++)
+			words[w++] = encode_8b10b(rd_state, e->window[e->rows + k][c]);
+	words[w] = encode_8b10b(rd_state, SYNC_CHARACTER);
+}
+
+int hs_frame_decode(hs_frame_encoder_t *e, const uint16_t *words, unsigned char *data) {
+	unsigned char codeword[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD];
+	int n = e->codewords;
+	int corrected = 0;
+	int failed = false;
+	for (int c=0; c < n; c++) {
+		int len = hs_frame_codeword_length(e, c);
+		for (int j=0; j < len; j++)
+			codeword[j] = decode_8b10b_lookup(words[j * n + c]) & DECODE_8B10B_DATA;
+		for (int k=0; k < (int)PARITY_BYTES_PER_CODEWORD; k++)
+			codeword[len + k] = decode_8b10b_lookup(words[e->data_length + k * n + c]) & DECODE_8B10B_DATA;
+		int rc = rs_decode(codeword, len, NULL);
+		if (rc == RS_DECODE_FAILED)
+			failed = true;
+		else
+			corrected += rc;
+		for (int j=0; j < len; j++)
+			data[j * n + c] = codeword[j];
+	}
+	return failed ? RS_DECODE_FAILED : corrected;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_hs_frame() {
+	printf("TESTING hs_frame .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	static hs_frame_encoder_t e;
+	static unsigned char data[HS_FRAME_MAX_DATA_LENGTH];
+	static unsigned char decoded[HS_FRAME_MAX_DATA_LENGTH];
+	static uint16_t words[HS_FRAME_MAX_WORDS];
+
+	uint32_t seed = 7;
+	test_random_fill(&seed, data, HS_FRAME_MAX_DATA_LENGTH);
+
+	/* Full codewords, shortened codewords of two lengths, one codeword and the largest frame */
+	int sizes[][2] = {{HS_FRAME_DEFAULT_CODEWORDS, HS_FRAME_DEFAULT_DATA_LENGTH}, {5, 1003}, {1, DUV_DATA_LENGTH},
+			{3, 3}, {HS_FRAME_MAX_CODEWORDS, HS_FRAME_MAX_DATA_LENGTH}};
+	int saved = gf256_get_kernel();
+	for (int k=0; k < GF256_NUM_KERNELS; k++) {
+		if (gf256_set_kernel(k) != EXIT_SUCCESS)
+			continue;
+		for (int s=0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			int n = sizes[s][0];
+			if (hs_frame_init(&e, n, sizes[s][1]) != EXIT_SUCCESS) {
+				fail = EXIT_FAILURE;
+				continue;
+			}
+			int rd = 0;
+			hs_frame_encode(&e, &rd, data, words);
+
+			/* The words are the data in order, then the parities, then the sync word, with no 8b10b errors */
+			decode_8b10b_t d;
+			decode_8b10b_start(&d, 0);
+			for (int i=0; i < e.words - 1; i++) {
+				int byte = decode_8b10b(&d, words[i]);
+				if (i < e.data_length && byte != data[i])
+					fail = EXIT_FAILURE;
+			}
+			if (decode_8b10b(&d, words[e.words - 1]) != DECODE_8B10B_SYNC_WORD || d.code_violations != 0
+					|| d.disparity_errors != 0) {
+				verbose_print(" %d bytes in %d codewords is not valid 8b10b\n", e.data_length, n);
+				fail = EXIT_FAILURE;
+			}
+
+			/* Each codeword has the parities of its own bytes */
+			for (int c=0; c < n; c++) {
+				unsigned char parities[PARITY_BYTES_PER_CODEWORD];
+				memset(parities, 0, sizeof(parities));
+				for (int j=0; j < hs_frame_codeword_length(&e, c); j++)
+					update_rs(parities, data[j * n + c]);
+				for (int p=0; p < (int)PARITY_BYTES_PER_CODEWORD; p++)
+					if ((decode_8b10b_lookup(words[e.data_length + p * n + c]) & DECODE_8B10B_DATA) != parities[p]) {
+						verbose_print(" %s codeword %d of %d bytes in %d codewords has the wrong parities\n",
+								gf256_kernel_name(k), c, e.data_length, n);
+						fail = EXIT_FAILURE;
+						break;
+					}
+			}
+		}
+	}
+	gf256_set_kernel(saved);
+
+	/* A burst of 16 bytes for every codeword is corrected, one more in each is not */
+	hs_frame_init(&e, HS_FRAME_DEFAULT_CODEWORDS, HS_FRAME_DEFAULT_DATA_LENGTH);
+	for (int burst=16; burst <= 17; burst++) {
+		int rd = 0;
+		hs_frame_encode(&e, &rd, data, words);
+		int bad_rd = 0;
+		for (int i=0; i < burst * e.codewords; i++) {
+			int w = e.data_length - 40 + i; // the end of the data and the start of the parities
+			words[w] = encode_8b10b(&bad_rd, (decode_8b10b_lookup(words[w]) & DECODE_8B10B_DATA) ^ 0x5a);
+		}
+		int rc = hs_frame_decode(&e, words, decoded);
+		verbose_print(" burst of %d words: %d\n", burst * e.codewords, rc);
+		if (burst == 16 && (rc != 16 * e.codewords || memcmp(decoded, data, e.data_length) != 0))
+			fail = EXIT_FAILURE;
+		if (burst == 17 && rc != RS_DECODE_FAILED)
+			fail = EXIT_FAILURE;
+	}
+
+	if (hs_frame_init(&e, 2, 2 * DATA_BYTES_PER_CODE_WORD + 1) != EXIT_FAILURE
+			|| hs_frame_init(&e, HS_FRAME_MAX_CODEWORDS + 1, 1000) != EXIT_FAILURE) {
+		verbose_print(" a frame that does not fit was accepted\n");
+		fail = EXIT_FAILURE;
+	}
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -0,0 +1,214 @@
+/*
+ * layout_codec.c
+ *
+ * Generated by scripts/gen_layout_codec.py from the layouts in telem_send/layout.
+ * Do not edit, change the layout and run the script again.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ */
+
+#include "../../telem_send/inc/layout_codec.h"
+
+void duv_header_pack(const duv_header_fields_t *f, unsigned char *buf) {
+	buf[0] = (unsigned char)((f->id & 0x07) | ((f->epoch << 3) & 0xf8));
+	buf[1] = (unsigned char)(((f->epoch >> 5) & 0xff));
+	buf[2] = (unsigned char)(((f->epoch >> 13) & 0x07) | ((f->uptime << 3) & 0xf8));
+	buf[3] = (unsigned char)(((f->uptime >> 5) & 0xff));
+	buf[4] = (unsigned char)(((f->uptime >> 13) & 0xff));
+	buf[5] = (unsigned char)(((f->uptime >> 21) & 0x0f) | ((f->type << 4) & 0xf0));
+	buf[6] = (unsigned char)((f->extended_id & 0x1f) | ((f->safe_mode << 5) & 0x20) | ((f->health_mode << 6) & 0x40) | ((f->science_mode << 7) & 0x80));
+}
+
+void duv_header_unpack(const unsigned char *buf, duv_header_fields_t *f) {
+	f->id = (uint32_t)(buf[0] & 0x07);
+	f->epoch = ((uint32_t)(buf[0] & 0xf8) >> 3) | ((uint32_t)(buf[1] & 0xff) << 5) | ((uint32_t)(buf[2] & 0x07) << 13);
+	f->uptime = ((uint32_t)(buf[2] & 0xf8) >> 3) | ((uint32_t)(buf[3] & 0xff) << 5) | ((uint32_t)(buf[4] & 0xff) << 13) | ((uint32_t)(buf[5] & 0x0f) << 21);
+	f->type = ((uint32_t)(buf[5] & 0xf0) >> 4);
+	f->extended_id = (uint32_t)(buf[6] & 0x1f);
+	f->safe_mode = ((uint32_t)(buf[6] & 0x20) >> 5);
+	f->health_mode = ((uint32_t)(buf[6] & 0x40) >> 6);
+	f->science_mode = ((uint32_t)(buf[6] & 0x80) >> 7);
+}
+
+void rttelemetry_pack(const rttelemetry_fields_t *f, unsigned char *buf) {
+	buf[0] = (unsigned char)((f->pi_temperature & 0xff));
+	buf[1] = (unsigned char)(((f->pi_temperature >> 8) & 0xff));
+	buf[2] = (unsigned char)((f->xruns & 0xff));
+	buf[3] = (unsigned char)(((f->xruns >> 8) & 0xff));
+	buf[4] = (unsigned char)((f->loop_time & 0xff));
+	buf[5] = (unsigned char)((f->cpu_speed & 0xff));
+	buf[6] = (unsigned char)((f->loop_time_p99 & 0xff));
+	buf[7] = (unsigned char)((f->deadline_used & 0xff));
+	buf[8] = (unsigned char)((f->pad1 & 0xff));
+	buf[9] = (unsigned char)(((f->pad1 >> 8) & 0xff));
+	buf[10] = (unsigned char)(((f->pad1 >> 16) & 0xff));
+	buf[11] = (unsigned char)(((f->pad1 >> 24) & 0xff));
+	buf[12] = (unsigned char)((f->pad2 & 0xff));
+	buf[13] = (unsigned char)(((f->pad2 >> 8) & 0xff));
+	buf[14] = (unsigned char)(((f->pad2 >> 16) & 0xff));
+	buf[15] = (unsigned char)(((f->pad2 >> 24) & 0xff));
+	buf[16] = (unsigned char)((f->pad3 & 0xff));
+	buf[17] = (unsigned char)(((f->pad3 >> 8) & 0xff));
+	buf[18] = (unsigned char)(((f->pad3 >> 16) & 0xff));
+	buf[19] = (unsigned char)(((f->pad3 >> 24) & 0xff));
+	buf[20] = (unsigned char)((f->pad4 & 0xff));
+	buf[21] = (unsigned char)(((f->pad4 >> 8) & 0xff));
+	buf[22] = (unsigned char)(((f->pad4 >> 16) & 0xff));
+	buf[23] = (unsigned char)(((f->pad4 >> 24) & 0xff));
+	buf[24] = (unsigned char)((f->pad5 & 0xff));
+	buf[25] = (unsigned char)(((f->pad5 >> 8) & 0xff));
+	buf[26] = (unsigned char)(((f->pad5 >> 16) & 0xff));
+	buf[27] = (unsigned char)(((f->pad5 >> 24) & 0xff));
+	buf[28] = (unsigned char)((f->pad6 & 0xff));
+	buf[29] = (unsigned char)(((f->pad6 >> 8) & 0xff));
+	buf[30] = (unsigned char)(((f->pad6 >> 16) & 0xff));
+	buf[31] = (unsigned char)(((f->pad6 >> 24) & 0xff));
+	buf[32] = (unsigned char)((f->pad7 & 0xff));
+	buf[33] = (unsigned char)(((f->pad7 >> 8) & 0xff));
+	buf[34] = (unsigned char)(((f->pad7 >> 16) & 0xff));
+	buf[35] = (unsigned char)(((f->pad7 >> 24) & 0xff));
+	buf[36] = (unsigned char)((f->pad8 & 0xff));
+	buf[37] = (unsigned char)(((f->pad8 >> 8) & 0xff));
+	buf[38] = (unsigned char)(((f->pad8 >> 16) & 0xff));
+	buf[39] = (unsigned char)(((f->pad8 >> 24) & 0xff));
+	buf[40] = (unsigned char)((f->pad9 & 0xff));
+	buf[41] = (unsigned char)(((f->pad9 >> 8) & 0xff));
+	buf[42] = (unsigned char)(((f->pad9 >> 16) & 0xff));
+	buf[43] = (unsigned char)(((f->pad9 >> 24) & 0xff));
+	buf[44] = (unsigned char)((f->pad10 & 0xff));
+	buf[45] = (unsigned char)(((f->pad10 >> 8) & 0xff));
+	buf[46] = (unsigned char)(((f->pad10 >> 16) & 0xff));
+	buf[47] = (unsigned char)(((f->pad10 >> 24) & 0xff));
+	buf[48] = (unsigned char)((f->pad11 & 0xff));
+	buf[49] = (unsigned char)(((f->pad11 >> 8) & 0xff));
+	buf[50] = (unsigned char)(((f->pad11 >> 16) & 0xff));
+	buf[51] = (unsigned char)(((f->pad11 >> 24) & 0xff));
+	buf[52] = (unsigned char)((f->pad12 & 0xff));
+	buf[53] = (unsigned char)(((f->pad12 >> 8) & 0xff));
+	buf[54] = (unsigned char)(((f->pad12 >> 16) & 0xff));
+	buf[55] = (unsigned char)(((f->pad12 >> 24) & 0xff));
+	buf[56] = (unsigned char)((f->pad13 & 0xff));
+}
+
+void rttelemetry_unpack(const unsigned char *buf, rttelemetry_fields_t *f) {
+	f->pi_temperature = (uint32_t)(buf[0] & 0xff) | ((uint32_t)(buf[1] & 0xff) << 8);
+	f->xruns = (uint32_t)(buf[2] & 0xff) | ((uint32_t)(buf[3] & 0xff) << 8);
+	f->loop_time = (uint32_t)(buf[4] & 0xff);
+	f->cpu_speed = (uint32_t)(buf[5] & 0xff);
+	f->loop_time_p99 = (uint32_t)(buf[6] & 0xff);
+	f->deadline_used = (uint32_t)(buf[7] & 0xff);
+	f->pad1 = (uint32_t)(buf[8] & 0xff) | ((uint32_t)(buf[9] & 0xff) << 8) | ((uint32_t)(buf[10] & 0xff) << 16) | ((uint32_t)(buf[11] & 0xff) << 24);
+	f->pad2 = (uint32_t)(buf[12] & 0xff) | ((uint32_t)(buf[13] & 0xff) << 8) | ((uint32_t)(buf[14] & 0xff) << 16) | ((uint32_t)(buf[15] & 0xff) << 24);
+	f->pad3 = (uint32_t)(buf[16] & 0xff) | ((uint32_t)(buf[17] & 0xff) << 8) | ((uint32_t)(buf[18] & 0xff) << 16) | ((uint32_t)(buf[19] & 0xff) << 24);
+	f->pad4 = (uint32_t)(buf[20] & 0xff) | ((uint32_t)(buf[21] & 0xff) << 8) | ((uint32_t)(buf[22] & 0xff) << 16) | ((uint32_t)(buf[23] & 0xff) << 24);
+	f->pad5 = (uint32_t)(buf[24] & 0xff) | ((uint32_t)(buf[25] & 0xff) << 8) | ((uint32_t)(buf[26] & 0xff) << 16) | ((uint32_t)(buf[27] & 0xff) << 24);
+	f->pad6 = (uint32_t)(buf[28] & 0xff) | ((uint32_t)(buf[29] & 0xff) << 8) | ((uint32_t)(buf[30] & 0xff) << 16) | ((uint32_t)(buf[31] & 0xff) << 24);
+	f->pad7 = (uint32_t)(buf[32] & 0xff) | ((uint32_t)(buf[33] & 0xff) << 8) | ((uint32_t)(buf[34] & 0xff) << 16) | ((uint32_t)(buf[35] & 0xff) << 24);
+	f->pad8 = (uint32_t)(buf[36] & 0xff) | ((uint32_t)(buf[37] & 0xff) << 8) | ((uint32_t)(buf[38] & 0xff) << 16) | ((uint32_t)(buf[39] & 0xff) << 24);
+	f->pad9 = (uint32_t)(buf[40] & 0xff) | ((uint32_t)(buf[41] & 0xff) << 8) | ((uint32_t)(buf[42] & 0xff) << 16) | ((uint32_t)(buf[43] & 0xff) << 24);
+	f->pad10 = (uint32_t)(buf[44] & 0xff) | ((uint32_t)(buf[45] & 0xff) << 8) | ((uint32_t)(buf[46] & 0xff) << 16) | ((uint32_t)(buf[47] & 0xff) << 24);
+	f->pad11 = (uint32_t)(buf[48] & 0xff) | ((uint32_t)(buf[49] & 0xff) << 8) | ((uint32_t)(buf[50] & 0xff) << 16) | ((uint32_t)(buf[51] & 0xff) << 24);
+	f->pad12 = (uint32_t)(buf[52] & 0xff) | ((uint32_t)(buf[53] & 0xff) << 8) | ((uint32_t)(buf[54] & 0xff) << 16) | ((uint32_t)(buf[55] & 0xff) << 24);
+	f->pad13 = (uint32_t)(buf[56] & 0xff);
+}
+
+void exptelemetry_pack(const exptelemetry_fields_t *f, unsigned char *buf) {
+	buf[0] = (unsigned char)((f->temperature & 0xff));
+	buf[1] = (unsigned char)(((f->temperature >> 8) & 0xff));
+	buf[2] = (unsigned char)((f->pressure & 0xff));
+	buf[3] = (unsigned char)(((f->pressure >> 8) & 0xff));
+	buf[4] = (unsigned char)(((f->pressure >> 16) & 0xff));
+	buf[5] = (unsigned char)(((f->pressure >> 24) & 0xff));
+	buf[6] = (unsigned char)((f->humidity & 0xff));
+	buf[7] = (unsigned char)(((f->humidity >> 8) & 0xff));
+	buf[8] = (unsigned char)((f->gas_sensor1 & 0xff));
+	buf[9] = (unsigned char)(((f->gas_sensor1 >> 8) & 0xff));
+	buf[10] = (unsigned char)((f->gas_sensor2 & 0xff));
+	buf[11] = (unsigned char)(((f->gas_sensor2 >> 8) & 0xff));
+	buf[12] = (unsigned char)((f->gas_sensor3 & 0xff));
+	buf[13] = (unsigned char)(((f->gas_sensor3 >> 8) & 0xff));
+	buf[14] = (unsigned char)((f->gyro0 & 0xff));
+	buf[15] = (unsigned char)(((f->gyro0 >> 8) & 0x0f) | ((f->gyro1 << 4) & 0xf0));
+	buf[16] = (unsigned char)(((f->gyro1 >> 4) & 0xff));
+	buf[17] = (unsigned char)((f->gyro2 & 0xff));
+	buf[18] = (unsigned char)(((f->gyro2 >> 8) & 0x0f) | ((f->gyro3 << 4) & 0xf0));
+	buf[19] = (unsigned char)(((f->gyro3 >> 4) & 0xff));
+	buf[20] = (unsigned char)((f->gyro4 & 0xff));
+	buf[21] = (unsigned char)(((f->gyro4 >> 8) & 0x0f) | ((f->gyro5 << 4) & 0xf0));
+	buf[22] = (unsigned char)(((f->gyro5 >> 4) & 0xff));
+	buf[23] = (unsigned char)((f->gyro6 & 0xff));
+	buf[24] = (unsigned char)(((f->gyro6 >> 8) & 0x0f) | ((f->gyro7 << 4) & 0xf0));
+	buf[25] = (unsigned char)(((f->gyro7 >> 4) & 0xff));
+	buf[26] = (unsigned char)((f->gyro8 & 0xff));
+	buf[27] = (unsigned char)(((f->gyro8 >> 8) & 0x0f) | ((f->photoresistor << 4) & 0xf0));
+	buf[28] = (unsigned char)(((f->photoresistor >> 4) & 0xff));
+	buf[29] = (unsigned char)(((f->photoresistor >> 12) & 0x0f) | ((f->realtimeclock << 4) & 0xf0));
+	buf[30] = (unsigned char)(((f->realtimeclock >> 4) & 0xff));
+	buf[31] = (unsigned char)(((f->realtimeclock >> 12) & 0xff));
+	buf[32] = (unsigned char)(((f->realtimeclock >> 20) & 0xff));
+	buf[33] = (unsigned char)(((f->realtimeclock >> 28) & 0x0f) | ((f->mvps_voltage << 4) & 0xf0));
+	buf[34] = (unsigned char)(((f->mvps_voltage >> 4) & 0xff));
+	buf[35] = (unsigned char)(((f->mvps_voltage >> 12) & 0x0f) | ((f->mvps_current << 4) & 0xf0));
+	buf[36] = (unsigned char)(((f->mvps_current >> 4) & 0xff));
+	buf[37] = (unsigned char)(((f->mvps_current >> 12) & 0x0f) | ((f->radiation << 4) & 0xf0));
+	buf[38] = (unsigned char)(((f->radiation >> 4) & 0xff));
+	buf[39] = (unsigned char)(((f->radiation >> 12) & 0x0f) | ((f->cosmic_rays << 4) & 0xf0));
+	buf[40] = (unsigned char)(((f->cosmic_rays >> 4) & 0xff));
+	buf[41] = (unsigned char)(((f->cosmic_rays >> 12) & 0x0f) | ((f->pad1 << 4) & 0xf0));
+	buf[42] = (unsigned char)(((f->pad1 >> 4) & 0xff));
+	buf[43] = (unsigned char)((f->pad2 & 0xff));
+	buf[44] = (unsigned char)(((f->pad2 >> 8) & 0xff));
+	buf[45] = (unsigned char)((f->pad3 & 0xff));
+	buf[46] = (unsigned char)(((f->pad3 >> 8) & 0xff));
+	buf[47] = (unsigned char)(((f->pad3 >> 16) & 0xff));
+	buf[48] = (unsigned char)(((f->pad3 >> 24) & 0xff));
+	buf[49] = (unsigned char)((f->pad4 & 0xff));
+	buf[50] = (unsigned char)(((f->pad4 >> 8) & 0xff));
+	buf[51] = (unsigned char)(((f->pad4 >> 16) & 0xff));
+	buf[52] = (unsigned char)(((f->pad4 >> 24) & 0xff));
+	buf[53] = (unsigned char)((f->pad5 & 0xff));
+	buf[54] = (unsigned char)(((f->pad5 >> 8) & 0xff));
+	buf[55] = (unsigned char)(((f->pad5 >> 16) & 0xff));
+	buf[56] = (unsigned char)(((f->pad5 >> 24) & 0xff));
+}
+
+void exptelemetry_unpack(const unsigned char *buf, exptelemetry_fields_t *f) {
+	f->temperature = (uint32_t)(buf[0] & 0xff) | ((uint32_t)(buf[1] & 0xff) << 8);
+	f->pressure = (uint32_t)(buf[2] & 0xff) | ((uint32_t)(buf[3] & 0xff) << 8) | ((uint32_t)(buf[4] & 0xff) << 16) | ((uint32_t)(buf[5] & 0xff) << 24);
+	f->humidity = (uint32_t)(buf[6] & 0xff) | ((uint32_t)(buf[7] & 0xff) << 8);
+	f->gas_sensor1 = (uint32_t)(buf[8] & 0xff) | ((uint32_t)(buf[9] & 0xff) << 8);
+	f->gas_sensor2 = (uint32_t)(buf[10] & 0xff) | ((uint32_t)(buf[11] & 0xff) << 8);
+	f->gas_sensor3 = (uint32_t)(buf[12] & 0xff) | ((uint32_t)(buf[13] & 0xff) << 8);
+	f->gyro0 = (uint32_t)(buf[14] & 0xff) | ((uint32_t)(buf[15] & 0x0f) << 8);
+	f->gyro1 = ((uint32_t)(buf[15] & 0xf0) >> 4) | ((uint32_t)(buf[16] & 0xff) << 4);
+	f->gyro2 = (uint32_t)(buf[17] & 0xff) | ((uint32_t)(buf[18] & 0x0f) << 8);
+	f->gyro3 = ((uint32_t)(buf[18] & 0xf0) >> 4) | ((uint32_t)(buf[19] & 0xff) << 4);
+	f->gyro4 = (uint32_t)(buf[20] & 0xff) | ((uint32_t)(buf[21] & 0x0f) << 8);
+	f->gyro5 = ((uint32_t)(buf[21] & 0xf0) >> 4) | ((uint32_t)(buf[22] & 0xff) << 4);
+	f->gyro6 = (uint32_t)(buf[23] & 0xff) | ((uint32_t)(buf[24] & 0x0f) << 8);
+	f->gyro7 = ((uint32_t)(buf[24] & 0xf0) >> 4) | ((uint32_t)(buf[25] & 0xff) << 4);
+	f->gyro8 = (uint32_t)(buf[26] & 0xff) | ((uint32_t)(buf[27] & 0x0f) << 8);
+	f->photoresistor = ((uint32_t)(buf[27] & 0xf0) >> 4) | ((uint32_t)(buf[28] & 0xff) << 4) | ((uint32_t)(buf[29] & 0x0f) << 12);
+	f->realtimeclock = ((uint32_t)(buf[29] & 0xf0) >> 4) | ((uint32_t)(buf[30] & 0xff) << 4) | ((uint32_t)(buf[31] & 0xff) << 12) | ((uint32_t)(buf[32] & 0xff) << 20) | ((uint32_t)(buf[33] & 0x0f) << 28);
+	f->mvps_voltage = ((uint32_t)(buf[33] & 0xf0) >> 4) | ((uint32_t)(buf[34] & 0xff) << 4) | ((uint32_t)(buf[35] & 0x0f) << 12);
+	f->mvps_current = ((uint32_t)(buf[35] & 0xf0) >> 4) | ((uint32_t)(buf[36] & 0xff) << 4) | ((uint32_t)(buf[37] & 0x0f) << 12);
+	f->radiation = ((uint32_t)(buf[37] & 0xf0) >> 4) | ((uint32_t)(buf[38] & 0xff) << 4) | ((uint32_t)(buf[39] & 0x0f) << 12);
+	f->cosmic_rays = ((uint32_t)(buf[39] & 0xf0) >> 4) | ((uint32_t)(buf[40] & 0xff) << 4) | ((uint32_t)(buf[41] & 0x0f) << 12);
+	f->pad1 = ((uint32_t)(buf[41] & 0xf0) >> 4) | ((uint32_t)(buf[42] & 0xff) << 4);
+	f->pad2 = (uint32_t)(buf[43] & 0xff) | ((uint32_t)(buf[44] & 0xff) << 8);
+	f->pad3 = (uint32_t)(buf[45] & 0xff) | ((uint32_t)(buf[46] & 0xff) << 8) | ((uint32_t)(buf[47] & 0xff) << 16) | ((uint32_t)(buf[48] & 0xff) << 24);
+	f->pad4 = (uint32_t)(buf[49] & 0xff) | ((uint32_t)(buf[50] & 0xff) << 8) | ((uint32_t)(buf[51] & 0xff) << 16) | ((uint32_t)(buf[52] & 0xff) << 24);
+	f->pad5 = (uint32_t)(buf[53] & 0xff) | ((uint32_t)(buf[54] & 0xff) << 8) | ((uint32_t)(buf[55] & 0xff) << 16) | ((uint32_t)(buf[56] & 0xff) << 24);
+}
@@ -0,0 +1,276 @@
+/*
+ * rs_decoder.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Reed-Solomon decoder.  See rs_decoder.h
+ *
+ * The codeword is a polynomial with the first data byte as the highest power of x and the last
+ * parity as x^0.  An error in the byte with power e has the locator X = alpha^(RS_PRIM * e).
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "../../telem_send/inc/gf256.h"
+#include "../../telem_send/inc/rs_decoder.h"
+#include "../../telem_send/inc/telem_processor.h"
+
+/* Forward declarations */
+int rs_decode_syndromes(unsigned char *codeword, int len, unsigned char syndromes[PARITY_BYTES_PER_CODEWORD]);
+int rs_decode_berlekamp_massey(unsigned char syndromes[PARITY_BYTES_PER_CODEWORD], unsigned char lambda[RS_MAX_ERRORS + 1]);
+int rs_decode_chien(unsigned char lambda[RS_MAX_ERRORS + 1], int degree, int n, int powers[RS_MAX_ERRORS]);
+
+/*
+ * The received parities XOR the parities of the received data are the remainder of the codeword
+ * divided by the generator.  The generator is zero at each root, so the syndromes are the
+ * remainder at the roots.  Returns false if the remainder is zero, which means no errors
+ */
+int rs_decode_syndromes(unsigned char *codeword, int len, unsigned char syndromes[PARITY_BYTES_PER_CODEWORD]) {
+	unsigned char remainder[PARITY_BYTES_PER_CODEWORD];
+	encode_rs(remainder, codeword, len);
+	int errors = false;
+	for (int k=0; k < (int)PARITY_BYTES_PER_CODEWORD; k++) {
+		remainder[k] ^= codeword[len + k];
+		if (remainder[k] != 0)
+			errors = true;
+	}
+	if (!errors)
+		return false;
+	for (int i=0; i < (int)PARITY_BYTES_PER_CODEWORD; i++) {
+		uint8_t root = gf256_pow_alpha(RS_PRIM * (RS_FCR + i));
+		uint8_t s = 0;
+		for (int k=0; k < (int)PARITY_BYTES_PER_CODEWORD; k++)
+			s = gf256_mul(s, root) ^ remainder[k];
+		syndromes[i] = s;
+	}
+	return true;
+}
+
+/*
+ * Find the error locator polynomial lambda, with lambda[0] = 1 and a root at the inverse of each
+ * error locator.  Returns its degree, which is the number of errors, or RS_DECODE_FAILED
+ */
+int rs_decode_berlekamp_massey(unsigned char syndromes[PARITY_BYTES_PER_CODEWORD], unsigned char lambda[RS_MAX_ERRORS + 1]) {
+	unsigned char b[PARITY_BYTES_PER_CODEWORD + 1];
+	unsigned char t[PARITY_BYTES_PER_CODEWORD + 1];
+	unsigned char l[PARITY_BYTES_PER_CODEWORD + 1];
+	memset(l, 0, sizeof(l));
+	memset(b, 0, sizeof(b));
+	l[0] = 1;
+	b[0] = 1;
+	int degree = 0;
+
+	for (int r=0; r < (int)PARITY_BYTES_PER_CODEWORD; r++) {
+		/* The discrepancy between the next syndrome and what the current lambda predicts */
+		uint8_t d = syndromes[r];
+		for (int i=1; i <= degree; i++)
+			d ^= gf256_mul(l[i], syndromes[r - i]);
+		/* b is multiplied by x each step */
+		memmove(&b[1], &b[0], PARITY_BYTES_PER_CODEWORD);
+		b[0] = 0;
+		if (d == 0)
+			continue;
+		for (int i=0; i <= (int)PARITY_BYTES_PER_CODEWORD; i++)
+			t[i] = l[i] ^ gf256_mul(d, b[i]);
+		if (2 * degree <= r) {
+			degree = r + 1 - degree;
+			for (int i=0; i <= (int)PARITY_BYTES_PER_CODEWORD; i++)
+				b[i] = gf256_div(l[i], d);
+		}
+		memcpy(l, t, sizeof(l));
+	}
+	if (degree > RS_MAX_ERRORS || l[degree] == 0)
+		return RS_DECODE_FAILED;
+	for (int i=degree + 1; i <= (int)PARITY_BYTES_PER_CODEWORD; i++)
+		if (l[i] != 0)
+			return RS_DECODE_FAILED;
+	memcpy(lambda, l, RS_MAX_ERRORS + 1);
+	return degree;
+}
+
+/*
+ * Try every power of x in a codeword of n bytes.  The terms of lambda(alpha^(-RS_PRIM * e)) are
+ * kept, and each term is multiplied by its own constant to step to the next e.  Returns the number
+ * of roots, which are written to powers, or RS_DECODE_FAILED if it is not the degree of lambda.
+ * That happens when an error would have to be in the bytes the code was shortened by
+ */
+int rs_decode_chien(unsigned char lambda[RS_MAX_ERRORS + 1], int degree, int n, int powers[RS_MAX_ERRORS]) {
+	uint8_t term[RS_MAX_ERRORS + 1];
+	uint8_t step[RS_MAX_ERRORS + 1];
+	for (int j=0; j <= degree; j++) {
+		term[j] = lambda[j];
+		step[j] = gf256_pow_alpha(GF256_ORDER - (RS_PRIM * j) % GF256_ORDER);
+	}
+	int count = 0;
+	for (int e=0; e < n; e++) {
+		uint8_t sum = 0;
+		for (int j=0; j <= degree; j++) {
+			sum ^= term[j];
+			term[j] = gf256_mul(term[j], step[j]);
+		}
+		if (sum == 0) {
+			if (count == degree)
+				return RS_DECODE_FAILED;
+			powers[count++] = e;
+		}
+	}
+	if (count != degree)
+		return RS_DECODE_FAILED;
+	return count;
+}
+
+int rs_decode(unsigned char *codeword, int len, int positions[RS_MAX_ERRORS]) {
+	unsigned char syndromes[PARITY_BYTES_PER_CODEWORD];
+	unsigned char lambda[RS_MAX_ERRORS + 1];
+	unsigned char omega[RS_MAX_ERRORS];
+	int powers[RS_MAX_ERRORS];
+	uint8_t values[RS_MAX_ERRORS];
+
+	if (len < 0 || len > DATA_BYTES_PER_CODE_WORD) {
+		error_print("RS codeword has %d data bytes\n", len);
+		return RS_DECODE_FAILED;
+	}
+	gf256_init();
+	if (!rs_decode_syndromes(codeword, len, syndromes))
+		return 0;
+
+	int degree = rs_decode_berlekamp_massey(syndromes, lambda);
+	if (degree <= 0)
+		return RS_DECODE_FAILED;
+	int n = len + PARITY_BYTES_PER_CODEWORD;
+	if (rs_decode_chien(lambda, degree, n, powers) == RS_DECODE_FAILED)
+		return RS_DECODE_FAILED;
+
+	/* The error evaluator omega = syndromes * lambda mod x^degree */
+	for (int i=0; i < degree; i++) {
+		omega[i] = 0;
+		for (int j=0; j <= i; j++)
+			omega[i] ^= gf256_mul(lambda[j], syndromes[i - j]);
+	}
+
+	/*
+	 * Forney.  With X the locator and Xi its inverse the error is
+	 * X^(1 - RS_FCR) * omega(Xi) / lambda'(Xi), and lambda' only has the odd terms of lambda
+	 */
+	for (int k=0; k < degree; k++) {
+		int log_x = (RS_PRIM * powers[k]) % GF256_ORDER;
+		uint8_t xi = gf256_pow_alpha(GF256_ORDER - log_x);
+		uint8_t num = 0;
+		for (int i=degree - 1; i >= 0; i--)
+			num = gf256_mul(num, xi) ^ omega[i];
+		uint8_t den = 0;
+		uint8_t xi2 = gf256_mul(xi, xi);
+		for (int j=(degree - 1) | 1; j >= 1; j -= 2)
+			den = gf256_mul(den, xi2) ^ lambda[j];
+		if (den == 0)
+			return RS_DECODE_FAILED;
+		int log_scale = (log_x * (GF256_ORDER + 1 - RS_FCR)) % GF256_ORDER;
+		values[k] = gf256_mul(gf256_pow_alpha(log_scale), gf256_div(num, den));
+		if (values[k] == 0)
+			return RS_DECODE_FAILED;
+	}
+
+	for (int k=0; k < degree; k++) {
+		codeword[n - 1 - powers[k]] ^= values[k];
+		if (positions != NULL)
+			positions[k] = n - 1 - powers[k];
+	}
+	return degree;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* Put errors in distinct random bytes, and mark the bytes in hit */
+void test_rs_decoder_add_errors(unsigned char *codeword, int n, int errors, uint32_t *seed, unsigned char *hit) {
+	memset(hit, 0, n);
+	for (int e=0; e < errors; e++) {
+		int p;
+		do {
+			p = (test_random(seed) >> 8) % n;
+		} while (hit[p]);
+		hit[p] = 1;
+		codeword[p] ^= 1 + (test_random(seed) >> 24) % 255;
+	}
+}
+
+int test_rs_decoder() {
+	printf("TESTING rs_decoder .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	unsigned char original[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD];
+	unsigned char codeword[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD];
+	unsigned char hit[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD];
+	int positions[RS_MAX_ERRORS];
+	uint32_t seed = 5;
+
+	int lengths[] = {DUV_DATA_LENGTH, DATA_BYTES_PER_CODE_WORD, 1};
+	for (int n=0; n < (int)(sizeof(lengths)/sizeof(lengths[0])); n++) {
+		int len = lengths[n];
+		int total = len + PARITY_BYTES_PER_CODEWORD;
+		for (int errors=0; errors <= RS_MAX_ERRORS + 1; errors++)
+			for (int trial=0; trial < 20; trial++) {
+				test_random_fill(&seed, original, len);
+				encode_rs(&original[len], original, len);
+				memcpy(codeword, original, total);
+				test_rs_decoder_add_errors(codeword, total, errors, &seed, hit);
+				unsigned char received[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD];
+				memcpy(received, codeword, total);
+
+				int rc = rs_decode(codeword, len, positions);
+				if (errors > RS_MAX_ERRORS) {
+					/* Too many to correct, so it must fail and leave the codeword alone */
+					if (rc != RS_DECODE_FAILED || memcmp(codeword, received, total) != 0) {
+						verbose_print(" %d errors in %d bytes were not detected\n", errors, len);
+						fail = EXIT_FAILURE;
+					}
+					continue;
+				}
+				if (rc != errors || memcmp(codeword, original, total) != 0) {
+					verbose_print(" %d errors in %d bytes: corrected %d\n", errors, len, rc);
+					fail = EXIT_FAILURE;
+					continue;
+				}
+				for (int k=0; k < rc; k++)
+					if (!hit[positions[k]]) {
+						verbose_print(" %d errors in %d bytes: wrong position %d\n", errors, len, positions[k]);
+						fail = EXIT_FAILURE;
+					}
+			}
+	}
+
+	if (rs_decode(codeword, DATA_BYTES_PER_CODE_WORD + 1, NULL) != RS_DECODE_FAILED) {
+		verbose_print(" a codeword that is too long was decoded\n");
+		fail = EXIT_FAILURE;
+	}
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
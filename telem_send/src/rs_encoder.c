@@ -0,0 +1,149 @@
+/*
+ * rs_encoder.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * Batch Reed-Solomon encoder.  See rs_encoder.h
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "debug.h"
+#include "test_random.h"
+#include "../../telem_send/inc/gf256.h"
+#include "../../telem_send/inc/rs_encoder.h"
+#include "../../telem_send/inc/telem_processor.h"
+
+/*
+ * The generator coefficients, in the order they are added to the register.  update_rs() of a
+ * feedback byte f on an all zero register gives f times these, because the update is linear
+ */
+unsigned char rs_encoder_coef[PARITY_BYTES_PER_CODEWORD];
+int rs_encoder_ready = false;
+
+/* Forward declarations */
+void rs_encoder_init();
+void rs_encode_group(rs_frame_t *frames, int lanes);
+
+void rs_encoder_init() {
+	gf256_init();
+	memset(rs_encoder_coef, 0, sizeof(rs_encoder_coef));
+	update_rs(rs_encoder_coef, 1);
+	rs_encoder_ready = true;
+}
+
+int rs_encode_frames(rs_frame_t *frames, int n) {
+	if (!rs_encoder_ready)
+		rs_encoder_init();
+	for (int f=0; f < n; f++)
+		if (frames[f].len < 0 || frames[f].len > DATA_BYTES_PER_CODE_WORD) {
+			error_print("RS frame %d has %d bytes\n", f, frames[f].len);
+			return EXIT_FAILURE;
+		}
+	for (int f=0; f < n; f += RS_BATCH_LANES)
+		rs_encode_group(&frames[f], n - f < RS_BATCH_LANES ? n - f : RS_BATCH_LANES);
+	return EXIT_SUCCESS;
+}
+
+/*
+ * Each row of the window holds one byte of the register for every lane.  As in encode_rs() the
+ * register slides along the window rather than being shifted, so after byte i the register is
+ * rows i+1 to i+32 and the parities end up in the last 32 rows
+ */
+void rs_encode_group(rs_frame_t *frames, int lanes) {
+	unsigned char window[DATA_BYTES_PER_CODE_WORD + PARITY_BYTES_PER_CODEWORD][RS_BATCH_LANES]
+			__attribute__((aligned(32)));
+	unsigned char feedback[RS_BATCH_LANES] __attribute__((aligned(32)));
+	int len = 0;
+	for (int l=0; l < lanes; l++)
+		if (frames[l].len > len)
+			len = frames[l].len;
+	memset(window, 0, (len + PARITY_BYTES_PER_CODEWORD) * sizeof(window[0]));
+
+	for (int i=0; i < len; i++) {
+		for (int l=0; l < lanes; l++) {
+			int j = i - (len - frames[l].len);
+			feedback[l] = window[i][l] ^ (j >= 0 ? frames[l].data[j] : 0);
+		}
+		gf256_mul_add_rows(window[i + 1], RS_BATCH_LANES, feedback, rs_encoder_coef, PARITY_BYTES_PER_CODEWORD, lanes);
+	}
+	for (int l=0; l < lanes; l++)
+		for (int k=0; k < (int)PARITY_BYTES_PER_CODEWORD; k++)
+			frames[l].parity[k] = window[len + k][l];
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_rs_encode_frames() {
+	printf("TESTING rs_encode_frames .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	gf256_init();
+	int saved = gf256_get_kernel();
+
+	/* Full and shortened frames mixed, and a number that is not a whole number of groups */
+	int n = 2 * RS_BATCH_LANES + 13;
+	static unsigned char data[2 * RS_BATCH_LANES + 13][DATA_BYTES_PER_CODE_WORD];
+	static rs_frame_t frames[2 * RS_BATCH_LANES + 13];
+	uint32_t seed = 11;
+	for (int f=0; f < n; f++)
+		test_random_fill(&seed, data[f], DATA_BYTES_PER_CODE_WORD);
+
+	for (int k=0; k < GF256_NUM_KERNELS; k++) {
+		if (gf256_set_kernel(k) != EXIT_SUCCESS)
+			continue;
+		verbose_print(" kernel %s\n", gf256_kernel_name(k));
+		for (int f=0; f < n; f++) {
+			frames[f].data = data[f];
+			frames[f].len = (f % 3 == 0) ? DATA_BYTES_PER_CODE_WORD : (f % 3 == 1) ? DUV_DATA_LENGTH : f % 200;
+		}
+		if (rs_encode_frames(frames, n) != EXIT_SUCCESS)
+			fail = EXIT_FAILURE;
+		for (int f=0; f < n; f++) {
+			unsigned char parities[PARITY_BYTES_PER_CODEWORD];
+			memset(parities, 0, sizeof(parities));
+			for (int i=0; i < frames[f].len; i++)
+				update_rs(parities, data[f][i]);
+			if (memcmp(parities, frames[f].parity, sizeof(parities)) != 0) {
+				verbose_print(" %s frame %d of %d bytes has the wrong parities\n", gf256_kernel_name(k), f, frames[f].len);
+				fail = EXIT_FAILURE;
+			}
+		}
+	}
+	gf256_set_kernel(saved);
+
+	frames[0].len = DATA_BYTES_PER_CODE_WORD + 1;
+	if (rs_encode_frames(frames, 1) != EXIT_FAILURE) {
+		verbose_print(" a frame that is too long was encoded\n");
+		fail = EXIT_FAILURE;
+	}
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
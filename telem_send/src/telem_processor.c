@@ -29,23 +29,27 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
-#include <assert.h>
 #include <time.h>
 #include <sched.h>
 
 #include "debug.h"
+#include "test_random.h"
 #include "config.h"
+#include "rt_log.h"
 
 #include "../../telem_send/inc/telem_thread.h"
 #include "../../telem_send/inc/TelemEncoding.h"
+#include "../../telem_send/inc/decode_8b10b.h"
+#include "../../telem_send/inc/layout_codec.h"
 
 /* Forward function definitions */
-void encode_duv_telem_packet(unsigned char *packet, uint16_t *encoded_packet);
+void encode_duv_telem_packet(int *rd_state, unsigned char *packet, uint16_t *encoded_packet, uint64_t *packed_packet);
+void init_telem_stream(telem_stream_t *stream, int id, int packet_len);
 
 /* Telemetry modulator variables */
 unsigned char parities[DUV_PARITIES_LENGTH];   /* This is the parities calculated by the RS encoder */
-uint16_t encoded_packet[2][DUV_PACKET_LENGTH+1]; /* This is the 10b encoded packet with parities. It includes space for SYNC WORD at the end. */
-int current_encoded_packet_num; /* We have two encoded packets.  One is being sent and the other is being built. */
+telem_stream_t telem_streams[TELEM_NUM_STREAMS];
+telem_stream_t *main_stream = &telem_streams[TELEM_STREAM_MAIN];
 
 /* This test packet is a 101010 sequence of 10b words */
 uint16_t encoded_packet_test1[] = {
@@ -63,36 +67,49 @@ uint16_t encoded_packet_test1[] = {
 		0x2aa,0x2aa,0x2aa,0x2aa,0x2aa,0x2aa,0x2aa,0x2aa,0xfa
 };
 
-int packet_length; // initialized at startup to equal the length of a packet.
-int first_packet_to_be_sent; // flag that tells us if a sync word is needed at the start of the packet
-int bits_sent_for_current_word; // how many bits have we sent for the current 10b word
-int words_sent_for_current_packet; // how many 10b words we have sent for the current packet
-int rd_state = 0; // 8b10b Encoder state, initialized once at startup
-
 int init_telemetry_processor(int packet_len) {
-	packet_length = packet_len;
-	first_packet_to_be_sent = true;
-	bits_sent_for_current_word = 0;
-	words_sent_for_current_packet = 0;
-	current_encoded_packet_num = 0;
-	init_rd_state();
+	init_rs_table();
+	decode_8b10b_init();
+	for (int i=0; i < TELEM_NUM_STREAMS; i++)
+		init_telem_stream(&telem_streams[i], i, packet_len);
 	return 0;
 }
 
+void init_telem_stream(telem_stream_t *stream, int id, int packet_len) {
+	stream->id = id;
+	stream->packet_length = packet_len;
+	stream->first_packet_to_be_sent = true;
+	stream->bits_sent_for_current_word = 0;
+	stream->words_sent_for_current_packet = 0;
+	stream->current_encoded_packet_num = 0;
+	stream->rd_state = 0;
+	stream->bits_sent = 0;
+	stream->frames_sent = 0;
+	stream->frames_started = 0;
+	stream->frame_start_bit = 0;
+	stream->bits_buffered = 0;
+}
+
+telem_stream_t *telem_processor_stream(int id) {
+	return &telem_streams[id];
+}
+
 void init_rd_state() {
-	rd_state = 0;
+	for (int i=0; i < TELEM_NUM_STREAMS; i++)
+		telem_streams[i].rd_state = 0;
 }
 
 /**
  * This is called when a packet of data needs to be encoded ready for transmission.  It must
- * go into the non active encoded packet buffer.  It will then be sent when the current
- * packet is finished.  The caller is responsible for working out which buffer to use
+ * go into the non active encoded packet buffer of the stream.  It will then be sent when the
+ * current packet is finished.  The caller is responsible for working out which buffer to use
  *
  */
-int encode_next_packet(unsigned char *packet, int encoded_packet_num) {
+int encode_next_packet(int stream, unsigned char *packet, int encoded_packet_num) {
 	int rc = EXIT_SUCCESS;
 	//debug_print("DEBUG: Getting next packet\n");
-	encode_duv_telem_packet(packet, encoded_packet[encoded_packet_num]);
+	telem_stream_t *s = &telem_streams[stream];
+	encode_duv_telem_packet(&s->rd_state, packet, s->encoded_packet[encoded_packet_num], s->packed_packet[encoded_packet_num]);
 	return rc;
 }
 
@@ -107,72 +124,169 @@ int encode_next_packet(unsigned char *packet, int encoded_packet_num) {
  *
  */
 int get_next_bit() {
+	return telem_stream_next_bit(main_stream);
+}
+
+int telem_stream_next_bit(telem_stream_t *s) {
 	int current_bit = -1; // the first bit is set to be the sync word
 
-	if (bits_sent_for_current_word == 0 && words_sent_for_current_packet == 0) {
+	if (s->bits_sent_for_current_word == 0 && s->words_sent_for_current_packet == 0) {
 		// This is the start of sending a packets.
 		// Tell the telem thread to fill the next one
-		telem_thread_fill_next_packet();
+		telem_thread_fill_next_packet(s->id);
 	}
 
-	if (bits_sent_for_current_word >= BITS_PER_10b_WORD) { // We are starting a new 10b word
-		bits_sent_for_current_word = 0;
-		if (first_packet_to_be_sent) {
-			first_packet_to_be_sent = false; // we have sent at least one word so this is no longer the start of a transmission
+	if (s->bits_sent_for_current_word >= BITS_PER_10b_WORD) { // We are starting a new 10b word
+		s->bits_sent_for_current_word = 0;
+		if (s->first_packet_to_be_sent) {
+			s->first_packet_to_be_sent = false; // we have sent at least one word so this is no longer the start of a transmission
+			s->frames_started++;
+			s->frame_start_bit = s->bits_sent - BITS_PER_10b_WORD;
 		} else {
 			// we sent a word from this packet so increment the counter
-			words_sent_for_current_packet++;
+			s->words_sent_for_current_packet++;
 		}
-		if (words_sent_for_current_packet >= packet_length+1) { // We are ready for a new packet.  We have the sync word in the final word
-			words_sent_for_current_packet = 0;
+		if (s->words_sent_for_current_packet >= s->packet_length+1) { // We are ready for a new packet.  We have the sync word in the final word
+			s->words_sent_for_current_packet = 0;
+			s->frames_sent++;
 
-			int next_packet = telem_thread_get_packet_num();
+			int next_packet = telem_thread_get_packet_num(s->id);
 			//debug_print("DEBUG: next packet: %i\n", next_packet);
-			if (next_packet == current_encoded_packet_num) {
-				error_print("Next packet was not available\n");
+			if (next_packet == s->current_encoded_packet_num) {
+				rt_error_print("Next packet was not available\n");
 				// TODO - we need to reset things here and send the sync word again.
 			} else {
-				current_encoded_packet_num = next_packet;
+				s->current_encoded_packet_num = next_packet;
 			}
+			s->frames_started++;
+			s->frame_start_bit = s->bits_sent - BITS_PER_10b_WORD; // the sync word was the end of the last packet
 			// TODO - call at end as well as start?
 			// TODO - is this causing audio clipping somehow.....
-			telem_thread_fill_next_packet();
+			telem_thread_fill_next_packet(s->id);
 		}
 
 	}
 	// so get the value
 	/* If we are starting to transmit then send the sync word first */
 	uint16_t current_word = 0xfa;
-	if (!first_packet_to_be_sent) {
-		current_word = encoded_packet[current_encoded_packet_num][words_sent_for_current_packet];
+	if (!s->first_packet_to_be_sent) {
+		current_word = s->encoded_packet[s->current_encoded_packet_num][s->words_sent_for_current_packet];
 	}
 	// we send most significant bit first of the 10 bit word
-	int shift_amt = 9 - bits_sent_for_current_word;
+	int shift_amt = 9 - s->bits_sent_for_current_word;
 	current_bit = ((current_word & 0x3ff) >> shift_amt)  & 0x01;
 
-	bits_sent_for_current_word++;
+	s->bits_sent_for_current_word++;
+	s->bits_sent++;
 	return current_bit;
 }
 
+uint64_t telem_stream_next_bits(telem_stream_t *s, int n) {
+	uint64_t bits = 0;
+	int packet_bits = (s->packet_length + 1) * BITS_PER_10b_WORD;
+	while (n > 0) {
+		int pos = s->words_sent_for_current_packet * BITS_PER_10b_WORD + s->bits_sent_for_current_word;
+		if (s->first_packet_to_be_sent || pos == 0 || pos >= packet_bits) {
+			/* The first sync word or the start of the next packet, where the packets are swapped */
+			bits = (bits << 1) | telem_stream_next_bit(s);
+			n--;
+			continue;
+		}
+		int k = packet_bits - pos;
+		if (k > n)
+			k = n;
+		uint64_t *packed = s->packed_packet[s->current_encoded_packet_num];
+		int offset = pos & 63;
+		uint64_t w = packed[pos >> 6] << offset;
+		if (offset != 0)
+			w |= packed[(pos >> 6) + 1] >> (64 - offset);
+		w >>= 64 - k;
+		bits = k == 64 ? w : (bits << k) | w;
+		pos += k;
+		/* A finished word is left with all of its bits sent, as telem_stream_next_bit() leaves it */
+		s->words_sent_for_current_packet = (pos - 1) / BITS_PER_10b_WORD;
+		s->bits_sent_for_current_word = pos - s->words_sent_for_current_packet * BITS_PER_10b_WORD;
+		s->bits_sent += k;
+		n -= k;
+	}
+	return bits;
+}
+
+int telem_stream_bits_to_frame_boundary(telem_stream_t *s) {
+	int boundary = s->packet_length * BITS_PER_10b_WORD; // the sync word at the end of the packet
+	if (s->first_packet_to_be_sent)
+		return BITS_PER_10b_WORD - s->bits_sent_for_current_word + boundary;
+	int pos = s->words_sent_for_current_packet * BITS_PER_10b_WORD + s->bits_sent_for_current_word;
+	if (pos < boundary)
+		return boundary - pos;
+	return (s->packet_length + 1) * BITS_PER_10b_WORD - pos + boundary;
+}
+
+/*
+ * The buffer also stops at the end of each sync word.  The next packet is then only taken from the
+ * telem thread with the first bit after the sync word, as it is when the bits are sent one at a time.
+ * The bits are counted in bits_sent as they are read from the buffer
+ */
+void telem_stream_fill_bit_buffer(telem_stream_t *s) {
+	int boundary = s->packet_length * BITS_PER_10b_WORD;
+	int pos = s->words_sent_for_current_packet * BITS_PER_10b_WORD + s->bits_sent_for_current_word;
+	int n = telem_stream_bits_to_frame_boundary(s);
+	if (s->first_packet_to_be_sent && s->bits_sent_for_current_word < BITS_PER_10b_WORD)
+		n = BITS_PER_10b_WORD - s->bits_sent_for_current_word;
+	else if (!s->first_packet_to_be_sent && pos >= boundary && pos < boundary + BITS_PER_10b_WORD)
+		n = boundary + BITS_PER_10b_WORD - pos;
+	if (n > 64)
+		n = 64;
+	s->bit_buffer = telem_stream_next_bits(s, n);
+	s->bits_buffered = n;
+	s->bits_sent -= n;
+}
+
+void telem_pack_words(const uint16_t *words, int num_words, uint64_t *packed) {
+	memset(packed, 0, ((num_words * BITS_PER_10b_WORD + 63) / 64 + 1) * sizeof(uint64_t));
+	for (int i=0; i < num_words; i++) {
+		uint64_t w = words[i] & CHARACTER_MASK;
+		int pos = i * BITS_PER_10b_WORD;
+		int shift = 64 - BITS_PER_10b_WORD - (pos & 63);
+		if (shift >= 0) {
+			packed[pos >> 6] |= w << shift;
+		} else {
+			/* The word is split between two 64 bit words */
+			packed[pos >> 6] |= w >> -shift;
+			packed[(pos >> 6) + 1] |= w << (64 + shift);
+		}
+	}
+}
+
+int telem_processor_at_frame_boundary() {
+	return telem_stream_at_frame_boundary(main_stream);
+}
+
+int telem_stream_at_frame_boundary(telem_stream_t *s) {
+	if (s->bits_buffered != 0)
+		return false;
+	if (s->first_packet_to_be_sent)
+		return s->bits_sent_for_current_word == 0;
+	/* The last data word is sent.  The next word is the sync word at the end of the packet */
+	return s->bits_sent_for_current_word >= BITS_PER_10b_WORD && s->words_sent_for_current_packet == s->packet_length - 1;
+}
 
 /**
  * This takes a telemetry frame and encodes it ready for transmission
  */
-void encode_duv_telem_packet(unsigned char *packet, uint16_t *encoded_packet) {
+void encode_duv_telem_packet(int *rd_state, unsigned char *packet, uint16_t *encoded_packet, uint64_t *packed_packet) {
 
-	memset(parities,0,sizeof(parities)); // Do this before every frame
+	encode_rs(parities, packet, DUV_DATA_LENGTH);
 
 	int j = 0;
-	// Encode the data, updating the RS encoder
-	for(int i=0; i< DUV_DATA_LENGTH;i++){
-		update_rs(parities,packet[i]);
-		encoded_packet[j++] = encode_8b10b(&rd_state,packet[i]);
-	}
+	for(int i=0; i< DUV_DATA_LENGTH;i++)
+		encoded_packet[j++] = encode_8b10b(rd_state,packet[i]);
 
 	// get the RS parities
 	for(int i=0;i< DUV_PARITIES_LENGTH;i++)
-		encoded_packet[j++] = encode_8b10b(&rd_state,parities[i]);
-	encoded_packet[j] = encode_8b10b(&rd_state,-1); // Insert end-of-frame flag
+		encoded_packet[j++] = encode_8b10b(rd_state,parities[i]);
+	encoded_packet[j] = encode_8b10b(rd_state,-1); // Insert end-of-frame flag
+	telem_pack_words(encoded_packet, DUV_PACKET_LENGTH+1, packed_packet);
 }
 
 /*
@@ -202,7 +316,7 @@ unsigned char test_packet[] = {
 		0x01,0x01,0x17,0x38,0xac,0x00,0x00,0x20};
 
 unsigned char * set_test_packet() {
-	encode_duv_telem_packet((unsigned char *)test_packet, encoded_packet[0]);
+	encode_duv_telem_packet(&main_stream->rd_state, (unsigned char *)test_packet, main_stream->encoded_packet[0], main_stream->packed_packet[0]);
 	return (unsigned char *)test_packet;
 }
 
@@ -242,9 +356,9 @@ int test_encode_packet() {
 	verbose_print("Packet header length: %i\n",(int)sizeof(duv_header_t))
 	verbose_print("Packet payload length: %i\n",(int)sizeof(rttelemetry_t))
 	verbose_print("Packet structure length: %i\n",(int)sizeof(duv_packet_t))
-	assert(sizeof(duv_header_t) == 7);
-	assert(sizeof(rttelemetry_t) == 57);
-	assert(sizeof(duv_packet_t) == DUV_DATA_LENGTH);
+	_Static_assert(sizeof(duv_header_t) == 7, "duv_header_t is not 7 bytes");
+	_Static_assert(sizeof(rttelemetry_t) == 57, "rttelemetry_t is not 57 bytes");
+	_Static_assert(sizeof(duv_packet_t) == DUV_DATA_LENGTH, "duv_packet_t is not DUV_DATA_LENGTH bytes");
 	duv_packet_t *packet = (duv_packet_t*)calloc(DUV_DATA_LENGTH,sizeof(char)); // allocate 64 bytes for the packet data
 
 	// This is the same header as the test packet
@@ -263,6 +377,16 @@ int test_encode_packet() {
 		}
 		verbose_print(" byte: %d %x\n",i,ptr[i]);
 	}
+
+	/* The generated codec must give the same bytes */
+	duv_header_fields_t header = {.id = 1, .epoch = 42, .uptime = 6920, .type = 1};
+	unsigned char packed_header[DUV_HEADER_PACKED_LENGTH];
+	duv_header_pack(&header, packed_header);
+	if (memcmp(packed_header, expected_result, sizeof(expected_result)) != 0
+			|| memcmp(packed_header, &packet->header, DUV_HEADER_PACKED_LENGTH) != 0) {
+		fail = EXIT_FAILURE;
+		verbose_print(" **err-> codec header is not the same\n");
+	}
 	free(packet);
 	if (fail == EXIT_SUCCESS) {
 		printf(" Pass\n");
@@ -272,6 +396,86 @@ int test_encode_packet() {
 	return fail;
 }
 
+/*
+ * The generated codec must read the same values as the bitfields from frames of random bytes,
+ * and pack them back into the same bytes
+ */
+int test_layout_codec() {
+	int fail = EXIT_SUCCESS;
+	printf("TESTING layout_codec .. ");
+	_Static_assert(DUV_HEADER_PACKED_LENGTH == sizeof(duv_header_t), "the duv_header layout does not match duv_header_t");
+	_Static_assert(RTTELEMETRY_PACKED_LENGTH == sizeof(rttelemetry_t), "the rttelemetry layout does not match rttelemetry_t");
+	_Static_assert(EXPTELEMETRY_PACKED_LENGTH == sizeof(exptelemetry_t),
+			"the exptelemetry layout does not match exptelemetry_t");
+
+	duv_packet_t rt;
+	exp_packet_t exp;
+	duv_header_fields_t h;
+	rttelemetry_fields_t r;
+	exptelemetry_fields_t e;
+	unsigned char buf[DUV_DATA_LENGTH];
+	uint32_t seed = 1;
+	for (int n=0; n < 100; n++) {
+		test_random_fill(&seed, (unsigned char *)&rt, sizeof(rt));
+		memcpy(&exp, &rt, sizeof(exp));
+
+		duv_header_unpack((unsigned char *)&rt.header, &h);
+		rttelemetry_unpack((unsigned char *)&rt.payload, &r);
+		exptelemetry_unpack((unsigned char *)&exp.payload, &e);
+		if (h.id != rt.header.id || h.epoch != rt.header.epoch || h.uptime != rt.header.uptime
+				|| h.type != rt.header.type || h.extended_id != rt.header.extended_id
+				|| h.safe_mode != rt.header.safe_mode || h.health_mode != rt.header.health_mode
+				|| h.science_mode != rt.header.science_mode) {
+			verbose_print(" header %d is not the same\n", n);
+			fail = EXIT_FAILURE;
+		}
+		if (r.pi_temperature != rt.payload.pi_temperature || r.xruns != rt.payload.xruns
+				|| r.loop_time != rt.payload.loop_time || r.cpu_speed != rt.payload.cpu_speed
+				|| r.loop_time_p99 != rt.payload.loop_time_p99 || r.deadline_used != rt.payload.deadline_used
+				|| r.pad12 != rt.payload.pad12 || r.pad13 != rt.payload.pad13) {
+			verbose_print(" rt telemetry %d is not the same\n", n);
+			fail = EXIT_FAILURE;
+		}
+		if (e.temperature != exp.payload.temperature || e.pressure != exp.payload.pressure
+				|| e.gyro0 != exp.payload.gyro0 || e.gyro1 != exp.payload.gyro1 || e.gyro8 != exp.payload.gyro8
+				|| e.photoresistor != exp.payload.photoresistor || e.realtimeclock != exp.payload.realtimeclock
+				|| e.cosmic_rays != exp.payload.cosmic_rays || e.pad1 != exp.payload.pad1
+				|| e.pad2 != exp.payload.pad2 || e.pad5 != exp.payload.pad5) {
+			verbose_print(" exp telemetry %d is not the same\n", n);
+			fail = EXIT_FAILURE;
+		}
+
+		duv_header_pack(&h, buf);
+		rttelemetry_pack(&r, buf + DUV_HEADER_PACKED_LENGTH);
+		if (memcmp(buf, &rt, sizeof(rt)) != 0) {
+			verbose_print(" rt frame %d did not pack to the same bytes\n", n);
+			fail = EXIT_FAILURE;
+		}
+		exptelemetry_pack(&e, buf + DUV_HEADER_PACKED_LENGTH);
+		if (memcmp(buf, &exp, sizeof(exp)) != 0) {
+			verbose_print(" exp frame %d did not pack to the same bytes\n", n);
+			fail = EXIT_FAILURE;
+		}
+	}
+
+	/* Values wider than a field are cut to fit, as they are by the bitfields */
+	uint32_t wide_type = 0x13;
+	h.type = wide_type;
+	duv_header_pack(&h, buf);
+	rt.header.type = wide_type;
+	if (memcmp(buf, &rt.header, DUV_HEADER_PACKED_LENGTH) != 0) {
+		verbose_print(" type was not cut to 4 bits\n");
+		fail = EXIT_FAILURE;
+	}
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
+
 unsigned char test_rs_parities_check[] = {0x19,0xa0,0x2c,0x20,0x59,0xf6,0x7c,0x12,0x84,0x27,0x77,0x98,0xb5,0xf3,0x89,0xf1,
 		0xa4,0x84,0xba,0x50,0x3a,0x0f,0x16,0x01,0x62,0x1c,0xcd,0x9a,0x11,0x1a,0xf2,0xa7};
 
@@ -280,7 +484,7 @@ int test_rs_encoder() {
 	printf("TESTING Rs Encoder .. ");
 	init_rd_state();
 	// Call the RS encoder without 8b10b encoding
-	test_telem_encoder(test_packet, encoded_packet[0]);
+	test_telem_encoder(test_packet, main_stream->encoded_packet[0]);
 
 	// Now check the parity bytes
 	// First should be 0x19 -> 25
@@ -288,11 +492,39 @@ int test_rs_encoder() {
 	//printf("First parity: %i \n",test_encoded_packet[DUV_DATA_LENGTH]);
 	//printf("Last Parity: %i \n",test_encoded_packet[DUV_DATA_LENGTH+DUV_PARITIES_LENGTH-1]);
 	for (int i=0; i < DUV_PARITIES_LENGTH; i++) {
-		if (encoded_packet[0][DUV_DATA_LENGTH+i] != test_rs_parities_check[i]) {
+		if (main_stream->encoded_packet[0][DUV_DATA_LENGTH+i] != test_rs_parities_check[i]) {
 			verbose_print(" failed with parity %d\n", i);
 			fail = 1;
 		}
 	}
+
+	/* The table driven encoders must give exactly the same parities */
+	unsigned char table_parities[DUV_PARITIES_LENGTH];
+	unsigned char frame_parities[DUV_PARITIES_LENGTH];
+	memset(table_parities, 0, sizeof(table_parities));
+	for (int i=0; i < DUV_DATA_LENGTH; i++)
+		update_rs_table(table_parities, test_packet[i]);
+	encode_rs(frame_parities, test_packet, DUV_DATA_LENGTH);
+	if (memcmp(table_parities, test_rs_parities_check, DUV_PARITIES_LENGTH) != 0
+			|| memcmp(frame_parities, test_rs_parities_check, DUV_PARITIES_LENGTH) != 0) {
+		verbose_print(" table encoder failed with the test packet\n");
+		fail = 1;
+	}
+
+	/* and for frames of random data of every length */
+	unsigned char data[DATA_BYTES_PER_CODE_WORD];
+	uint32_t seed = 1;
+	for (int len=0; len <= DATA_BYTES_PER_CODE_WORD; len++) {
+		test_random_fill(&seed, data, len);
+		memset(parities, 0, sizeof(parities));
+		for (int i=0; i < len; i++)
+			update_rs(parities, data[i]);
+		encode_rs(frame_parities, data, len);
+		if (memcmp(parities, frame_parities, DUV_PARITIES_LENGTH) != 0) {
+			verbose_print(" table encoder failed with %d random bytes\n", len);
+			fail = 1;
+		}
+	}
 	if (fail == 0) {
 		printf(" Pass\n");
 	} else {
@@ -306,9 +538,9 @@ int test_sync_word() {
 	int fail = 0;
 	printf("TESTING Sync word %x %x .. ",0xfa, (~0xfa) & 0x3ff);
 	init_rd_state();
-	encode_duv_telem_packet(test_packet, encoded_packet[0]);
+	encode_duv_telem_packet(&main_stream->rd_state, test_packet, main_stream->encoded_packet[0], main_stream->packed_packet[0]);
 
-	uint16_t word = encoded_packet[0][DUV_DATA_LENGTH+DUV_PARITIES_LENGTH];
+	uint16_t word = main_stream->encoded_packet[0][DUV_DATA_LENGTH+DUV_PARITIES_LENGTH];
 	verbose_print(" Sync Word is %x \n",word );
 
 	if (word != 0x0fa && word != 0x305) // 0x305 is ~0xfa
@@ -330,7 +562,7 @@ int test_get_next_bit() {
 	/* reset the state of the modulator */
 	init_telemetry_processor(DUV_PACKET_LENGTH);
 	// but then set the test packet rather than the real telemetry that was captured
-	encode_duv_telem_packet(test_packet, encoded_packet[0]);
+	encode_duv_telem_packet(&main_stream->rd_state, test_packet, main_stream->encoded_packet[0], main_stream->packed_packet[0]);
 
 	// Generate the first 40 bits of the test packet - the header
 	// First four bytes are: 0x51,0x01, 0x40, 0xd8
@@ -351,7 +583,7 @@ int test_get_next_bit() {
 
 
 	verbose_print("%x %x %x %x\n",test_packet[0], test_packet[1], test_packet[2],test_packet[3]);
-	verbose_print("%x %x %x %x\n",encoded_packet[0][0], encoded_packet[0][1], encoded_packet[0][2],encoded_packet[0][3]);
+	verbose_print("%x %x %x %x\n",main_stream->encoded_packet[0][0], main_stream->encoded_packet[0][1], main_stream->encoded_packet[0][2],main_stream->encoded_packet[0][3]);
 
 	for (int i=0; i < 50; i++) {
 		int b = get_next_bit();
@@ -371,10 +603,10 @@ int test_get_next_bit() {
 	//	printf("First parity: %x \n",test_encoded_packet[DUV_DATA_LENGTH] );
 	//	printf("Last Parity: %x \n",test_encoded_packet[DUV_DATA_LENGTH+DUV_PARITIES_LENGTH-1] );
 
-	if (encoded_packet[0][DUV_DATA_LENGTH] != 0x264) {
+	if (main_stream->encoded_packet[0][DUV_DATA_LENGTH] != 0x264) {
 		fail = 1;
 	}
-	if (encoded_packet[0][DUV_DATA_LENGTH+DUV_PARITIES_LENGTH-1] != 0x7a) {
+	if (main_stream->encoded_packet[0][DUV_DATA_LENGTH+DUV_PARITIES_LENGTH-1] != 0x7a) {
 		fail = 1;
 	}
 
@@ -386,3 +618,114 @@ int test_get_next_bit() {
 	}
 	return fail;
 }
+
+/*
+ * Send a few frames a bit at a time and then again in blocks of different sizes, and check that
+ * the bits and the state of the stream are the same.  Each frame is different, and a new one is
+ * supplied whenever the stream asks for it, as the telem thread would.  The first is supplied
+ * before the stream starts, so the next is ready when the first has been sent.
+ */
+#define TEST_NEXT_BITS_LENGTH (3 * (DUV_PACKET_LENGTH+1) * BITS_PER_10b_WORD + 123)
+
+int test_get_next_bits_supply(int *frame) {
+	unsigned char packet[DUV_DATA_LENGTH];
+	for (int i=0; i < DUV_DATA_LENGTH; i++)
+		packet[i] = i * 13 + *frame * 7;
+	if (telem_thread_supply_packet(TELEM_STREAM_MAIN, packet))
+		(*frame)++;
+	return *frame;
+}
+
+int test_get_next_bits() {
+	printf("TESTING get_next_bits .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	static uint8_t expected[TEST_NEXT_BITS_LENGTH];
+	static uint8_t boundary[TEST_NEXT_BITS_LENGTH + 1];
+
+	/* Packing puts the first bit of each word in the right place */
+	uint16_t words[DUV_PACKET_LENGTH+1];
+	uint64_t packed[TELEM_PACKED_LENGTH];
+	for (int i=0; i < DUV_PACKET_LENGTH+1; i++)
+		words[i] = (i * 0x2a5 + 0x0fa) & CHARACTER_MASK;
+	telem_pack_words(words, DUV_PACKET_LENGTH+1, packed);
+	for (int b=0; b < (DUV_PACKET_LENGTH+1) * BITS_PER_10b_WORD; b++) {
+		int bit = (words[b / BITS_PER_10b_WORD] >> (9 - b % BITS_PER_10b_WORD)) & 1;
+		if (((packed[b >> 6] >> (63 - (b & 63))) & 1) != bit)
+			fail = EXIT_FAILURE;
+	}
+
+	int frame = 0;
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	test_get_next_bits_supply(&frame);
+	for (int i=0; i < TEST_NEXT_BITS_LENGTH; i++) {
+		boundary[i] = telem_processor_at_frame_boundary();
+		expected[i] = get_next_bit();
+		test_get_next_bits_supply(&frame);
+	}
+	boundary[TEST_NEXT_BITS_LENGTH] = telem_processor_at_frame_boundary();
+	telem_stream_t sent = *main_stream;
+	int frames_supplied = frame;
+
+	int sizes[] = {8, 32, 64, 1, 13, 64, 64, 7};
+	frame = 0;
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	test_get_next_bits_supply(&frame);
+	int i = 0;
+	for (int k=0; i < TEST_NEXT_BITS_LENGTH; k++) {
+		int n = sizes[k % (sizeof(sizes)/sizeof(sizes[0]))];
+		if (n > TEST_NEXT_BITS_LENGTH - i)
+			n = TEST_NEXT_BITS_LENGTH - i;
+		int to_boundary = telem_stream_bits_to_frame_boundary(main_stream);
+		if ((i + to_boundary <= TEST_NEXT_BITS_LENGTH && !boundary[i + to_boundary])
+				|| telem_processor_at_frame_boundary() != boundary[i]) {
+			verbose_print(" frame boundary wrong at bit %d\n", i);
+			fail = EXIT_FAILURE;
+		}
+		uint64_t bits = telem_stream_next_bits(main_stream, n);
+		for (int b=0; b < n; b++)
+			if (((bits >> (n - 1 - b)) & 1) != expected[i + b]) {
+				verbose_print(" bit %d is wrong in a block of %d\n", i + b, n);
+				fail = EXIT_FAILURE;
+			}
+		i += n;
+		test_get_next_bits_supply(&frame);
+	}
+	if (frame != frames_supplied || main_stream->bits_sent != sent.bits_sent || main_stream->frames_sent != sent.frames_sent
+			|| main_stream->words_sent_for_current_packet != sent.words_sent_for_current_packet
+			|| main_stream->bits_sent_for_current_word != sent.bits_sent_for_current_word
+			|| main_stream->current_encoded_packet_num != sent.current_encoded_packet_num) {
+		verbose_print(" the stream state is different after %d frames\n", frame);
+		fail = EXIT_FAILURE;
+	}
+
+	/* The bit buffer gives the same bits, and keeps the frame boundary where it was */
+	frame = 0;
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	test_get_next_bits_supply(&frame);
+	for (i=0; i < TEST_NEXT_BITS_LENGTH; i++) {
+		if (telem_processor_at_frame_boundary() != boundary[i] || telem_stream_read_bit(main_stream) != expected[i]) {
+			verbose_print(" bit buffer is wrong at bit %d\n", i);
+			fail = EXIT_FAILURE;
+			break;
+		}
+		test_get_next_bits_supply(&frame);
+	}
+	if (main_stream->bits_sent != sent.bits_sent || main_stream->frames_sent != sent.frames_sent) {
+		verbose_print(" bit buffer sent %d bits in %d frames\n", main_stream->bits_sent, main_stream->frames_sent);
+		fail = EXIT_FAILURE;
+	}
+
+	/* The tests that follow do not supply packets, so leave buffer one as the next to send */
+	init_telemetry_processor(DUV_PACKET_LENGTH);
+	telem_thread_restart(TELEM_STREAM_MAIN);
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
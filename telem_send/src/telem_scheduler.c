@@ -0,0 +1,234 @@
+/*
+ * telem_scheduler.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The pattern of frame types and the queue of frames that are built ahead.  The queue is a
+ * ring of depth slots indexed by the count of frames added and taken.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+
+#include "config.h"
+#include "debug.h"
+#include "../../telem_send/inc/telem_scheduler.h"
+
+char *telem_scheduler_frame_names[TELEM_NUM_FRAME_TYPES] = {"NONE", "RT", "EXP", "WOD"};
+
+int telem_scheduler_parse_pattern(char *text, int *pattern, int max) {
+	int length = 0;
+	char *p = text;
+	while (*p != '\0') {
+		while (isspace((unsigned char)*p))
+			p++;
+		char *name = p;
+		while (*p != '\0' && *p != ',' && !isspace((unsigned char)*p))
+			p++;
+		int name_length = p - name;
+		while (isspace((unsigned char)*p))
+			p++;
+		if (*p != '\0' && *p != ',')
+			return -1; // a space inside a name
+		if (name_length == 0)
+			return -1;
+		int type = 0;
+		for (int t=1; t < TELEM_NUM_FRAME_TYPES; t++)
+			if (strlen(telem_scheduler_frame_names[t]) == name_length
+					&& strncasecmp(name, telem_scheduler_frame_names[t], name_length) == 0)
+				type = t;
+		if (type == 0 || length == max)
+			return -1;
+		pattern[length++] = type;
+		if (*p == ',') {
+			p++;
+			if (*p == '\0')
+				return -1; // nothing after the last comma
+		}
+	}
+	if (length == 0)
+		return -1;
+	return length;
+}
+
+char *telem_scheduler_frame_name(int type) {
+	if (type < 1 || type >= TELEM_NUM_FRAME_TYPES)
+		return telem_scheduler_frame_names[0];
+	return telem_scheduler_frame_names[type];
+}
+
+int telem_scheduler_init(telem_schedule_t *s, char *pattern, int depth) {
+	int length = telem_scheduler_parse_pattern(pattern, s->pattern, TELEM_SCHEDULER_MAX_PATTERN);
+	if (length < 0) {
+		error_print("Frame pattern is not valid: %s\n", pattern);
+		return EXIT_FAILURE;
+	}
+	if (depth < 1 || depth > TELEM_SCHEDULER_MAX_QUEUE) {
+		error_print("Frame queue depth must be 1 to %d, not %d\n", TELEM_SCHEDULER_MAX_QUEUE, depth);
+		return EXIT_FAILURE;
+	}
+	s->pattern_length = length;
+	s->next_in_pattern = 0;
+	s->depth = depth;
+	__atomic_store_n(&s->frames_added, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&s->frames_taken, 0, __ATOMIC_RELAXED);
+	for (int t=0; t < TELEM_NUM_FRAME_TYPES; t++)
+		__atomic_store_n(&s->frames_sent[t], 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&s->late, 0, __ATOMIC_RELAXED);
+	return EXIT_SUCCESS;
+}
+
+int telem_scheduler_next_type(telem_schedule_t *s) {
+	int type = s->pattern[s->next_in_pattern];
+	s->next_in_pattern++;
+	if (s->next_in_pattern == s->pattern_length)
+		s->next_in_pattern = 0;
+	return type;
+}
+
+int telem_scheduler_add(telem_schedule_t *s, int type, unsigned char *data, int len) {
+	if (len > DUV_DATA_LENGTH) {
+		error_print("Frame of type %d has %d bytes\n", type, len);
+		return EXIT_FAILURE;
+	}
+	if (telem_scheduler_queue_length(s) >= s->depth)
+		return EXIT_FAILURE;
+	telem_frame_t *frame = &s->queue[s->frames_added % s->depth];
+	frame->type = type;
+	memcpy(frame->data, data, len);
+	memset(frame->data + len, 0, DUV_DATA_LENGTH - len);
+	__atomic_store_n(&s->frames_added, s->frames_added + 1, __ATOMIC_RELEASE);
+	return EXIT_SUCCESS;
+}
+
+telem_frame_t *telem_scheduler_head(telem_schedule_t *s) {
+	if (telem_scheduler_queue_length(s) == 0)
+		return NULL;
+	return &s->queue[s->frames_taken % s->depth];
+}
+
+void telem_scheduler_frame_sent(telem_schedule_t *s) {
+	telem_frame_t *frame = telem_scheduler_head(s);
+	if (frame == NULL)
+		return;
+	__atomic_add_fetch(&s->frames_sent[frame->type], 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&s->frames_taken, s->frames_taken + 1, __ATOMIC_RELEASE);
+}
+
+void telem_scheduler_frame_late(telem_schedule_t *s) {
+	__atomic_add_fetch(&s->late, 1, __ATOMIC_RELAXED);
+}
+
+int telem_scheduler_queue_length(telem_schedule_t *s) {
+	uint32_t taken = __atomic_load_n(&s->frames_taken, __ATOMIC_ACQUIRE);
+	uint32_t added = __atomic_load_n(&s->frames_added, __ATOMIC_ACQUIRE);
+	return added - taken;
+}
+
+void telem_scheduler_print_status(telem_schedule_t *s, char *name) {
+	printf(" %s frame queue: %d of %d ready, sent", name, telem_scheduler_queue_length(s), s->depth);
+	for (int t=1; t < TELEM_NUM_FRAME_TYPES; t++)
+		printf(" %s %u", telem_scheduler_frame_names[t], __atomic_load_n(&s->frames_sent[t], __ATOMIC_RELAXED));
+	printf(", %u late\n", __atomic_load_n(&s->late, __ATOMIC_RELAXED));
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+int test_telem_scheduler() {
+	printf("TESTING telem_scheduler .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+
+	int pattern[TELEM_SCHEDULER_MAX_PATTERN];
+	int expected[] = {TELEM_FRAME_RT, TELEM_FRAME_EXP, TELEM_FRAME_EXP, TELEM_FRAME_RT};
+	int length = telem_scheduler_parse_pattern(" rt, EXP ,Exp,RT\n", pattern, TELEM_SCHEDULER_MAX_PATTERN);
+	if (length != 4 || memcmp(pattern, expected, sizeof(expected)) != 0) {
+		verbose_print(" pattern read as %d frames\n", length);
+		fail = EXIT_FAILURE;
+	}
+	char *bad[] = {"", "RT,XYZ", "RT,,EXP", "RT,", "R T", "RT,EXP,RT"};
+	for (int i=0; i < 6; i++) {
+		int max = i == 5 ? 2 : TELEM_SCHEDULER_MAX_PATTERN;
+		if (telem_scheduler_parse_pattern(bad[i], pattern, max) != -1) {
+			verbose_print(" pattern '%s' was accepted\n", bad[i]);
+			fail = EXIT_FAILURE;
+		}
+	}
+
+	telem_schedule_t s;
+	if (telem_scheduler_init(&s, "RT", 0) != EXIT_FAILURE) {
+		verbose_print(" queue depth 0 was accepted\n");
+		fail = EXIT_FAILURE;
+	}
+	telem_scheduler_init(&s, "RT,EXP,EXP,RT", 3);
+	if (telem_scheduler_head(&s) != NULL) {
+		verbose_print(" new queue is not empty\n");
+		fail = EXIT_FAILURE;
+	}
+
+	/* Keep the queue full while frames are taken, so the ring wraps a few times */
+	unsigned char data[DUV_DATA_LENGTH];
+	int sent = 0;
+	for (int n=0; n < 20; n++) {
+		while (telem_scheduler_queue_length(&s) < s.depth) {
+			int type = telem_scheduler_next_type(&s);
+			memset(data, type, sizeof(data));
+			telem_scheduler_add(&s, type, data, type == TELEM_FRAME_RT ? DUV_DATA_LENGTH : 10);
+		}
+		memset(data, 0, sizeof(data));
+		if (telem_scheduler_add(&s, TELEM_FRAME_RT, data, DUV_DATA_LENGTH) != EXIT_FAILURE) {
+			verbose_print(" frame added to a full queue\n");
+			fail = EXIT_FAILURE;
+		}
+		telem_frame_t *frame = telem_scheduler_head(&s);
+		int type = expected[sent % 4];
+		if (frame->type != type || frame->data[0] != type || frame->data[9] != type
+				|| frame->data[DUV_DATA_LENGTH-1] != (type == TELEM_FRAME_RT ? type : 0)) {
+			verbose_print(" frame %d is type %d, expected %d\n", sent, frame->type, type);
+			fail = EXIT_FAILURE;
+		}
+		telem_scheduler_frame_sent(&s);
+		sent++;
+	}
+	if (s.frames_sent[TELEM_FRAME_RT] != 10 || s.frames_sent[TELEM_FRAME_EXP] != 10) {
+		verbose_print(" sent %d RT and %d EXP frames\n", s.frames_sent[TELEM_FRAME_RT], s.frames_sent[TELEM_FRAME_EXP]);
+		fail = EXIT_FAILURE;
+	}
+	while (telem_scheduler_head(&s) != NULL)
+		telem_scheduler_frame_sent(&s);
+	if (telem_scheduler_queue_length(&s) != 0 || s.frames_sent[TELEM_FRAME_RT] + s.frames_sent[TELEM_FRAME_EXP] != 22) {
+		verbose_print(" queue did not empty\n");
+		fail = EXIT_FAILURE;
+	}
+	if (g_verbose)
+		telem_scheduler_print_status(&s, "test");
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}
@@ -30,25 +30,45 @@
  * To determine if data collection is complete the telem processor should check
  * which encoded packet buffer will be filled next.
  *
+ * Each telemetry stream has its own flag and buffers, so the DUV and the high speed
+ * telemetry can both be sent at once.  The streams are filled one at a time.
+ *
+ * The frames are built ahead of time.  Each stream has a schedule with a queue of frames and
+ * a pattern of frame types, see telem_scheduler.h.  When there is no packet to encode the
+ * thread gathers the telemetry for the next frame in the pattern of a stream with room in its
+ * queue.  A request for a packet encodes the frame at the head of the queue, so the modulator
+ * does not wait for the sensors to be read.
+ *
+ * A sample of the telemetry is kept in the whole orbit data store every wod_period_sec.  The
+ * WOD frames send the stored samples in turn.
+ *
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <pthread.h>
 #include <sched.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "config.h"
 #include "debug.h"
-#include "jack_audio.h"
+#include "audio_backend.h"
+#include "loop_latency.h"
+#include "realtime.h"
 #include "device_lps25hb.h"
 #include "device_ds3231.h"
 #include "device_ads1015.h"
 
 #include "duv_telem_layout.h"
 #include "telem_processor.h"
+#include "telem_scheduler.h"
+#include "wod_store.h"
 
 /* Forward function definitions */
 int gather_duv_telemetry(uint8_t type);
+void telem_thread_fill_stream(int stream);
+void telem_thread_build_frame(int stream);
+void telem_thread_store_wod();
 void print_duv_packet(duv_packet_t *packet);
 void print_duv_header(duv_header_t header);
 void print_rttelemetry(rttelemetry_t payload);
@@ -58,20 +78,24 @@ duv_packet_t *telem_packet;  /* This is the raw data before it is RS encoded */
 int called = false; /* true if we have already started the thread */
 int running = true;
 pthread_mutex_t fill_packet_mutex = PTHREAD_MUTEX_INITIALIZER;
-int fill_packet = true;
-int packet_num = 1; // The buffer that is ready to send.  Initialize to one so that on the first pass through we fill buffer zero
-
-typedef struct {
-    duv_header_t header;
-    rttelemetry_t rtHealth;
-    exptelemetry_t exp;
-} telem_buffer_t;
+int fill_packet[TELEM_NUM_STREAMS] = {true, true}; // fill the first packet of each stream at startup
+int packet_num[TELEM_NUM_STREAMS] = {1, 1}; // The buffer that is ready to send.  Initialize to one so that on the first pass through we fill buffer zero
 
 /* Allocate a static buffer to store the telemetry when it is collected */
 telem_buffer_t telem_buffer;
 
-duv_packet_t realtimeFrame;
-exp_packet_t experimentFrame;
+/* The frame being built, packed from the telemetry */
+unsigned char telem_frame[DUV_DATA_LENGTH];
+duv_header_fields_t wod_header;
+
+/* Past samples for the WOD frames */
+wod_store_t wod_store;
+telem_buffer_t wod_sample;
+int wod_stored = false; // true once the first sample of this run is stored
+struct timespec last_wod_time;
+
+/* The frame types to send and the frames built ahead for each stream */
+telem_schedule_t telem_schedule[TELEM_NUM_STREAMS];
 
 /**
  * Main process of the telem thread.  This is called when the pthread is created.
@@ -88,56 +112,157 @@ void *telem_thread_process(void * arg) {
 	called++;
 
 	debug_print("Starting Thread: %s\n", name);
+	realtime_prefault_stack(g_prefault_stack_kb);
 
 	/* Initialize */
 //	telem_packet = (duv_packet_t*)calloc(DUV_DATA_LENGTH,sizeof(char)); // allocate 64 bytes for the packet data
+	for (int stream=0; stream < TELEM_NUM_STREAMS; stream++)
+		if (telem_scheduler_init(&telem_schedule[stream], g_frame_pattern, g_frame_queue_depth) != EXIT_SUCCESS) {
+			error_print("Using frame pattern %s with %d frames built ahead\n", TELEM_SCHEDULER_DEFAULT_PATTERN,
+					TELEM_SCHEDULER_DEFAULT_QUEUE_DEPTH);
+			telem_scheduler_init(&telem_schedule[stream], TELEM_SCHEDULER_DEFAULT_PATTERN, TELEM_SCHEDULER_DEFAULT_QUEUE_DEPTH);
+		}
+	if (wod_store_open(&wod_store, g_wod_file, g_wod_records, g_wod_sync_records) != EXIT_SUCCESS)
+		error_print("WOD frames will hold the latest telemetry\n");
 
 	/* Run until stopped */
 	while (running) {
-		/* use a mutex to prevent race conditions with fill_buffer */
-		pthread_mutex_lock( &fill_packet_mutex );
-		if (fill_packet) {
-			fill_packet = false;
+		int filled = false;
+		for (int stream=0; stream < TELEM_NUM_STREAMS; stream++) {
+			/* use a mutex to prevent race conditions with fill_buffer */
+			pthread_mutex_lock( &fill_packet_mutex );
+			int fill = fill_packet[stream];
+			fill_packet[stream] = false;
 			pthread_mutex_unlock( &fill_packet_mutex );
-			int packet_buffer_to_fill = !packet_num; // toggle the buffer so we fill the other one
-
-			int type = 2;
-			int rc = gather_duv_telemetry(type);
-			if (rc != 0) {
-				error_print("Error creating telemetry packet\n");
+			if (fill) {
+				telem_thread_fill_stream(stream);
+				filled = true;
 			}
-
-//			realtimeFrame.header = telem_buffer.header;
-//			realtimeFrame.payload = telem_buffer.rtHealth;
-//			int len = sizeof(realtimeFrame);
-//			encode_next_packet((unsigned char *)&realtimeFrame, packet_buffer_to_fill);
-
-			experimentFrame.header = telem_buffer.header;
-			experimentFrame.payload = telem_buffer.exp;
-			//int len = sizeof(experimentFrame);
-			//printf("ENCODING PACKET LEN %d\n",len);
-
-			encode_next_packet((unsigned char *)&experimentFrame, packet_buffer_to_fill);
-
-			packet_num = packet_buffer_to_fill; /* This is now the next buffer available */
 		}
-		pthread_mutex_unlock( &fill_packet_mutex );
+		/* Build one frame ahead at a time, so a request for a packet waits for at most one sensor read */
+		if (!filled)
+			for (int stream=0; stream < TELEM_NUM_STREAMS; stream++) {
+				telem_schedule_t *s = &telem_schedule[stream];
+				if (telem_scheduler_queue_length(s) < s->depth) {
+					telem_thread_build_frame(stream);
+					break;
+				}
+			}
 		sched_yield();
 	}
+	wod_store_close(&wod_store);
 	debug_print("Exiting Thread: %s\n", name);
 	called--;
 //	free(telem_packet);
 	return EXIT_SUCCESS;
 }
 
-void telem_thread_fill_next_packet() {
+/*
+ * Encode the next frame from the queue into the buffer of the stream that is not being sent.  If
+ * the queue is empty the frame is built now
+ */
+void telem_thread_fill_stream(int stream) {
+	int packet_buffer_to_fill = !packet_num[stream]; // toggle the buffer so we fill the other one
+	telem_schedule_t *s = &telem_schedule[stream];
+
+	telem_frame_t *frame = telem_scheduler_head(s);
+	if (frame == NULL) {
+		telem_scheduler_frame_late(s);
+		telem_thread_build_frame(stream);
+		frame = telem_scheduler_head(s);
+	}
+
+	encode_next_packet(stream, frame->data, packet_buffer_to_fill);
+	telem_scheduler_frame_sent(s);
+
+	__atomic_store_n(&packet_num[stream], packet_buffer_to_fill, __ATOMIC_RELEASE); /* This is now the next buffer available */
+}
+
+/*
+ * Gather the telemetry for the next frame type in the pattern of a stream and add the frame to
+ * its queue
+ */
+void telem_thread_build_frame(int stream) {
+	telem_schedule_t *s = &telem_schedule[stream];
+	int type = telem_scheduler_next_type(s);
+	int rc = gather_duv_telemetry(type);
+	if (rc != 0) {
+		error_print("Error creating telemetry packet\n");
+	}
+	telem_thread_store_wod();
+
+	unsigned char *payload = &telem_frame[DUV_HEADER_PACKED_LENGTH];
+	switch (type) {
+	case TELEM_FRAME_RT:
+		duv_header_pack(&telem_buffer.header, telem_frame);
+		rttelemetry_pack(&telem_buffer.rtHealth, payload);
+		telem_scheduler_add(s, type, telem_frame, DUV_HEADER_PACKED_LENGTH + RTTELEMETRY_PACKED_LENGTH);
+		break;
+	case TELEM_FRAME_EXP:
+		duv_header_pack(&telem_buffer.header, telem_frame);
+		exptelemetry_pack(&telem_buffer.exp, payload);
+		telem_scheduler_add(s, type, telem_frame, DUV_HEADER_PACKED_LENGTH + EXPTELEMETRY_PACKED_LENGTH);
+		break;
+	case TELEM_FRAME_WOD:
+		/* The header of the stored sample is kept, so the frame has the time it was taken */
+		if (wod_store_next(&wod_store, &wod_sample) != EXIT_SUCCESS)
+			wod_sample = telem_buffer;
+		wod_header = wod_sample.header;
+		wod_header.type = TELEM_FRAME_WOD;
+		duv_header_pack(&wod_header, telem_frame);
+		rttelemetry_pack(&wod_sample.rtHealth, payload);
+		telem_scheduler_add(s, type, telem_frame, DUV_HEADER_PACKED_LENGTH + RTTELEMETRY_PACKED_LENGTH);
+		break;
+	}
+}
+
+/*
+ * Add the telemetry just gathered to the WOD store if a period has passed since the last sample.
+ * This is a copy into the mapped file, and a write to the card every wod_sync_records samples
+ */
+void telem_thread_store_wod() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	if (wod_stored && now.tv_sec - last_wod_time.tv_sec < g_wod_period_sec)
+		return;
+	if (wod_store_append(&wod_store, &telem_buffer) == EXIT_SUCCESS) {
+		wod_stored = true;
+		last_wod_time = now;
+	}
+}
+
+void telem_thread_fill_next_packet(int stream) {
 	pthread_mutex_lock( &fill_packet_mutex );
-	fill_packet = true;
+	fill_packet[stream] = true;
 	pthread_mutex_unlock( &fill_packet_mutex );
 }
 
-int telem_thread_get_packet_num() {
-	return packet_num;
+telem_schedule_t *telem_thread_schedule(int stream) {
+	return &telem_schedule[stream];
+}
+
+int telem_thread_get_packet_num(int stream) {
+	return __atomic_load_n(&packet_num[stream], __ATOMIC_ACQUIRE);
+}
+
+void telem_thread_restart(int stream) {
+	pthread_mutex_lock( &fill_packet_mutex );
+	fill_packet[stream] = true;
+	pthread_mutex_unlock( &fill_packet_mutex );
+	__atomic_store_n(&packet_num[stream], 1, __ATOMIC_RELEASE);
+}
+
+int telem_thread_supply_packet(int stream, unsigned char *packet) {
+	pthread_mutex_lock( &fill_packet_mutex );
+	int fill = fill_packet[stream];
+	fill_packet[stream] = false;
+	pthread_mutex_unlock( &fill_packet_mutex );
+	if (!fill)
+		return false;
+	int packet_buffer_to_fill = !packet_num[stream];
+	encode_next_packet(stream, packet, packet_buffer_to_fill);
+	__atomic_store_n(&packet_num[stream], packet_buffer_to_fill, __ATOMIC_RELEASE);
+	return true;
 }
 
 int gather_duv_telemetry(uint8_t type) {
@@ -229,6 +354,16 @@ int gather_duv_telemetry(uint8_t type) {
 		telem_buffer.rtHealth.loop_time = get_loop_time_microsec()/100;
 		verbose_print("Audio loop time %.2f ms\n",telem_buffer.rtHealth.loop_time/10.0);
 
+		/* Audio loop time percentile and worst case fraction of the period used over the short window */
+		latency_histogram_t loop_hist;
+		loop_latency_get(g_latency_short_window_sec, &loop_hist);
+		double p99 = latency_histogram_percentile(&loop_hist, 99) / 100000;
+		telem_buffer.rtHealth.loop_time_p99 = p99 > 255 ? 255 : p99;
+		double used = 100.0 * loop_hist.max_ns / loop_latency_deadline_ns();
+		telem_buffer.rtHealth.deadline_used = used > 255 ? 255 : used;
+		verbose_print("Audio loop time p99 %.2f ms, deadline used %d%%\n",telem_buffer.rtHealth.loop_time_p99/10.0,
+				telem_buffer.rtHealth.deadline_used);
+
 		/* Xruns since we started running */
 		telem_buffer.rtHealth.xruns = get_xruns_since_start();
 		verbose_print("Xruns since start %i\n",telem_buffer.rtHealth.xruns);
@@ -316,8 +451,8 @@ void print_rttelemetry(rttelemetry_t payload) {
     printf("Audio Loop: %d  ",payload.loop_time);
     printf("Proc Speed: %d  ",payload.cpu_speed);
     printf("\n");
-    printf("Data 2: %d  ",payload.data2);
-    printf("Data 3: %d  ",payload.data3);
+    printf("Audio Loop p99: %d  ",payload.loop_time_p99);
+    printf("Deadline Used: %d  ",payload.deadline_used);
     printf("None: %d  ",payload.pad1);
     printf("None: %d  ",payload.pad2);
     printf("\n");
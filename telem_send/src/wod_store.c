@@ -0,0 +1,385 @@
+/*
+ * wod_store.c
+ *
+ *  Created on: Oct 19, 2026
+ *      Author: g0kla
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ *
+ * The whole orbit data ring file.  The header page is followed by the records.  The record for
+ * sequence number n is in slot (n-1) % capacity, so the oldest record is found from the next
+ * sequence number alone.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "debug.h"
+#include "../../telem_send/inc/wod_store.h"
+
+/* Forward declarations */
+uint32_t wod_store_checksum(uint32_t crc, const void *data, size_t len);
+uint32_t wod_store_header_checksum(wod_store_header_t *header);
+uint32_t wod_store_record_checksum(wod_record_t *record);
+wod_record_t *wod_store_record(wod_store_t *store, uint32_t seq);
+int wod_store_record_valid(wod_store_t *store, uint32_t seq);
+wod_store_header_t *wod_store_find_header(wod_store_t *store);
+int wod_store_write_header(wod_store_t *store);
+int wod_store_sync_slots(wod_store_t *store, uint32_t first, uint32_t last);
+
+/* CRC-32, bit at a time.  It is only run once for each sample */
+uint32_t wod_store_checksum(uint32_t crc, const void *data, size_t len) {
+	const unsigned char *p = data;
+	crc = ~crc;
+	for (size_t i=0; i < len; i++) {
+		crc ^= p[i];
+		for (int b=0; b < 8; b++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+	return ~crc;
+}
+
+uint32_t wod_store_header_checksum(wod_store_header_t *header) {
+	return wod_store_checksum(0, header, offsetof(wod_store_header_t, checksum));
+}
+
+uint32_t wod_store_record_checksum(wod_record_t *record) {
+	uint32_t crc = wod_store_checksum(0, &record->seq, sizeof(record->seq));
+	return wod_store_checksum(crc, &record->sample, sizeof(record->sample));
+}
+
+wod_record_t *wod_store_record(wod_store_t *store, uint32_t seq) {
+	return &store->records[(seq - 1) % store->capacity];
+}
+
+int wod_store_record_valid(wod_store_t *store, uint32_t seq) {
+	wod_record_t *record = wod_store_record(store, seq);
+	return record->seq == seq && record->checksum == wod_store_record_checksum(record);
+}
+
+/* The newer of the two header copies that is good and matches this layout, or NULL */
+wod_store_header_t *wod_store_find_header(wod_store_t *store) {
+	wod_store_header_t *best = NULL;
+	for (int c=0; c < 2; c++) {
+		wod_store_header_t *h = (wod_store_header_t *)(store->map + c * WOD_STORE_HEADER_COPY_SIZE);
+		if (h->magic != WOD_STORE_MAGIC || h->checksum != wod_store_header_checksum(h))
+			continue;
+		if (h->record_size != sizeof(wod_record_t) || h->capacity != store->capacity || h->next_seq == 0)
+			continue;
+		if (best == NULL || (int32_t)(h->generation - best->generation) > 0)
+			best = h;
+	}
+	return best;
+}
+
+/* Write the header over the older copy, so the newer one is still good if this is torn */
+int wod_store_write_header(wod_store_t *store) {
+	store->generation++;
+	wod_store_header_t header;
+	memset(&header, 0, sizeof(header));
+	header.magic = WOD_STORE_MAGIC;
+	header.record_size = sizeof(wod_record_t);
+	header.capacity = store->capacity;
+	header.generation = store->generation;
+	header.next_seq = store->next_seq;
+	header.checksum = wod_store_header_checksum(&header);
+	memcpy(store->map + (store->generation % 2) * WOD_STORE_HEADER_COPY_SIZE, &header, sizeof(header));
+	if (msync(store->map, WOD_STORE_HEADER_SIZE, MS_SYNC) != 0) {
+		error_print("Could not sync the WOD store header: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+/* msync the records in slots first to last.  The start is rounded down to a page */
+int wod_store_sync_slots(wod_store_t *store, uint32_t first, uint32_t last) {
+	long page_size = sysconf(_SC_PAGESIZE);
+	unsigned char *start = (unsigned char *)&store->records[first];
+	unsigned char *end = (unsigned char *)&store->records[last + 1];
+	unsigned char *page = store->map + ((start - store->map) / page_size) * page_size;
+	if (msync(page, end - page, MS_SYNC) != 0) {
+		error_print("Could not sync the WOD store records: %s\n", strerror(errno));
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int wod_store_open(wod_store_t *store, char *filename, int capacity, int sync_records) {
+	memset(store, 0, sizeof(*store));
+	store->fd = -1;
+	if (capacity < 1 || sync_records < 1) {
+		error_print("WOD store needs at least one record and one record to sync, not %d and %d\n", capacity, sync_records);
+		return EXIT_FAILURE;
+	}
+	store->capacity = capacity;
+	store->sync_records = sync_records;
+	store->map_size = WOD_STORE_HEADER_SIZE + (size_t)capacity * sizeof(wod_record_t);
+
+	int fd = open(filename, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		error_print("Could not open the WOD store %s: %s\n", filename, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		error_print("Could not read the size of the WOD store %s: %s\n", filename, strerror(errno));
+		close(fd);
+		return EXIT_FAILURE;
+	}
+
+	/* Make the file its full size now, so that no blocks are allocated as it fills */
+	int created = (size_t)st.st_size != store->map_size;
+	if (created) {
+		if (st.st_size != 0)
+			debug_print("WOD store %s is not the expected size, starting again\n", filename);
+		int rc = ftruncate(fd, 0);
+		if (rc == 0) {
+			rc = posix_fallocate(fd, 0, store->map_size);
+			if (rc != 0) // not all file systems can allocate, so just set the size
+				rc = ftruncate(fd, store->map_size);
+		}
+		if (rc != 0) {
+			error_print("Could not size the WOD store %s\n", filename);
+			close(fd);
+			return EXIT_FAILURE;
+		}
+	}
+
+	void *map = mmap(NULL, store->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		error_print("Could not map the WOD store %s: %s\n", filename, strerror(errno));
+		close(fd);
+		return EXIT_FAILURE;
+	}
+	store->fd = fd;
+	store->map = map;
+	store->records = (wod_record_t *)(store->map + WOD_STORE_HEADER_SIZE);
+
+	wod_store_header_t *header = wod_store_find_header(store);
+	if (header == NULL) {
+		if (!created) {
+			debug_print("WOD store %s has no header for this layout, starting again\n", filename);
+			memset(store->map, 0, store->map_size);
+			wod_store_sync_slots(store, 0, store->capacity - 1);
+		}
+		store->generation = 0;
+		store->next_seq = 1;
+		return wod_store_write_header(store);
+	}
+	store->generation = header->generation;
+	store->next_seq = header->next_seq;
+
+	/* Keep the records that reached the file after the header was last written */
+	uint32_t header_seq = store->next_seq;
+	for (uint32_t i=0; i < store->capacity && wod_store_record_valid(store, store->next_seq); i++)
+		store->next_seq++;
+	if (store->next_seq != header_seq) {
+		debug_print("WOD store %s recovered %d records after the header\n", filename, store->next_seq - header_seq);
+		return wod_store_write_header(store);
+	}
+	return EXIT_SUCCESS;
+}
+
+int wod_store_append(wod_store_t *store, telem_buffer_t *sample) {
+	if (store->fd < 0)
+		return EXIT_FAILURE;
+	wod_record_t *record = wod_store_record(store, store->next_seq);
+	record->seq = store->next_seq;
+	record->sample = *sample;
+	record->checksum = wod_store_record_checksum(record);
+	if (store->unsynced == 0)
+		store->dirty_first = store->next_seq;
+	store->next_seq++;
+	store->unsynced++;
+	if (store->unsynced >= store->sync_records)
+		return wod_store_sync(store);
+	return EXIT_SUCCESS;
+}
+
+int wod_store_next(wod_store_t *store, telem_buffer_t *sample) {
+	int count = wod_store_count(store);
+	uint32_t oldest = store->next_seq - count;
+	/* Skip any record that was only half written before a crash */
+	for (int i=0; i < count; i++) {
+		if (store->read_seq < oldest || store->read_seq >= store->next_seq)
+			store->read_seq = oldest;
+		uint32_t seq = store->read_seq++;
+		if (wod_store_record_valid(store, seq)) {
+			*sample = wod_store_record(store, seq)->sample;
+			return EXIT_SUCCESS;
+		}
+	}
+	return EXIT_FAILURE;
+}
+
+int wod_store_count(wod_store_t *store) {
+	if (store->fd < 0)
+		return 0;
+	uint32_t written = store->next_seq - 1;
+	return written < store->capacity ? written : store->capacity;
+}
+
+int wod_store_sync(wod_store_t *store) {
+	if (store->fd < 0 || store->unsynced == 0)
+		return EXIT_SUCCESS;
+	int rc;
+	uint32_t first = (store->dirty_first - 1) % store->capacity;
+	uint32_t last = (store->next_seq - 2) % store->capacity;
+	if (store->next_seq - store->dirty_first >= store->capacity)
+		rc = wod_store_sync_slots(store, 0, store->capacity - 1);
+	else if (first <= last)
+		rc = wod_store_sync_slots(store, first, last);
+	else {
+		rc = wod_store_sync_slots(store, first, store->capacity - 1);
+		if (rc == EXIT_SUCCESS)
+			rc = wod_store_sync_slots(store, 0, last);
+	}
+	/* The header only moves on once the records are in the file */
+	if (rc == EXIT_SUCCESS)
+		rc = wod_store_write_header(store);
+	store->unsynced = 0;
+	store->syncs++;
+	return rc;
+}
+
+void wod_store_close(wod_store_t *store) {
+	if (store->fd < 0)
+		return;
+	wod_store_sync(store);
+	munmap(store->map, store->map_size);
+	close(store->fd);
+	store->fd = -1;
+}
+
+/******************************************************************************
+ *
+ * TEST FUNCTIONS
+ *
+ ******************************************************************************/
+
+/* Read the next samples and check their uptimes */
+int test_wod_store_read(wod_store_t *store, int *uptimes, int n) {
+	int fail = EXIT_SUCCESS;
+	telem_buffer_t sample;
+	for (int i=0; i < n; i++) {
+		if (wod_store_next(store, &sample) != EXIT_SUCCESS || sample.header.uptime != uptimes[i]
+				|| sample.exp.pressure != 100 + uptimes[i]) {
+			verbose_print(" read %d expected uptime %d got %d\n", i, uptimes[i], sample.header.uptime);
+			fail = EXIT_FAILURE;
+		}
+	}
+	return fail;
+}
+
+int test_wod_store() {
+	printf("TESTING wod_store .. ");
+	verbose_print("\n");
+	int fail = EXIT_SUCCESS;
+	char *filename = "wod_test.dat";
+	unlink(filename);
+
+	wod_store_t store;
+	telem_buffer_t sample;
+	memset(&sample, 0, sizeof(sample));
+	if (wod_store_open(&store, filename, 5, 3) != EXIT_SUCCESS) {
+		printf(" Fail\n");
+		return EXIT_FAILURE;
+	}
+	if (wod_store_next(&store, &sample) != EXIT_FAILURE) {
+		verbose_print(" empty store returned a sample\n");
+		fail = EXIT_FAILURE;
+	}
+
+	/* Fill the ring and wrap, syncing every 3 records */
+	for (int i=1; i <= 7; i++) {
+		sample.header.uptime = i;
+		sample.exp.pressure = 100 + i;
+		wod_store_append(&store, &sample);
+	}
+	int round_robin[] = {3, 4, 5, 6, 7, 3, 4};
+	if (wod_store_count(&store) != 5 || store.syncs != 2) {
+		verbose_print(" %d records and %d syncs after 7 samples\n", wod_store_count(&store), store.syncs);
+		fail = EXIT_FAILURE;
+	}
+	if (test_wod_store_read(&store, round_robin, 7) != EXIT_SUCCESS)
+		fail = EXIT_FAILURE;
+	wod_store_close(&store);
+
+	/* The samples are still there when it is opened again */
+	wod_store_open(&store, filename, 5, 100);
+	if (test_wod_store_read(&store, round_robin, 2) != EXIT_SUCCESS)
+		fail = EXIT_FAILURE;
+
+	/* A crash after the pages were written back but before the header was */
+	for (int i=8; i <= 9; i++) {
+		sample.header.uptime = i;
+		sample.exp.pressure = 100 + i;
+		wod_store_append(&store, &sample);
+	}
+	msync(store.map, store.map_size, MS_SYNC);
+	munmap(store.map, store.map_size);
+	close(store.fd);
+	wod_store_open(&store, filename, 5, 100);
+	int recovered[] = {5, 6, 7, 8, 9, 5};
+	if (store.next_seq != 10 || test_wod_store_read(&store, recovered, 6) != EXIT_SUCCESS) {
+		verbose_print(" next record after the crash is %d\n", store.next_seq);
+		fail = EXIT_FAILURE;
+	}
+	uint32_t generation = store.generation;
+	wod_store_close(&store);
+
+	/* A torn write of the newer header copy falls back to the older one */
+	int fd = open(filename, O_RDWR);
+	unsigned char junk[16];
+	memset(junk, 0xA5, sizeof(junk));
+	if (pwrite(fd, junk, sizeof(junk), (generation % 2) * WOD_STORE_HEADER_COPY_SIZE) != sizeof(junk))
+		fail = EXIT_FAILURE;
+	close(fd);
+	wod_store_open(&store, filename, 5, 100);
+	if (store.next_seq != 10 || wod_store_count(&store) != 5) {
+		verbose_print(" next record with a torn header is %d\n", store.next_seq);
+		fail = EXIT_FAILURE;
+	}
+
+	/* A record that was half written is skipped */
+	wod_store_record(&store, 6)->sample.exp.pressure = 0;
+	int skipped[] = {5, 7, 8, 9, 5};
+	if (test_wod_store_read(&store, skipped, 5) != EXIT_SUCCESS)
+		fail = EXIT_FAILURE;
+	wod_store_close(&store);
+
+	/* A different number of records starts again */
+	wod_store_open(&store, filename, 4, 100);
+	if (wod_store_count(&store) != 0) {
+		verbose_print(" store kept %d records when resized\n", wod_store_count(&store));
+		fail = EXIT_FAILURE;
+	}
+	wod_store_close(&store);
+	unlink(filename);
+
+	if (fail == EXIT_SUCCESS) {
+		printf(" Pass\n");
+	} else {
+		printf(" Fail\n");
+	}
+	return fail;
+}